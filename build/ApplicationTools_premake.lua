@@ -51,6 +51,7 @@ local ALL_SRC_DIR     = SRC_DIR .. "all/"
 local ALL_EXTERN_DIR  = ALL_SRC_DIR .. "extern/"
 local WIN_SRC_DIR     = SRC_DIR .. "win/"
 local WIN_EXTERN_DIR  = WIN_SRC_DIR .. "extern/"
+local LINUX_SRC_DIR   = SRC_DIR .. "linux/"
 
 local function ApplicationTools_SetPaths(_root)
 	SRC_DIR         = _root .. SRC_DIR
@@ -58,6 +59,7 @@ local function ApplicationTools_SetPaths(_root)
 	ALL_EXTERN_DIR  = _root .. ALL_EXTERN_DIR
 	WIN_SRC_DIR     = _root .. WIN_SRC_DIR
 	WIN_EXTERN_DIR  = _root .. WIN_EXTERN_DIR
+	LINUX_SRC_DIR   = _root .. LINUX_SRC_DIR
 end
 
 local function ApplicationTools_Globals()
@@ -86,6 +88,11 @@ local function ApplicationTools_Globals()
 			WIN_SRC_DIR,
 			WIN_EXTERN_DIR,
 			})
+	filter { "platforms:Linux*" }
+		includedirs({
+			LINUX_SRC_DIR,
+			})
+		forceincludes { "apt/glibc.h" } -- see glibc.h
 	filter {}
 end
 
@@ -107,6 +114,7 @@ function ApplicationTools_Project(_root, _targetDir, _config)
 			["*"]        = ALL_SRC_DIR .. "apt/**",
 			["extern/*"] = ALL_EXTERN_DIR .. "**",
 			["win"]      = WIN_SRC_DIR .. "apt/**",
+			["linux"]    = LINUX_SRC_DIR .. "apt/**",
 			})
 
 		files({
@@ -133,6 +141,11 @@ function ApplicationTools_Project(_root, _targetDir, _config)
 				WIN_EXTERN_DIR .. "**.c",
 				WIN_EXTERN_DIR .. "**.cpp",
 				})
+		filter { "platforms:Linux*" }
+			files({
+				LINUX_SRC_DIR  .. "**.h",
+				LINUX_SRC_DIR  .. "**.cpp",
+				})
 		filter {}
 
 		for k,v in pairs(_config) do
@@ -163,4 +176,7 @@ function ApplicationTools_Link()
 
 	filter { "platforms:Win*" }
 		links { "shlwapi" }
+	filter { "platforms:Linux*" }
+		links { "pthread" }
+	filter {}
 end
@@ -2,11 +2,18 @@ dofile "ApplicationTools_premake.lua"
 
 workspace "ApplicationTools"
 	location(_ACTION)
-	platforms { "Win64" }
+	if os.istarget("linux") then
+		platforms { "Linux64" }
+	else
+		platforms { "Win64" }
+	end
 	flags { "StaticRuntime" }
 	filter { "platforms:Win64" }
 		system "windows"
 		architecture "x86_64"
+	filter { "platforms:Linux64" }
+		system "linux"
+		architecture "x86_64"
 	filter {}
 
 	configurations { "Debug", "Release" }
@@ -34,6 +41,7 @@ workspace "ApplicationTools"
 		kind "ConsoleApp"
 		language "C++"
 		targetdir "../bin"
+		exceptionhandling "On" -- catch.hpp requires exceptions
 
 		local TESTS_DIR         = "../tests/"
 		local TESTS_EXTERN_DIR  = TESTS_DIR .. "extern/"
@@ -0,0 +1,275 @@
+#include <apt/DerivedDataCache.h>
+
+#include <apt/hash.h>
+#include <apt/log.h>
+#include <apt/FileSystem.h>
+#include <apt/Time.h>
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+#include <EASTL/vector.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace apt;
+
+namespace {
+	const uint kNameLength = 16 + 1 + 16 + 1 + 8; // "<content hash>-<converter id>-<converter version>"
+
+	bool ParseName(const char* _name, DerivedDataCache::Key& ret_)
+	{
+		if (strlen(_name) != kNameLength) {
+			return false;
+		}
+		unsigned long long contentHash, converterId;
+		unsigned int converterVersion;
+		if (sscanf(_name, "%16llx-%16llx-%8x", &contentHash, &converterId, &converterVersion) != 3) {
+			return false;
+		}
+		ret_.m_contentHash      = (uint64)contentHash;
+		ret_.m_converterId      = (uint64)converterId;
+		ret_.m_converterVersion = (uint32)converterVersion;
+		return true;
+	}
+
+	// Temporary files may belong to another process which is writing to the cache, hence only delete those which weren't modified recently.
+	const double kStaleTempAgeSeconds = 60.0 * 60.0;
+	bool IsStale(DateTime _timeModified, DateTime _now)
+	{
+		return _now.getSecondsSince(_timeModified) > kStaleTempAgeSeconds;
+	}
+}
+
+// PUBLIC
+
+DerivedDataCache::Key DerivedDataCache::MakeKey(const char* _data, uint64 _dataSize, const char* _converterName, uint32 _converterVersion)
+{
+	Key ret;
+	ret.m_contentHash      = HashData(_data, _dataSize);
+	ret.m_converterId      = HashString<uint64>(_converterName);
+	ret.m_converterVersion = _converterVersion;
+	return ret;
+}
+
+DerivedDataCache::DerivedDataCache()
+	: m_maxSize(0)
+	, m_size(0)
+	, m_tempCounter(0)
+{
+}
+
+DerivedDataCache::~DerivedDataCache()
+{
+}
+
+bool DerivedDataCache::init(const char* _rootDir, uint64 _maxSizeBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_root.set(_rootDir);
+	m_maxSize = _maxSizeBytes;
+	m_size = 0;
+	m_entries.clear();
+
+	PathStr tmpDir("%s/tmp", _rootDir);
+	if (!FileSystem::CreateDir((const char*)PathStr("%s/", (const char*)tmpDir))) {
+		return false;
+	}
+	tmpDir.replace('\\', '/');
+
+	const DateTime now = Time::GetDateTime();
+	eastl::vector<PathStr> staleList;
+	FileSystem::Enumerate(_rootDir, [&](const FileSystem::DirEntry& _entry)
+		{
+			if (_entry.m_isDir) {
+				return FileSystem::EnumerateAction_Continue;
+			}
+			PathStr dir;
+			dir.set(_entry.m_dir);
+			dir.replace('\\', '/'); // Enumerate() may return platform separators
+			if (dir == tmpDir) {
+				if (IsStale(_entry.m_timeModified, now)) {
+					staleList.push_back(_entry.getPath());
+				}
+				return FileSystem::EnumerateAction_Continue;
+			}
+			Key key;
+			if (ParseName(_entry.m_name, key)) {
+				insert(key, _entry.m_size, (sint64)_entry.m_timeModified.getRaw());
+			}
+			return FileSystem::EnumerateAction_Continue;
+		},
+		true);
+	for (auto& path : staleList) {
+		FileSystem::Delete((const char*)path);
+	}
+
+	evict(m_maxSize);
+	return true;
+}
+
+bool DerivedDataCache::get(const Key& _key, File& ret_)
+{
+	APT_ASSERT(!m_root.isEmpty());
+	PathStr path = makePath(_key);
+	if (!exists(_key)) {
+		return false;
+	}
+	if (!File::Read(ret_, (const char*)path)) {
+		remove(_key);
+		return false;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	insert(_key, ret_.getDataSize(), (sint64)Time::GetDateTime().getRaw());
+	return true;
+}
+
+bool DerivedDataCache::put(const Key& _key, const File& _data)
+{
+	APT_ASSERT(!m_root.isEmpty());
+	PathStr path = makePath(_key);
+	PathStr tmpPath("%s/tmp/%s.%08x%08x", (const char*)m_root, FileSystem::FindFileNameAndExtension((const char*)path), (uint32)Time::GetTimestamp().getRaw(), m_tempCounter.fetch_add(1));
+
+ // write to a temporary file, then rename into place
+	if (!File::Write(_data, (const char*)tmpPath)) {
+		return false;
+	}
+	if (!FileSystem::CreateDir((const char*)FileSystem::GetPath((const char*)path)) || !FileSystem::Rename((const char*)tmpPath, (const char*)path)) {
+		FileSystem::Delete((const char*)tmpPath);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	insert(_key, _data.getDataSize(), (sint64)Time::GetDateTime().getRaw());
+	if (m_size > m_maxSize) {
+		evict(m_maxSize - m_maxSize / 8); // evict slightly more than required to avoid evicting on every subsequent put()
+	}
+	return true;
+}
+
+bool DerivedDataCache::remove(const Key& _key)
+{
+	APT_ASSERT(!m_root.isEmpty());
+	{	std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_entries.find(GetEntryHash(_key));
+		if (it != m_entries.end()) {
+			m_size -= it->second.m_size;
+			m_entries.erase(it);
+		}
+	}
+	return FileSystem::Delete((const char*)makePath(_key));
+}
+
+bool DerivedDataCache::exists(const Key& _key)
+{
+	APT_ASSERT(!m_root.isEmpty());
+	const uint64 entryHash = GetEntryHash(_key);
+	{	std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_entries.find(entryHash);
+		if (it != m_entries.end()) {
+			it->second.m_lastAccess = (sint64)Time::GetDateTime().getRaw();
+			return true;
+		}
+	}
+
+ // the output may have been written by another process sharing the cache dir, it's added to the index by get()
+	return File::Exists((const char*)makePath(_key));
+}
+
+void DerivedDataCache::setMaxSize(uint64 _maxSizeBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_maxSize = _maxSizeBytes;
+	evict(m_maxSize);
+}
+
+bool DerivedDataCache::convertImage(Image& ret_, const char* _srcPath, const char* _converterName, uint32 _converterVersion, const ImageConverter& _converter, Image::FileFormat _format)
+{
+	File src;
+	if (!FileSystem::Read(src, _srcPath)) {
+		return false;
+	}
+	Key key = MakeKey(src, _converterName, _converterVersion);
+
+	File dst;
+	if (get(key, dst)) {
+		if (Image::Read(ret_, dst, _format)) {
+			return true;
+		}
+		APT_LOG_ERR("DerivedDataCache: Invalid output for '%s' (%s), reconverting", _srcPath, _converterName);
+		remove(key);
+	}
+
+	Image srcImage;
+	if (!Image::Read(srcImage, src)) {
+		return false;
+	}
+	if (!_converter(srcImage, ret_)) {
+		APT_LOG_ERR("DerivedDataCache: Error converting '%s' (%s)", _srcPath, _converterName);
+		return false;
+	}
+	if (!Image::Write(ret_, dst, _format)) {
+		return false;
+	}
+	put(key, dst); // failing to cache the output isn't an error
+	return true;
+}
+
+// PRIVATE
+
+uint64 DerivedDataCache::GetEntryHash(const Key& _key)
+{
+	uint64 ret = Hash<uint64>(&_key.m_contentHash, sizeof(_key.m_contentHash));
+	ret = Hash<uint64>(&_key.m_converterId, sizeof(_key.m_converterId), ret);
+	return Hash<uint64>(&_key.m_converterVersion, sizeof(_key.m_converterVersion), ret);
+}
+
+PathStr DerivedDataCache::makePath(const Key& _key) const
+{
+	return PathStr("%s/%02x/%016llx-%016llx-%08x",
+		(const char*)m_root,
+		(uint32)(_key.m_contentHash >> 56),
+		(unsigned long long)_key.m_contentHash,
+		(unsigned long long)_key.m_converterId,
+		_key.m_converterVersion
+		);
+}
+
+void DerivedDataCache::insert(const Key& _key, uint64 _size, sint64 _lastAccess)
+{
+	Entry& entry = m_entries[GetEntryHash(_key)];
+	if (entry.m_size > 0) {
+		m_size -= entry.m_size;
+	}
+	entry.m_key        = _key;
+	entry.m_size       = _size;
+	entry.m_lastAccess = _lastAccess;
+	m_size += _size;
+}
+
+void DerivedDataCache::evict(uint64 _targetSize)
+{
+	if (m_size <= _targetSize) {
+		return;
+	}
+
+	eastl::vector<const Entry*> lru;
+	lru.reserve(m_entries.size());
+	for (auto& it : m_entries) {
+		lru.push_back(&it.second);
+	}
+	eastl::sort(lru.begin(), lru.end(), [](const Entry* _a, const Entry* _b) { return _a->m_lastAccess < _b->m_lastAccess; });
+
+	uint evictCount = 0;
+	for (const Entry* entry : lru) {
+		if (m_size <= _targetSize) {
+			break;
+		}
+		m_size -= entry->m_size;
+		FileSystem::Delete((const char*)makePath(entry->m_key));
+		++evictCount;
+	}
+	for (uint i = 0; i < evictCount; ++i) {
+		m_entries.erase(GetEntryHash(lru[i]->m_key));
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/File.h>
+#include <apt/Image.h>
+#include <apt/String.h>
+
+#include <EASTL/functional.h>
+#include <EASTL/hash_map.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// DerivedDataCache
+// Persistent cache for the outputs of expensive conversions (e.g. image format
+// conversion, compression). Outputs are keyed by a hash of the input data plus
+// a converter id and version, hence any change to the input or to the
+// converter produces a new key; stale outputs are never served, they're just
+// evicted eventually.
+//
+// Outputs are stored one file per key, sharded by the first byte of the
+// content hash (<root>/<xx>/<key>). Outputs are written to <root>/tmp/ and
+// renamed into place, so a partially written output is never visible to other
+// threads or processes sharing the cache dir.
+//
+// The total size of the cache is limited, the least recently used outputs are
+// evicted first. Access times are only tracked in memory; when the cache is
+// initialized the order is approximated by the time each output was written.
+//
+// get()/put()/remove() are thread safe.
+////////////////////////////////////////////////////////////////////////////////
+class DerivedDataCache: private non_copyable<DerivedDataCache>
+{
+public:
+	struct Key
+	{
+		uint64 m_contentHash;       // Hash of the input data.
+		uint64 m_converterId;       // HashString() of the converter name.
+		uint32 m_converterVersion;  // Increment to invalidate all outputs of a converter.
+	};
+	static Key MakeKey(const char* _data, uint64 _dataSize, const char* _converterName, uint32 _converterVersion);
+	static Key MakeKey(const File& _input, const char* _converterName, uint32 _converterVersion) { return MakeKey(_input.getData(), _input.getDataSize(), _converterName, _converterVersion); }
+
+	DerivedDataCache();
+	~DerivedDataCache();
+
+	// Use _rootDir (as-is, no root search) for the cache, create it if it doesn't exist. Existing outputs are scanned, stale temporary
+	// files are deleted. If the total size exceeds _maxSizeBytes outputs are evicted. Return false if an error occurred.
+	bool        init(const char* _rootDir, uint64 _maxSizeBytes);
+
+	// Read the output for _key into ret_. Return false if there is no output for _key.
+	bool        get(const Key& _key, File& ret_);
+	// Store _data as the output for _key, replacing any existing output. Return false if an error occurred.
+	bool        put(const Key& _key, const File& _data);
+	// Delete the output for _key. Return false if there was no output for _key.
+	bool        remove(const Key& _key);
+	// Return true if there is an output for _key. Outputs written by another process aren't added to the index until get() is called.
+	bool        exists(const Key& _key);
+
+	// Evict outputs until the total size is less than _maxSizeBytes.
+	void        setMaxSize(uint64 _maxSizeBytes);
+	uint64      getMaxSize() const                 { return m_maxSize; }
+	// Return the total size of the outputs in bytes.
+	uint64      getSize() const                    { return m_size; }
+	uint        getEntryCount() const              { return (uint)m_entries.size(); }
+	const char* getRoot() const                    { return (const char*)m_root; }
+
+	// Convert _src into ret_, return false if an error occurred.
+	typedef eastl::function<bool(const Image& _src, Image& ret_)> ImageConverter;
+
+	// Read the image at _srcPath (via FileSystem::Read()) and convert it via _converter. The result is stored in the cache as
+	// _format (which must support all the properties of the result, e.g. DDS for compressed formats or mips). If the input data,
+	// _converterName and _converterVersion are unchanged the result is read from the cache and _converter isn't called.
+	// Return false if an error occurred.
+	bool        convertImage(
+		Image&                ret_,
+		const char*           _srcPath,
+		const char*           _converterName,
+		uint32                _converterVersion,
+		const ImageConverter& _converter,
+		Image::FileFormat     _format = Image::FileFormat_Dds
+		);
+
+private:
+	struct Entry
+	{
+		Key    m_key;
+		uint64 m_size;
+		sint64 m_lastAccess;        // Raw DateTime.
+	};
+
+	PathStr                         m_root;
+	uint64                          m_maxSize;
+	uint64                          m_size;
+	eastl::hash_map<uint64, Entry>  m_entries;       // Keyed by GetEntryHash().
+	std::mutex                      m_mutex;
+	std::atomic<uint32>             m_tempCounter;
+
+	static uint64 GetEntryHash(const Key& _key);
+
+	PathStr     makePath(const Key& _key) const;
+	// Add/update an entry. Call with m_mutex locked.
+	void        insert(const Key& _key, uint64 _size, sint64 _lastAccess);
+	// Evict the least recently used entries until m_size <= _targetSize. Call with m_mutex locked.
+	void        evict(uint64 _targetSize);
+
+}; // class DerivedDataCache
+
+} // namespace apt
@@ -168,7 +168,7 @@ private:
 	const ClassRef* m_cref;
 };
 #define APT_FACTORY_DEFINE(_baseClass) \
-	eastl::vector_map<apt::StringHash, apt::Factory<_baseClass>::ClassRef*>* apt::Factory<_baseClass>::s_registry
+	template <> eastl::vector_map<apt::StringHash, apt::Factory<_baseClass>::ClassRef*>* apt::Factory<_baseClass>::s_registry = nullptr
 #define APT_FACTORY_REGISTER(_baseClass, _subClass, _createFunc, _destroyFunc) \
 	static apt::Factory<_baseClass>::ClassRef s_ ## _subClass(#_subClass, _createFunc, _destroyFunc);
 #define APT_FACTORY_REGISTER_DEFAULT(_baseClass, _subClass) \
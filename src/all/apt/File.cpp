@@ -2,14 +2,34 @@
 
 #include <cstdlib> // malloc, free
 #include <cstring> // memcpy
+#include <new>     // placement new
 #include <utility> // swap
 
 using namespace apt;
 
+static uint64 s_UnbufferedThreshold = 0;
+
 // PUBLIC
 
+void File::SetUnbufferedThreshold(uint64 _bytes)
+{
+	s_UnbufferedThreshold = _bytes;
+}
+
+uint64 File::GetUnbufferedThreshold()
+{
+	return s_UnbufferedThreshold;
+}
+
 void File::setData(const char* _data, uint64 _size)
 {
+	if (m_shared) {
+		if (_data || _size == 0) {
+			releaseData();
+		} else {
+			makeUnique();
+		}
+	}
 	if (m_data) {
 		if (_size > m_dataSize || _size == 0) {
 			free(m_data);
@@ -27,8 +47,23 @@ void File::setData(const char* _data, uint64 _size)
 	m_dataSize = _size;
 }
 
+void File::swap(File& _file_)
+{
+	PathStr path;
+	path.set((const char*)m_path);
+	m_path.set((const char*)_file_.m_path);
+	_file_.m_path.set((const char*)path);
+	std::swap(m_data,     _file_.m_data);
+	std::swap(m_dataSize, _file_.m_dataSize);
+	std::swap(m_impl,     _file_.m_impl);
+	std::swap(m_shared,   _file_.m_shared);
+}
+
 void File::appendData(const char* _data, uint64 _size)
 {
+	if (m_shared) {
+		makeUnique();
+	}
 	m_data = (char*)realloc(m_data, m_dataSize + _size);
 	if (_data) {
 		memcpy(m_data + m_dataSize, _data, _size);
@@ -44,12 +79,67 @@ void File::ctorCommon()
 	m_data = nullptr;
 	m_dataSize = 0;
 	m_impl = nullptr;
+	m_shared = nullptr;
 }
 
 void File::dtorCommon()
 {
-	if (m_data) {
+	releaseData();
+}
+
+void File::releaseData()
+{
+	if (m_shared) {
+		SharedData::Release(m_shared);
+	} else if (m_data) {
 		free(m_data);
-		m_data = nullptr;
 	}
+	m_data = nullptr;
+	m_dataSize = 0;
+}
+
+void File::setShared(SharedData* _sharedData)
+{
+	SharedData::AddRef(_sharedData);
+	releaseData();
+	m_shared   = _sharedData;
+	m_data     = _sharedData->getData();
+	m_dataSize = _sharedData->m_size;
+}
+
+void File::makeUnique()
+{
+	APT_ASSERT(m_shared);
+	char* data = (char*)malloc(m_dataSize + 2); // preserve the implicit null
+	APT_ASSERT(data);
+	memcpy(data, m_data, m_dataSize + 2);
+	SharedData::Release(m_shared);
+	m_data = data;
+}
+
+File::SharedData* File::SharedData::Create(const char* _data, uint64 _size)
+{
+	SharedData* ret = (SharedData*)malloc(sizeof(SharedData) + _size + 2);
+	APT_ASSERT(ret);
+	new(&ret->m_refCount) std::atomic<uint32>(1);
+	ret->m_size = _size;
+	if (_data) {
+		memcpy(ret->getData(), _data, _size);
+	}
+	ret->getData()[_size] = ret->getData()[_size + 1] = '\0';
+	return ret;
+}
+
+void File::SharedData::AddRef(SharedData* _sharedData)
+{
+	_sharedData->m_refCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void File::SharedData::Release(SharedData*& _sharedData_)
+{
+	if (_sharedData_->m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		_sharedData_->m_refCount.~atomic();
+		free(_sharedData_);
+	}
+	_sharedData_ = nullptr;
 }
@@ -3,6 +3,8 @@
 #include <apt/apt.h>
 #include <apt/String.h>
 
+#include <atomic>
+
 namespace apt {
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -11,6 +13,9 @@ namespace apt {
 // Files loaded into memory via Read() have an implicit null character appended
 // to the internal data buffer, hence getData() can be interpreted directly as
 // C string.
+// Data read via FileSystem::Read() may be shared with the FileSystem content 
+// cache (see FileSystem::SetContentCache()). Shared data is copied on the first
+// call to the non-const getData(), setData() or appendData().
 // \todo API should include some interface for either writing to the internal 
 //   buffer directly, or setting the buffer ptr without copying all the data
 //   (prefer the former, buffer ownership issues in the latter case).
@@ -38,6 +43,17 @@ public:
 	// in which case any existing file at _path may or may not have been overwritten.
 	static bool Write(const File& _file, const char* _path = 0);
 
+	// As Write() but append to the file at _path, which is created if it doesn't exist.
+	static bool Append(const File& _file, const char* _path = 0);
+
+	// Files larger than _bytes are read/written unbuffered (bypassing the system file cache) by Read()/Write(). This avoids evicting
+	// the file cache for very large sequential transfers, but is slower for files which are accessed repeatedly. Whole sectors are
+	// transferred directly to/from the file's data if it's sector-aligned, else via a staging buffer (i.e. the same number of copies as
+	// buffered access). 0 disables unbuffered access (the default). On Linux the transfer is buffered but the file's pages are dropped
+	// from the cache afterward.
+	static void   SetUnbufferedThreshold(uint64 _bytes);
+	static uint64 GetUnbufferedThreshold();
+
 	// Allocate _size bytes for the internal buffer and optionally copy from _data. If _data 
 	// is 0 the buffer is allocated.
 	void        setData(const char* _data, uint64 _size);
@@ -48,20 +64,51 @@ public:
 	const char* getPath() const                                 { return (const char*)m_path; }
 	void        setPath(const char* _path)                      { m_path.set(_path); }
 	const char* getData() const                                 { return m_data; }
-	char*       getData()                                       { return m_data; }
+	char*       getData()                                       { if (m_shared) makeUnique(); return m_data; }
 	uint64      getDataSize() const                             { return m_dataSize; }
 	void        setDataSize(uint64 _size)                       { setData(0, _size); }
+	bool        isShared() const                                { return m_shared != nullptr; }
+
+	// Exchange the path, data and any platform resources with _file_.
+	void        swap(File& _file_);
+
+	// Reference counted, immutable data buffer. The data (plus 2 null characters) immediately follows the header. Public such that
+	// the FileSystem content cache can hold a reference directly, there's no other reason to use it.
+	struct SharedData
+	{
+		std::atomic<uint32> m_refCount;
+		uint64              m_size;
 
+		char* getData() { return (char*)(this + 1); }
+
+		// Allocate a buffer of _size bytes with a ref count of 1, optionally copy from _data.
+		static SharedData* Create(const char* _data, uint64 _size);
+		static void        AddRef(SharedData* _sharedData);
+		static void        Release(SharedData*& _sharedData_);
+	};
 
 private:
-	PathStr m_path;
-	char*   m_data;
-	uint64  m_dataSize;
-	void*   m_impl;
+	friend class FileSystem;
+
+	PathStr     m_path;
+	char*       m_data;
+	uint64      m_dataSize;
+	void*       m_impl;
+	SharedData* m_shared;     // If non-null, m_data points to m_shared->getData().
 
 	void ctorCommon();
 	void dtorCommon();
 
+	// As Read(), but if the file size is <= _maxSharedBytes the data is read directly into a SharedData buffer (see FileSystem::ReadCached()).
+	static bool ReadShared(File& file_, const char* _path, uint64 _maxSharedBytes);
+
+	// Release the data buffer (free or release the shared data).
+	void releaseData();
+	// Point to _sharedData (the ref count is incremented).
+	void setShared(SharedData* _sharedData);
+	// Copy shared data into a buffer owned by this.
+	void makeUnique();
+
 };
 
 } // namespace apt
@@ -0,0 +1,111 @@
+#include <apt/FileActionCoalescer.h>
+
+#include <apt/hash.h>
+
+using namespace apt;
+
+namespace {
+	// Result of receiving action _next for a path with a pending action _prev.
+	FileSystem::FileAction Coalesce(FileSystem::FileAction _prev, FileSystem::FileAction _next)
+	{
+		if (_prev == FileSystem::FileAction_Count) {
+			return _next;
+		}
+		switch (_next) {
+			case FileSystem::FileAction_Created:
+				return _prev == FileSystem::FileAction_Created ? FileSystem::FileAction_Created : FileSystem::FileAction_Modified;
+			case FileSystem::FileAction_Deleted:
+				return _prev == FileSystem::FileAction_Created ? FileSystem::FileAction_Count : FileSystem::FileAction_Deleted;
+			case FileSystem::FileAction_Modified:
+			default:
+				return _prev == FileSystem::FileAction_Created ? FileSystem::FileAction_Created : FileSystem::FileAction_Modified;
+		};
+	}
+}
+
+// PUBLIC
+
+FileActionCoalescer::FileActionCoalescer(uint _windowMs)
+{
+	setWindow(_windowMs);
+}
+
+void FileActionCoalescer::setWindow(uint _windowMs)
+{
+	m_windowMs = _windowMs;
+	m_window = Timestamp((sint64)_windowMs * Time::GetSystemFrequency() / 1000);
+}
+
+void FileActionCoalescer::push(const char* _path, uint _pathLength, FileSystem::FileAction _action, Timestamp _time)
+{
+	const uint64 pathHash = Hash<uint64>(_path, _pathLength);
+	auto it = m_pendingMap.find(pathHash);
+	if (it != m_pendingMap.end()) {
+		Pending& pending = m_pending[it->second];
+		pending.m_action = Coalesce(pending.m_action, _action);
+		pending.m_time = _time;
+		return;
+	}
+
+	Pending pending;
+	pending.m_pathHash   = pathHash;
+	pending.m_pathOffset = (uint32)m_arena.size();
+	pending.m_pathLength = (uint32)_pathLength;
+	pending.m_action     = _action;
+	pending.m_time       = _time;
+	m_arena.insert(m_arena.end(), _path, _path + _pathLength);
+	m_arena.push_back('\0');
+	m_pendingMap[pathHash] = (uint)m_pending.size();
+	m_pending.push_back(pending);
+}
+
+uint FileActionCoalescer::flush(Timestamp _time, bool _all)
+{
+	m_batch.clear();
+	m_batchArena.clear();
+	m_batchArena.swap(m_arena); // batched paths remain in m_batchArena, remaining paths are copied back to m_arena
+
+	uint remaining = 0;
+	for (uint i = 0; i < m_pending.size(); ++i) {
+		Pending& pending = m_pending[i];
+		if (_all || pending.m_time + m_window <= _time) {
+			m_pendingMap.erase(pending.m_pathHash);
+			if (pending.m_action != FileSystem::FileAction_Count) {
+				FileSystem::FileActionEvent event;
+				event.m_path   = m_batchArena.data() + pending.m_pathOffset;
+				event.m_action = pending.m_action;
+				m_batch.push_back(event);
+			}
+			continue;
+		}
+
+		const char* path = m_batchArena.data() + pending.m_pathOffset;
+		pending.m_pathOffset = (uint32)m_arena.size();
+		m_arena.insert(m_arena.end(), path, path + pending.m_pathLength + 1);
+		m_pendingMap[pending.m_pathHash] = remaining;
+		m_pending[remaining++] = pending;
+	}
+	m_pending.resize(remaining);
+	return (uint)m_batch.size();
+}
+
+Timestamp FileActionCoalescer::getNextReadyTime() const
+{
+	Timestamp ret;
+	for (uint i = 0; i < m_pending.size(); ++i) {
+		Timestamp t = m_pending[i].m_time + m_window;
+		if (i == 0 || t < ret) {
+			ret = t;
+		}
+	}
+	return ret;
+}
+
+void FileActionCoalescer::clear()
+{
+	m_pending.clear();
+	m_pendingMap.clear();
+	m_arena.clear();
+	m_batchArena.clear();
+	m_batch.clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/FileSystem.h>
+#include <apt/Time.h>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// FileActionCoalescer
+// Accumulate file actions from a platform watcher and coalesce them per path.
+// Sequences of actions for the same path collapse to a single action:
+//   Created  + Modified = Created
+//   Created  + Deleted  = (none)
+//   Modified + Deleted  = Deleted
+//   Deleted  + Created  = Modified
+// A path becomes ready for dispatch once no further actions have been received
+// for it within the coalesce window (a window of 0 means every action is ready
+// at the next flush()).
+// Paths are stored in an arena; pushing an action doesn't allocate unless the
+// arena needs to grow.
+// Not thread safe, the platform implementation is responsible for locking.
+////////////////////////////////////////////////////////////////////////////////
+class FileActionCoalescer
+{
+public:
+	FileActionCoalescer(uint _windowMs = 0);
+
+	void     setWindow(uint _windowMs);
+	uint     getWindow() const                 { return m_windowMs; }
+
+	// Add an action for _path (_pathLength characters, need not be null-terminated) received at _time.
+	void     push(const char* _path, uint _pathLength, FileSystem::FileAction _action, Timestamp _time);
+
+	// Gather all actions which are ready at _time (or all actions if _all is true) into a batch. The batch (and the paths it
+	// references) remain valid until the next call to flush() or clear(). Return the number of actions in the batch.
+	uint     flush(Timestamp _time, bool _all = false);
+	const FileSystem::FileActionEvent* getBatch() const { return m_batch.data(); }
+	uint     getBatchSize() const              { return (uint)m_batch.size(); }
+
+	// Return the time at which the next pending action becomes ready, or Timestamp() if there are no pending actions.
+	Timestamp getNextReadyTime() const;
+
+	bool     isEmpty() const                   { return m_pending.empty(); }
+	void     clear();
+
+private:
+	struct Pending
+	{
+		uint64                 m_pathHash;
+		uint32                 m_pathOffset;
+		uint32                 m_pathLength;
+		FileSystem::FileAction m_action;     // FileAction_Count if the action was cancelled (Created + Deleted).
+		Timestamp              m_time;       // Time of the most recent action.
+	};
+
+	uint                                    m_windowMs;
+	Timestamp                               m_window;
+	eastl::vector<Pending>                  m_pending;      // In order of the first action received for each path.
+	eastl::hash_map<uint64, uint>           m_pendingMap;   // Path hash -> index in m_pending.
+	eastl::vector<char>                     m_arena;        // Pending paths.
+	eastl::vector<char>                     m_batchArena;   // Batched paths (the previous m_arena).
+	eastl::vector<FileSystem::FileActionEvent> m_batch;
+
+}; // class FileActionCoalescer
+
+} // namespace apt
@@ -0,0 +1,493 @@
+#include <apt/FileIndex.h>
+
+#include <apt/hash.h>
+#include <apt/log.h>
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+#include <cstring>
+
+using namespace apt;
+
+namespace {
+	const char   kFileIndexMagic[4]  = { 'A', 'P', 'T', 'I' };
+	const uint32 kFileIndexVersion   = 2;
+
+	enum FileIndexFlags_
+	{
+		FileIndexFlags_ContentHash = 1 << 0
+	};
+
+	struct FileIndexHeader
+	{
+		char   m_magic[4];
+		uint32 m_version;
+		uint32 m_flags;
+		uint32 m_entryCount;
+		uint32 m_dirCount;
+		uint32 m_stringsSize;
+		uint32 m_rootLength;
+		uint32 m_pad;
+	};
+
+	template <typename tEntry>
+	bool LessPathHash(const tEntry& _a, const tEntry& _b)
+	{
+		return _a.m_pathHash < _b.m_pathHash;
+	}
+
+	template <typename tEntry>
+	const tEntry* FindPathHash(const tEntry* _begin, uint _count, uint64 _pathHash)
+	{
+		const tEntry* end = _begin + _count;
+		const tEntry* it = eastl::lower_bound(_begin, end, _pathHash, [](const tEntry& _entry, uint64 _hash) { return _entry.m_pathHash < _hash; });
+		return (it != end && it->m_pathHash == _pathHash) ? it : nullptr;
+	}
+
+	bool ContainsHash(const eastl::vector<uint64>& _sorted, uint64 _hash)
+	{
+		return eastl::binary_search(_sorted.begin(), _sorted.end(), _hash);
+	}
+
+	void SortUnique(eastl::vector<uint64>& _list)
+	{
+		eastl::sort(_list.begin(), _list.end());
+		_list.erase(eastl::unique(_list.begin(), _list.end()), _list.end());
+	}
+
+	typedef eastl::pair<uint64, uint64> HashPair;
+
+	// Return the first element of _sorted whose first member is _hash (or end).
+	const HashPair* LowerBound(const eastl::vector<HashPair>& _sorted, uint64 _hash)
+	{
+		return eastl::lower_bound(_sorted.begin(), _sorted.end(), _hash, [](const HashPair& _pair, uint64 _hash) { return _pair.first < _hash; });
+	}
+}
+
+// Results of scanDir(), merged into the index once all scans are done.
+struct FileIndex::Scan
+{
+	eastl::vector<Entry>  m_entries;
+	eastl::vector<Dir>    m_dirs;     // New dirs (not already in the index).
+	eastl::vector<char>   m_strings;  // Paths for m_dirs, offsets are relative to the end of the current string table.
+};
+
+// PUBLIC
+
+FileIndex::FileIndex()
+{
+	clear();
+}
+
+FileIndex::~FileIndex()
+{
+}
+
+bool FileIndex::build(const char* _path, bool _contentHash)
+{
+	clear();
+
+	m_root.set(_path);
+	while (m_root.getLength() > 1 && (m_root[m_root.getLength() - 1] == '/' || m_root[m_root.getLength() - 1] == '\\')) {
+		m_root.setLength(m_root.getLength() - 1);
+		m_root[m_root.getLength()] = '\0';
+	}
+	if (m_root.isEmpty()) {
+		m_root.set(".");
+	}
+	DateTime rootTime;
+	if (!FileSystem::GetTimeModifiedIfExists((const char*)m_root, rootTime)) {
+		APT_LOG_ERR("FileIndex::build: '%s' not found", _path);
+		clear();
+		return false;
+	}
+	m_contentHash = _contentHash;
+
+	Scan scan;
+	Dir root = { HashPath(""), 0, rootTime.getRaw(), 0, 0 };
+	scan.m_dirs.push_back(root);
+	scan.m_strings.push_back('\0');
+	scanDir("", scan, nullptr);
+
+	m_entryData.swap(scan.m_entries);
+	m_dirData.swap(scan.m_dirs);
+	m_stringData.swap(scan.m_strings);
+	eastl::sort(m_entryData.begin(), m_entryData.end(), LessPathHash<Entry>);
+	eastl::sort(m_dirData.begin(), m_dirData.end(), LessPathHash<Dir>);
+	updateTables();
+
+	return true;
+}
+
+uint FileIndex::refresh(bool _rescanAll)
+{
+	if (m_root.isEmpty()) {
+		return 0;
+	}
+
+	eastl::vector<uint64> rescan;
+	rescan.swap(m_dirtyDirs);
+	for (uint i = 0; i < m_dirCount; ++i) {
+		const Dir& dir = m_dirs[i];
+		if (_rescanAll) {
+			rescan.push_back(dir.m_pathHash);
+			continue;
+		}
+	 // deleted dirs are handled by rescanning the parent (whose modified time changes), except for the root
+		DateTime timeModified;
+		if (!FileSystem::GetTimeModifiedIfExists((const char*)makeFullPath(getDirPath(dir)), timeModified)) {
+			if (dir.m_pathLength == 0) {
+				rescan.push_back(dir.m_pathHash);
+			}
+			continue;
+		}
+		if (timeModified.getRaw() != dir.m_timeModified) {
+			rescan.push_back(dir.m_pathHash);
+		}
+	}
+	SortUnique(rescan);
+	if (rescan.empty()) {
+		return 0;
+	}
+
+ // (parent hash, path hash) for each dir except the root, sorted by parent
+	eastl::vector<HashPair> children;
+	children.reserve(m_dirCount);
+	for (uint i = 0; i < m_dirCount; ++i) {
+		if (m_dirs[i].m_pathLength != 0) {
+			children.push_back(eastl::make_pair(m_dirs[i].m_parentHash, m_dirs[i].m_pathHash));
+		}
+	}
+	eastl::sort(children.begin(), children.end());
+
+ // scan, the existing tables aren't modified until the merge below
+	Scan scan;
+	eastl::vector<uint64> rescanned;
+	eastl::vector<HashPair> rescannedTimes;
+	eastl::vector<uint64> removedDirs;
+	eastl::vector<uint64> subdirs;
+	for (uint64 dirHash : rescan) {
+		const Dir* dir = findDir(dirHash);
+		if (!dir) {
+			continue; // notify() was called for a path which isn't in the index
+		}
+		PathStr dirPath = makeFullPath(getDirPath(*dir));
+		DateTime timeModified;
+		subdirs.clear();
+		if (FileSystem::GetTimeModifiedIfExists((const char*)dirPath, timeModified)) {
+			scanDir(getDirPath(*dir), scan, &subdirs);
+			SortUnique(subdirs);
+			rescannedTimes.push_back(eastl::make_pair(dirHash, timeModified.getRaw()));
+		} else if (dir->m_pathLength != 0) {
+			continue; // the parent dir is rescanned
+		}
+		rescanned.push_back(dirHash);
+		for (const HashPair* child = LowerBound(children, dirHash); child != children.end() && child->first == dirHash; ++child) {
+			if (!ContainsHash(subdirs, child->second)) {
+				removedDirs.push_back(child->second);
+			}
+		}
+	}
+	SortUnique(rescanned);
+	eastl::sort(rescannedTimes.begin(), rescannedTimes.end());
+
+ // removed dirs include their subtrees (removedDirs grows as the subtrees are visited)
+	for (uint i = 0; i < (uint)removedDirs.size(); ++i) {
+		const uint64 removed = removedDirs[i];
+		for (const HashPair* child = LowerBound(children, removed); child != children.end() && child->first == removed; ++child) {
+			removedDirs.push_back(child->second);
+		}
+	}
+	SortUnique(removedDirs);
+
+ // count changes
+	uint ret = 0;
+	eastl::vector<uint64> scanned;
+	scanned.reserve(scan.m_entries.size());
+	for (auto& entry : scan.m_entries) {
+		const Entry* prev = find(entry.m_pathHash);
+		if (!prev || prev->m_size != entry.m_size || prev->m_timeModified != entry.m_timeModified) {
+			++ret;
+		}
+		scanned.push_back(entry.m_pathHash);
+	}
+	SortUnique(scanned);
+
+ // merge
+	makeMutable();
+	auto entriesEnd = eastl::remove_if(m_entryData.begin(), m_entryData.end(),
+		[&](const Entry& _entry) {
+			if (ContainsHash(rescanned, _entry.m_dirHash) || ContainsHash(removedDirs, _entry.m_dirHash)) {
+				if (!ContainsHash(scanned, _entry.m_pathHash)) {
+					++ret;
+				}
+				return true;
+			}
+			return false;
+		});
+	m_entryData.erase(entriesEnd, m_entryData.end());
+	m_entryData.insert(m_entryData.end(), scan.m_entries.begin(), scan.m_entries.end());
+	eastl::sort(m_entryData.begin(), m_entryData.end(), LessPathHash<Entry>);
+
+	auto dirsEnd = eastl::remove_if(m_dirData.begin(), m_dirData.end(),
+		[&](const Dir& _dir) {
+			return ContainsHash(removedDirs, _dir.m_pathHash);
+		});
+	m_dirData.erase(dirsEnd, m_dirData.end());
+	for (auto& dir : m_dirData) {
+		const HashPair* it = LowerBound(rescannedTimes, dir.m_pathHash);
+		if (it != rescannedTimes.end() && it->first == dir.m_pathHash) {
+			dir.m_timeModified = it->second;
+		}
+	}
+	m_dirData.insert(m_dirData.end(), scan.m_dirs.begin(), scan.m_dirs.end());
+	eastl::sort(m_dirData.begin(), m_dirData.end(), LessPathHash<Dir>);
+	m_stringData.insert(m_stringData.end(), scan.m_strings.begin(), scan.m_strings.end());
+
+	updateTables();
+
+	return ret;
+}
+
+void FileIndex::notify(const char* _path, FileSystem::FileAction _action)
+{
+	APT_UNUSED(_action); // any action may add/remove/modify entries in the parent dir
+	const char* name = FileSystem::FindFileNameAndExtension(_path);
+	PathStr dir;
+	if (name > _path) {
+		dir.set(_path);
+		dir.setLength((uint)(name - _path) - 1);
+		dir[dir.getLength()] = '\0';
+	}
+	m_dirtyDirs.push_back(HashPath((const char*)dir));
+}
+
+bool FileIndex::load(const char* _path, FileSystem::RootType _rootHint)
+{
+	clear();
+	if (!FileSystem::Read(m_file, _path, _rootHint)) {
+		return false;
+	}
+
+	const char* err = nullptr;
+	const char* data = m_file.getData();
+	const uint64 dataSize = m_file.getDataSize();
+	const FileIndexHeader* header = (const FileIndexHeader*)data;
+	if (dataSize < sizeof(FileIndexHeader) || memcmp(header->m_magic, kFileIndexMagic, sizeof(kFileIndexMagic)) != 0) {
+		err = "Not a file index";
+		goto FileIndex_load_end;
+	}
+	if (header->m_version != kFileIndexVersion) {
+		err = "Unsupported version";
+		goto FileIndex_load_end;
+	}
+	if (dataSize != sizeof(FileIndexHeader) + header->m_entryCount * sizeof(Entry) + header->m_dirCount * sizeof(Dir) + header->m_stringsSize + header->m_rootLength + 1) {
+		err = "Invalid file size";
+		goto FileIndex_load_end;
+	}
+
+	data += sizeof(FileIndexHeader);
+	m_entries     = (const Entry*)data;
+	m_entryCount  = header->m_entryCount;
+	data += m_entryCount * sizeof(Entry);
+	m_dirs        = (const Dir*)data;
+	m_dirCount    = header->m_dirCount;
+	data += m_dirCount * sizeof(Dir);
+	m_strings     = data;
+	m_stringsSize = header->m_stringsSize;
+	data += m_stringsSize;
+
+ // the tables are used in place, validate anything which is used as an offset or relied on by the binary searches (entries refer
+ // to dirs by hash and lookups tolerate missing dirs, hence there are no indices to check)
+	if (data[header->m_rootLength] != '\0') {
+		err = "Invalid root path";
+		goto FileIndex_load_end;
+	}
+	for (uint i = 0; i < m_dirCount; ++i) {
+		const Dir& dir = m_dirs[i];
+		if ((uint64)dir.m_pathOffset + dir.m_pathLength >= m_stringsSize || m_strings[dir.m_pathOffset + dir.m_pathLength] != '\0') {
+			err = "Invalid dir path";
+			goto FileIndex_load_end;
+		}
+		if (i > 0 && m_dirs[i - 1].m_pathHash > dir.m_pathHash) {
+			err = "Dir table isn't sorted";
+			goto FileIndex_load_end;
+		}
+	}
+	for (uint i = 1; i < m_entryCount; ++i) {
+		if (m_entries[i - 1].m_pathHash > m_entries[i].m_pathHash) {
+			err = "Entry table isn't sorted";
+			goto FileIndex_load_end;
+		}
+	}
+	m_root.set(data);
+	m_contentHash = (header->m_flags & FileIndexFlags_ContentHash) != 0;
+
+FileIndex_load_end:
+	if (err) {
+		APT_LOG_ERR("FileIndex::load: Error loading '%s':\n\t%s", _path, err);
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool FileIndex::save(const char* _path, FileSystem::RootType _root) const
+{
+ // dir paths are compacted (refresh() doesn't remove paths for deleted dirs from the string table)
+	uint stringsSize = 0;
+	for (uint i = 0; i < m_dirCount; ++i) {
+		stringsSize += m_dirs[i].m_pathLength + 1;
+	}
+
+	File f;
+	f.setDataSize(sizeof(FileIndexHeader) + m_entryCount * sizeof(Entry) + m_dirCount * sizeof(Dir) + stringsSize + m_root.getLength() + 1);
+	char* data = f.getData();
+
+	FileIndexHeader* header = (FileIndexHeader*)data;
+	memcpy(header->m_magic, kFileIndexMagic, sizeof(kFileIndexMagic));
+	header->m_version     = kFileIndexVersion;
+	header->m_flags       = m_contentHash ? FileIndexFlags_ContentHash : 0;
+	header->m_entryCount  = (uint32)m_entryCount;
+	header->m_dirCount    = (uint32)m_dirCount;
+	header->m_stringsSize = (uint32)stringsSize;
+	header->m_rootLength  = (uint32)m_root.getLength();
+	header->m_pad         = 0;
+	data += sizeof(FileIndexHeader);
+
+	memcpy(data, m_entries, m_entryCount * sizeof(Entry));
+	data += m_entryCount * sizeof(Entry);
+
+	Dir* dirs = (Dir*)data;
+	char* strings = data + m_dirCount * sizeof(Dir);
+	uint32 stringOffset = 0;
+	for (uint i = 0; i < m_dirCount; ++i) {
+		dirs[i] = m_dirs[i];
+		dirs[i].m_pathOffset = stringOffset;
+		memcpy(strings + stringOffset, getDirPath(m_dirs[i]), m_dirs[i].m_pathLength + 1);
+		stringOffset += m_dirs[i].m_pathLength + 1;
+	}
+	data = strings + stringsSize;
+
+	memcpy(data, (const char*)m_root, m_root.getLength() + 1);
+
+	return FileSystem::Write(f, _path, _root);
+}
+
+void FileIndex::clear()
+{
+	m_root.clear();
+	m_contentHash = false;
+	m_file.setData(nullptr, 0);
+	m_entryData.clear();
+	m_dirData.clear();
+	m_stringData.clear();
+	m_dirtyDirs.clear();
+	updateTables();
+}
+
+const FileIndex::Entry* FileIndex::find(const char* _path) const
+{
+	return find(HashPath(_path));
+}
+
+const FileIndex::Entry* FileIndex::find(uint64 _pathHash) const
+{
+	return FindPathHash(m_entries, m_entryCount, _pathHash);
+}
+
+DateTime FileIndex::getTimeModified(const char* _path) const
+{
+	const Entry* entry = find(_path);
+	return entry ? entry->getTimeModified() : DateTime();
+}
+
+uint64 FileIndex::HashPath(const char* _path)
+{
+	PathStr path;
+	path.set(_path);
+	path.replace('\\', '/');
+	return HashString<uint64>((const char*)path);
+}
+
+// PRIVATE
+
+const FileIndex::Dir* FileIndex::findDir(uint64 _pathHash) const
+{
+	return FindPathHash(m_dirs, m_dirCount, _pathHash);
+}
+
+PathStr FileIndex::makeFullPath(const char* _path) const
+{
+	if (*_path == '\0') {
+		return m_root;
+	}
+	return PathStr("%s/%s", (const char*)m_root, _path);
+}
+
+void FileIndex::makeMutable()
+{
+	if (!m_file.getData()) {
+		return;
+	}
+	m_entryData.assign(m_entries, m_entries + m_entryCount);
+	m_dirData.assign(m_dirs, m_dirs + m_dirCount);
+	m_stringData.assign(m_strings, m_strings + m_stringsSize);
+	m_file.setData(nullptr, 0);
+	updateTables();
+}
+
+void FileIndex::updateTables()
+{
+	m_entries     = m_entryData.data();
+	m_entryCount  = m_entryData.size();
+	m_dirs        = m_dirData.data();
+	m_dirCount    = m_dirData.size();
+	m_strings     = m_stringData.data();
+	m_stringsSize = m_stringData.size();
+}
+
+void FileIndex::scanDir(const char* _path, Scan& scan_, eastl::vector<uint64>* subdirs_) const
+{
+	const uint64 scanHash = HashPath(_path);
+	const uint rootLength = m_root.getLength();
+	FileSystem::Enumerate((const char*)makeFullPath(_path), [&](const FileSystem::DirEntry& _entry)
+		{
+		 // path relative to the root
+			const char* dir = strlen(_entry.m_dir) > rootLength ? _entry.m_dir + rootLength + 1 : "";
+			PathStr path = *dir ? PathStr("%s/%s", dir, _entry.m_name) : PathStr(_entry.m_name);
+			path.replace('\\', '/'); // paths in the index are '/' separated
+			const uint64 pathHash = HashPath((const char*)path);
+			const uint64 dirHash  = HashPath(dir);
+
+			if (_entry.m_isDir) {
+				if (subdirs_ && dirHash == scanHash) {
+					subdirs_->push_back(pathHash);
+				}
+				if (findDir(pathHash)) {
+					return FileSystem::EnumerateAction_SkipDir; // already in the index, rescanned separately if it changed
+				}
+				Dir newDir = { pathHash, dirHash, _entry.m_timeModified.getRaw(), (uint32)(m_stringsSize + scan_.m_strings.size()), (uint32)path.getLength() };
+				scan_.m_dirs.push_back(newDir);
+				scan_.m_strings.insert(scan_.m_strings.end(), (const char*)path, (const char*)path + path.getLength() + 1);
+				return FileSystem::EnumerateAction_Continue;
+			}
+
+			Entry newEntry = { pathHash, dirHash, _entry.m_size, _entry.m_timeModified.getRaw(), 0 };
+			if (m_contentHash) {
+				const Entry* prev = find(pathHash);
+				if (prev && prev->m_size == newEntry.m_size && prev->m_timeModified == newEntry.m_timeModified) {
+					newEntry.m_contentHash = prev->m_contentHash;
+				} else {
+					File f;
+					if (File::Read(f, (const char*)_entry.getPath())) {
+						newEntry.m_contentHash = HashData(f.getData(), f.getDataSize());
+					}
+				}
+			}
+			scan_.m_entries.push_back(newEntry);
+			return FileSystem::EnumerateAction_Continue;
+		},
+		true);
+}
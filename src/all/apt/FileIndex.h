@@ -0,0 +1,125 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/File.h>
+#include <apt/FileSystem.h>
+#include <apt/String.h>
+#include <apt/Time.h>
+
+#include <EASTL/vector.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// FileIndex
+// Snapshot of the file metadata (size, last modified time and optionally a
+// content hash) for a directory tree, stored as a table sorted by path hash.
+// Up-to-date checks on large numbers of files become table lookups instead of
+// a file system query per file.
+//
+// Paths are relative to the index root, with '/' as the separator. Lookups are
+// case sensitive.
+//
+// The table may be saved to disk; load() references the file data in place
+// (no per-entry parsing), a copy is only made when the index is modified by
+// refresh(). After loading, call refresh() to bring the index up to date:
+// - Each dir's last modified time is compared with the snapshot, which
+//   catches files/dirs being created, deleted or renamed. Only changed dirs are
+//   rescanned.
+// - Modifying a file doesn't update its parent dir's modified time, hence
+//   either forward notifications via notify() (dirs containing the notified
+//   paths are rescanned) or pass _rescanAll to refresh().
+//
+// FileIndex is not thread safe.
+////////////////////////////////////////////////////////////////////////////////
+class FileIndex: private non_copyable<FileIndex>
+{
+public:
+	struct Entry
+	{
+		uint64   m_pathHash;      // HashPath() of the path relative to the index root.
+		uint64   m_dirHash;       // HashPath() of the parent dir.
+		uint64   m_size;          // Size in bytes.
+		uint64   m_timeModified;  // Raw DateTime.
+		uint64   m_contentHash;   // Hash of the file data, 0 if the index was built without content hashes.
+
+		DateTime getTimeModified() const { return DateTime((sint64)m_timeModified); }
+	};
+
+	FileIndex();
+	~FileIndex();
+
+	// Scan _path (recursively) and rebuild the index. _path is used as-is (as per FileSystem::Enumerate()). If _contentHash
+	// is true, each file is read in order to compute m_contentHash. Return false if an error occurred.
+	bool         build(const char* _path, bool _contentHash = false);
+
+	// Update the index (see class description). Return the number of entries which were added, removed or modified.
+	uint         refresh(bool _rescanAll = false);
+
+	// Mark the dir containing _path for rescan on the next call to refresh(). _path is relative to the index root, hence
+	// this may be passed paths from a FileActionCallback if notifications were begun on getRoot().
+	void         notify(const char* _path, FileSystem::FileAction _action);
+
+	// Read/write the index from/to _path. Return false if an error occurred, in which case load() leaves the index empty.
+	bool         load(const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+	bool         save(const char* _path, FileSystem::RootType _root = FileSystem::RootType_Default) const;
+
+	void         clear();
+
+	// Return the entry for _path (relative to the index root), or nullptr if _path isn't in the index.
+	const Entry* find(const char* _path) const;
+	const Entry* find(uint64 _pathHash) const;
+	bool         exists(const char* _path) const           { return find(_path) != nullptr; }
+	// Return DateTime() if _path isn't in the index, as per FileSystem::GetTimeModified().
+	DateTime     getTimeModified(const char* _path) const;
+
+	const char*  getRoot() const                           { return (const char*)m_root; }
+	uint         getEntryCount() const                     { return m_entryCount; }
+	bool         hasContentHash() const                    { return m_contentHash; }
+
+	// Hash a path as stored in the index ('\' is treated as '/').
+	static uint64 HashPath(const char* _path);
+
+private:
+	struct Dir
+	{
+		uint64 m_pathHash;
+		uint64 m_parentHash;
+		uint64 m_timeModified;    // Raw DateTime.
+		uint32 m_pathOffset;      // Offset of the (null-terminated) relative path in m_strings.
+		uint32 m_pathLength;
+	};
+
+	PathStr              m_root;
+	bool                 m_contentHash;
+
+ // tables, either point into m_file (after load()) or to the m_*Data members
+	const Entry*          m_entries;
+	uint                  m_entryCount;
+	const Dir*            m_dirs;
+	uint                  m_dirCount;
+	const char*           m_strings;
+	uint                  m_stringsSize;
+
+	File                  m_file;
+	eastl::vector<Entry>  m_entryData;
+	eastl::vector<Dir>    m_dirData;
+	eastl::vector<char>   m_stringData;
+	eastl::vector<uint64> m_dirtyDirs; // Dirs to rescan on the next call to refresh().
+
+	const Dir*           findDir(uint64 _pathHash) const;
+	const char*          getDirPath(const Dir& _dir) const { return m_strings + _dir.m_pathOffset; }
+	PathStr              makeFullPath(const char* _path) const;
+
+	// Copy the tables out of m_file so that they can be modified.
+	void                 makeMutable();
+	void                 updateTables();
+
+	struct Scan;
+	// Enumerate _path (relative to the root) and append its files plus any dirs which aren't already in the index to scan_,
+	// recursing into the new dirs. If subdirs_ isn't nullptr it receives the hashes of all of _path's immediate subdirs.
+	void                 scanDir(const char* _path, Scan& scan_, eastl::vector<uint64>* subdirs_) const;
+
+}; // class FileIndex
+
+} // namespace apt
@@ -1,13 +1,89 @@
 #include <apt/FileSystem.h>
 
+#include <apt/hash.h>
 #include <apt/log.h>
 #include <apt/File.h>
 #include <apt/String.h>
 
+#include <EASTL/hash_map.h>
+#include <EASTL/list.h>
+#include <EASTL/sort.h>
+#include <EASTL/vector.h>
+
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#ifdef APT_COMPILER_GNU
+	#include <strings.h> // strcasecmp
+#endif
+#include <thread>
 
 using namespace apt;
 
+namespace {
+ // Resolved paths for FindExisting(), keyed by a hash of the relative path and root hint. An empty string is a 'not found' entry.
+	static eastl::hash_map<uint64, PathStr> s_PathCache;
+	static std::mutex                       s_PathCacheMutex;
+	static std::atomic<bool>                s_PathCacheEnabled(false); // Tested before locking, the uncached path doesn't touch the mutex.
+	static bool                             s_PathCacheCacheNotFound = false;
+
+	uint64 PathCacheKey(const char* _path, FileSystem::RootType _rootHint)
+	{
+		return HashString<uint64>(_path, Hash<uint64>(&_rootHint, sizeof(_rootHint)));
+	}
+
+ // Content cache for ReadCached(), in LRU order (most recently used at the front). Each entry holds a reference to data which is
+ // shared with any File returned by Read(), erasing an entry only releases the cache's reference.
+	struct ContentCacheEntry
+	{
+		uint64            m_key;
+		DateTime          m_timeModified;
+		File::SharedData* m_shared;
+	};
+	typedef eastl::list<ContentCacheEntry> ContentCacheList;
+	static ContentCacheList                                    s_ContentCache;
+	static eastl::hash_map<uint64, ContentCacheList::iterator> s_ContentCacheMap;
+	static std::mutex                                          s_ContentCacheMutex;
+	static uint64                                              s_ContentCacheBudget = 0;
+	static uint64                                              s_ContentCacheSize   = 0;
+	static bool                                                s_ContentCacheCheckTimeModified = true;
+
+ // Hash _path with separators normalized, such that paths constructed by MakePath() and paths from file action notifications match.
+	uint64 ContentCacheKey(const char* _path)
+	{
+		if (_path[0] == '.' && (_path[1] == '/' || _path[1] == '\\')) {
+			_path += 2;
+		}
+		char buf[512];
+		uint n = 0;
+		for (; *_path && n < sizeof(buf); ++_path) {
+			char c = *_path == '\\' ? '/' : *_path;
+			if (c == '/' && n > 0 && buf[n - 1] == '/') {
+				continue;
+			}
+			buf[n++] = c;
+		}
+		uint64 ret = Hash<uint64>(buf, n);
+		return *_path ? HashString<uint64>(_path, ret) : ret; // path longer than buf, hash the remainder as-is
+	}
+
+	void ContentCacheErase(ContentCacheList::iterator _it)
+	{
+		s_ContentCacheSize -= _it->m_shared->m_size;
+		File::SharedData::Release(_it->m_shared);
+		s_ContentCacheMap.erase(_it->m_key);
+		s_ContentCache.erase(_it);
+	}
+
+	void ContentCacheEvict(uint64 _budget)
+	{
+		while (!s_ContentCache.empty() && s_ContentCacheSize > _budget) {
+			ContentCacheErase(--s_ContentCache.end());
+		}
+	}
+}
+
 // PUBLIC
 
 const char* FileSystem::GetRoot(RootType _type)
@@ -18,6 +94,7 @@ const char* FileSystem::GetRoot(RootType _type)
 void FileSystem::SetRoot(RootType _type, const char* _path)
 {
 	s_roots[_type].set(_path);
+	FlushPathCache();
 }
 
 bool FileSystem::Read(File& file_, const char* _path, RootType _rootHint)
@@ -28,7 +105,7 @@ bool FileSystem::Read(File& file_, const char* _path, RootType _rootHint)
 		//APT_ASSERT(false);
 		return false;
 	}
-	return File::Read(file_, (const char*)fullPath);
+	return ReadCached(file_, (const char*)fullPath);
 }
 
 bool FileSystem::ReadIfExists(File& file_, const char* _path, RootType _rootHint)
@@ -37,26 +114,92 @@ bool FileSystem::ReadIfExists(File& file_, const char* _path, RootType _rootHint
 	if (!FindExisting(fullPath, _path ? _path : file_.getPath(), _rootHint)) {
 		return false;
 	}
-	return File::Read(file_, (const char*)fullPath);
+	return ReadCached(file_, (const char*)fullPath);
 }
 
 bool FileSystem::Write(const File& _file, const char* _path, RootType _root)
 {
 	PathStr fullPath = MakePath(_path ? _path : _file.getPath(), _root);
+	FlushPathCache();
+	InvalidateContentCache((const char*)fullPath);
 	return File::Write(_file, (const char*)fullPath);
 }
 
+bool FileSystem::Append(const File& _file, const char* _path, RootType _root)
+{
+	PathStr fullPath = MakePath(_path ? _path : _file.getPath(), _root);
+	FlushPathCache();
+	InvalidateContentCache((const char*)fullPath);
+	return File::Append(_file, (const char*)fullPath);
+}
+
 bool FileSystem::Exists(const char* _path, RootType _rootHint)
 {
 	PathStr buf;
 	return FindExisting(buf, _path, _rootHint);
 }
 
+void FileSystem::FlushPathCache()
+{
+	if (!s_PathCacheEnabled) { // the cache is cleared when disabled
+		return;
+	}
+	std::lock_guard<std::mutex> lock(s_PathCacheMutex);
+	s_PathCache.clear();
+}
+
+void FileSystem::SetPathCacheEnabled(bool _enabled, bool _cacheNotFound)
+{
+	std::lock_guard<std::mutex> lock(s_PathCacheMutex);
+	s_PathCacheEnabled = _enabled;
+	s_PathCacheCacheNotFound = _cacheNotFound;
+	s_PathCache.clear();
+}
+
+void FileSystem::SetContentCache(uint64 _budgetBytes, bool _checkTimeModified)
+{
+	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+	s_ContentCacheBudget = _budgetBytes;
+	s_ContentCacheCheckTimeModified = _checkTimeModified;
+	ContentCacheEvict(_budgetBytes);
+}
+
+uint64 FileSystem::GetContentCacheBudget()
+{
+	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+	return s_ContentCacheBudget;
+}
+
+uint64 FileSystem::GetContentCacheSize()
+{
+	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+	return s_ContentCacheSize;
+}
+
+void FileSystem::InvalidateContentCache(const char* _path)
+{
+	const uint64 key = _path ? ContentCacheKey((const char*)GetAbsolutePath(_path)) : 0;
+	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+	if (!_path) {
+		ContentCacheEvict(0);
+		return;
+	}
+	auto it = s_ContentCacheMap.find(key);
+	if (it != s_ContentCacheMap.end()) {
+		ContentCacheErase(it->second);
+	}
+}
+
 bool FileSystem::Matches(const char* _pattern, const char* _str)
+{
+	return Matches(_pattern, (uint)strlen(_pattern), _str, (uint)strlen(_str));
+}
+
+bool FileSystem::Matches(const char* _pattern, uint _patternLength, const char* _str, uint _strLength)
 {
 // based on https://research.swtch.com/glob
-	const size_t plen = strlen(_pattern);
-	const size_t nlen = strlen(_str);
+	const size_t plen = _patternLength;
+	const size_t nlen = _strLength;
 	size_t px = 0;
 	size_t nx = 0;
 	size_t nextPx = 0;
@@ -183,7 +326,11 @@ bool FileSystem::CompareExtension(const char* _ext, const char* _path)
 	}
 	const char* cmp = FindExtension(_path);
 	if (cmp) {
+#ifdef APT_COMPILER_MSVC
 		return _stricmp(_ext, cmp) == 0;
+#else
+		return strcasecmp(_ext, cmp) == 0;
+#endif
 	}
 	return false;
 }
@@ -200,17 +347,198 @@ const char* FileSystem::FindFileNameAndExtension(const char* _path)
 	return ret;
 }
 
+int FileSystem::ListFiles(PathStr retList_[], int _maxResults, const char* _path, std::initializer_list<const char*> _filterList, bool _recursive)
+{
+	return ListFiles(retList_, _maxResults, _path, GlobSet(_filterList), _recursive);
+}
+
+int FileSystem::ListDirs(PathStr retList_[], int _maxResults, const char* _path, std::initializer_list<const char*> _filterList, bool _recursive)
+{
+	return ListDirs(retList_, _maxResults, _path, GlobSet(_filterList), _recursive);
+}
+
+int FileSystem::ListFilesParallel(eastl::vector<PathStr>& retList_, const char* _path, std::initializer_list<const char*> _filterList, int _threadCount, bool _sorted)
+{
+	return ListFilesParallel(retList_, _path, GlobSet(_filterList), _threadCount, _sorted);
+}
+
+int FileSystem::ListFilesParallel(eastl::vector<PathStr>& retList_, const char* _path, const GlobSet& _filter, int _threadCount, bool _sorted)
+{
+	if (_threadCount <= 0) {
+		_threadCount = (int)std::thread::hardware_concurrency();
+		_threadCount = _threadCount > 0 ? _threadCount : 1;
+	}
+
+ // shared queue of dirs to read; pendingCount is the number of dirs which are queued or currently being read
+	std::mutex              mutex;
+	std::condition_variable cv;
+	eastl::vector<PathStr>  queue;
+	int                     pendingCount = 1;
+	queue.push_back(PathStr());
+	queue.back().set(_path);
+
+	eastl::vector<eastl::vector<PathStr> > results(_threadCount);
+	auto worker = [&](int _threadIndex)
+	{
+		eastl::vector<PathStr>& files = results[_threadIndex];
+		eastl::vector<PathStr>  subdirs;
+		for (;;) {
+			PathStr dir;
+			{	std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&]{ return !queue.empty() || pendingCount == 0; });
+				if (queue.empty()) {
+					return; // pendingCount == 0, all done
+				}
+				dir = (PathStr&&)queue.back();
+				queue.pop_back();
+			}
+
+			Enumerate((const char*)dir, [&](const DirEntry& _entry)
+				{
+					if (_entry.m_isDir) {
+						subdirs.push_back(_entry.getPath());
+					} else if (_filter.matches(_entry.m_name)) {
+						files.push_back(_entry.getPath());
+					}
+					return EnumerateAction_Continue;
+				});
+
+			bool done = false;
+			{	std::lock_guard<std::mutex> lock(mutex);
+				for (auto& subdir : subdirs) {
+					queue.push_back((PathStr&&)subdir);
+				}
+				pendingCount += (int)subdirs.size() - 1;
+				done = pendingCount == 0;
+			}
+			if (done || subdirs.size() > 1) {
+				cv.notify_all();
+			} else if (!subdirs.empty()) {
+				cv.notify_one();
+			}
+			subdirs.clear();
+		}
+	};
+
+	eastl::vector<std::thread> threads;
+	for (int i = 1; i < _threadCount; ++i) {
+		threads.push_back(std::thread(worker, i));
+	}
+	worker(0);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	int ret = 0;
+	const size_t first = retList_.size();
+	for (auto& files : results) {
+		ret += (int)files.size();
+		for (auto& file : files) {
+			retList_.push_back((PathStr&&)file);
+		}
+	}
+	if (_sorted) {
+		eastl::sort(retList_.begin() + first, retList_.end());
+	}
+	return ret;
+}
+
 // PRIVATE
 
 PathStr FileSystem::s_roots[RootType_Count];
 
 bool FileSystem::FindExisting(PathStr& ret_, const char* _path, RootType _rootHint)
 {
-	for (int r = (int)_rootHint; r != -1; --r) {
+	const bool useCache = s_PathCacheEnabled;
+	uint64 key = 0;
+	if (useCache) {
+		key = PathCacheKey(_path, _rootHint);
+		std::lock_guard<std::mutex> lock(s_PathCacheMutex);
+		auto it = s_PathCache.find(key);
+		if (it != s_PathCache.end()) {
+			ret_ = it->second;
+			return !ret_.isEmpty();
+		}
+	}
+
+	bool ret = false;
+	int r = (int)_rootHint;
+	for (; r != -1; --r) {
 		ret_ = MakePath(_path, (RootType)r);
 		if (File::Exists((const char*)ret_)) {
-			return true;
+			ret = true;
+			break;
 		}
 	}
-	return false;
+
+	if (useCache) {
+		std::lock_guard<std::mutex> lock(s_PathCacheMutex);
+		if (s_PathCacheEnabled) { // may have been disabled (and cleared) during the search
+		 // a miss, or a hit in a lower priority root (which implies a miss in the higher priority roots), is only cached if
+		 // 'not found' results are cached
+			if (r == (int)_rootHint || s_PathCacheCacheNotFound) {
+				s_PathCache[key] = ret ? ret_ : PathStr();
+			}
+		}
+	}
+	return ret;
+}
+
+bool FileSystem::ReadCached(File& file_, const char* _fullPath)
+{
+	uint64 budget;
+	bool checkTimeModified;
+	{	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+		budget = s_ContentCacheBudget;
+		checkTimeModified = s_ContentCacheCheckTimeModified;
+	}
+	if (budget == 0) {
+		return File::Read(file_, _fullPath);
+	}
+
+	const uint64 key = ContentCacheKey((const char*)GetAbsolutePath(_fullPath));
+	DateTime timeModified;
+	if (checkTimeModified && !GetTimeModifiedIfExists(_fullPath, timeModified)) {
+		InvalidateContentCache(_fullPath);
+		return File::Read(file_, _fullPath); // file was deleted, let File::Read() handle the error
+	}
+
+	{	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+		auto it = s_ContentCacheMap.find(key);
+		if (it != s_ContentCacheMap.end()) {
+			ContentCacheEntry& entry = *it->second;
+			if (!checkTimeModified || entry.m_timeModified.getRaw() == timeModified.getRaw()) {
+				s_ContentCache.splice(s_ContentCache.begin(), s_ContentCache, it->second); // move to front
+				file_.setShared(entry.m_shared);
+				file_.setPath(_fullPath);
+				return true;
+			}
+			ContentCacheErase(it->second); // stale
+		}
+	}
+
+	if (!File::ReadShared(file_, _fullPath, budget)) {
+		return false;
+	}
+	if (!file_.m_shared) {
+		return true; // exceeds the budget
+	}
+	File::SharedData* shared = file_.m_shared;
+	const uint64 size = file_.getDataSize();
+
+	std::lock_guard<std::mutex> lock(s_ContentCacheMutex);
+	auto it = s_ContentCacheMap.find(key);
+	if (it != s_ContentCacheMap.end()) {
+		ContentCacheErase(it->second); // another thread read the file concurrently
+	}
+	ContentCacheEntry entry;
+	entry.m_key = key;
+	entry.m_timeModified = timeModified;
+	entry.m_shared = shared;
+	File::SharedData::AddRef(shared);
+	s_ContentCache.push_front(entry);
+	s_ContentCacheMap[key] = s_ContentCache.begin();
+	s_ContentCacheSize += size;
+	ContentCacheEvict(s_ContentCacheBudget);
+	return true;
 }
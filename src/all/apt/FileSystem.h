@@ -2,9 +2,13 @@
 
 #include <apt/apt.h>
 #include <apt/File.h>
+#include <apt/GlobSet.h>
 #include <apt/String.h>
 #include <apt/Time.h>
 
+#include <EASTL/functional.h>
+#include <EASTL/vector.h>
+
 #include <initializer_list>
 
 namespace apt {
@@ -48,11 +52,20 @@ public:
 	// any existing file at _path may or may not have been overwritten. _root is ignored if _path is absolute.
 	static bool        Write(const File& _file, const char* _path = nullptr, RootType _root = RootType_Default);
 
+	// As Write() but append to the file at _path, which is created if it doesn't exist.
+	static bool        Append(const File& _file, const char* _path = nullptr, RootType _root = RootType_Default);
+
 	// Return true if _path exists. Each root is searched, beginning at _rootHint.
 	static bool        Exists(const char* _path, RootType _rootHint = RootType_Default);
 
 	// Delete a file.
 	static bool        Delete(const char* _path);
+	// Delete the dir specified by _path and its contents (recursively). Return false if an error occurred.
+	static bool        DeleteDir(const char* _path);
+
+	// Rename/move a file, replacing any existing file at _newPath (atomically if both paths are on the same volume). Paths are used as-is.
+	// Return false if an error occurred.
+	static bool        Rename(const char* _path, const char* _newPath);
 
 	// Get the creation/last modified time for a file. The path is constructed as per Read(). 
 	static DateTime    GetTimeCreated(const char* _path, RootType _rootHint = RootType_Default);
@@ -62,6 +75,25 @@ public:
 	// If _path contains only directory names, it must end in a path separator (e.g. "dir0/dir1/").
 	static bool        CreateDir(const char* _path);
 
+	// If enabled, paths resolved by Read(), ReadIfExists(), Exists() and GetTime*() are cached (disabled by default). The cache is
+	// flushed by SetRoot(), Write(), Delete() and when a FileAction_Created/FileAction_Deleted notification is dispatched. Call 
+	// FlushPathCache() if files may have been created or deleted by some other means.
+	// If _cacheNotFound is true, 'not found' results (and paths found in a lower priority root than the root hint) are also cached.
+	// Only do this if files are never created outside FileSystem, or if notifications are active for the root directories.
+	static void        FlushPathCache();
+	static void        SetPathCacheEnabled(bool _enabled, bool _cacheNotFound = false);
+
+	// Files loaded by Read() and ReadIfExists() are cached in memory (keyed by the resolved path) up to _budgetBytes, the least recently
+	// used files are evicted first. Cached data is shared with File instances without copying (see File). Entries are invalidated by 
+	// Write(), Delete() and file action notifications; if _checkTimeModified is true the file's modified time is also checked on each
+	// read (else reading a cached file doesn't touch the file system). A budget of 0 disables the cache (the default).
+	static void        SetContentCache(uint64 _budgetBytes, bool _checkTimeModified = true);
+	static uint64      GetContentCacheBudget();
+	// Return the total size of the cached files in bytes.
+	static uint64      GetContentCacheSize();
+	// Invalidate the cache entry for _path (as resolved by Read()), or all entries if _path is 0.
+	static void        InvalidateContentCache(const char* _path = nullptr);
+
  // Path manipulation
 
 	// Concatenate _path + s_separator + s_root[_root]. _root is ignored if _path is absolute.
@@ -69,7 +101,8 @@ public:
 
 	// Match _str against _pattern with wildcard characters: '?' matches a single character, '*' matches zero or more characters.
 	static bool        Matches(const char* _pattern, const char* _str);
-	// Call Matches() for each of a list of patterns e.g. { "*.txt", "*.png" }.	
+	static bool        Matches(const char* _pattern, uint _patternLength, const char* _str, uint _strLength);
+	// Call Matches() for each of a list of patterns e.g. { "*.txt", "*.png" }. Prefer GlobSet when matching many strings against the same list.
 	static bool        MatchesMulti(std::initializer_list<const char*> _patternList, const char* _str);
 
 	// Make _path relative to _root.
@@ -104,8 +137,45 @@ public:
 
 	// List up to _maxResults files in _path, with optional recursion. Return the number of files which would be found if not limited by _maxResults.
 	static int         ListFiles(PathStr retList_[], int _maxResults, const char* _path, std::initializer_list<const char*> _filterList = { "*" }, bool _recursive = false);
+	static int         ListFiles(PathStr retList_[], int _maxResults, const char* _path, const GlobSet& _filter, bool _recursive = false);
 	// List up to _maxResults dirs in _path, with optional recursion. _filters is a null-separated list of filter strings. Return the number of dirs which would be found if not limited by _maxResults.
 	static int         ListDirs(PathStr retList_[], int _maxResults, const char* _path, std::initializer_list<const char*> _filterList= { "*" }, bool _recursive = false);
+	static int         ListDirs(PathStr retList_[], int _maxResults, const char* _path, const GlobSet& _filter, bool _recursive = false);
+
+
+	// As ListFiles() with recursion, but subdirs are distributed between _threadCount worker threads (0 = use the hardware thread count).
+	// Results are appended to retList_, sorted if _sorted is true (else the order is nondeterministic). Paths are as returned by ListFiles().
+	// Return the number of files found.
+	static int         ListFilesParallel(eastl::vector<PathStr>& retList_, const char* _path, std::initializer_list<const char*> _filterList = { "*" }, int _threadCount = 0, bool _sorted = false);
+	static int         ListFilesParallel(eastl::vector<PathStr>& retList_, const char* _path, const GlobSet& _filter, int _threadCount = 0, bool _sorted = false);
+
+	// Entry passed to the Enumerate() callback. m_dir and m_name are only valid for the duration of the callback.
+	struct DirEntry
+	{
+		const char* m_dir;           // Path of the parent dir (_path as passed to Enumerate() plus any subdirs, separators as per ListFiles()).
+		const char* m_name;          // File/dir name without the path.
+		bool        m_isDir;
+		uint64      m_size;          // Size in bytes, 0 for dirs.
+		DateTime    m_timeModified;
+
+		// Construct the full path (m_dir + separator + m_name), this matches the path returned by ListFiles() for the same file.
+		PathStr     getPath() const;
+	};
+	enum EnumerateAction_
+	{
+		EnumerateAction_Continue,    // Continue, recurse into the current entry if it's a dir and recursion is enabled.
+		EnumerateAction_SkipDir,     // Continue, but don't recurse into the current entry (i.e. prune the subtree).
+		EnumerateAction_Stop,        // Stop the enumeration immediately.
+
+		EnumerateAction_Count
+	};
+	typedef int EnumerateAction;
+	typedef eastl::function<EnumerateAction(const DirEntry& _entry)> EnumerateCallback;
+
+	// Call _callback for each file and dir in _path, with optional (depth-first) recursion. Entries are passed to _callback as they're 
+	// read from the file system; no list is built and no full path strings are constructed unless requested via DirEntry::getPath().
+	// Return false if the enumeration was stopped by _callback.
+	static bool        Enumerate(const char* _path, const EnumerateCallback& _callback, bool _recursive = false);
 
 
  // File action notifications
@@ -122,20 +192,44 @@ public:
 
 	typedef void (FileActionCallback)(const char* _path, FileAction _action);
 
+	struct FileActionEvent
+	{
+		const char* m_path;          // Path relative to the watched dir.
+		FileAction  m_action;
+	};
+	typedef void (FileActionBatchCallback)(const char* _dir, const FileActionEvent* _events, uint _eventCount);
+
 	// Begin receiving notifications for changes to _dir (and its subtree). _callback will be called once for each event. See DispatchNotifcations().
 	static void        BeginNotifications(const char* _dir, FileActionCallback* _callback);
+	// Begin receiving batched notifications for changes to _dir (and its subtree). Actions are coalesced per path (see FileActionCoalescer),
+	// a path is delivered once no further actions have been received for it within _coalesceMs. _callback is called from a background thread
+	// (DispatchNotifications() isn't required) and must not call Begin/EndNotifications().
+	static void        BeginNotifications(const char* _dir, FileActionBatchCallback* _callback, uint _coalesceMs = 100);
 	// Stop receiving notifications for changes to _dir.
 	static void        EndNotifications(const char* _dir);
-	// Dispatch file action notifications. If _dir is 0, dispatch to all registered callbacks. This should be called frequently.
+	// Dispatch file action notifications to FileActionCallbacks. If _dir is 0, dispatch to all registered callbacks. Actions received since
+	// the previous call are coalesced per path. This should be called frequently.
 	static void        DispatchNotifications(const char* _dir = nullptr);
 
 private:
+	friend class FileIndex;
+
 	static PathStr    s_roots[RootType_Count];
 	static const char s_separator; // per-platform default separator
 	
 	// Get a path to an existing file based on _path and _rootHint. Return false if no existing file was found.
 	static bool FindExisting(PathStr& ret_, const char* _path, RootType _rootHint);
 
+	// Get the last modified time for _path as-is (no root search, no path cache). Return false if _path doesn't exist.
+	static bool GetTimeModifiedIfExists(const char* _path, DateTime& ret_);
+
+	// Get the absolute path for _path (relative paths are resolved against the working directory). Content cache entries are keyed by
+	// the absolute path, such that Delete()/Rename() via a relative path invalidate entries read via a root.
+	static PathStr GetAbsolutePath(const char* _path);
+
+	// Read _fullPath via the content cache, if enabled.
+	static bool ReadCached(File& file_, const char* _fullPath);
+
 };
 
 } // namespace apt
@@ -0,0 +1,149 @@
+#include <apt/GlobSet.h>
+
+#include <apt/hash.h>
+#include <apt/FileSystem.h>
+
+#include <cstring>
+
+using namespace apt;
+
+// PUBLIC
+
+GlobSet::GlobSet(std::initializer_list<const char*> _patternList)
+{
+	for (auto& pattern : _patternList) {
+		add(pattern);
+	}
+}
+
+void GlobSet::add(const char* _pattern)
+{
+	APT_ASSERT(_pattern);
+	const uint len = (uint)strlen(_pattern);
+
+	Pattern pattern;
+	pattern.m_offset = (uint)m_strings.size();
+	pattern.m_length = len;
+	pattern.m_prefixLength = 0;
+	pattern.m_suffixLength = 0;
+	pattern.m_minLength = 0;
+	pattern.m_prefixSuffix = false;
+	
+	uint starCount = 0;
+	uint questionCount = 0;
+	uint firstWildcard = len;
+	uint lastWildcard = len;
+	for (uint i = 0; i < len; ++i) {
+		char c = _pattern[i];
+		if (c == '*' || c == '?') {
+			firstWildcard = firstWildcard == len ? i : firstWildcard;
+			lastWildcard = i;
+			if (c == '*') {
+				++starCount;
+			} else {
+				++questionCount;
+			}
+		}
+	}
+	if (len > 0 && starCount == len) {
+		m_matchAll = true;
+		return;
+	}
+	m_strings.insert(m_strings.end(), _pattern, _pattern + len);
+	pattern.m_minLength = len - starCount;
+
+	if (firstWildcard == len) {
+	 // literal
+		pattern.m_prefixLength = len;
+		m_literals.insert(eastl::make_pair(Hash<uint64>(_pattern, len), pattern));
+		return;
+	}
+
+	pattern.m_prefixLength = firstWildcard;
+	pattern.m_suffixLength = len - lastWildcard - 1;
+	if (starCount == 1 && questionCount == 0) {
+		pattern.m_prefixSuffix = true;
+		const char* suffix = _pattern + lastWildcard + 1;
+		if (firstWildcard == 0 && suffix[0] == '.' && suffix[1] != '\0' && !strchr(suffix + 1, '.')) {
+		 // extension only
+			m_extensions.insert(eastl::make_pair(Hash<uint64>(suffix + 1, pattern.m_suffixLength - 1), pattern));
+			return;
+		}
+	}
+	m_patterns.push_back(pattern);
+}
+
+void GlobSet::clear()
+{
+	m_matchAll = false;
+	m_strings.clear();
+	m_literals.clear();
+	m_extensions.clear();
+	m_patterns.clear();
+}
+
+bool GlobSet::matches(const char* _str) const
+{
+	return matches(_str, (uint)strlen(_str));
+}
+
+bool GlobSet::matches(const char* _str, uint _strLength) const
+{
+	if (m_matchAll) {
+		return true;
+	}
+
+	if (!m_literals.empty() && matchesLookup(m_literals, 0, _str, _strLength)) {
+		return true;
+	}
+
+	if (!m_extensions.empty()) {
+		const char* ext = _str + _strLength;
+		while (ext != _str && *(ext - 1) != '.') {
+			--ext;
+		}
+		if (ext != _str && matchesLookup(m_extensions, 2, ext, (uint)(_str + _strLength - ext))) {
+			return true;
+		}
+	}
+
+	for (auto& pattern : m_patterns) {
+		if (_strLength < pattern.m_minLength) {
+			continue;
+		}
+		const char* str = getString(pattern);
+		if (memcmp(_str, str, pattern.m_prefixLength) != 0) {
+			continue;
+		}
+		if (memcmp(_str + _strLength - pattern.m_suffixLength, str + pattern.m_length - pattern.m_suffixLength, pattern.m_suffixLength) != 0) {
+			continue;
+		}
+		if (pattern.m_prefixSuffix) {
+			return true;
+		}
+	 // match the remainder of the pattern against the remainder of the string
+		const uint pbeg = pattern.m_prefixLength;
+		const uint pend = pattern.m_length - pattern.m_suffixLength;
+		const uint sbeg = pattern.m_prefixLength;
+		const uint send = _strLength - pattern.m_suffixLength;
+		if (FileSystem::Matches(str + pbeg, pend - pbeg, _str + sbeg, send - sbeg)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// PRIVATE
+
+bool GlobSet::matchesLookup(const eastl::hash_multimap<uint64, Pattern>& _map, uint _patternOffset, const char* _str, uint _strLength) const
+{
+	auto range = _map.equal_range(Hash<uint64>(_str, _strLength));
+	for (auto it = range.first; it != range.second; ++it) {
+		const Pattern& pattern = it->second;
+		if (pattern.m_length - _patternOffset == _strLength && memcmp(getString(pattern) + _patternOffset, _str, _strLength) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
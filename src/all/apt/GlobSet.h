@@ -0,0 +1,62 @@
+#pragma once
+
+#include <apt/apt.h>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+
+#include <initializer_list>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// GlobSet
+// A list of wildcard patterns (see FileSystem::Matches()) compiled once for 
+// repeated matching, e.g. during directory scans. Patterns are classified as 
+// they're added:
+// - Literal ("file.txt") and extension-only ("*.txt") patterns are matched via
+//   a single hash lookup, regardless of the number of patterns.
+// - Other patterns reject candidates on length and literal prefix/suffix before
+//   running the wildcard matcher on the remaining part of the string. Patterns
+//   of the form "prefix*suffix" are fully resolved by the prefix/suffix test.
+// Matching is case sensitive, as FileSystem::Matches().
+////////////////////////////////////////////////////////////////////////////////
+class GlobSet
+{
+public:
+	GlobSet() = default;
+	GlobSet(std::initializer_list<const char*> _patternList);
+
+	void add(const char* _pattern);
+	void clear();
+
+	// Return true if _str matches any pattern in the set.
+	bool matches(const char* _str) const;
+	bool matches(const char* _str, uint _strLength) const;
+
+	bool isEmpty() const    { return !m_matchAll && m_literals.empty() && m_extensions.empty() && m_patterns.empty(); }
+
+private:
+	struct Pattern
+	{
+		uint m_offset;        // Offset of the pattern string in m_strings.
+		uint m_length;
+		uint m_prefixLength;  // Length of the literal prefix (before the first wildcard).
+		uint m_suffixLength;  // Length of the literal suffix (after the last wildcard).
+		uint m_minLength;     // Min length of a matching string (number of non-'*' characters).
+		bool m_prefixSuffix;  // Pattern is fully resolved by the prefix/suffix test (single '*', no '?').
+	};
+
+	bool                                  m_matchAll = false; // Set contains "*".
+	eastl::vector<char>                   m_strings;          // Pattern strings (not null-terminated).
+	eastl::hash_multimap<uint64, Pattern> m_literals;         // Literal patterns, keyed by hash of the whole pattern.
+	eastl::hash_multimap<uint64, Pattern> m_extensions;       // "*.ext" patterns, keyed by hash of the extension.
+	eastl::vector<Pattern>                m_patterns;         // Other patterns.
+
+	const char* getString(const Pattern& _pattern) const { return m_strings.data() + _pattern.m_offset; }
+	// Find _str in _map, compare with the pattern string from _patternOffset (skip "*." for extension patterns).
+	bool        matchesLookup(const eastl::hash_multimap<uint64, Pattern>& _map, uint _patternOffset, const char* _str, uint _strLength) const;
+	
+}; // class GlobSet
+
+} // namespace apt
@@ -728,12 +728,13 @@ bool Image::ReadExr(Image& img_, const char* _data, uint _dataSize)
 	img_.m_compression = Compression_None;
 	img_.alloc();
 
-	float* data = (float*)img_.m_data;
-	for (uint i = 0, n = img_.m_width * img_.m_height; i < n; ++i) {
-	 // \hack read the channels in reverse order (convert ABGR -> RGBA)
-	 // \todo inspect the channel names directly
-		for (int j = exr.num_channels - 1; j >= 0; --j, ++data) {
-			*data = ((float*)exr.images[j])[i];
+	{	float* data = (float*)img_.m_data;
+		for (uint i = 0, n = img_.m_width * img_.m_height; i < n; ++i) {
+		 // \hack read the channels in reverse order (convert ABGR -> RGBA)
+		 // \todo inspect the channel names directly
+			for (int j = exr.num_channels - 1; j >= 0; --j, ++data) {
+				*data = ((float*)exr.images[j])[i];
+			}
 		}
 	}
 
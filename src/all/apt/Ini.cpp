@@ -120,11 +120,11 @@ void Ini::pushSection(const char* _name)
 #define APT_Ini_pushValueArray(_type, _typeEnum, _valueMember) \
 	template <> void Ini::pushValueArray<_type>(const char* _name, const _type _value[], int _count) { \
 		APT_ASSERT_MSG(findKey(_name, &m_sections.back()) == 0, "Ini::pushValue: '%s' already exists in section '%s'", _name, m_sections.back().m_name.isEmpty() ? "default" : (const char*)m_sections.back().m_name); \
-		Key key = { NameStr(_name), ValueType:: ## _typeEnum, _count, (int)m_values.size() }; \
+		Key key = { NameStr(_name), ValueType::_typeEnum, _count, (int)m_values.size() }; \
 		m_keys.push_back(key); \
 		for (int i = 0; i < _count; ++i) { \
 			m_values.push_back(Value()); \
-			m_values.back(). ## _valueMember = _value[i]; \
+			m_values.back()._valueMember = _value[i]; \
 		} \
 		++m_sections.back().m_propertyCount; \
 	}
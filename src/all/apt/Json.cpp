@@ -1,5 +1,9 @@
 #include <apt/Json.h>
+#include <apt/JsonImpl.h>
+#include <apt/JsonReader.h>
+#include <apt/JsonWriter.h>
 
+#include <apt/base64.h>
 #include <apt/log.h>
 #include <apt/math.h>
 #include <apt/memory.h>
@@ -11,141 +15,265 @@
 
 #include <cstring>
 
-#define RAPIDJSON_ASSERT(x) APT_ASSERT(x)
-#define RAPIDJSON_PARSE_DEFAULT_FLAGS (kParseFullPrecisionFlag | kParseCommentsFlag | kParseTrailingCommasFlag)
-#include <rapidjson/error/en.h>
-#include <rapidjson/document.h>
-#include <rapidjson/prettywriter.h>
-
 using namespace apt;
 
-static Json::ValueType GetValueType(rapidjson::Type _type)
-{
-	switch (_type) {
-		case rapidjson::kNullType:   return Json::ValueType_Null;
-		case rapidjson::kObjectType: return Json::ValueType_Object;
-		case rapidjson::kArrayType:  return Json::ValueType_Array;
-		case rapidjson::kFalseType:
-		case rapidjson::kTrueType:   return Json::ValueType_Bool;
-		case rapidjson::kNumberType: return Json::ValueType_Number;
-		case rapidjson::kStringType: return Json::ValueType_String;
-		default: APT_ASSERT(false); break;
-	};
-
-	return Json::ValueType_Count;
-}
-
 /*******************************************************************************
 
                                    Json
 
 *******************************************************************************/
 
-struct Json::Impl
-{
-	rapidjson::Document m_dom;
+const char apt::kBinaryName[] = "binary";
 
- // current value set after find()
-	rapidjson::Value* m_value = nullptr;
+void apt::SetBinary(rapidjson::Value& value_, const void* _data, uint _sizeBytes, bool _compressed, rapidjson::Document::AllocatorType& _allocator_)
+{
+	char* str = (char*)_allocator_.Malloc(_sizeBytes + kBinaryHeaderSize + 1);
+	str[0] = _compressed ? '1' : '0';
+	if (_sizeBytes > 0) {
+		memcpy(str + kBinaryHeaderSize, _data, _sizeBytes);
+	}
+	str[_sizeBytes + kBinaryHeaderSize] = '\0';
+	value_.SetObject();
+	value_.AddMember(
+		rapidjson::Value(rapidjson::StringRef(kBinaryName)),
+		rapidjson::Value(rapidjson::StringRef(str, (rapidjson::SizeType)(_sizeBytes + kBinaryHeaderSize))),
+		_allocator_
+		);
+}
 
- // value stack for objects/arrays
-	eastl::vector<eastl::pair<rapidjson::Value*, int> > m_stack;
+char* apt::Float32ToString(float _value, char* buffer_)
+{
+	using namespace rapidjson::internal;
 
-	void push(rapidjson::Value* _val = nullptr)
-	{
-		APT_ASSERT(m_stack.empty() || top() != _val); // probably a mistake, called push() twice?
-		m_stack.push_back(eastl::make_pair(_val ? _val : m_value, 0));
-	}
-	void pop()
-	{
-		APT_ASSERT(!m_stack.empty());
-		m_stack.pop_back();
-	}
-	rapidjson::Value* top() 
-	{
-		APT_ASSERT(!m_stack.empty());
-		return m_stack.back().first;
+	uint32 bits;
+	memcpy(&bits, &_value, sizeof(bits));
+	if (bits >> 31) {
+		*buffer_++ = '-';
 	}
-	int& topIter()
-	{
-		APT_ASSERT(!m_stack.empty());
-		return m_stack.back().second;
+	const uint32 mantissa = bits & 0x7fffff;
+	const int    biasedExp = (int)((bits >> 23) & 0xff);
+	if (mantissa == 0 && biasedExp == 0) {
+		memcpy(buffer_, "0.0", 3);
+		return buffer_ + 3;
 	}
 
-	// Get the current value, optionally access the element _i if an array.
-	rapidjson::Value* get(int _i = -1) 
-	{
-		rapidjson::Value* ret = m_value;
-		APT_ASSERT(ret);
-		if (_i >= 0 && GetValueType(ret->GetType()) == ValueType_Array) {
-			int n = (int)ret->GetArray().Size();
-			APT_ASSERT_MSG(_i < n, "Array index out of bounds (%d/%d)", _i, n);
-			ret = &ret->GetArray()[_i];
-		}
-		return ret;
+	DiyFp v;
+	if (biasedExp != 0) {
+		v = DiyFp(mantissa | 0x800000, biasedExp - 150);
+	} else {
+		v = DiyFp(mantissa, -149);
 	}
-};
-
+ // boundaries are halfway to the adjacent floats, the lower gap is halved at a power of 2
+	DiyFp wp = DiyFp((v.f << 1) + 1, v.e - 1).NormalizeBoundary();
+	DiyFp wm = (mantissa == 0 && biasedExp > 1) ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+	wm.f <<= wm.e - wp.e;
+	wm.e = wp.e;
+
+	int K;
+	const DiyFp cmk = GetCachedPower(wp.e, &K);
+	const DiyFp W  = v.Normalize() * cmk;
+	DiyFp Wp = wp * cmk;
+	DiyFp Wm = wm * cmk;
+	Wm.f++;
+	Wp.f--;
+	int length;
+	DigitGen(W, Wp, Wp.f - Wm.f, buffer_, &length, &K);
+	return Prettify(buffer_, length, K, 324);
+}
 
 // PUBLIC
 
-bool Json::Read(Json& json_, const File& _file)
+bool Json::Read(Json& json_, const File& _file, const JsonSchema* _schema)
 {
-	json_.m_impl->m_dom.Parse(_file.getData());
-	if (json_.m_impl->m_dom.HasParseError()) {
-		APT_LOG_ERR("Json error: %s\n\t'%s'", _file.getPath(), rapidjson::GetParseError_En(json_.m_impl->m_dom.GetParseError()));
-		return false;
+	if (_schema) {
+		rapidjson::StringStream stream(_file.getData());
+		if (!_schema->m_impl->parse<rapidjson::kParseDefaultFlags>(json_.m_impl->m_dom, stream, _file.getPath())) {
+			return false;
+		}
+	} else {
+		json_.m_impl->m_dom.Parse(_file.getData());
+		if (json_.m_impl->m_dom.HasParseError()) {
+			APT_LOG_ERR("Json error: %s\n\t'%s'", _file.getPath(), rapidjson::GetParseError_En(json_.m_impl->m_dom.GetParseError()));
+			return false;
+		}
 	}
+	File().swap(json_.m_impl->m_insituFile);
+	json_.m_impl->m_memberIndex.clear();
 	return true;
 }
 
-bool Json::Read(Json& json_, const char* _path, FileSystem::RootType _rootHint)
+bool Json::Read(Json& json_, const char* _path, FileSystem::RootType _rootHint, const JsonSchema* _schema)
 {
 	APT_AUTOTIMER("Json::Read(%s)", _path);
 	File f;
 	if (!FileSystem::ReadIfExists(f, _path, _rootHint)) {
 		return false;
 	}
-	return Read(json_, f);
+	return ReadInsitu(json_, f, _schema);
+}
+
+bool Json::ReadInsitu(Json& json_, File& file_, const JsonSchema* _schema)
+{
+	char* data = file_.getData(); // copies the data if shared
+	if (!data) {
+		APT_LOG_ERR("Json error: %s\n\t'No data'", file_.getPath());
+		return false;
+	}
+	if (_schema) {
+		rapidjson::InsituStringStream stream(data);
+		if (!_schema->m_impl->parse<rapidjson::kParseDefaultFlags | rapidjson::kParseInsituFlag>(json_.m_impl->m_dom, stream, file_.getPath())) {
+			return false;
+		}
+	} else {
+		json_.m_impl->m_dom.ParseInsitu(data);
+		if (json_.m_impl->m_dom.HasParseError()) {
+			APT_LOG_ERR("Json error: %s\n\t'%s'", file_.getPath(), rapidjson::GetParseError_En(json_.m_impl->m_dom.GetParseError()));
+			return false;
+		}
+	}
+ // the previous in situ data (if any) is no longer referenced, release it
+	json_.m_impl->m_insituFile.swap(file_);
+	File().swap(file_);
+	json_.m_impl->m_memberIndex.clear();
+	return true;
+}
+
+bool Json::Validate(const Json& _json, const JsonSchema& _schema)
+{
+	APT_ASSERT(_schema.m_impl->m_document); // not initialized
+	rapidjson::SchemaValidator validator(*_schema.m_impl->m_document);
+	_json.m_impl->m_dom.Accept(validator);
+	if (!validator.IsValid()) {
+		JsonSchema::Impl::LogError(validator, (const char*)_schema.m_impl->m_path);
+		return false;
+	}
+	return true;
+}
+
+// Write _dom to _stream with the writer selected by _flags (see Json::WriteFlags).
+template <typename tStream>
+static bool WriteDom(const rapidjson::Document& _dom, tStream& stream_, uint32 _flags)
+{
+	const bool float32 = (_flags & Json::WriteFlags_Float32) != 0;
+	if (_flags & Json::WriteFlags_Pretty) {
+		rapidjson::PrettyWriter<tStream> wr(stream_);
+		wr.SetIndent('\t', 1);
+		wr.SetFormatOptions(rapidjson::kFormatSingleLineArray);
+		Base64Handler<rapidjson::PrettyWriter<tStream> > handler(wr, float32);
+		return _dom.Accept(handler);
+	}
+	rapidjson::Writer<tStream> wr(stream_);
+	Base64Handler<rapidjson::Writer<tStream> > handler(wr, float32);
+	return _dom.Accept(handler);
 }
 
-bool Json::Write(const Json& _json, File& file_)
+// rapidjson output stream for Json::Write(OutputCallback), passes the output to the callback in fixed size chunks.
+struct CallbackStream
+{
+	typedef char Ch;
+
+	const Json::OutputCallback& m_callback;
+	char*                       m_buffer;
+	char*                       m_cur;
+	char*                       m_end;
+	bool                        m_error = false;
+
+	CallbackStream(const Json::OutputCallback& _callback, uint _chunkSize)
+		: m_callback(_callback)
+	{
+		_chunkSize = APT_MAX(_chunkSize, (uint)64);
+		m_buffer = m_cur = (char*)APT_MALLOC(_chunkSize);
+		m_end = m_buffer + _chunkSize;
+	}
+
+	~CallbackStream()
+	{
+		APT_FREE(m_buffer);
+	}
+
+	void Put(char _c)
+	{
+		if (m_cur == m_end) {
+			Flush();
+		}
+		*m_cur++ = _c;
+	}
+
+	void Flush()
+	{
+		if (m_cur != m_buffer && !m_error) {
+			m_error = !m_callback(m_buffer, (uint)(m_cur - m_buffer));
+		}
+		m_cur = m_buffer;
+	}
+};
+
+bool Json::Write(const Json& _json, File& file_, uint32 _flags)
 {
 	rapidjson::StringBuffer buf;
-	rapidjson::PrettyWriter<rapidjson::StringBuffer> wr(buf);
-	wr.SetIndent('\t', 1);
-	wr.SetFormatOptions(rapidjson::kFormatSingleLineArray);
-	_json.m_impl->m_dom.Accept(wr);
+	if (!WriteDom(_json.m_impl->m_dom, buf, _flags)) {
+		APT_LOG_ERR("Json error: %s\n\t'Invalid value (NaN or infinity)'", file_.getPath());
+		return false;
+	}
 	file_.setData(buf.GetString(), buf.GetSize());
 	return true;
 }
 
-bool Json::Write(const Json& _json, const char* _path, FileSystem::RootType _rootHint)
+bool Json::Write(const Json& _json, const char* _path, FileSystem::RootType _rootHint, uint32 _flags)
 {
 	APT_AUTOTIMER("Json::Write(%s)", _path);
 	File f;
-	if (Write(_json, f)) {
+	if (Write(_json, f, _flags)) {
 		return FileSystem::Write(f, _path, _rootHint);
 	}
 	return false;
 }
 
+bool Json::Write(const Json& _json, const OutputCallback& _callback, uint32 _flags, uint _chunkSize)
+{
+	APT_ASSERT(_callback);
+	CallbackStream stream(_callback, _chunkSize);
+	if (!WriteDom(_json.m_impl->m_dom, stream, _flags)) {
+		APT_LOG_ERR("Json error: Write()\n\t'Invalid value (NaN or infinity)'");
+		return false;
+	}
+	stream.Flush();
+	return !stream.m_error;
+}
+
 Json::Json(const char* _path, FileSystem::RootType _rootHint)
 	: m_impl(nullptr)
 {
-	m_impl = APT_NEW(Impl);
-	m_impl->m_dom.SetObject();
-	m_impl->push(&m_impl->m_dom);
+	init(nullptr, _path, _rootHint);
+}
 
-	if (_path) {
-		Json::Read(*this, _path, _rootHint);
-	}
+Json::Json(JsonArena& _arena, const char* _path, FileSystem::RootType _rootHint)
+	: m_impl(nullptr)
+{
+	init(&_arena, _path, _rootHint);
 }
 
 Json::~Json()
 {
 	if (m_impl) {
+		JsonArena* arena = m_impl->m_arena;
+		bool ownArena = m_impl->m_ownArena;
 		APT_DELETE(m_impl);
+		--arena->m_userCount;
+		if (ownArena) {
+			APT_DELETE(arena);
+		}
+	}
+}
+
+void Json::clear()
+{
+	m_impl->m_dom.SetObject();
+	File().swap(m_impl->m_insituFile);
+	m_impl->resetStack();
+
+	if (m_impl->m_arena->getUserCount() == 1) {
+		m_impl->m_arena->reset();
 	}
 }
 
@@ -156,14 +284,42 @@ bool Json::find(const char* _name)
 	if (!top->IsObject()) {
 		return false;
 	}
-	auto it = top->FindMember(_name);
-	if (it != top->MemberEnd()) {
-		m_impl->m_value = &it->value;
+	int i = m_impl->findMember(0, _name);
+	if (i >= 0) {
+		m_impl->m_value = &(top->MemberBegin() + i)->value;
+		return true;
+	}
+	return false;
+}
+
+bool Json::find(StringHash _nameHash)
+{
+	rapidjson::Value* top = m_impl->top();
+
+	if (!top->IsObject()) {
+		return false;
+	}
+	int i = m_impl->findMember(_nameHash.getHash(), nullptr);
+	if (i >= 0) {
+		m_impl->m_value = &(top->MemberBegin() + i)->value;
 		return true;
 	}
 	return false;
 }
 
+void Json::setMemberIndexThreshold(uint _memberCount)
+{
+	m_impl->m_memberIndexThreshold = _memberCount;
+	if (_memberCount == 0) {
+		m_impl->m_memberIndex.clear();
+	}
+}
+
+uint Json::getMemberIndexThreshold() const
+{
+	return m_impl->m_memberIndexThreshold;
+}
+
 bool Json::next()
 {
 	rapidjson::Value* top = m_impl->top();
@@ -264,7 +420,7 @@ template <> vec2 Json::getValue<vec2>(int _i) const
 	const rapidjson::Value* jsonValue = m_impl->get(_i);
 	APT_ASSERT_MSG(GetValueType(jsonValue->GetType()) == ValueType_Array, "Json::getValue: not an array");
 	APT_ASSERT_MSG(jsonValue->Size() == 2, "Json::getValue: invalid vec2, size = %d", jsonValue->Size());
-	auto& arr = jsonValue->GetArray();
+	auto arr = jsonValue->GetArray();
 	return vec2(arr[0].GetFloat(), arr[1].GetFloat());
 }
 template <> vec3 Json::getValue<vec3>(int _i) const
@@ -272,7 +428,7 @@ template <> vec3 Json::getValue<vec3>(int _i) const
 	const rapidjson::Value* jsonValue = m_impl->get(_i);
 	APT_ASSERT_MSG(GetValueType(jsonValue->GetType()) == ValueType_Array, "Json::getValue: not an array");
 	APT_ASSERT_MSG(jsonValue->Size() == 3, "Json::getValue: invalid vec3, size = %d", jsonValue->Size());
-	auto& arr = jsonValue->GetArray();
+	auto arr = jsonValue->GetArray();
 	return vec3(arr[0].GetFloat(), arr[1].GetFloat(), arr[2].GetFloat());
 }
 template <> vec4 Json::getValue<vec4>(int _i) const
@@ -280,7 +436,7 @@ template <> vec4 Json::getValue<vec4>(int _i) const
 	const rapidjson::Value* jsonValue = m_impl->get(_i);
 	APT_ASSERT_MSG(GetValueType(jsonValue->GetType()) == ValueType_Array, "Json::getValue: not an array");
 	APT_ASSERT_MSG(jsonValue->Size() == 4, "Json::getValue: invalid vec4, size = %d", jsonValue->Size());
-	auto& arr = jsonValue->GetArray();
+	auto arr = jsonValue->GetArray();
 	return vec4(arr[0].GetFloat(), arr[1].GetFloat(), arr[2].GetFloat(), arr[3].GetFloat());
 }
 template <> mat2 Json::getValue<mat2>(int _i) const
@@ -373,6 +529,7 @@ int Json::getArrayLength() const
 
 void Json::beginObject(const char* _name)
 {
+	bool created = false;
 	if (_name && find(_name)) {
 	  // object already existed, check the type
 		APT_ASSERT(GetValueType(m_impl->m_value->GetType()) == ValueType_Object);
@@ -395,8 +552,10 @@ void Json::beginObject(const char* _name)
 				);
 			m_impl->m_value = &(m_impl->top()->MemberEnd() - 1)->value;
 		}
+		created = true;
 	}
 	APT_VERIFY(enterObject());
+	m_impl->m_stack.back().m_created = created;
 }
 
 void Json::beginArray(const char* _name)
@@ -818,6 +977,111 @@ template <> void Json::pushValue<mat4>(mat4 _val)
 	leaveArray();
 }
 
+// Element conversion for getValues()/pushValues(). GetElement() returns false if _value isn't a tType (the integer types also require
+// an integer which fits the 32 or 64 bit signed/unsigned base type).
+static inline bool GetElement(const rapidjson::Value& _value, bool&    ret_) { if (!_value.IsBool())   return false; ret_ = _value.GetBool();           return true; }
+static inline bool GetElement(const rapidjson::Value& _value, sint8&   ret_) { if (!_value.IsInt())    return false; ret_ = (sint8)_value.GetInt();     return true; }
+static inline bool GetElement(const rapidjson::Value& _value, uint8&   ret_) { if (!_value.IsUint())   return false; ret_ = (uint8)_value.GetUint();    return true; }
+static inline bool GetElement(const rapidjson::Value& _value, sint16&  ret_) { if (!_value.IsInt())    return false; ret_ = (sint16)_value.GetInt();    return true; }
+static inline bool GetElement(const rapidjson::Value& _value, uint16&  ret_) { if (!_value.IsUint())   return false; ret_ = (uint16)_value.GetUint();   return true; }
+static inline bool GetElement(const rapidjson::Value& _value, sint32&  ret_) { if (!_value.IsInt())    return false; ret_ = _value.GetInt();            return true; }
+static inline bool GetElement(const rapidjson::Value& _value, uint32&  ret_) { if (!_value.IsUint())   return false; ret_ = _value.GetUint();           return true; }
+static inline bool GetElement(const rapidjson::Value& _value, sint64&  ret_) { if (!_value.IsInt64())  return false; ret_ = _value.GetInt64();          return true; }
+static inline bool GetElement(const rapidjson::Value& _value, uint64&  ret_) { if (!_value.IsUint64()) return false; ret_ = _value.GetUint64();         return true; }
+static inline bool GetElement(const rapidjson::Value& _value, float32& ret_) { if (!_value.IsNumber()) return false; ret_ = _value.GetFloat();          return true; }
+static inline bool GetElement(const rapidjson::Value& _value, float64& ret_) { if (!_value.IsNumber()) return false; ret_ = _value.GetDouble();         return true; }
+
+static inline rapidjson::Value MakeElement(bool    _value) { return rapidjson::Value(_value); }
+static inline rapidjson::Value MakeElement(sint8   _value) { return rapidjson::Value((sint32)_value); }
+static inline rapidjson::Value MakeElement(uint8   _value) { return rapidjson::Value((uint32)_value); }
+static inline rapidjson::Value MakeElement(sint16  _value) { return rapidjson::Value((sint32)_value); }
+static inline rapidjson::Value MakeElement(uint16  _value) { return rapidjson::Value((uint32)_value); }
+static inline rapidjson::Value MakeElement(sint32  _value) { return rapidjson::Value(_value); }
+static inline rapidjson::Value MakeElement(uint32  _value) { return rapidjson::Value(_value); }
+static inline rapidjson::Value MakeElement(sint64  _value) { return rapidjson::Value(_value); }
+static inline rapidjson::Value MakeElement(uint64  _value) { return rapidjson::Value(_value); }
+static inline rapidjson::Value MakeElement(float32 _value) { return rapidjson::Value(_value); }
+static inline rapidjson::Value MakeElement(float64 _value) { return rapidjson::Value(_value); }
+
+template <typename tType>
+uint Json::getValues(tType* _values_, uint _count, uint _offset) const
+{
+ // the current value may be the array (after find()/enterArray()) or an element (after next())
+	const rapidjson::Value* arr = m_impl->m_value;
+	if (!arr || !arr->IsArray()) {
+		arr = m_impl->top();
+	}
+	APT_ASSERT_MSG(arr->IsArray(), "Json::getValues: not an array");
+	const uint size = (uint)arr->Size();
+	if (_offset >= size) {
+		return 0;
+	}
+	_count = APT_MIN(_count, size - _offset);
+	const rapidjson::Value* src = arr->Begin() + _offset;
+	for (uint i = 0; i < _count; ++i) {
+		if (!GetElement(src[i], _values_[i])) {
+			return i;
+		}
+	}
+	return _count;
+}
+template uint Json::getValues<bool>   (bool*    _values_, uint _count, uint _offset) const;
+template uint Json::getValues<sint8>  (sint8*   _values_, uint _count, uint _offset) const;
+template uint Json::getValues<uint8>  (uint8*   _values_, uint _count, uint _offset) const;
+template uint Json::getValues<sint16> (sint16*  _values_, uint _count, uint _offset) const;
+template uint Json::getValues<uint16> (uint16*  _values_, uint _count, uint _offset) const;
+template uint Json::getValues<sint32> (sint32*  _values_, uint _count, uint _offset) const;
+template uint Json::getValues<uint32> (uint32*  _values_, uint _count, uint _offset) const;
+template uint Json::getValues<sint64> (sint64*  _values_, uint _count, uint _offset) const;
+template uint Json::getValues<uint64> (uint64*  _values_, uint _count, uint _offset) const;
+template uint Json::getValues<float32>(float32* _values_, uint _count, uint _offset) const;
+template uint Json::getValues<float64>(float64* _values_, uint _count, uint _offset) const;
+
+template <typename tType>
+void Json::pushValues(const tType* _values, uint _count)
+{
+	rapidjson::Value* arr = m_impl->top();
+	APT_ASSERT_MSG(arr->IsArray(), "Json::pushValues: not an array");
+	if (_count == 0) {
+		return;
+	}
+	auto& allocator = m_impl->m_dom.GetAllocator();
+	arr->Reserve(arr->Size() + (rapidjson::SizeType)_count, allocator);
+	for (uint i = 0; i < _count; ++i) {
+		arr->PushBack(MakeElement(_values[i]).Move(), allocator);
+	}
+	m_impl->m_value = arr->End() - 1;
+}
+template void Json::pushValues<bool>   (const bool*    _values, uint _count);
+template void Json::pushValues<sint8>  (const sint8*   _values, uint _count);
+template void Json::pushValues<uint8>  (const uint8*   _values, uint _count);
+template void Json::pushValues<sint16> (const sint16*  _values, uint _count);
+template void Json::pushValues<uint16> (const uint16*  _values, uint _count);
+template void Json::pushValues<sint32> (const sint32*  _values, uint _count);
+template void Json::pushValues<uint32> (const uint32*  _values, uint _count);
+template void Json::pushValues<sint64> (const sint64*  _values, uint _count);
+template void Json::pushValues<uint64> (const uint64*  _values, uint _count);
+template void Json::pushValues<float32>(const float32* _values, uint _count);
+template void Json::pushValues<float64>(const float64* _values, uint _count);
+
+// PRIVATE
+
+void Json::init(JsonArena* _arena, const char* _path, FileSystem::RootType _rootHint)
+{
+	bool ownArena = _arena == nullptr;
+	if (ownArena) {
+		_arena = APT_NEW(JsonArena);
+	}
+	++_arena->m_userCount;
+	m_impl = APT_NEW(Impl(_arena, ownArena));
+	m_impl->m_dom.SetObject();
+	m_impl->push(&m_impl->m_dom);
+
+	if (_path) {
+		Json::Read(*this, _path, _rootHint);
+	}
+}
+
 /*******************************************************************************
 
                               SerializerJson
@@ -829,11 +1093,61 @@ template <> void Json::pushValue<mat4>(mat4 _val)
 SerializerJson::SerializerJson(Json& _json_, Mode _mode)
 	: Serializer(_mode) 
 	, m_json(&_json_)
+	, m_reader(nullptr)
+	, m_writer(nullptr)
+{
+}
+
+SerializerJson::SerializerJson(JsonReader& _reader_)
+	: Serializer(Mode_Read)
+	, m_json(nullptr)
+	, m_reader(&_reader_)
+	, m_writer(nullptr)
+{
+}
+
+SerializerJson::SerializerJson(JsonWriter& _writer_)
+	: Serializer(Mode_Write)
+	, m_json(nullptr)
+	, m_reader(nullptr)
+	, m_writer(&_writer_)
+{
+}
+
+// Move _reader_ to the next array element, or find _name. _typeStr is used for error messages.
+static bool ReaderSeek(SerializerJson& _serializer_, JsonReader& _reader_, const char* _name, const char* _typeStr)
 {
+	APT_ASSERT(_serializer_.getMode() == SerializerJson::Mode_Read); // reader is read-only
+	if (_reader_.isInArray()) {
+		return _reader_.next();
+	}
+	if (!_name) {
+		_serializer_.setError("Error serializing %s; name must be specified if not in an array", _typeStr);
+		return false;
+	}
+	if (!_reader_.find(_name)) {
+		_serializer_.setError("Error serializing %s; '%s' not found", _typeStr, _name);
+		return false;
+	}
+	return true;
 }
 
 bool SerializerJson::beginObject(const char* _name)
 {
+	if (m_reader) {
+		if (!ReaderSeek(*this, *m_reader, _name, "object")) {
+			return false;
+		}
+		if (m_reader->getType() != Json::ValueType_Object) {
+			setError("SerializerJson::beginObject(); '%s' not an object", _name ? _name : "");
+			return false;
+		}
+		return m_reader->enterObject();
+	}
+	if (m_writer) {
+		m_writer->beginObject(_name);
+		return true;
+	}
 	if (getMode() == Mode_Read) {
 		if (m_json->getArrayLength() >= 0) { // inside array
 			if (!m_json->next()) {
@@ -860,7 +1174,11 @@ bool SerializerJson::beginObject(const char* _name)
 }
 void SerializerJson::endObject()
 {
-	if (m_mode == Mode_Read) {
+	if (m_reader) {
+		m_reader->leaveObject();
+	} else if (m_writer) {
+		m_writer->endObject();
+	} else if (m_mode == Mode_Read) {
 		m_json->leaveObject();
 	} else {
 		m_json->endObject();
@@ -869,6 +1187,22 @@ void SerializerJson::endObject()
 
 bool SerializerJson::beginArray(uint& _length_, const char* _name)
 {
+	if (m_reader) {
+		if (!ReaderSeek(*this, *m_reader, _name, "array")) {
+			return false;
+		}
+		if (m_reader->getType() != Json::ValueType_Array) {
+			setError("SerializerJson::beginArray(); '%s' not an array", _name ? _name : "");
+			return false;
+		}
+		m_reader->enterArray();
+		_length_ = (uint)m_reader->getArrayLength();
+		return true;
+	}
+	if (m_writer) {
+		m_writer->beginArray(_name);
+		return true;
+	}
 	if (m_mode == Mode_Read) {
 		if (m_json->getArrayLength() >= 0) { // inside array
 			if (!m_json->next()) {
@@ -896,7 +1230,11 @@ bool SerializerJson::beginArray(uint& _length_, const char* _name)
 }
 void SerializerJson::endArray()
 {
-	if (m_mode == Mode_Read) {
+	if (m_reader) {
+		m_reader->leaveArray();
+	} else if (m_writer) {
+		m_writer->endArray();
+	} else if (m_mode == Mode_Read) {
 		m_json->leaveArray();
 	} else {
 		m_json->endArray();
@@ -906,6 +1244,25 @@ void SerializerJson::endArray()
 template <typename tType>
 static bool ValueImpl(SerializerJson& _serializer_, tType& _value_, const char* _name)
 {
+	JsonReader* reader = _serializer_.getReader();
+	if (reader) {
+		if (!ReaderSeek(_serializer_, *reader, _name, Serializer::ValueTypeToStr<tType>())) {
+			return false;
+		}
+		_value_ = reader->getValue<tType>();
+		return true;
+	}
+	JsonWriter* writer = _serializer_.getWriter();
+	if (writer) {
+		APT_ASSERT(_serializer_.getMode() == SerializerJson::Mode_Write); // writer is write-only
+		if (!_name && !writer->isInArray()) {
+			_serializer_.setError("Error serializing %s; name must be specified if not in an array", Serializer::ValueTypeToStr<tType>());
+			return false;
+		}
+		writer->setValue<tType>(_name, _value_);
+		return true;
+	}
+
 	Json* json = _serializer_.getJson();
 	if (!_name && json->getArrayLength() == -1) {
 		_serializer_.setError("Error serializing %s; name must be specified if not in an array", Serializer::ValueTypeToStr<tType>());
@@ -947,152 +1304,177 @@ bool SerializerJson::value(uint64&  _value_, const char* _name) { return ValueIm
 bool SerializerJson::value(float32& _value_, const char* _name) { return ValueImpl<float32>(*this, _value_, _name); }
 bool SerializerJson::value(float64& _value_, const char* _name) { return ValueImpl<float64>(*this, _value_, _name); }
 
-bool SerializerJson::value(StringBase& _value_, const char* _name) 
-{ 
-	if (!_name && m_json->getArrayLength() == -1) {
-		setError("Error serializing StringBase; name must be specified if not in an array");
+template <typename tType>
+static bool ValueArrayImpl(SerializerJson& _serializer_, tType* _values_, uint _count, const char* _name)
+{
+	Json* json = _serializer_.getJson();
+	if (!json) {
+		return _serializer_.Serializer::value(_values_, _count, _name); // element-wise
+	}
+	uint len = _count;
+	if (!_serializer_.beginArray(len, _name)) {
 		return false;
 	}
-	if (getMode() == SerializerJson::Mode_Read) {
-		if (_name) {
-			if (!m_json->find(_name)) {
-				setError("Error serializing StringBase; '%s' not found", _name);
-				return false;
-			}
+	bool ret = true;
+	if (_serializer_.getMode() == SerializerJson::Mode_Read) {
+		if (len != _count) {
+			_serializer_.setError("Error serializing %s array '%s': array length was %d, expected %d", Serializer::ValueTypeToStr<tType>(), _name ? _name : "", (int)len, (int)_count);
+			ret = false;
 		} else {
-			if (!m_json->next()) {
-				return false;
+			const uint n = json->getValues<tType>(_values_, _count);
+			if (n != _count) {
+				_serializer_.setError("Error serializing %s array '%s': element %u not a %s", Serializer::ValueTypeToStr<tType>(), _name ? _name : "", (unsigned)n, Serializer::ValueTypeToStr<tType>());
+				ret = false;
 			}
 		}
-
-		if (m_json->getType() == Json::ValueType_String) {
-			_value_.set(m_json->getValue<const char*>());
-			return true;
-		} else {
-			setError("Error serializing StringBase; '%s' not a string", _name ? _name : "");
-			return false;
-		}
-
 	} else {
-		if (_name) {
-			m_json->setValue<const char*>(_name, (const char*)_value_);
-		} else {
-			m_json->pushValue<const char*>((const char*)_value_);
-		}
-		return true; 
+		json->pushValues<tType>(_values_, _count);
 	}
+	_serializer_.endArray();
+	return ret;
 }
 
+bool SerializerJson::value(bool*    _values_, uint _count, const char* _name) { return ValueArrayImpl<bool>   (*this, _values_, _count, _name); }
+bool SerializerJson::value(sint8*   _values_, uint _count, const char* _name) { return ValueArrayImpl<sint8>  (*this, _values_, _count, _name); }
+bool SerializerJson::value(uint8*   _values_, uint _count, const char* _name) { return ValueArrayImpl<uint8>  (*this, _values_, _count, _name); }
+bool SerializerJson::value(sint16*  _values_, uint _count, const char* _name) { return ValueArrayImpl<sint16> (*this, _values_, _count, _name); }
+bool SerializerJson::value(uint16*  _values_, uint _count, const char* _name) { return ValueArrayImpl<uint16> (*this, _values_, _count, _name); }
+bool SerializerJson::value(sint32*  _values_, uint _count, const char* _name) { return ValueArrayImpl<sint32> (*this, _values_, _count, _name); }
+bool SerializerJson::value(uint32*  _values_, uint _count, const char* _name) { return ValueArrayImpl<uint32> (*this, _values_, _count, _name); }
+bool SerializerJson::value(sint64*  _values_, uint _count, const char* _name) { return ValueArrayImpl<sint64> (*this, _values_, _count, _name); }
+bool SerializerJson::value(uint64*  _values_, uint _count, const char* _name) { return ValueArrayImpl<uint64> (*this, _values_, _count, _name); }
+bool SerializerJson::value(float32* _values_, uint _count, const char* _name) { return ValueArrayImpl<float32>(*this, _values_, _count, _name); }
+bool SerializerJson::value(float64* _values_, uint _count, const char* _name) { return ValueArrayImpl<float64>(*this, _values_, _count, _name); }
 
-// Base64 encode/decode of binary data, adapted from https://github.com/adamvr/arduino-base64
-static const char kBase64Alphabet[] = 
-		"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-		"abcdefghijklmnopqrstuvwxyz"
-		"0123456789+/"
-		;
-static inline void Base64A3ToA4(const unsigned char* _a3, unsigned char* a4_) 
-{
-	a4_[0] = (_a3[0] & 0xfc) >> 2;
-	a4_[1] = ((_a3[0] & 0x03) << 4) + ((_a3[1] & 0xf0) >> 4);
-	a4_[2] = ((_a3[1] & 0x0f) << 2) + ((_a3[2] & 0xc0) >> 6);
-	a4_[3] = (_a3[2] & 0x3f);
-}
-static inline void Base64A4ToA3(const unsigned char* _a4, unsigned char* a3_) {
-	a3_[0] = (_a4[0] << 2) + ((_a4[1] & 0x30) >> 4);
-	a3_[1] = ((_a4[1] & 0xf) << 4) + ((_a4[2] & 0x3c) >> 2);
-	a3_[2] = ((_a4[2] & 0x3) << 6) + _a4[3];
+bool SerializerJson::value(StringBase& _value_, const char* _name) 
+{ 
+	if (getMode() == Mode_Read) {
+		uint length;
+		const char* str = readString(_name, length, "StringBase");
+		if (!str) {
+			return false;
+		}
+		_value_.set(str, length);
+		return true;
+	}
+	return writeString((const char*)_value_, _name, "StringBase");
 }
-static inline unsigned char Base64Index(char _c)
+
+bool SerializerJson::beginObject(const ReflectName& _name)
 {
-	if (_c >= 'A' && _c <= 'Z') return _c - 'A';
-	if (_c >= 'a' && _c <= 'z') return _c - 71;
-	if (_c >= '0' && _c <= '9') return _c + 4;
-	if (_c == '+') return 62;
-	if (_c == '/') return 63;
-	return -1;
-}
-static void Base64Encode(const char* _in, uint _inSizeBytes, char* out_, uint outSizeBytes_)
-{
-	uint i = 0;
-	uint j = 0;
-	uint k = 0;
-	unsigned char a3[3];
-	unsigned char a4[4];
-	while (_inSizeBytes--) {
-		a3[i++] = *(_in++);
-		if (i == 3) {
-			Base64A3ToA4(a3, a4);
-			for (i = 0; i < 4; i++) {
-				out_[k++] = kBase64Alphabet[a4[i]];
-			}
-			i = 0;
-		}
+	if (!m_json) {
+		return beginObject(_name.m_str);
 	}
-	if (i) {
-		for (j = i; j < 3; j++) {
-			a3[j] = '\0';
-		}
-		Base64A3ToA4(a3, a4);
-		for (j = 0; j < i + 1; j++) {
-			out_[k++] = kBase64Alphabet[a4[j]];
+	if (m_mode == Mode_Read) {
+		if (!findMember(_name)) {
+			setError("SerializerJson::beginObject(); '%s' not found", _name.m_str);
+			return false;
 		}
-		while ((i++ < 3)) {
-			out_[k++] = '=';
+		if (m_json->getType() != Json::ValueType_Object) {
+			setError("SerializerJson::beginObject(); '%s' not an object", _name.m_str);
+			return false;
 		}
+		return m_json->enterObject();
 	}
-	out_[k] = '\0';
-	APT_ASSERT(outSizeBytes_ == k); // overflow
-}
-static void Base64Decode(const char* _in, uint _inSizeBytes, char* out_, uint outSizeBytes_) {
-	uint i = 0;
-	uint j = 0;
-	uint k = 0;
-	unsigned char a3[3];
-	unsigned char a4[4];
-	while (_inSizeBytes--) {
-		if (*_in == '=') {
-			break;
-		}
-		a4[i++] = *(_in++);
-		if (i == 4) {
-			for (i = 0; i < 4; i++) {
-				a4[i] = Base64Index(a4[i]);
-			}
-			Base64A4ToA3(a4, a3);
-			for (i = 0; i < 3; i++) {
-				out_[k++] = a3[i];
-			}
-			i = 0;
-		}
+	if (!canAppend()) {
+		return beginObject(_name.m_str);
 	}
+	Json::Impl& impl = *m_json->m_impl;
+	impl.top()->AddMember(
+		rapidjson::StringRef(_name.m_str, _name.m_length),
+		rapidjson::Value(rapidjson::kObjectType).Move(),
+		impl.m_dom.GetAllocator()
+		);
+	impl.m_value = &(impl.top()->MemberEnd() - 1)->value;
+	APT_VERIFY(m_json->enterObject());
+	impl.m_stack.back().m_created = true;
+	return true;
+}
 
-	if (i) {
-		for (j = i; j < 4; j++) {
-			a4[j] = '\0';
-		}
-		for (j = 0; j < 4; j++) {
-			a4[j] = Base64Index(a4[j]);
+bool SerializerJson::beginArray(uint& _length_, const ReflectName& _name)
+{
+	if (!m_json) {
+		return beginArray(_length_, _name.m_str);
+	}
+	if (m_mode == Mode_Read) {
+		if (!findMember(_name)) {
+			setError("SerializerJson::beginArray(); '%s' not found", _name.m_str);
+			return false;
 		}
-		Base64A4ToA3(a4, a3);
-		for (j = 0; j < i - 1; j++) {
-			out_[k++] = a3[j];
+		if (m_json->getType() != Json::ValueType_Array) {
+			setError("SerializerJson::beginArray(); '%s' not an array", _name.m_str);
+			return false;
 		}
+		m_json->enterArray();
+		_length_ = (uint)m_json->getArrayLength();
+		return true;
+	}
+	if (!canAppend()) {
+		return beginArray(_length_, _name.m_str);
 	}
-	APT_ASSERT(outSizeBytes_ == k); // overflow
+	Json::Impl& impl = *m_json->m_impl;
+	impl.top()->AddMember(
+		rapidjson::StringRef(_name.m_str, _name.m_length),
+		rapidjson::Value(rapidjson::kArrayType).Move(),
+		impl.m_dom.GetAllocator()
+		);
+	impl.m_value = &(impl.top()->MemberEnd() - 1)->value;
+	APT_VERIFY(m_json->enterArray());
+	return true;
 }
-static uint Base64EncSizeBytes(uint _sizeBytes) 
+
+template <typename tType>
+bool SerializerJson::value(tType& _value_, const ReflectName& _name)
 {
-	uint n = _sizeBytes;
-	return (n + 2 - ((n + 2) % 3)) / 3 * 4;
+	if (!m_json) {
+		return value(_value_, _name.m_str);
+	}
+	if (m_mode == Mode_Read) {
+		if (!findMember(_name)) {
+			setError("Error serializing %s; '%s' not found", ValueTypeToStr<tType>(), _name.m_str);
+			return false;
+		}
+		_value_ = m_json->getValue<tType>();
+		return true;
+	}
+	if (!canAppend()) {
+		return value(_value_, _name.m_str);
+	}
+	Json::Impl& impl = *m_json->m_impl;
+	impl.top()->AddMember(
+		rapidjson::StringRef(_name.m_str, _name.m_length),
+		MakeElement(_value_).Move(),
+		impl.m_dom.GetAllocator()
+		);
+	impl.m_value = &(impl.top()->MemberEnd() - 1)->value;
+	return true;
 }
-static uint Base64DecSizeBytes(char* _buf, uint _sizeBytes) 
+template <> bool SerializerJson::value<StringBase>(StringBase& _value_, const ReflectName& _name)
 {
-	uint padCount = 0;
-	for (uint i = _sizeBytes - 1; _buf[i] == '='; i--) {
-		padCount++;
+	if (!m_json || m_mode == Mode_Read || !canAppend()) {
+		return value(_value_, _name.m_str);
 	}
-	return ((6 * _sizeBytes) / 8) - padCount;
+	Json::Impl& impl = *m_json->m_impl;
+	impl.top()->AddMember(
+		rapidjson::StringRef(_name.m_str, _name.m_length),
+		rapidjson::Value().SetString((const char*)_value_, (rapidjson::SizeType)_value_.getLength(), impl.m_dom.GetAllocator()).Move(),
+		impl.m_dom.GetAllocator()
+		);
+	impl.m_value = &(impl.top()->MemberEnd() - 1)->value;
+	return true;
 }
+template bool SerializerJson::value<bool>   (bool&    _value_, const ReflectName& _name);
+template bool SerializerJson::value<sint8>  (sint8&   _value_, const ReflectName& _name);
+template bool SerializerJson::value<uint8>  (uint8&   _value_, const ReflectName& _name);
+template bool SerializerJson::value<sint16> (sint16&  _value_, const ReflectName& _name);
+template bool SerializerJson::value<uint16> (uint16&  _value_, const ReflectName& _name);
+template bool SerializerJson::value<sint32> (sint32&  _value_, const ReflectName& _name);
+template bool SerializerJson::value<uint32> (uint32&  _value_, const ReflectName& _name);
+template bool SerializerJson::value<sint64> (sint64&  _value_, const ReflectName& _name);
+template bool SerializerJson::value<uint64> (uint64&  _value_, const ReflectName& _name);
+template bool SerializerJson::value<float32>(float32& _value_, const ReflectName& _name);
+template bool SerializerJson::value<float64>(float64& _value_, const ReflectName& _name);
+
 
 bool SerializerJson::binary(void*& _data_, uint& _sizeBytes_, const char* _name, CompressionFlags _compressionFlags)
 {
@@ -1104,45 +1486,198 @@ bool SerializerJson::binary(void*& _data_, uint& _sizeBytes_, const char* _name,
 			data = nullptr;
 			Compress(_data_, _sizeBytes_, (void*&)data, sizeBytes, _compressionFlags);
 		}
-		String<0> str;
-		str.setLength(Base64EncSizeBytes(sizeBytes) + 1);
+		if (!m_writer) {
+		 // store the raw data in the DOM, encoded by Json::Write()/WriteBinary()
+			bool ret = writeString("", _name, "binary");
+			if (ret) {
+				SetBinary(*m_json->m_impl->m_value, data, sizeBytes, _compressionFlags != CompressionFlags_None, m_json->m_impl->m_dom.GetAllocator());
+			}
+			if (_compressionFlags != CompressionFlags_None) {
+				free(data);
+			}
+			return ret;
+		}
+		const uint strSizeBytes = Base64EncSizeBytes(sizeBytes) + 2;
+		char* str = (char*)APT_MALLOC(strSizeBytes);
 		str[0] = _compressionFlags == CompressionFlags_None ? '0' : '1'; // prepend 0, or 1 if compression
-		Base64Encode(data, sizeBytes, (char*)str + 1, str.getLength() - 1);
+		Base64Encode(data, sizeBytes, str + 1, strSizeBytes - 1);
 		if (_compressionFlags != CompressionFlags_None) {
 			free(data);
 		}
-		value((StringBase&)str, _name);
+		bool ret = writeString(str, _name, "binary");
+		APT_FREE(str);
+		return ret;
 
 	} else {
-		String<0> str;
-		value((StringBase&)str, _name);
-		bool compressed = str[0] == '1' ? true : false;
-		uint binSizeBytes = Base64DecSizeBytes((char*)str + 1, str.getLength() - 1);
-		char* bin = (char*)APT_MALLOC(binSizeBytes);
-		Base64Decode((char*)str + 1, str.getLength() - 1, bin, binSizeBytes);
-
-		char* ret = bin;
-		uint retSizeBytes = binSizeBytes;
-		if (compressed) {
-			ret = nullptr; // Decompress to allocates the final buffer
-			Decompress(bin, binSizeBytes, (void*&)ret, retSizeBytes);
+	 // decode directly from the string value, into _data_ or the decompressor input
+		uint strLength;
+		bool isBinary = false;
+		const char* str = readString(_name, strLength, "binary", &isBinary);
+		if (!str) {
+			return false;
 		}
-		if (_data_) {
-			if (retSizeBytes != _sizeBytes_) {
-				setError("Error serializing %s, buffer size was %llu (expected %llu)", _sizeBytes_, retSizeBytes);
-				if (compressed) {
-					APT_FREE(ret);
+		if (isBinary) {
+		 // raw data (written to the DOM or read via Json::ReadBinary())
+			const char* bin = str + kBinaryHeaderSize;
+			const uint binSizeBytes = strLength - kBinaryHeaderSize;
+			if (str[0] == '1') {
+				if (_data_) {
+					if (!DecompressToBuffer(bin, binSizeBytes, _data_, _sizeBytes_)) {
+						setError("Error serializing binary '%s'; decompressed size didn't match buffer size %llu", _name ? _name : "", (unsigned long long)_sizeBytes_);
+						return false;
+					}
+				} else {
+					Decompress(bin, binSizeBytes, _data_, _sizeBytes_);
+				}
+				return true;
+			}
+			if (_data_) {
+				if (binSizeBytes != _sizeBytes_) {
+					setError("Error serializing binary '%s'; buffer size was %llu (expected %llu)", _name ? _name : "", (unsigned long long)_sizeBytes_, (unsigned long long)binSizeBytes);
+					return false;
 				}
+			} else {
+				_data_ = APT_MALLOC(binSizeBytes);
+				_sizeBytes_ = binSizeBytes;
+			}
+			memcpy(_data_, bin, binSizeBytes);
+			return true;
+		}
+		if (strLength < 1 || (str[0] != '0' && str[0] != '1')) {
+			setError("Error serializing binary; '%s' invalid data", _name ? _name : "");
+			return false;
+		}
+		bool compressed = str[0] == '1' ? true : false;
+		++str;
+		--strLength;
+		uint binSizeBytes = Base64DecSizeBytes(str, strLength);
+
+		if (!compressed && _data_) {
+			if (binSizeBytes != _sizeBytes_) {
+				setError("Error serializing binary '%s'; buffer size was %llu (expected %llu)", _name ? _name : "", (unsigned long long)_sizeBytes_, (unsigned long long)binSizeBytes);
 				return false;
 			}
-			memcpy(_data_, ret, retSizeBytes);
-			if (compressed) {
-				APT_FREE(ret);
+			if (!Base64Decode(str, strLength, (char*)_data_, binSizeBytes)) {
+				setError("Error serializing binary; '%s' invalid data", _name ? _name : "");
+				return false;
+			}
+			return true;
+		}
+
+		char* bin = (char*)APT_MALLOC(binSizeBytes);
+		if (!Base64Decode(str, strLength, bin, binSizeBytes)) {
+			setError("Error serializing binary; '%s' invalid data", _name ? _name : "");
+			APT_FREE(bin);
+			return false;
+		}
+		if (!compressed) {
+			_data_ = bin;
+			_sizeBytes_ = binSizeBytes;
+			return true;
+		}
+		bool ret = true;
+		if (_data_) {
+			if (!DecompressToBuffer(bin, binSizeBytes, _data_, _sizeBytes_)) {
+				setError("Error serializing binary '%s'; decompressed size didn't match buffer size %llu", _name ? _name : "", (unsigned long long)_sizeBytes_);
+				ret = false;
 			}
 		} else {
-			_data_ = ret;
-			_sizeBytes_ = retSizeBytes;
+			Decompress(bin, binSizeBytes, _data_, _sizeBytes_);
+		}
+		APT_FREE(bin);
+		return ret;
+	}
+}
+
+// PRIVATE
+
+const char* SerializerJson::readString(const char* _name, uint& length_, const char* _typeStr, bool* binary_)
+{
+	APT_ASSERT(getMode() == Mode_Read);
+	if (m_reader) {
+		if (!ReaderSeek(*this, *m_reader, _name, _typeStr)) {
+			return nullptr;
+		}
+		if (m_reader->getType() != Json::ValueType_String) {
+			setError("Error serializing %s; '%s' not a string", _typeStr, _name ? _name : "");
+			return nullptr;
+		}
+		const char* ret = m_reader->getValue<const char*>();
+		length_ = (uint)strlen(ret);
+		return ret;
+	}
+	if (!_name && m_json->getArrayLength() == -1) {
+		setError("Error serializing %s; name must be specified if not in an array", _typeStr);
+		return nullptr;
+	}
+	if (_name) {
+		if (!m_json->find(_name)) {
+			setError("Error serializing %s; '%s' not found", _typeStr, _name);
+			return nullptr;
+		}
+	} else {
+		if (!m_json->next()) {
+			return nullptr;
+		}
+	}
+	const rapidjson::Value* value = m_json->m_impl->m_value;
+	if (binary_) {
+		if (const rapidjson::Value* bin = GetBinary(*value)) {
+			*binary_ = true;
+			length_ = (uint)bin->GetStringLength();
+			return bin->GetString();
+		}
+	}
+	if (m_json->getType() != Json::ValueType_String) {
+		setError("Error serializing %s; '%s' not a string", _typeStr, _name ? _name : "");
+		return nullptr;
+	}
+	length_ = (uint)value->GetStringLength();
+	return value->GetString();
+}
+
+bool SerializerJson::findMember(const ReflectName& _name)
+{
+	Json::Impl& impl = *m_json->m_impl;
+	rapidjson::Value* top = impl.top();
+	if (!top->IsObject()) {
+		return false;
+	}
+	int i = impl.findMember(_name.m_hash, _name.m_str);
+	if (i < 0) {
+		return false;
+	}
+	impl.m_value = &(top->MemberBegin() + i)->value;
+	return true;
+}
+
+bool SerializerJson::canAppend() const
+{
+ // reflected objects are always begun by the serializer and field names are unique, hence if the object was created (rather
+ // than found) a member can't already exist
+	Json::Impl& impl = *m_json->m_impl;
+	return impl.m_stack.back().m_created && impl.top()->IsObject();
+}
+
+bool SerializerJson::writeString(const char* _value, const char* _name, const char* _typeStr)
+{
+	APT_ASSERT(getMode() == Mode_Write);
+	if (m_writer) {
+		if (!_name && !m_writer->isInArray()) {
+			setError("Error serializing %s; name must be specified if not in an array", _typeStr);
+			return false;
 		}
+		m_writer->setValue<const char*>(_name, _value);
+		return true;
+	}
+	if (!_name && m_json->getArrayLength() == -1) {
+		setError("Error serializing %s; name must be specified if not in an array", _typeStr);
+		return false;
+	}
+	if (_name) {
+		m_json->setValue<const char*>(_name, _value);
+	} else {
+		m_json->pushValue<const char*>(_value);
 	}
 	return true;
 }
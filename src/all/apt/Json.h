@@ -2,7 +2,11 @@
 
 #include <apt/apt.h>
 #include <apt/FileSystem.h>
+#include <apt/Reflect.h>
 #include <apt/Serializer.h>
+#include <apt/StringHash.h>
+
+#include <EASTL/functional.h>
 
 namespace apt {
 
@@ -75,10 +79,21 @@ namespace apt {
 // - String ptrs passed as the _name argument for setValue() are assumed to have 
 //   a lifetime at least as long as the Json object. String ptrs passed as the 
 //   _value argument are copied internally.
+// - Documents read from a path are parsed in situ (see ReadInsitu()), the file
+//   data is kept by the Json object.
+// - Binary data written by SerializerJson::binary() is stored in the DOM as an
+//   object with a single internal member (an object parsed from text is never
+//   mistaken for binary data). Write() encodes the data as a base64 string.
+// - Json objects which load many documents in sequence should call clear()
+//   before each Read*(), otherwise the memory used by previous documents isn't
+//   reclaimed until the Json is destroyed.
 ////////////////////////////////////////////////////////////////////////////////
 class Json
 {
 	friend class SerializerJson; 
+	friend class JsonLinesReader;
+	friend class JsonLinesWriter;
+	friend class JsonPatchLog;
 public:
 	enum ValueType
 	{
@@ -92,17 +107,69 @@ public:
 		ValueType_Count
 	};
 
-	static bool Read(Json& json_, const File& _file);
-	static bool Read(Json& json_, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
-	static bool Write(const Json& _json, File& file_);
-	static bool Write(const Json& _json, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+	// Output format for Write().
+	enum WriteFlags
+	{
+		WriteFlags_None    = 0,       // Compact, no whitespace.
+		WriteFlags_Pretty  = 1 << 0,  // Indent with tabs, arrays on a single line.
+		WriteFlags_Float32 = 1 << 1,  // Write non-integer numbers with float32 precision (the shortest representation which round trips as a float32, in most cases).
+
+		WriteFlags_Default = WriteFlags_Pretty
+	};
+
+	// Receive _size bytes of output. Return false to stop writing.
+	typedef eastl::function<bool(const char* _data, uint _size)> OutputCallback;
+
+	// If _schema is specified the document is validated during parsing, json_ is unchanged if validation fails.
+	static bool Read(Json& json_, const File& _file, const JsonSchema* _schema = nullptr);
+	static bool Read(Json& json_, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default, const JsonSchema* _schema = nullptr);
+	// Parse file_'s data in place; string values in the document point into the file data instead of being copied. json_ takes
+	// ownership of the data (file_ is empty on return) which remains valid for the lifetime of json_, or until the next call to
+	// Read*(). file_'s data must be null-terminated (as per File::Read()). Read(json_, _path) uses this internally.
+	static bool ReadInsitu(Json& json_, File& file_, const JsonSchema* _schema = nullptr);
+	// Validate an existing document against _schema. This is a second pass over the DOM, prefer passing the schema to Read*().
+	static bool Validate(const Json& _json, const JsonSchema& _schema);
+	// _flags is a combination of WriteFlags. Return false if an error occurred (e.g. the document contains NaN or infinity).
+	static bool Write(const Json& _json, File& file_, uint32 _flags = WriteFlags_Default);
+	static bool Write(const Json& _json, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default, uint32 _flags = WriteFlags_Default);
+	// Stream the output to _callback in chunks of _chunkSize bytes (e.g. to write directly to a file descriptor or socket), memory
+	// use is bounded by the chunk size. Return false if an error occurred or _callback returned false.
+	static bool Write(const Json& _json, const OutputCallback& _callback, uint32 _flags = WriteFlags_Default, uint _chunkSize = 64 * 1024);
+	// Read/write the document as CBOR (RFC 8949). Arrays of numbers are stored as typed arrays (RFC 8746) and binary data (see
+	// SerializerJson::binary()) as byte strings, hence both are copied directly rather than converted to/from text.
+	static bool ReadBinary(Json& json_, const File& _file);
+	static bool ReadBinary(Json& json_, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+	static bool WriteBinary(const Json& _json, File& file_);
+	static bool WriteBinary(const Json& _json, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+
+	// Write an RFC 6902 patch (an array of operations) to patch_ which transforms _from into _to. Subtrees are compared via a 64
+	// bit structural hash (member order and the representation of numbers aren't significant), hence identical regions are
+	// skipped without a full comparison. Only add, remove and replace operations are generated.
+	static void Diff(const Json& _from, const Json& _to, Json& patch_);
+	// Apply an RFC 6902 patch to json_ (all operations are supported). Return false if an operation fails, in which case json_
+	// contains the preceding operations. The current value is reset to the root.
+	static bool ApplyPatch(Json& json_, const Json& _patch);
 		
 	// Reads from _path if specified.
 	Json(const char* _path = nullptr, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+	// Allocate from _arena instead of an internal arena.
+	Json(JsonArena& _arena, const char* _path = nullptr, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
 	~Json();
 
+	// Reset to an empty document. The arena is reset if this is its only user, such that the memory is reused by subsequent reads.
+	void clear();
+
 	// Find a named value in the current object. Return true if the value is found, in which case getValue() may be called.
+	// Finding members in document order is O(1). Objects with at least getMemberIndexThreshold() members are indexed on the
+	// first find(), otherwise the search is linear.
 	bool find(const char* _name);
+	// As find(const char*) but match by hash (StringHash(_name)); member names aren't compared, hence a hash collision
+	// may return the wrong member.
+	bool find(StringHash _nameHash);
+
+	// Set the minimum number of members in an object for find() to build a lookup index, 0 disables indexing.
+	void setMemberIndexThreshold(uint _memberCount);
+	uint getMemberIndexThreshold() const;
 	
 	// Get the next value in the current object/array. Return true if not the end of the object/array, in which case getValue() may be called.
 	bool next();
@@ -156,22 +223,42 @@ public:
 	// Push _value into the current array.
 	template <typename tType>
 	void pushValue(tType _value);
+
+	// Copy up to _count elements of the current value (or the current array if the current value isn't an array) to _values_,
+	// starting at element _offset. Return the number of elements copied. Copying stops at the first element which isn't a tType (bool
+	// or numeric, integer types require an integer), in which case the return value is that element's index relative to _offset.
+	template <typename tType>
+	uint getValues(tType* _values_, uint _count, uint _offset = 0) const;
+
+	// Push _count values into the current array.
+	template <typename tType>
+	void pushValues(const tType* _values, uint _count);
 	
 private:
 	struct Impl;
 	Impl* m_impl;
 
+	static const uint kDefaultMemberIndexThreshold = 32;
+
+	void init(JsonArena* _arena, const char* _path, FileSystem::RootType _rootHint);
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 // SerializerJson
 ////////////////////////////////////////////////////////////////////////////////
-class SerializerJson: public Serializer
+class SerializerJson final: public Serializer
 {
 public:
 	SerializerJson(Json& _json_, Mode _mode);
+	// Read directly from _reader_, no DOM is built (Mode_Read only). Serializing members in document order is most efficient.
+	SerializerJson(JsonReader& _reader_);
+	// Write directly to _writer_, no DOM is built (Mode_Write only).
+	SerializerJson(JsonWriter& _writer_);
 
-	Json* getJson() { return m_json; }
+	Json*       getJson()   { return m_json; }
+	JsonReader* getReader() { return m_reader; }
+	JsonWriter* getWriter() { return m_writer; }
 
 	bool beginObject(const char* _name = nullptr) override;
 	void endObject() override;
@@ -192,14 +279,104 @@ public:
 	bool value(float64&    _value_, const char* _name = nullptr) override;
 	bool value(StringBase& _value_, const char* _name = nullptr) override;
 	
+	bool value(bool*       _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint8*      _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint8*      _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint16*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint16*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint32*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint32*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint64*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint64*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(float32*    _values_, uint _count, const char* _name = nullptr) override;
+	bool value(float64*    _values_, uint _count, const char* _name = nullptr) override;
+	
 	bool binary(void*& _data_, uint& _sizeBytes_, const char* _name = nullptr, CompressionFlags _compressionFlags = CompressionFlags_None) override;
 
+	// Reflected serialization (see Reflect.h). Members are found via the precomputed name hash. When writing to a DOM, members of
+	// objects created by the serializer are appended without a lookup (reflected field names are unique).
+	bool beginObject(const ReflectName& _name);
+	bool beginArray(uint& _length_, const ReflectName& _name);
+	template <typename tType>
+	bool value(tType& _value_, const ReflectName& _name);
+
 private:
-	Json* m_json;
+	Json*       m_json;
+	JsonReader* m_reader;
+	JsonWriter* m_writer;
+
+	// Find _name in the current object of m_json.
+	bool findMember(const ReflectName& _name);
+	// Whether members of the current object of m_json can be appended without a lookup.
+	bool canAppend() const;
 
 	int string(const char* _value_, const char* _name);
 
+	// Find/next a string value, return a ptr to the string data (valid while the Json/JsonReader is unchanged) or nullptr if an
+	// error occurred. _typeStr is used for error messages. If binary_ is not null, raw binary data in the DOM is also accepted (and
+	// binary_ set to true).
+	const char* readString(const char* _name, uint& length_, const char* _typeStr, bool* binary_ = nullptr);
+	bool        writeString(const char* _value, const char* _name, const char* _typeStr);
+
 }; // class SerializerJson
 
+// Reflected serialization via SerializerJson uses the hashed names, scalar arrays are copied directly to/from a DOM.
+template <>
+struct ReflectBackend<SerializerJson>
+{
+	static bool BeginObject(SerializerJson& _serializer_, const ReflectName* _name)
+	{
+		return _name ? _serializer_.beginObject(*_name) : _serializer_.beginObject();
+	}
+	static void EndObject(SerializerJson& _serializer_)
+	{
+		_serializer_.endObject();
+	}
+
+	static bool BeginArray(SerializerJson& _serializer_, uint& _length_, const ReflectName* _name)
+	{
+		return _name ? _serializer_.beginArray(_length_, *_name) : _serializer_.beginArray(_length_);
+	}
+	static void EndArray(SerializerJson& _serializer_)
+	{
+		_serializer_.endArray();
+	}
+
+	template <typename tType>
+	static bool Value(SerializerJson& _serializer_, tType& _value_, const ReflectName* _name)
+	{
+		return _name ? _serializer_.value(_value_, *_name) : _serializer_.value(_value_);
+	}
+
+	template <typename tType>
+	static bool Values(SerializerJson& _serializer_, tType* _values_, uint _count, const ReflectName* _name)
+	{
+		return _serializer_.value(_values_, _count, _name ? _name->m_str : nullptr);
+	}
+
+	template <typename tType>
+	static bool Elements(SerializerJson& _serializer_, tType* _values_, uint _count)
+	{
+		Json* json = _serializer_.getJson();
+		if (!json) {
+			return ReflectBackend<Serializer>::Elements((Serializer&)_serializer_, _values_, _count);
+		}
+		if (_serializer_.getMode() == Serializer::Mode_Read) {
+			const uint n = json->getValues<tType>(_values_, _count);
+			if (n != _count) {
+				if ((int)n < json->getArrayLength()) {
+					_serializer_.setError("Error serializing %s array; element %u not a %s", Serializer::ValueTypeToStr<tType>(), (unsigned)n, Serializer::ValueTypeToStr<tType>());
+				} else {
+					_serializer_.setError("Error serializing %s array; expected %d elements", Serializer::ValueTypeToStr<tType>(), (int)_count);
+				}
+				return false;
+			}
+		} else {
+			json->pushValues<tType>(_values_, _count);
+		}
+		return true;
+	}
+};
+
 
 } // namespace apt
@@ -0,0 +1,52 @@
+#include <apt/JsonArena.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/memory.h>
+
+using namespace apt;
+
+// PUBLIC
+
+JsonArena::JsonArena(uint _capacity, uint _chunkSize)
+	: m_impl(nullptr)
+	, m_userCount(0)
+{
+	m_impl = APT_NEW(Impl);
+	m_impl->m_chunkSize = _chunkSize;
+	if (_capacity > 0) {
+		m_impl->m_bufferSize = _capacity + Impl::kBufferOverhead;
+		m_impl->m_buffer = (char*)APT_MALLOC(m_impl->m_bufferSize);
+	}
+	m_impl->initAllocator();
+}
+
+JsonArena::~JsonArena()
+{
+	APT_ASSERT_MSG(m_userCount == 0, "JsonArena: %u Json objects still in use", (uint32)m_userCount);
+	m_impl->shutdownAllocator();
+	APT_FREE(m_impl->m_buffer);
+	APT_DELETE(m_impl);
+}
+
+void JsonArena::reset()
+{
+	uint capacity = (uint)m_impl->getAllocator().Capacity();
+	m_impl->shutdownAllocator(); // frees any additional chunks
+	if (capacity > m_impl->m_baseCapacity) {
+	 // grow the buffer to fit everything which was allocated before the reset
+		APT_FREE(m_impl->m_buffer);
+		m_impl->m_bufferSize = capacity + Impl::kBufferOverhead;
+		m_impl->m_buffer = (char*)APT_MALLOC(m_impl->m_bufferSize);
+	}
+	m_impl->initAllocator();
+}
+
+uint JsonArena::getSize() const
+{
+	return (uint)m_impl->getAllocator().Size();
+}
+
+uint JsonArena::getCapacity() const
+{
+	return (uint)m_impl->getAllocator().Capacity();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <apt/apt.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonArena
+// Memory for Json documents. Memory is allocated from a single buffer, plus
+// additional chunks if the buffer is exhausted, and is only released when the
+// arena is reset. Resetting grows the buffer to the total size previously
+// allocated, hence an arena which is reused for documents of a similar size
+// (e.g. a batch loader) quickly settles on a single allocation.
+//
+// Each Json owns an arena by default. An arena may also be passed to the Json
+// ctor to be shared between several documents, in which case it must outlive
+// them. Not thread safe.
+////////////////////////////////////////////////////////////////////////////////
+class JsonArena: private non_copyable<JsonArena>
+{
+	friend class Json;
+public:
+	// _capacity is the initial buffer size (0 to allocate on demand), _chunkSize is the minimum size of additional chunks.
+	JsonArena(uint _capacity = 0, uint _chunkSize = 64 * 1024);
+	~JsonArena();
+
+	// Release all memory allocated from the arena. Any documents using the arena must be cleared or destroyed first.
+	void reset();
+
+	// Bytes allocated from the arena since the last reset.
+	uint getSize() const;
+	// Total size of the buffer plus any additional chunks.
+	uint getCapacity() const;
+	// Number of Json objects using the arena.
+	uint getUserCount() const { return m_userCount; }
+
+private:
+	struct Impl;
+	Impl* m_impl;
+	uint  m_userCount;
+
+}; // class JsonArena
+
+} // namespace apt
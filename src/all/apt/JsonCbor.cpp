@@ -0,0 +1,557 @@
+#include <apt/Json.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/compress.h>
+#include <apt/log.h>
+#include <apt/math.h>
+#include <apt/memory.h>
+#include <apt/FileSystem.h>
+#include <apt/Time.h>
+
+#include <EASTL/vector.h>
+
+#include <cfloat>
+#include <cstring>
+
+using namespace apt;
+
+// CBOR (RFC 8949) encoding for Json::ReadBinary()/WriteBinary(). Numeric arrays are stored as typed arrays (RFC 8746), binary
+// data as byte strings (compressed data is wrapped in kCborTagCompressed).
+static const uint64 kCborTagCompressed     = 0x41505401; // 'APT', 1 (first come first served range)
+static const uint   kCborTypedArrayMinSize = 4;          // Shorter arrays are stored as regular arrays.
+static const int    kCborMaxDepth          = 512;
+
+enum CborMajorType
+{
+	CborMajorType_Uint,
+	CborMajorType_Sint,
+	CborMajorType_Bytes,
+	CborMajorType_String,
+	CborMajorType_Array,
+	CborMajorType_Map,
+	CborMajorType_Tag,
+	CborMajorType_Simple
+};
+
+// Typed array tags are 0b010fsell where f = float, s = signed, e = little endian, ll = log2(element size) (or float16/32/64/128).
+enum CborTypedArray
+{
+	CborTypedArray_Uint8   = 64,
+	CborTypedArray_Uint16  = 69,
+	CborTypedArray_Uint32  = 70,
+	CborTypedArray_Uint64  = 71,
+	CborTypedArray_Sint8   = 72,
+	CborTypedArray_Sint16  = 77,
+	CborTypedArray_Sint32  = 78,
+	CborTypedArray_Sint64  = 79,
+	CborTypedArray_Float32 = 85,
+	CborTypedArray_Float64 = 86,
+
+	CborTypedArray_First   = 64,
+	CborTypedArray_Last    = 87
+};
+
+struct CborWriter
+{
+	eastl::vector<char> m_buffer;
+
+	void writeByte(uint8 _byte)
+	{
+		m_buffer.push_back((char)_byte);
+	}
+
+	void writeBE(uint64 _value, uint _sizeBytes)
+	{
+		for (uint i = _sizeBytes; i > 0; --i) {
+			writeByte((uint8)(_value >> ((i - 1) * 8)));
+		}
+	}
+
+	void writeBytes(const void* _data, uint _sizeBytes)
+	{
+		m_buffer.insert(m_buffer.end(), (const char*)_data, (const char*)_data + _sizeBytes);
+	}
+
+	void writeHead(CborMajorType _type, uint64 _value)
+	{
+		const uint8 major = (uint8)(_type << 5);
+		if (_value < 24) {
+			writeByte(major | (uint8)_value);
+		} else if (_value <= 0xff) {
+			writeByte(major | 24);
+			writeBE(_value, 1);
+		} else if (_value <= 0xffff) {
+			writeByte(major | 25);
+			writeBE(_value, 2);
+		} else if (_value <= 0xffffffff) {
+			writeByte(major | 26);
+			writeBE(_value, 4);
+		} else {
+			writeByte(major | 27);
+			writeBE(_value, 8);
+		}
+	}
+
+	void writeString(CborMajorType _type, const char* _str, uint _length)
+	{
+		writeHead(_type, _length);
+		writeBytes(_str, _length);
+	}
+
+	void writeNumber(const rapidjson::Value& _value)
+	{
+		if (_value.IsDouble()) {
+		 // use a float32 if the value can be represented exactly (converting an out of range value is undefined)
+			const double d = _value.GetDouble();
+			if (fabs(d) <= (double)FLT_MAX && (double)(float)d == d) {
+				const float f = (float)d;
+				uint32 bits;
+				memcpy(&bits, &f, sizeof(bits));
+				writeByte((CborMajorType_Simple << 5) | 26);
+				writeBE(bits, 4);
+			} else {
+				uint64 bits;
+				memcpy(&bits, &d, sizeof(bits));
+				writeByte((CborMajorType_Simple << 5) | 27);
+				writeBE(bits, 8);
+			}
+		} else if (_value.IsUint64()) {
+			writeHead(CborMajorType_Uint, _value.GetUint64());
+		} else {
+			writeHead(CborMajorType_Sint, (uint64)(-1 - _value.GetInt64()));
+		}
+	}
+
+	template <typename tType>
+	static void Store(char*& out_, tType _value)
+	{
+		memcpy(out_, &_value, sizeof(tType));
+		out_ += sizeof(tType);
+	}
+
+	// Write _array as a typed array if all elements are numbers of the same kind (integer or floating point), else return false.
+	bool writeTypedArray(const rapidjson::Value& _array)
+	{
+		const uint count = (uint)_array.Size();
+		if (count < kCborTypedArrayMinSize || !_array[0].IsNumber()) {
+			return false;
+		}
+		const bool isDouble = _array[0].IsDouble();
+		bool isFloat = true;
+		uint64 maxUint = 0;
+		sint64 minSint = 0;
+		for (auto& value : _array.GetArray()) {
+			if (!value.IsNumber() || value.IsDouble() != isDouble) {
+				return false;
+			}
+			if (isDouble) {
+				const double d = value.GetDouble();
+				isFloat &= fabs(d) <= (double)FLT_MAX && (double)(float)d == d;
+			} else if (value.IsUint64()) {
+				maxUint = APT_MAX(maxUint, value.GetUint64());
+			} else {
+				minSint = APT_MIN(minSint, value.GetInt64());
+			}
+		}
+
+		CborTypedArray tag;
+		uint elementSizeBytes;
+		if (isDouble) {
+			tag = isFloat ? CborTypedArray_Float32 : CborTypedArray_Float64;
+			elementSizeBytes = isFloat ? 4 : 8;
+		} else if (minSint == 0) {
+			     if (maxUint <= UINT8_MAX)  { tag = CborTypedArray_Uint8;  elementSizeBytes = 1; }
+			else if (maxUint <= UINT16_MAX) { tag = CborTypedArray_Uint16; elementSizeBytes = 2; }
+			else if (maxUint <= UINT32_MAX) { tag = CborTypedArray_Uint32; elementSizeBytes = 4; }
+			else                            { tag = CborTypedArray_Uint64; elementSizeBytes = 8; }
+		} else {
+			     if (minSint >= INT8_MIN  && maxUint <= INT8_MAX)  { tag = CborTypedArray_Sint8;  elementSizeBytes = 1; }
+			else if (minSint >= INT16_MIN && maxUint <= INT16_MAX) { tag = CborTypedArray_Sint16; elementSizeBytes = 2; }
+			else if (minSint >= INT32_MIN && maxUint <= INT32_MAX) { tag = CborTypedArray_Sint32; elementSizeBytes = 4; }
+			else if (maxUint <= INT64_MAX)                         { tag = CborTypedArray_Sint64; elementSizeBytes = 8; }
+			else {
+				return false;
+			}
+		}
+
+	 // elements are little endian (as is the target)
+		writeHead(CborMajorType_Tag, tag);
+		writeHead(CborMajorType_Bytes, count * elementSizeBytes);
+		const uint offset = (uint)m_buffer.size();
+		m_buffer.resize(offset + count * elementSizeBytes);
+		char* out = m_buffer.data() + offset;
+		for (auto& value : _array.GetArray()) {
+			switch (tag) {
+				case CborTypedArray_Uint8:   Store(out, (uint8)value.GetUint64());  break;
+				case CborTypedArray_Uint16:  Store(out, (uint16)value.GetUint64()); break;
+				case CborTypedArray_Uint32:  Store(out, (uint32)value.GetUint64()); break;
+				case CborTypedArray_Uint64:  Store(out, (uint64)value.GetUint64()); break;
+				case CborTypedArray_Sint8:   Store(out, (sint8)value.GetInt64());   break;
+				case CborTypedArray_Sint16:  Store(out, (sint16)value.GetInt64());  break;
+				case CborTypedArray_Sint32:  Store(out, (sint32)value.GetInt64());  break;
+				case CborTypedArray_Sint64:  Store(out, (sint64)value.GetInt64());  break;
+				case CborTypedArray_Float32: Store(out, (float32)value.GetDouble()); break;
+				case CborTypedArray_Float64: Store(out, (float64)value.GetDouble()); break;
+				default: APT_ASSERT(false); break;
+			};
+		}
+		return true;
+	}
+
+	void writeValue(const rapidjson::Value& _value)
+	{
+		switch (_value.GetType()) {
+			case rapidjson::kNullType:   writeByte((CborMajorType_Simple << 5) | 22); break;
+			case rapidjson::kFalseType:  writeByte((CborMajorType_Simple << 5) | 20); break;
+			case rapidjson::kTrueType:   writeByte((CborMajorType_Simple << 5) | 21); break;
+			case rapidjson::kNumberType: writeNumber(_value); break;
+			case rapidjson::kStringType: writeString(CborMajorType_String, _value.GetString(), (uint)_value.GetStringLength()); break;
+			case rapidjson::kArrayType:
+				if (!writeTypedArray(_value)) {
+					writeHead(CborMajorType_Array, _value.Size());
+					for (auto& element : _value.GetArray()) {
+						writeValue(element);
+					}
+				}
+				break;
+			case rapidjson::kObjectType:
+				if (const rapidjson::Value* bin = GetBinary(_value)) {
+					const char* str = bin->GetString();
+					if (str[0] == '1') {
+						writeHead(CborMajorType_Tag, kCborTagCompressed);
+					}
+					writeString(CborMajorType_Bytes, str + kBinaryHeaderSize, (uint)bin->GetStringLength() - kBinaryHeaderSize);
+					break;
+				}
+				writeHead(CborMajorType_Map, _value.MemberCount());
+				for (auto& member : _value.GetObject()) {
+					writeString(CborMajorType_String, member.name.GetString(), (uint)member.name.GetStringLength());
+					writeValue(member.value);
+				}
+				break;
+			default:
+				APT_ASSERT(false);
+				break;
+		};
+	}
+};
+
+struct CborReader
+{
+	typedef rapidjson::Document::AllocatorType Allocator;
+
+	const uint8* m_pos;
+	const uint8* m_end;
+	Allocator&   m_allocator;
+	const char*  m_error;
+	int          m_depth;
+
+	CborReader(const void* _data, uint _sizeBytes, Allocator& _allocator_)
+		: m_pos((const uint8*)_data)
+		, m_end((const uint8*)_data + _sizeBytes)
+		, m_allocator(_allocator_)
+		, m_error(nullptr)
+		, m_depth(0)
+	{
+	}
+
+	bool error(const char* _msg)
+	{
+		m_error = _msg;
+		return false;
+	}
+
+	uint remaining() const
+	{
+		return (uint)(m_end - m_pos);
+	}
+
+	bool readBE(uint64& value_, uint _sizeBytes)
+	{
+		if (remaining() < _sizeBytes) {
+			return error("Unexpected end of data");
+		}
+		value_ = 0;
+		for (uint i = 0; i < _sizeBytes; ++i) {
+			value_ = (value_ << 8) | *m_pos++;
+		}
+		return true;
+	}
+
+	// Read an initial byte + argument. info_ is the additional information (31 indicates an indefinite length or break).
+	bool readHead(uint8& major_, uint8& info_, uint64& value_)
+	{
+		if (remaining() < 1) {
+			return error("Unexpected end of data");
+		}
+		const uint8 byte = *m_pos++;
+		major_ = byte >> 5;
+		info_ = byte & 0x1f;
+		if (info_ < 24) {
+			value_ = info_;
+			return true;
+		}
+		switch (info_) {
+			case 24: return readBE(value_, 1);
+			case 25: return readBE(value_, 2);
+			case 26: return readBE(value_, 4);
+			case 27: return readBE(value_, 8);
+			case 31: value_ = 0; return true;
+			default: return error("Invalid additional information");
+		};
+	}
+
+	bool isBreak() const
+	{
+		return m_pos < m_end && *m_pos == 0xff;
+	}
+
+	// Read a definite length byte/text string of _type, return a ptr to the data.
+	const uint8* readString(CborMajorType _type, uint& length_)
+	{
+		uint8 major, info;
+		uint64 length;
+		if (!readHead(major, info, length)) {
+			return nullptr;
+		}
+		if (major != _type || info == 31) {
+			error(_type == CborMajorType_Bytes ? "Expected a definite length byte string" : "Expected a definite length text string");
+			return nullptr;
+		}
+		if (length > remaining()) {
+			error("Unexpected end of data");
+			return nullptr;
+		}
+		const uint8* ret = m_pos;
+		length_ = (uint)length;
+		m_pos += length;
+		return ret;
+	}
+
+	static double HalfToDouble(uint16 _half)
+	{
+		const int exponent = (_half >> 10) & 0x1f;
+		const int mantissa = _half & 0x3ff;
+		double ret;
+		if (exponent == 0) {
+			ret = ldexp((double)mantissa, -24);
+		} else if (exponent != 31) {
+			ret = ldexp((double)(mantissa + 1024), exponent - 25);
+		} else {
+			ret = mantissa == 0 ? INFINITY : NAN;
+		}
+		return (_half & 0x8000) ? -ret : ret;
+	}
+
+	bool readTypedArray(uint64 _tag, rapidjson::Value& value_)
+	{
+		const uint bits = (uint)(_tag - CborTypedArray_First);
+		const bool isFloat  = (bits & 0x10) != 0;
+		const bool isSigned = (bits & 0x08) != 0;
+		const bool isLE     = (bits & 0x04) != 0;
+		const uint sizeLog2 = bits & 0x03;
+		if (isFloat && (isSigned || sizeLog2 == 3)) {
+			return error("Unsupported typed array");
+		}
+		const uint elementSizeBytes = isFloat ? (2u << sizeLog2) : (1u << sizeLog2);
+
+		uint length;
+		const uint8* data = readString(CborMajorType_Bytes, length);
+		if (!data) {
+			return false;
+		}
+		if (length % elementSizeBytes != 0) {
+			return error("Typed array size is not a multiple of the element size");
+		}
+		const uint count = length / elementSizeBytes;
+		value_.SetArray();
+		value_.Reserve((rapidjson::SizeType)count, m_allocator);
+		for (uint i = 0; i < count; ++i, data += elementSizeBytes) {
+			uint64 raw = 0;
+			for (uint j = 0; j < elementSizeBytes; ++j) {
+				raw |= (uint64)data[isLE ? j : elementSizeBytes - j - 1] << (j * 8);
+			}
+			rapidjson::Value element;
+			if (isFloat) {
+				switch (elementSizeBytes) {
+					case 2: element.SetDouble(HalfToDouble((uint16)raw)); break;
+					case 4: { uint32 u = (uint32)raw; float32 f; memcpy(&f, &u, sizeof(f)); element.SetDouble(f); break; }
+					default: { float64 d; memcpy(&d, &raw, sizeof(d)); element.SetDouble(d); break; }
+				};
+			} else if (isSigned) {
+				const uint shift = 64 - elementSizeBytes * 8;
+				element.SetInt64((sint64)(raw << shift) >> shift); // sign extend
+			} else {
+				element.SetUint64(raw);
+			}
+			value_.PushBack(element, m_allocator);
+		}
+		return true;
+	}
+
+	bool readValue(rapidjson::Value& value_)
+	{
+		if (++m_depth > kCborMaxDepth) {
+			return error("Maximum depth exceeded");
+		}
+		const uint8* start = m_pos;
+		uint8 major, info;
+		uint64 arg;
+		if (!readHead(major, info, arg)) {
+			return false;
+		}
+		bool ret = true;
+		switch (major) {
+			case CborMajorType_Uint:
+				value_.SetUint64(arg);
+				break;
+			case CborMajorType_Sint:
+				if (arg > (uint64)INT64_MAX) {
+					return error("Negative integer out of range");
+				}
+				value_.SetInt64(-1 - (sint64)arg);
+				break;
+			case CborMajorType_Bytes:
+			case CborMajorType_String: {
+				if (info == 31) {
+					return error("Indefinite length strings are not supported");
+				}
+				m_pos = start;
+				uint length;
+				const uint8* data = readString((CborMajorType)major, length);
+				if (!data) {
+					return false;
+				}
+				if (major == CborMajorType_Bytes) {
+					SetBinary(value_, data, length, false, m_allocator);
+				} else {
+					value_.SetString((const char*)data, (rapidjson::SizeType)length, m_allocator);
+				}
+				break;
+			}
+			case CborMajorType_Array:
+				value_.SetArray();
+				if (info == 31) {
+					while (ret && !isBreak()) {
+						rapidjson::Value element;
+						ret = readValue(element);
+						value_.PushBack(element, m_allocator);
+					}
+					++m_pos;
+				} else {
+					value_.Reserve((rapidjson::SizeType)APT_MIN(arg, (uint64)remaining()), m_allocator); // each element is at least 1 byte
+					for (uint64 i = 0; ret && i < arg; ++i) {
+						rapidjson::Value element;
+						ret = readValue(element);
+						value_.PushBack(element, m_allocator);
+					}
+				}
+				break;
+			case CborMajorType_Map:
+				value_.SetObject();
+				for (uint64 i = 0; ret && (info == 31 ? !isBreak() : i < arg); ++i) {
+					uint length;
+					const uint8* name = readString(CborMajorType_String, length);
+					if (!name) {
+						return false;
+					}
+					rapidjson::Value key((const char*)name, (rapidjson::SizeType)length, m_allocator);
+					rapidjson::Value member;
+					ret = readValue(member);
+					value_.AddMember(key, member, m_allocator);
+				}
+				if (info == 31) {
+					++m_pos;
+				}
+				break;
+			case CborMajorType_Tag:
+				if (arg >= CborTypedArray_First && arg <= CborTypedArray_Last) {
+					ret = readTypedArray(arg, value_);
+				} else if (arg == kCborTagCompressed) {
+					uint length;
+					const uint8* data = readString(CborMajorType_Bytes, length);
+					if (!data) {
+						return false;
+					}
+					SetBinary(value_, data, length, true, m_allocator);
+				} else {
+				 // ignore unknown tags
+					ret = readValue(value_);
+					--m_depth;
+				}
+				break;
+			case CborMajorType_Simple:
+				switch (info) {
+					case 20: value_.SetBool(false); break;
+					case 21: value_.SetBool(true); break;
+					case 22:
+					case 23: value_.SetNull(); break; // undefined -> null
+					case 25: value_.SetDouble(HalfToDouble((uint16)arg)); break;
+					case 26: { uint32 u = (uint32)arg; float32 f; memcpy(&f, &u, sizeof(f)); value_.SetDouble(f); break; }
+					case 27: { float64 d; memcpy(&d, &arg, sizeof(d)); value_.SetDouble(d); break; }
+					default: return error("Unsupported simple value");
+				};
+				break;
+			default:
+				APT_ASSERT(false);
+				break;
+		};
+		if (m_pos > m_end) {
+			return error("Unexpected end of data");
+		}
+		--m_depth;
+		return ret;
+	}
+};
+
+// PUBLIC
+
+bool Json::ReadBinary(Json& json_, const File& _file)
+{
+	rapidjson::Document& dom = json_.m_impl->m_dom;
+	rapidjson::Value root;
+	CborReader reader(_file.getData(), (uint)_file.getDataSize(), dom.GetAllocator());
+	bool ret = reader.readValue(root);
+	if (ret && reader.remaining() != 0) {
+		ret = reader.error("Unexpected data after the root value");
+	}
+	if (ret && !root.IsObject()) {
+		ret = reader.error("Root value is not a map");
+	}
+	if (!ret) {
+		APT_LOG_ERR("Json error: %s\n\t'%s'", _file.getPath(), reader.m_error);
+		return false;
+	}
+	static_cast<rapidjson::Value&>(dom) = root;
+	File().swap(json_.m_impl->m_insituFile);
+	json_.m_impl->m_memberIndex.clear();
+	return true;
+}
+
+bool Json::ReadBinary(Json& json_, const char* _path, FileSystem::RootType _rootHint)
+{
+	APT_AUTOTIMER("Json::ReadBinary(%s)", _path);
+	File f;
+	if (!FileSystem::ReadIfExists(f, _path, _rootHint)) {
+		return false;
+	}
+	return ReadBinary(json_, f);
+}
+
+bool Json::WriteBinary(const Json& _json, File& file_)
+{
+	CborWriter writer;
+	writer.writeValue(_json.m_impl->m_dom);
+	file_.setData(writer.m_buffer.data(), writer.m_buffer.size());
+	return true;
+}
+
+bool Json::WriteBinary(const Json& _json, const char* _path, FileSystem::RootType _rootHint)
+{
+	APT_AUTOTIMER("Json::WriteBinary(%s)", _path);
+	File f;
+	if (WriteBinary(_json, f)) {
+		return FileSystem::Write(f, _path, _rootHint);
+	}
+	return false;
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+// Implementation details shared by Json.cpp and the Json*.cpp files, not part of the public interface.
+
+#include <apt/Json.h>
+#include <apt/JsonArena.h>
+#include <apt/JsonSchema.h>
+
+#include <apt/base64.h>
+#include <apt/hash.h>
+#include <apt/log.h>
+#include <apt/memory.h>
+#include <apt/File.h>
+#include <apt/String.h>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+#define RAPIDJSON_ASSERT(x) APT_ASSERT(x)
+#define RAPIDJSON_PARSE_DEFAULT_FLAGS (kParseFullPrecisionFlag | kParseCommentsFlag | kParseTrailingCommasFlag)
+#include <rapidjson/error/en.h>
+#include <rapidjson/document.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/schema.h>
+
+namespace apt {
+
+struct JsonArena::Impl
+{
+	typedef rapidjson::MemoryPoolAllocator<> Allocator;
+	static const uint kBufferOverhead = 64; // >= sizeof(Allocator::ChunkHeader), which is stored at the start of the buffer
+
+	char* m_buffer       = nullptr;
+	uint  m_bufferSize   = 0;
+	uint  m_chunkSize    = 0;
+	uint  m_baseCapacity = 0; // Allocator capacity after init, if exceeded additional chunks were allocated.
+
+ // the allocator is constructed in place so that reset() can recreate it with a larger buffer without invalidating the ptr held by documents
+	alignas(Allocator) char m_allocator[sizeof(Allocator)];
+
+	Allocator& getAllocator()
+	{
+		return *((Allocator*)m_allocator);
+	}
+	void initAllocator()
+	{
+		if (m_buffer) {
+			new(m_allocator) Allocator(m_buffer, m_bufferSize, m_chunkSize);
+		} else {
+			new(m_allocator) Allocator(m_chunkSize);
+		}
+		m_baseCapacity = (uint)getAllocator().Capacity();
+	}
+	void shutdownAllocator()
+	{
+		getAllocator().~Allocator();
+	}
+};
+
+struct JsonSchema::Impl
+{
+	rapidjson::Document        m_source;             // Schema text, must outlive m_document.
+	rapidjson::SchemaDocument* m_document = nullptr;
+	PathStr                    m_path;
+
+	// Resolve remote references via JsonSchema::Find().
+	struct RemoteProvider: public rapidjson::IRemoteSchemaDocumentProvider
+	{
+		FileSystem::RootType m_rootHint;
+
+		const rapidjson::SchemaDocument* GetRemoteDocument(const char* _uri, rapidjson::SizeType _length) override
+		{
+			PathStr path;
+			path.append(_uri, (uint)_length);
+			const JsonSchema* schema = JsonSchema::Find((const char*)path, m_rootHint);
+			return schema ? schema->m_impl->m_document : nullptr;
+		}
+	};
+
+	// Generator for rapidjson::Document::Populate(), filters parser events through a validator.
+	template <unsigned kFlags, typename tStream>
+	struct ValidatingParser
+	{
+		tStream&    m_stream;
+		const Impl& m_schema;
+		const char* m_path;
+		bool        m_ret = false;
+
+		ValidatingParser(tStream& _stream_, const Impl& _schema, const char* _path)
+			: m_stream(_stream_)
+			, m_schema(_schema)
+			, m_path(_path)
+		{
+		}
+
+		template <typename tHandler>
+		bool operator()(tHandler& _handler_)
+		{
+		 // validation state is allocated per object/array, a pool avoids the malloc/free overhead
+			rapidjson::MemoryPoolAllocator<> stateAllocator;
+			rapidjson::GenericSchemaValidator<rapidjson::SchemaDocument, tHandler, rapidjson::MemoryPoolAllocator<> > validator(*m_schema.m_document, _handler_, &stateAllocator);
+			rapidjson::Reader reader;
+			rapidjson::ParseResult result = reader.Parse<kFlags>(m_stream, validator);
+			if (!validator.IsValid()) {
+				LogError(validator, m_path);
+			} else if (result.IsError()) {
+				APT_LOG_ERR("Json error: %s\n\t'%s'", m_path, rapidjson::GetParseError_En(result.Code()));
+			}
+			return m_ret = !result.IsError();
+		}
+	};
+
+	~Impl()
+	{
+		APT_DELETE(m_document);
+	}
+
+	bool compile(const File& _file, FileSystem::RootType _rootHint)
+	{
+		rapidjson::Document source;
+		source.Parse(_file.getData());
+		if (source.HasParseError()) {
+			APT_LOG_ERR("JsonSchema error: %s\n\t'%s'", _file.getPath(), rapidjson::GetParseError_En(source.GetParseError()));
+			return false;
+		}
+		APT_DELETE(m_document);
+		m_source.Swap(source);
+		RemoteProvider provider;
+		provider.m_rootHint = _rootHint;
+		m_document = APT_NEW(rapidjson::SchemaDocument(m_source, &provider));
+		m_path.set(_file.getPath());
+		return true;
+	}
+
+	// Parse _stream_ into dom_, return false if a parse or validation error occurred in which case dom_ is unchanged.
+	template <unsigned kFlags, typename tStream>
+	bool parse(rapidjson::Document& dom_, tStream& _stream_, const char* _path) const
+	{
+		APT_ASSERT(m_document); // not initialized
+		ValidatingParser<kFlags, tStream> parser(_stream_, *this, _path);
+		dom_.Populate(parser);
+		return parser.m_ret;
+	}
+
+	template <typename tValidator>
+	static void LogError(const tValidator& _validator, const char* _path)
+	{
+		rapidjson::StringBuffer documentPointer;
+		rapidjson::StringBuffer schemaPointer;
+		_validator.GetInvalidDocumentPointer().Stringify(documentPointer);
+		_validator.GetInvalidSchemaPointer().Stringify(schemaPointer);
+		APT_LOG_ERR("Json schema error: %s\n\t'%s' failed at '%s' (schema '%s')",
+			_path,
+			_validator.GetInvalidSchemaKeyword(),
+			documentPointer.GetString(),
+			schemaPointer.GetString()
+			);
+	}
+};
+
+inline Json::ValueType GetValueType(rapidjson::Type _type)
+{
+	switch (_type) {
+		case rapidjson::kNullType:   return Json::ValueType_Null;
+		case rapidjson::kObjectType: return Json::ValueType_Object;
+		case rapidjson::kArrayType:  return Json::ValueType_Array;
+		case rapidjson::kFalseType:
+		case rapidjson::kTrueType:   return Json::ValueType_Bool;
+		case rapidjson::kNumberType: return Json::ValueType_Number;
+		case rapidjson::kStringType: return Json::ValueType_String;
+		default: APT_ASSERT(false); break;
+	};
+
+	return Json::ValueType_Count;
+}
+
+struct Json::Impl
+{
+	JsonArena*          m_arena;
+	bool                m_ownArena;
+	rapidjson::Document m_dom;
+	File                m_insituFile; // Data referenced by m_dom after ReadInsitu().
+
+ // current value set after find()
+	rapidjson::Value* m_value = nullptr;
+
+	Impl(JsonArena* _arena, bool _ownArena)
+		: m_arena(_arena)
+		, m_ownArena(_ownArena)
+		, m_dom(&_arena->m_impl->getAllocator())
+	{
+	}
+
+ // value stack for objects/arrays
+	struct Level
+	{
+		rapidjson::Value* m_value;
+		int               m_iter;      // Used by next().
+		int               m_lastFind;  // Member index of the last successful find(), -1 if none.
+		bool              m_created;   // Object was created by beginObject(), see SerializerJson::canAppend().
+	};
+	eastl::vector<Level> m_stack;
+
+ // lookup index for large objects, built on the first find() and keyed by the object's address. Members appended since the last find()
+ // are indexed incrementally. If members were removed or the object was replaced (e.g. a value swapped into the same address) the
+ // index is rebuilt, this is detected via the member count and the name of the last indexed member
+	struct MemberIndex
+	{
+		uint                               m_count    = 0;        // Number of members indexed.
+		const char*                        m_lastName = nullptr;  // Name of member m_count - 1 when it was indexed.
+		eastl::hash_map<uint64, uint32>    m_map;                 // Name hash -> member index.
+	};
+	eastl::hash_map<const rapidjson::Value*, MemberIndex> m_memberIndex;
+	uint m_memberIndexThreshold = kDefaultMemberIndexThreshold;
+
+	void push(rapidjson::Value* _val = nullptr)
+	{
+		APT_ASSERT(m_stack.empty() || top() != _val); // probably a mistake, called push() twice?
+		Level level;
+		level.m_value    = _val ? _val : m_value;
+		level.m_iter     = 0;
+		level.m_lastFind = -1;
+		level.m_created  = false;
+		m_stack.push_back(level);
+	}
+	void pop()
+	{
+		APT_ASSERT(!m_stack.empty());
+		m_stack.pop_back();
+	}
+	// Reset the value stack to the root, e.g. after the document was modified directly.
+	void resetStack()
+	{
+		m_memberIndex.clear();
+		m_stack.clear();
+		m_value = nullptr;
+		push(&m_dom);
+	}
+	rapidjson::Value* top() 
+	{
+		APT_ASSERT(!m_stack.empty());
+		return m_stack.back().m_value;
+	}
+	int& topIter()
+	{
+		APT_ASSERT(!m_stack.empty());
+		return m_stack.back().m_iter;
+	}
+
+	// Return true if the _ith member of _object matches _nameHash/_name. If _name is null only the hash is compared.
+	static bool MemberMatches(const rapidjson::Value& _object, uint _i, uint64 _nameHash, const char* _name)
+	{
+		const char* name = (_object.MemberBegin() + _i)->name.GetString();
+		return _name ? strcmp(name, _name) == 0 : HashString<uint64>(name) == _nameHash;
+	}
+
+	// Find a member of the current object by _nameHash/_name, return the member index or -1 if not found. If both are specified
+	// _name is compared and _nameHash is used for the index.
+	int findMember(uint64 _nameHash, const char* _name)
+	{
+		Level& level = m_stack.back();
+		const rapidjson::Value& object = *level.m_value;
+		const int count = (int)object.MemberCount();
+
+	 // in-order access, check the member after the last find() first
+		for (int i = level.m_lastFind + 1; i >= level.m_lastFind && i >= 0; --i) {
+			if (i < count && MemberMatches(object, (uint)i, _nameHash, _name)) {
+				return level.m_lastFind = i;
+			}
+		}
+
+		if (m_memberIndexThreshold > 0 && count >= (int)m_memberIndexThreshold) {
+			MemberIndex& index = m_memberIndex[&object];
+			if (index.m_count > (uint)count || (index.m_count > 0 && (object.MemberBegin() + (index.m_count - 1))->name.GetString() != index.m_lastName)) {
+				index.m_count = 0;
+				index.m_map.clear();
+			}
+			for (; index.m_count < (uint)count; ++index.m_count) { // index any members added since the last find()
+				uint64 hash = HashString<uint64>((object.MemberBegin() + index.m_count)->name.GetString());
+				index.m_map.insert(eastl::make_pair(hash, (uint32)index.m_count)); // first member with a given name takes precedence
+			}
+			index.m_lastName = count > 0 ? (object.MemberBegin() + (count - 1))->name.GetString() : nullptr;
+			if (_name && _nameHash == 0) {
+				_nameHash = HashString<uint64>(_name);
+			}
+			auto it = index.m_map.find(_nameHash);
+			if (it == index.m_map.end()) {
+				return -1;
+			}
+			if (MemberMatches(object, it->second, _nameHash, _name)) {
+				return level.m_lastFind = (int)it->second;
+			}
+		 // hash collision, fall back to a linear search
+		}
+
+		for (int i = 0; i < count; ++i) {
+			if (MemberMatches(object, (uint)i, _nameHash, _name)) {
+				return level.m_lastFind = i;
+			}
+		}
+		return -1;
+	}
+
+	// Get the current value, optionally access the element _i if an array.
+	rapidjson::Value* get(int _i = -1) 
+	{
+		rapidjson::Value* ret = m_value;
+		APT_ASSERT(ret);
+		if (_i >= 0 && GetValueType(ret->GetType()) == ValueType_Array) {
+			int n = (int)ret->GetArray().Size();
+			APT_ASSERT_MSG(_i < n, "Array index out of bounds (%d/%d)", _i, n);
+			ret = &ret->GetArray()[_i];
+		}
+		return ret;
+	}
+};
+
+// Binary data (see SerializerJson::binary()) is stored in the DOM as an object with a single member named kBinaryName, whose value
+// is a string containing '0' (or '1' if compressed) followed by the raw bytes. The member name is a const string and is identified
+// by its address, hence parsed text can't produce a binary value. Json::Write() encodes the data as base64 (prefixed by '0' or '1'),
+// Json::WriteBinary() as a CBOR byte string.
+extern const char kBinaryName[];
+const uint        kBinaryHeaderSize = 1;
+
+inline bool IsBinaryName(const rapidjson::Value& _name)
+{
+	return _name.GetString() == kBinaryName;
+}
+
+// Return the binary string (including the header) if _value is binary data, else nullptr.
+inline const rapidjson::Value* GetBinary(const rapidjson::Value& _value)
+{
+	if (!_value.IsObject() || _value.MemberCount() != 1) {
+		return nullptr;
+	}
+	const rapidjson::Value::Member& member = *_value.MemberBegin();
+	if (!IsBinaryName(member.name) || !member.value.IsString() || member.value.GetStringLength() < kBinaryHeaderSize) {
+		return nullptr;
+	}
+	return &member.value;
+}
+
+// Set value_ to binary data, _data is copied.
+void SetBinary(rapidjson::Value& value_, const void* _data, uint _sizeBytes, bool _compressed, rapidjson::Document::AllocatorType& _allocator_);
+
+// Deep copy _src to dst_. Unlike rapidjson's CopyFrom(), strings which reference external memory (string refs, in situ strings) are
+// always copied (except the binary member name, which is identified by its address).
+void CopyValue(rapidjson::Value& dst_, const rapidjson::Value& _src, rapidjson::Document::AllocatorType& _allocator_);
+
+// Write a short decimal representation of _value which round trips as a float32 (Grisu2, as rapidjson::internal::dtoa() but
+// with the boundaries of a float32), e.g. 0.1f is written as "0.1" rather than "0.10000000149011612". _value must be finite. Return
+// a pointer to the end of the string (not null terminated), buffer_ should be at least 32 bytes.
+char* Float32ToString(float _value, char* buffer_);
+
+// SAX handler for Json::Write(), forwards to tWriter and converts binary objects to base64 strings. StartObject() is deferred until
+// the first key is known, binary objects are reduced to their string member.
+template <typename tWriter>
+struct Base64Handler
+{
+	tWriter&            m_writer;
+	eastl::vector<char> m_buffer;
+	bool                m_float32;
+	bool                m_objectPending = false; // StartObject() not yet forwarded
+	bool                m_binaryString  = false; // next String() is binary data
+	bool                m_binaryEnd     = false; // next EndObject() closes a binary object
+
+	Base64Handler(tWriter& _writer_, bool _float32 = false): m_writer(_writer_), m_float32(_float32) {}
+
+	bool flush()
+	{
+		if (m_objectPending) {
+			m_objectPending = false;
+			return m_writer.StartObject();
+		}
+		return true;
+	}
+
+	bool Null()                                                            { return flush() && m_writer.Null(); }
+	bool Bool(bool _b)                                                     { return flush() && m_writer.Bool(_b); }
+	bool Int(int _i)                                                       { return flush() && m_writer.Int(_i); }
+	bool Uint(unsigned _u)                                                 { return flush() && m_writer.Uint(_u); }
+	bool Int64(int64_t _i)                                                 { return flush() && m_writer.Int64(_i); }
+	bool Uint64(uint64_t _u)                                               { return flush() && m_writer.Uint64(_u); }
+	bool RawNumber(const char* _str, rapidjson::SizeType _len, bool _copy) { return flush() && m_writer.RawNumber(_str, _len, _copy); }
+	bool StartObject()                                                     { bool ret = flush(); m_objectPending = true; return ret; }
+	bool StartArray()                                                      { return flush() && m_writer.StartArray(); }
+	bool EndArray(rapidjson::SizeType _count)                              { return flush() && m_writer.EndArray(_count); }
+
+	bool Key(const char* _str, rapidjson::SizeType _len, bool _copy)
+	{
+		if (m_objectPending && _str == kBinaryName) {
+			m_objectPending = false;
+			m_binaryString = true;
+			return true;
+		}
+		return flush() && m_writer.Key(_str, _len, _copy);
+	}
+
+	bool EndObject(rapidjson::SizeType _count)
+	{
+		if (m_binaryEnd) {
+			m_binaryEnd = false;
+			return true;
+		}
+		return flush() && m_writer.EndObject(_count);
+	}
+
+	bool Double(double _d)
+	{
+		if (!flush()) {
+			return false;
+		}
+	 // non-finite values and values outside the float32 range go to the writer (which fails on NaN/infinity)
+		if (!m_float32 || !(fabs(_d) <= (double)FLT_MAX)) {
+			return m_writer.Double(_d);
+		}
+		char buf[32];
+		const char* end = Float32ToString((float)_d, buf);
+		return m_writer.RawValue(buf, (size_t)(end - buf), rapidjson::kNumberType);
+	}
+
+	bool String(const char* _str, rapidjson::SizeType _len, bool _copy)
+	{
+		if (!m_binaryString) {
+			return flush() && m_writer.String(_str, _len, _copy);
+		}
+		m_binaryString = false;
+		m_binaryEnd = true;
+		const uint binSizeBytes = _len - kBinaryHeaderSize;
+		const uint strLength = Base64EncSizeBytes(binSizeBytes) + 1;
+		m_buffer.resize(strLength + 1);
+		m_buffer[0] = _str[0];
+		Base64Encode(_str + kBinaryHeaderSize, binSizeBytes, m_buffer.data() + 1, strLength);
+		return m_writer.String(m_buffer.data(), (rapidjson::SizeType)strLength, true);
+	}
+};
+
+// Store a single value (string values are copied to m_str), used by JsonReader/JsonIndex.
+struct ValueHandler: public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ValueHandler>
+{
+	rapidjson::Value*    m_value;
+	eastl::vector<char>* m_str;
+
+	ValueHandler(rapidjson::Value* _value, eastl::vector<char>* _str): m_value(_value), m_str(_str) {}
+
+	bool Null()              { m_value->SetNull();    return true; }
+	bool Bool(bool _b)       { m_value->SetBool(_b);   return true; }
+	bool Int(int _i)         { m_value->SetInt(_i);    return true; }
+	bool Uint(unsigned _u)   { m_value->SetUint(_u);   return true; }
+	bool Int64(int64_t _i)   { m_value->SetInt64(_i);  return true; }
+	bool Uint64(uint64_t _u) { m_value->SetUint64(_u); return true; }
+	bool Double(double _d)   { m_value->SetDouble(_d); return true; }
+	bool String(const char* _str, rapidjson::SizeType _len, bool)
+	{
+		m_str->assign(_str, _str + _len);
+		m_str->push_back('\0');
+		m_value->SetString(rapidjson::StringRef(m_str->data(), _len));
+		return true;
+	}
+};
+
+} // namespace apt
@@ -0,0 +1,640 @@
+#include <apt/JsonIndex.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/log.h>
+#include <apt/memory.h>
+
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+#include <emmintrin.h> // SSE2
+#if APT_COMPILER_MSVC
+	#include <intrin.h>
+#endif
+
+using namespace apt;
+
+struct JsonIndex::Impl
+{
+	static const unsigned kParseFlags = rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag; // parse a single value
+	static const uint32   kInvalid    = ~0u;
+	static const uint     kBlockSize  = 64;
+
+ // tape node per value (and per member name); the nodes of a value are [i, m_end), hence skipping a value is m_end
+	struct Node
+	{
+		uint32 m_offset;  // Offset of the first character.
+		uint32 m_end;     // Index of the next sibling node.
+		uint32 m_count;   // Element/member count for objects/arrays.
+	};
+
+	enum State
+	{
+		State_Value,       // Expect a value (root, or after ':').
+		State_ArrayValue,  // Expect a value or ']'.
+		State_Key,         // Expect a member name or '}'.
+		State_Colon,       // Expect ':'.
+		State_Comma,       // Expect ',' or the closing '}'/']'.
+		State_Done         // Root closed.
+	};
+
+	struct Level
+	{
+		uint32 m_node;      // Object/array node.
+		uint32 m_pos;       // Next member/element node.
+	};
+
+	const char*           m_data  = nullptr;
+	uint                  m_size  = 0;
+	eastl::vector<Node>   m_tape;
+	String<64>            m_error;
+
+ // build state
+	eastl::vector<uint32> m_open;  // Open object/array nodes.
+	State                 m_state = State_Value;
+
+ // cursor state
+	eastl::vector<Level>  m_stack;
+	uint32                m_current = kInvalid;
+	Json::ValueType       m_type    = Json::ValueType_Count;
+	rapidjson::Reader     m_reader;
+	rapidjson::Value      m_value;
+	eastl::vector<char>   m_string;
+	eastl::vector<char>   m_name;
+	rapidjson::Value      m_nameValue;
+
+	bool setError(uint _offset, const char* _msg)
+	{
+		if (m_error.isEmpty()) {
+			m_error.setf("offset %u: %s", (uint32)_offset, _msg);
+			APT_LOG_ERR("JsonIndex error: %s", (const char*)m_error);
+		}
+		return false;
+	}
+
+	void pushNode(uint32 _offset)
+	{
+		Node node;
+		node.m_offset = _offset;
+		node.m_end    = (uint32)m_tape.size() + 1;
+		node.m_count  = 0;
+		m_tape.push_back(node);
+	}
+
+	void endValue()
+	{
+		if (m_open.empty()) {
+			m_state = State_Done;
+		} else {
+			++m_tape[m_open.back()].m_count;
+			m_state = State_Comma;
+		}
+	}
+
+	bool close(uint32 _offset, char _c)
+	{
+		const uint32 node = m_open.back();
+		if (m_data[m_tape[node].m_offset] != (_c == '}' ? '{' : '[')) {
+			return setError(_offset, _c == '}' ? "Missing a comma or ']' after an array element." : "Missing a comma or '}' after an object member.");
+		}
+		m_tape[node].m_end = (uint32)m_tape.size();
+		m_open.pop_back();
+		endValue();
+		return true;
+	}
+
+	// Stage 2: consume the next structural/pseudo-structural character (see scanBlock()).
+	bool token(uint32 _offset)
+	{
+		const char c = m_data[_offset];
+		switch (m_state) {
+			case State_ArrayValue:
+				if (c == ']') {
+					return close(_offset, c);
+				}
+				// fall through
+			case State_Value:
+				if (c == '{' || c == '[') {
+					m_open.push_back((uint32)m_tape.size());
+					pushNode(_offset);
+					m_state = c == '{' ? State_Key : State_ArrayValue;
+					return true;
+				}
+				if (m_open.empty()) {
+					return setError(_offset, "The document root must be an object or an array.");
+				}
+				if (c == '"' || c == 't' || c == 'f' || c == 'n' || c == '-' || (c >= '0' && c <= '9')) {
+					pushNode(_offset);
+					endValue();
+					return true;
+				}
+				return setError(_offset, "Invalid value.");
+			case State_Key:
+				if (c == '}') {
+					return close(_offset, c);
+				}
+				if (c != '"') {
+					return setError(_offset, "Missing a name for object member.");
+				}
+				pushNode(_offset);
+				m_state = State_Colon;
+				return true;
+			case State_Colon:
+				if (c != ':') {
+					return setError(_offset, "Missing a colon after a name of object member.");
+				}
+				m_state = State_Value;
+				return true;
+			case State_Comma: {
+				const bool isArray = m_data[m_tape[m_open.back()].m_offset] == '[';
+				if (c == ',') {
+					m_state = isArray ? State_ArrayValue : State_Key; // permits trailing commas
+					return true;
+				}
+				if (c == '}' || c == ']') {
+					return close(_offset, c);
+				}
+				return setError(_offset, isArray ? "Missing a comma or ']' after an array element." : "Missing a comma or '}' after an object member.");
+			}
+			default:
+				break;
+		};
+		return setError(_offset, "The document root must not be followed by other values.");
+	}
+
+	static uint64 PrefixXor(uint64 _x)
+	{
+		_x ^= _x << 1;
+		_x ^= _x << 2;
+		_x ^= _x << 4;
+		_x ^= _x << 8;
+		_x ^= _x << 16;
+		_x ^= _x << 32;
+		return _x;
+	}
+
+	static uint CountTrailingZeros(uint64 _x)
+	{
+		#if APT_COMPILER_MSVC
+			unsigned long ret;
+			_BitScanForward64(&ret, _x);
+			return (uint)ret;
+		#else
+			return (uint)__builtin_ctzll(_x);
+		#endif
+	}
+
+	// Stage 1 (SSE2): classify a 64 byte block and pass the offsets of structural characters, opening quotes and the first
+	// character of other values to token(). Carries (escape, in-string, separator) are propagated between blocks. Return false if
+	// an error occurred or a comment was found (outside a string), in which case the scalar path must be used.
+	struct ScanState
+	{
+		uint64 m_escaped   = 0; // First character of the next block is escaped.
+		uint64 m_inString  = 0; // ~0 if the next block begins inside a string.
+		uint64 m_separator = 1; // Last character of the previous block was whitespace, structural or a quote.
+	};
+
+	bool scanBlock(const char* _block, uint32 _offset, ScanState& _state_, bool& comment_)
+	{
+		uint64 quote = 0, backslash = 0, slash = 0, structural = 0, whitespace = 0;
+		for (uint i = 0; i < kBlockSize / 16; ++i) {
+			const __m128i v = _mm_loadu_si128((const __m128i*)(_block + i * 16));
+			const __m128i s = _mm_or_si128(
+				_mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}'))),
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('[')), _mm_cmpeq_epi8(v, _mm_set1_epi8(']')))
+					),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(',')))
+				);
+			const __m128i w = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),  _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+				_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')))
+				);
+			const uint shift = i * 16;
+			quote      |= (uint64)(uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')))  << shift;
+			backslash  |= (uint64)(uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << shift;
+			slash      |= (uint64)(uint16)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')))  << shift;
+			structural |= (uint64)(uint16)_mm_movemask_epi8(s) << shift;
+			whitespace |= (uint64)(uint16)_mm_movemask_epi8(w) << shift;
+		}
+
+	 // escaped characters follow an unescaped backslash (backslashes are rare, hence loop over them)
+		uint64 escaped = _state_.m_escaped;
+		_state_.m_escaped = 0;
+		while (backslash) {
+			const uint i = CountTrailingZeros(backslash);
+			backslash &= backslash - 1;
+			if ((escaped >> i) & 1) {
+				continue;
+			}
+			if (i == kBlockSize - 1) {
+				_state_.m_escaped = 1;
+			} else {
+				escaped |= 1ull << (i + 1);
+			}
+		}
+		quote &= ~escaped;
+
+	 // in-string mask includes the opening quote but not the closing quote
+		const uint64 inString = PrefixXor(quote) ^ _state_.m_inString;
+		_state_.m_inString = (uint64)((sint64)inString >> 63);
+		if (slash & ~inString) {
+			comment_ = true;
+			return false;
+		}
+		structural &= ~inString;
+		const uint64 other = ~(inString | quote | structural | whitespace);
+		const uint64 separator = whitespace | structural | quote;
+		uint64 tokens = structural | (quote & inString) | (other & ((separator << 1) | _state_.m_separator));
+		_state_.m_separator = separator >> 63;
+
+		while (tokens) {
+			if (!token(_offset + CountTrailingZeros(tokens))) {
+				return false;
+			}
+			tokens &= tokens - 1;
+		}
+		return true;
+	}
+
+	// Stage 1 (scalar), supports comments.
+	bool scan()
+	{
+		uint i = 0;
+		while (i < m_size) {
+			const char c = m_data[i];
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+				++i;
+			} else if (c == '/') {
+				if (i + 1 < m_size && m_data[i + 1] == '/') {
+					while (i < m_size && m_data[i] != '\n') {
+						++i;
+					}
+				} else if (i + 1 < m_size && m_data[i + 1] == '*') {
+					i += 2;
+					while (i + 1 < m_size && !(m_data[i] == '*' && m_data[i + 1] == '/')) {
+						++i;
+					}
+					if (i + 1 >= m_size) {
+						return setError(m_size, "Unterminated comment.");
+					}
+					i += 2;
+				} else {
+					return setError(i, "Invalid value.");
+				}
+			} else if (c == '"') {
+				if (!token((uint32)i)) {
+					return false;
+				}
+				for (++i; i < m_size && m_data[i] != '"'; ++i) {
+					i += m_data[i] == '\\' ? 1 : 0;
+				}
+				if (i >= m_size) {
+					return setError(m_size, "Missing a closing quotation mark in string.");
+				}
+				++i;
+			} else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') {
+				if (!token((uint32)i)) {
+					return false;
+				}
+				++i;
+			} else {
+				if (!token((uint32)i)) {
+					return false;
+				}
+				while (i < m_size && !strchr(" \t\n\r{}[]:,\"/", m_data[i])) {
+					++i;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool build()
+	{
+		m_tape.clear();
+		m_open.clear();
+		m_state = State_Value;
+
+		ScanState scanState;
+		bool comment = false;
+		uint32 offset = 0;
+		for (; offset + kBlockSize <= m_size; offset += kBlockSize) {
+			if (!scanBlock(m_data + offset, offset, scanState, comment)) {
+				break;
+			}
+		}
+		if (!comment && m_error.isEmpty() && offset < m_size) {
+		 // pad the last block with whitespace
+			char block[kBlockSize];
+			memset(block, ' ', kBlockSize);
+			memcpy(block, m_data + offset, m_size - offset);
+			scanBlock(block, offset, scanState, comment);
+		}
+		if (comment) {
+		 // comments are uncommon, restart on the scalar path
+			m_tape.clear();
+			m_open.clear();
+			m_state = State_Value;
+			scan();
+		} else if (m_error.isEmpty() && scanState.m_inString) {
+			setError(m_size, "Missing a closing quotation mark in string.");
+		}
+		if (!m_error.isEmpty()) {
+			return false;
+		}
+		if (m_state != State_Done) {
+			return setError(m_size, m_tape.empty() ? "The document is empty." : "Unexpected end of document.");
+		}
+		eastl::vector<uint32>().swap(m_open);
+		return true;
+	}
+
+	// Parse the scalar value at _node via _handler_.
+	template <typename tHandler>
+	bool parse(uint32 _node, tHandler& _handler_)
+	{
+		const uint32 offset = m_tape[_node].m_offset;
+		rapidjson::MemoryStream is(m_data + offset, (size_t)(m_size - offset));
+		rapidjson::ParseResult result = m_reader.Parse<kParseFlags>(is, _handler_);
+		if (result.IsError()) {
+			return setError((uint)(offset + result.Offset()), rapidjson::GetParseError_En(result.Code()));
+		}
+		return true;
+	}
+
+	// Set the current value (and name if _key != kInvalid), scalar values are parsed.
+	bool setCurrent(uint32 _node, uint32 _key)
+	{
+		m_current = _node;
+		m_type = Json::ValueType_Count;
+		if (_key != kInvalid) {
+			ValueHandler nameHandler(&m_nameValue, &m_name);
+			if (!parse(_key, nameHandler)) {
+				return false;
+			}
+		}
+		const char c = m_data[m_tape[_node].m_offset];
+		if (c == '{' || c == '[') {
+			m_type = c == '{' ? Json::ValueType_Object : Json::ValueType_Array;
+			return true;
+		}
+		ValueHandler valueHandler(&m_value, &m_string);
+		if (!parse(_node, valueHandler)) {
+			return false;
+		}
+		m_type = GetValueType(m_value.GetType());
+		return true;
+	}
+
+	// Compare the member name at _key with _name without unescaping, unless the name contains escape sequences.
+	bool keyMatches(uint32 _key, const char* _name, uint _nameLength, bool _namePlain)
+	{
+		const uint32 offset = m_tape[_key].m_offset + 1;
+		const char* key = m_data + offset;
+		if (_namePlain && _nameLength < m_size - offset && memcmp(key, _name, _nameLength) == 0 && key[_nameLength] == '"') {
+			return true;
+		}
+		bool escaped = !_namePlain;
+		for (uint i = 0; !escaped && offset + i < m_size && key[i] != '"'; ++i) {
+			escaped = key[i] == '\\';
+		}
+		if (!escaped) {
+			return false;
+		}
+		ValueHandler nameHandler(&m_nameValue, &m_name);
+		return parse(_key, nameHandler) && strcmp(m_name.data(), _name) == 0;
+	}
+
+	bool enter(Json::ValueType _type)
+	{
+		if (m_current == kInvalid || m_type != _type) {
+			return false;
+		}
+		Level level;
+		level.m_node = m_current;
+		level.m_pos  = m_current + 1;
+		m_stack.push_back(level);
+		m_current = kInvalid;
+		m_type = Json::ValueType_Count;
+		return true;
+	}
+
+	void leave(Json::ValueType _type)
+	{
+		APT_ASSERT(m_stack.size() > 1); // can't leave the root
+		APT_ASSERT((m_data[m_tape[m_stack.back().m_node].m_offset] == '[') == (_type == Json::ValueType_Array));
+		m_stack.pop_back();
+		m_current = kInvalid;
+		m_type = Json::ValueType_Count;
+	}
+};
+
+// PUBLIC
+
+JsonIndex::JsonIndex()
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl);
+}
+
+JsonIndex::~JsonIndex()
+{
+	APT_DELETE(m_impl);
+}
+
+bool JsonIndex::init(const char* _data, uint64 _dataSize)
+{
+	m_impl->m_data    = _data;
+	m_impl->m_size    = 0;
+	m_impl->m_current = Impl::kInvalid;
+	m_impl->m_type    = Json::ValueType_Count;
+	m_impl->m_stack.clear();
+	m_impl->m_error.clear();
+	if (_dataSize > (uint64)UINT32_MAX) {
+		m_impl->m_tape.clear();
+		return m_impl->setError(0, "The document is too large (> 4GB).");
+	}
+	m_impl->m_size = (uint)_dataSize;
+	if (!m_impl->build()) {
+		m_impl->m_tape.clear();
+		return false;
+	}
+	Impl::Level level;
+	level.m_node = 0;
+	level.m_pos  = 1;
+	m_impl->m_stack.push_back(level);
+	return true;
+}
+
+const char* JsonIndex::getError() const
+{
+	return m_impl->m_error.isEmpty() ? nullptr : (const char*)m_impl->m_error;
+}
+
+uint JsonIndex::getTapeSize() const
+{
+	return (uint)m_impl->m_tape.size();
+}
+
+bool JsonIndex::find(const char* _name)
+{
+	if (m_impl->m_stack.empty() || isInArray()) {
+		return false;
+	}
+	const eastl::vector<Impl::Node>& tape = m_impl->m_tape;
+	Impl::Level& level = m_impl->m_stack.back();
+	const uint32 begin = level.m_node + 1;
+	const uint32 end   = tape[level.m_node].m_end;
+	const uint   nameLength = (uint)strlen(_name);
+	const bool   namePlain  = strpbrk(_name, "\"\\") == nullptr;
+
+ // search forward from the current position and wrap around to the start of the object, skip values via the tape
+	for (uint32 pass = 0, key = level.m_pos; pass < 2; ++pass, key = begin) {
+		const uint32 stop = pass == 0 ? end : level.m_pos;
+		while (key < stop) {
+			const uint32 value = key + 1;
+			if (m_impl->keyMatches(key, _name, nameLength, namePlain)) {
+				level.m_pos = tape[value].m_end;
+				m_impl->m_name.assign(_name, _name + nameLength + 1);
+				return m_impl->setCurrent(value, Impl::kInvalid);
+			}
+			key = tape[value].m_end;
+		}
+	}
+	m_impl->m_current = Impl::kInvalid;
+	m_impl->m_type = Json::ValueType_Count;
+	return false;
+}
+
+bool JsonIndex::next()
+{
+	if (m_impl->m_stack.empty()) {
+		return false;
+	}
+	Impl::Level& level = m_impl->m_stack.back();
+	if (level.m_pos >= m_impl->m_tape[level.m_node].m_end) {
+		m_impl->m_current = Impl::kInvalid;
+		m_impl->m_type = Json::ValueType_Count;
+		return false;
+	}
+	if (isInArray()) {
+		const uint32 value = level.m_pos;
+		level.m_pos = m_impl->m_tape[value].m_end;
+		return m_impl->setCurrent(value, Impl::kInvalid);
+	}
+	const uint32 key = level.m_pos;
+	level.m_pos = m_impl->m_tape[key + 1].m_end;
+	return m_impl->setCurrent(key + 1, key);
+}
+
+Json::ValueType JsonIndex::getType() const
+{
+	return m_impl->m_type;
+}
+
+const char* JsonIndex::getName() const
+{
+	if (m_impl->m_stack.empty() || isInArray() || m_impl->m_type == Json::ValueType_Count) {
+		return nullptr;
+	}
+	return m_impl->m_name.data();
+}
+
+template <> bool JsonIndex::getValue<bool>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Bool, "JsonIndex::getValue: not a bool");
+	return m_impl->m_value.GetBool();
+}
+template <> sint64 JsonIndex::getValue<sint64>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonIndex::getValue: not a number");
+	return m_impl->m_value.GetInt64();
+}
+template <> sint32 JsonIndex::getValue<sint32>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonIndex::getValue: not a number");
+	return m_impl->m_value.GetInt();
+}
+template <> sint16 JsonIndex::getValue<sint16>() const
+{
+	return (sint16)getValue<sint32>();
+}
+template <> sint8 JsonIndex::getValue<sint8>() const
+{
+	return (sint8)getValue<sint32>();
+}
+template <> uint64 JsonIndex::getValue<uint64>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonIndex::getValue: not a number");
+	return m_impl->m_value.GetUint64();
+}
+template <> uint32 JsonIndex::getValue<uint32>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonIndex::getValue: not a number");
+	return m_impl->m_value.GetUint();
+}
+template <> uint16 JsonIndex::getValue<uint16>() const
+{
+	return (uint16)getValue<uint32>();
+}
+template <> uint8 JsonIndex::getValue<uint8>() const
+{
+	return (uint8)getValue<uint32>();
+}
+template <> float32 JsonIndex::getValue<float32>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonIndex::getValue: not a number");
+	return m_impl->m_value.GetFloat();
+}
+template <> float64 JsonIndex::getValue<float64>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonIndex::getValue: not a number");
+	return m_impl->m_value.GetDouble();
+}
+template <> const char* JsonIndex::getValue<const char*>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_String, "JsonIndex::getValue: not a string");
+	return m_impl->m_value.GetString();
+}
+
+bool JsonIndex::enterObject()
+{
+	if (m_impl->enter(Json::ValueType_Object)) {
+		return true;
+	}
+	APT_ASSERT(false); // not an object
+	return false;
+}
+
+void JsonIndex::leaveObject()
+{
+	m_impl->leave(Json::ValueType_Object);
+}
+
+bool JsonIndex::enterArray()
+{
+	if (m_impl->enter(Json::ValueType_Array)) {
+		return true;
+	}
+	APT_ASSERT(false); // not an array
+	return false;
+}
+
+void JsonIndex::leaveArray()
+{
+	m_impl->leave(Json::ValueType_Array);
+}
+
+bool JsonIndex::isInArray() const
+{
+	APT_ASSERT(!m_impl->m_stack.empty());
+	return m_impl->m_data[m_impl->m_tape[m_impl->m_stack.back().m_node].m_offset] == '[';
+}
+
+int JsonIndex::getArrayLength() const
+{
+	APT_ASSERT(!m_impl->m_stack.empty());
+	return isInArray() ? (int)m_impl->m_tape[m_impl->m_stack.back().m_node].m_count : -1;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/File.h>
+#include <apt/Json.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonIndex
+// Random access cursor over Json text, for querying a few values in a large
+// document without building a DOM. init() scans the text (SIMD) for
+// structural characters and builds a tape with one entry per value, where
+// each entry records the end of the value such that skipping an object or
+// array is a single jump. Values are parsed only when the cursor reaches them
+// via find()/next().
+// Traversal follows the same state machine as JsonReader, except that:
+// - find() may be called in any order; the search starts after the previous
+//   member and skips over the values of other members.
+// - getArrayLength() is O(1).
+// - Leaving an object/array is O(1); any remaining values aren't parsed.
+// The structure is validated by init(), scalar values are validated when they
+// are parsed. Documents must be smaller than 4GB. The text must remain valid
+// for the lifetime of the index. The tape uses 12 bytes per value/name.
+////////////////////////////////////////////////////////////////////////////////
+class JsonIndex: private non_copyable<JsonIndex>
+{
+public:
+	JsonIndex();
+	~JsonIndex();
+
+	// Build the index for _data (_dataSize bytes, need not be null-terminated). Return false if the document structure is invalid
+	// or the root is not an object or an array.
+	bool init(const char* _data, uint64 _dataSize);
+	bool init(const File& _file)                       { return init(_file.getData(), _file.getDataSize()); }
+
+	// Return the first error encountered, or nullptr if no error occurred.
+	const char* getError() const;
+
+	// Number of tape entries (values plus member names).
+	uint getTapeSize() const;
+
+	// Find a named value in the current object. Return true if the value is found, in which case getValue() may be called.
+	bool find(const char* _name);
+
+	// Get the next value in the current object/array. Return true if not the end of the object/array, in which case getValue() may be called.
+	bool next();
+
+	// Get the type of the current value (ValueType_Count if there is no current value).
+	Json::ValueType getType() const;
+
+	// Get the name of the current value, or nullptr if in an array.
+	const char* getName() const;
+
+	// Get the current value. tType must match the type of the current value. Valid until the cursor moves.
+	template <typename tType>
+	tType getValue() const;
+
+	// Enter the current object (call immediately after find() or next()). Return false if the current value is not an object.
+	bool enterObject();
+	// Leave the current object.
+	void leaveObject();
+
+	// Enter the current array (call immediately after find() or next()). Return false if the current value is not an array.
+	bool enterArray();
+	// Leave the current array.
+	void leaveArray();
+
+	// Return the number of elements in the current array (or -1 if not in an array).
+	int getArrayLength() const;
+	// Return true if the current container is an array.
+	bool isInArray() const;
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+}; // class JsonIndex
+
+} // namespace apt
@@ -0,0 +1,337 @@
+#include <apt/JsonLinesReader.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/log.h>
+#include <apt/math.h>
+#include <apt/memory.h>
+#include <apt/FileSystem.h>
+#include <apt/Time.h>
+
+#include <EASTL/vector.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace apt;
+
+struct JsonLinesReader::Impl
+{
+	enum SlotState
+	{
+		SlotState_Free,
+		SlotState_Parsing,
+		SlotState_Ready,
+		SlotState_Delivering
+	};
+
+ // parsed chunk, the documents are pooled and reused for subsequent chunks
+	struct Slot
+	{
+		SlotState             m_state       = SlotState_Free;
+		uint32                m_chunk       = 0;
+		JsonArena             m_arena;
+		eastl::vector<Json*>  m_docs;
+		eastl::vector<uint64> m_offsets;                // Line offset per record.
+		uint                  m_count       = 0;        // Number of records parsed.
+		uint64                m_errorOffset = 0;
+		const char*           m_error       = nullptr;  // Parse error (static string), stops reading after the chunk is delivered.
+
+		~Slot()
+		{
+			for (Json* doc : m_docs) {
+				APT_DELETE(doc);
+			}
+		}
+
+		void release()
+		{
+			for (uint i = 0, n = APT_MIN(m_count + 1, (uint)m_docs.size()); i < n; ++i) {
+				m_docs[i]->clear();
+			}
+			m_arena.reset();
+			m_count = 0;
+			m_error = nullptr;
+			m_offsets.clear();
+		}
+	};
+
+	int                        m_threadCount;
+	uint                       m_chunkSize;
+	eastl::vector<Slot*>       m_slots;
+	eastl::vector<std::thread> m_threads;
+	std::mutex                 m_mutex;
+	std::condition_variable    m_workerCv;
+	std::condition_variable    m_readerCv;
+
+	const char*                m_data        = nullptr;
+	uint64                     m_dataSize    = 0;
+	bool                       m_ordered     = true;
+	bool                       m_stop        = false;
+	uint64                     m_splitPos    = 0;        // Start of the next chunk.
+	uint32                     m_chunkCount  = 0;        // Chunks split so far.
+	uint32                     m_nextChunk   = 0;        // Next chunk to deliver if m_ordered.
+	uint32                     m_delivered   = 0;        // Chunks delivered so far.
+	Slot*                      m_current     = nullptr;  // Slot being delivered by next().
+	uint                       m_record      = 0;        // Next record in m_current.
+	uint64                     m_recordCount = 0;
+	String<64>                 m_error;
+
+	Impl(int _threadCount, uint _chunkSize)
+		: m_threadCount(_threadCount)
+		, m_chunkSize(APT_MAX(_chunkSize, (uint)1))
+	{
+		if (m_threadCount <= 0) {
+			m_threadCount = (int)std::thread::hardware_concurrency();
+			m_threadCount = m_threadCount > 0 ? m_threadCount : 1;
+		}
+	 // 2 slots per thread such that workers don't stall while the reader consumes a chunk
+		for (int i = 0; i < m_threadCount * 2; ++i) {
+			m_slots.push_back(APT_NEW(Slot));
+		}
+	}
+
+	~Impl()
+	{
+		for (Slot* slot : m_slots) {
+			APT_DELETE(slot);
+		}
+	}
+
+	void setError(uint64 _offset, const char* _msg)
+	{
+		if (m_error.isEmpty()) {
+			uint64 line = 1;
+			for (const char* pos = m_data, *end = m_data + _offset; (pos = (const char*)memchr(pos, '\n', end - pos)) != nullptr; ++pos) {
+				++line;
+			}
+			m_error.setf("line %llu: %s", (unsigned long long)line, _msg);
+			APT_LOG_ERR("JsonLinesReader error: %s", (const char*)m_error);
+		}
+	}
+
+	uint64 findChunkEnd(uint64 _begin) const
+	{
+		const uint64 pos = _begin + m_chunkSize;
+		if (pos >= m_dataSize) {
+			return m_dataSize;
+		}
+		const char* newline = (const char*)memchr(m_data + pos, '\n', (size_t)(m_dataSize - pos));
+		return newline ? (uint64)(newline - m_data) + 1 : m_dataSize;
+	}
+
+	void parseChunk(Slot& slot_, uint64 _begin, uint64 _end)
+	{
+		for (uint64 pos = _begin; pos < _end; ) {
+			const char* line = m_data + pos;
+			const char* newline = (const char*)memchr(line, '\n', (size_t)(_end - pos));
+			const uint64 lineEnd = newline ? (uint64)(newline - m_data) : _end;
+			const uint64 length = lineEnd - pos;
+
+			bool empty = true;
+			for (uint64 i = 0; empty && i < length; ++i) {
+				empty = line[i] == ' ' || line[i] == '\t' || line[i] == '\r';
+			}
+			if (!empty) {
+				if (slot_.m_count == slot_.m_docs.size()) {
+					slot_.m_docs.push_back(APT_NEW(Json(slot_.m_arena)));
+				}
+				rapidjson::Document& dom = slot_.m_docs[slot_.m_count]->m_impl->m_dom;
+				dom.Parse(line, (size_t)length);
+				if (dom.HasParseError()) {
+					slot_.m_errorOffset = pos + dom.GetErrorOffset();
+					slot_.m_error = rapidjson::GetParseError_En(dom.GetParseError());
+					return;
+				}
+				slot_.m_offsets.push_back(pos);
+				++slot_.m_count;
+			}
+			pos = lineEnd + 1;
+		}
+	}
+
+	void worker()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;) {
+			Slot* slot = nullptr;
+			m_workerCv.wait(lock, [this, &slot]()
+				{
+					if (m_stop || m_splitPos >= m_dataSize) {
+						return true;
+					}
+					for (Slot* s : m_slots) {
+						if (s->m_state == SlotState_Free) {
+							slot = s;
+							return true;
+						}
+					}
+					return false;
+				});
+			if (m_stop || m_splitPos >= m_dataSize) {
+				break;
+			}
+			const uint64 begin = m_splitPos;
+			m_splitPos = findChunkEnd(begin);
+			const uint64 end = m_splitPos;
+			slot->m_state = SlotState_Parsing;
+			slot->m_chunk = m_chunkCount++;
+
+			lock.unlock();
+			parseChunk(*slot, begin, end);
+			lock.lock();
+
+			slot->m_state = SlotState_Ready;
+			m_readerCv.notify_all();
+		}
+		m_readerCv.notify_all();
+	}
+
+	// Return the slot to the pool.
+	void release(Slot* _slot)
+	{
+		_slot->release();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		_slot->m_state = SlotState_Free;
+		m_workerCv.notify_one();
+	}
+
+	// Wait for the next chunk to deliver, return nullptr if there are no more chunks.
+	Slot* acquire()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;) {
+			for (Slot* slot : m_slots) {
+				if (slot->m_state == SlotState_Ready && (!m_ordered || slot->m_chunk == m_nextChunk)) {
+					slot->m_state = SlotState_Delivering;
+					++m_nextChunk;
+					++m_delivered;
+					return slot;
+				}
+			}
+			if (m_stop || (m_splitPos >= m_dataSize && m_delivered == m_chunkCount)) {
+				return nullptr;
+			}
+			m_readerCv.wait(lock);
+		}
+	}
+};
+
+// PUBLIC
+
+JsonLinesReader::JsonLinesReader(int _threadCount, uint _chunkSize)
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl(_threadCount, _chunkSize));
+}
+
+JsonLinesReader::~JsonLinesReader()
+{
+	end();
+	APT_DELETE(m_impl);
+}
+
+void JsonLinesReader::begin(const char* _data, uint64 _dataSize, bool _ordered)
+{
+	end();
+	m_impl->m_data        = _data;
+	m_impl->m_dataSize    = _data ? _dataSize : 0;
+	m_impl->m_ordered     = _ordered;
+	m_impl->m_stop        = false;
+	m_impl->m_splitPos    = 0;
+	m_impl->m_chunkCount  = 0;
+	m_impl->m_nextChunk   = 0;
+	m_impl->m_delivered   = 0;
+	m_impl->m_record      = 0;
+	m_impl->m_recordCount = 0;
+	m_impl->m_error.clear();
+	for (int i = 0; i < m_impl->m_threadCount; ++i) {
+		m_impl->m_threads.push_back(std::thread([this]() { m_impl->worker(); }));
+	}
+}
+
+Json* JsonLinesReader::next(uint64* offset_)
+{
+	for (;;) {
+		Impl::Slot* slot = m_impl->m_current;
+		if (slot && m_impl->m_record < slot->m_count) {
+			if (offset_) {
+				*offset_ = slot->m_offsets[m_impl->m_record];
+			}
+			++m_impl->m_recordCount;
+			return slot->m_docs[m_impl->m_record++];
+		}
+		if (slot) {
+			const bool error = slot->m_error != nullptr;
+			if (error) {
+				m_impl->setError(slot->m_errorOffset, slot->m_error);
+			}
+			m_impl->m_current = nullptr;
+			m_impl->release(slot);
+			if (error) {
+				end();
+				return nullptr;
+			}
+		}
+		m_impl->m_current = m_impl->acquire();
+		m_impl->m_record = 0;
+		if (!m_impl->m_current) {
+			return nullptr;
+		}
+	}
+}
+
+void JsonLinesReader::end()
+{
+	{	std::lock_guard<std::mutex> lock(m_impl->m_mutex);
+		m_impl->m_stop = true;
+		m_impl->m_workerCv.notify_all();
+	}
+	for (auto& thread : m_impl->m_threads) {
+		thread.join();
+	}
+	m_impl->m_threads.clear();
+	for (Impl::Slot* slot : m_impl->m_slots) {
+		if (slot->m_state != Impl::SlotState_Free) {
+			slot->release();
+			slot->m_state = Impl::SlotState_Free;
+		}
+	}
+	m_impl->m_current = nullptr;
+}
+
+bool JsonLinesReader::read(const char* _data, uint64 _dataSize, const RecordCallback& _callback, bool _ordered)
+{
+	begin(_data, _dataSize, _ordered);
+	bool ret = true;
+	uint64 offset;
+	while (Json* json = next(&offset)) {
+		if (!_callback(*json, offset)) {
+			ret = false;
+			break;
+		}
+	}
+	end();
+	return ret && getError() == nullptr;
+}
+
+bool JsonLinesReader::read(const char* _path, const RecordCallback& _callback, bool _ordered, FileSystem::RootType _rootHint)
+{
+	APT_AUTOTIMER("JsonLinesReader::read(%s)", _path);
+	File f;
+	if (!FileSystem::ReadIfExists(f, _path, _rootHint)) {
+		return false;
+	}
+	return read(f, _callback, _ordered);
+}
+
+const char* JsonLinesReader::getError() const
+{
+	return m_impl->m_error.isEmpty() ? nullptr : (const char*)m_impl->m_error;
+}
+
+uint64 JsonLinesReader::getRecordCount() const
+{
+	return m_impl->m_recordCount;
+}
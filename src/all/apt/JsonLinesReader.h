@@ -0,0 +1,64 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/File.h>
+#include <apt/Json.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonLinesReader
+// Parallel reader for newline-delimited Json (NDJSON), one document per line.
+// The text is split into line-aligned chunks of approximately _chunkSize bytes
+// which are parsed by worker threads. Records are delivered on the calling
+// thread, either via next() or a callback passed to read().
+//
+//  JsonLinesReader reader;
+//  reader.begin(data, dataSize);
+//  while (Json* json = reader.next()) {
+//     int v = json->getValue<int>("Value");
+//  }
+//  reader.end();
+//
+// If _ordered is true records are delivered in line order, otherwise chunks
+// are delivered as soon as they are parsed (records within a chunk remain in
+// order). Documents are pooled per chunk and share an arena, the memory is
+// reused for subsequent chunks. Empty lines are skipped. Reading stops at the
+// first invalid line (see getError()).
+////////////////////////////////////////////////////////////////////////////////
+class JsonLinesReader: private non_copyable<JsonLinesReader>
+{
+public:
+	// Receive a record, _offset is the offset of the line in the text. Return false to stop reading.
+	typedef eastl::function<bool(Json& _json_, uint64 _offset)> RecordCallback;
+
+	// _threadCount worker threads (0 = use the hardware thread count).
+	JsonLinesReader(int _threadCount = 0, uint _chunkSize = 1024 * 1024);
+	~JsonLinesReader();
+
+	// Begin reading _data (_dataSize bytes), which must remain valid until end() is called.
+	void begin(const char* _data, uint64 _dataSize, bool _ordered = true);
+	// Get the next record, optionally return the offset of the line in offset_. Return nullptr after the last record, or if an
+	// error occurred. The Json is valid until the next call to next() or end().
+	Json* next(uint64* offset_ = nullptr);
+	// Stop the worker threads. Called implicitly by begin() and the dtor.
+	void end();
+
+	// Call _callback for each record. Return false if an error occurred or _callback returned false.
+	bool read(const char* _data, uint64 _dataSize, const RecordCallback& _callback, bool _ordered = true);
+	bool read(const File& _file, const RecordCallback& _callback, bool _ordered = true) { return read(_file.getData(), _file.getDataSize(), _callback, _ordered); }
+	bool read(const char* _path, const RecordCallback& _callback, bool _ordered = true, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+
+	// Return the first error encountered since begin(), or nullptr if no error occurred.
+	const char* getError() const;
+
+	// Number of records delivered since begin().
+	uint64 getRecordCount() const;
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+}; // class JsonLinesReader
+
+} // namespace apt
@@ -0,0 +1,131 @@
+#include <apt/JsonLinesWriter.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/log.h>
+#include <apt/math.h>
+#include <apt/memory.h>
+#include <apt/FileSystem.h>
+#include <apt/Time.h>
+
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+using namespace apt;
+
+struct JsonLinesWriter::Impl
+{
+ // rapidjson output stream, appends to m_buffer
+	struct Stream
+	{
+		typedef char Ch;
+		eastl::vector<char>* m_buffer;
+
+		void Put(char _c) { m_buffer->push_back(_c); }
+		void Flush()      {}
+	};
+
+	OutputCallback            m_callback;
+	uint                      m_bufferSize;
+	eastl::vector<char>       m_buffer;
+	uint64                    m_size        = 0;  // Bytes passed to m_callback.
+	uint64                    m_recordCount = 0;
+	bool                      m_error       = false;
+	Stream                    m_stream;
+	rapidjson::Writer<Stream> m_writer;
+
+	Impl(const OutputCallback& _callback, uint _bufferSize)
+		: m_callback(_callback)
+		, m_bufferSize(APT_MAX(_bufferSize, (uint)64))
+		, m_writer(m_stream)
+	{
+		m_stream.m_buffer = &m_buffer;
+		m_buffer.reserve(m_bufferSize);
+	}
+
+	void flush()
+	{
+		if (!m_buffer.empty()) {
+			if (!m_error) {
+				m_error = !m_callback(m_buffer.data(), (uint)m_buffer.size());
+			}
+			m_size += m_buffer.size();
+			m_buffer.clear();
+		}
+	}
+};
+
+// PUBLIC
+
+JsonLinesWriter::JsonLinesWriter(uint _bufferSize)
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl(OutputCallback(), _bufferSize));
+}
+
+JsonLinesWriter::JsonLinesWriter(const OutputCallback& _callback, uint _bufferSize)
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl(_callback, _bufferSize));
+}
+
+JsonLinesWriter::~JsonLinesWriter()
+{
+	APT_DELETE(m_impl);
+}
+
+bool JsonLinesWriter::write(const Json& _json)
+{
+	const uint prevSize = (uint)m_impl->m_buffer.size();
+	m_impl->m_writer.Reset(m_impl->m_stream);
+	Base64Handler<rapidjson::Writer<Impl::Stream> > handler(m_impl->m_writer);
+	if (!_json.m_impl->m_dom.Accept(handler)) {
+	 // discard the partial record
+		m_impl->m_buffer.resize(prevSize);
+		APT_LOG_ERR("Json error: JsonLinesWriter\n\t'Invalid value (NaN or infinity)'");
+		return false;
+	}
+	m_impl->m_buffer.push_back('\n');
+	++m_impl->m_recordCount;
+	if (m_impl->m_callback && m_impl->m_buffer.size() >= m_impl->m_bufferSize) {
+		m_impl->flush();
+	}
+	return !m_impl->m_error;
+}
+
+bool JsonLinesWriter::finish()
+{
+	if (m_impl->m_callback) {
+		m_impl->flush();
+	}
+	return !m_impl->m_error;
+}
+
+bool JsonLinesWriter::finish(File& file_)
+{
+	APT_ASSERT(!m_impl->m_callback); // output isn't buffered
+	file_.setData(m_impl->m_buffer.data(), m_impl->m_buffer.size());
+	m_impl->m_size += m_impl->m_buffer.size();
+	m_impl->m_buffer.clear();
+	return true;
+}
+
+bool JsonLinesWriter::finish(const char* _path, FileSystem::RootType _root)
+{
+	APT_AUTOTIMER("JsonLinesWriter::finish(%s)", _path);
+	File f;
+	if (finish(f)) {
+		return FileSystem::Write(f, _path, _root);
+	}
+	return false;
+}
+
+uint64 JsonLinesWriter::getSize() const
+{
+	return m_impl->m_size + m_impl->m_buffer.size();
+}
+
+uint64 JsonLinesWriter::getRecordCount() const
+{
+	return m_impl->m_recordCount;
+}
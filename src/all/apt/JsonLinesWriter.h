@@ -0,0 +1,48 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/File.h>
+#include <apt/Json.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonLinesWriter
+// Write documents as newline-delimited Json (NDJSON), one document per line.
+// Output is either buffered (retrieve via finish(File&)), or streamed to a
+// callback in writes of at least _bufferSize bytes.
+////////////////////////////////////////////////////////////////////////////////
+class JsonLinesWriter: private non_copyable<JsonLinesWriter>
+{
+public:
+	typedef Json::OutputCallback OutputCallback;
+
+	// Buffer the output.
+	JsonLinesWriter(uint _bufferSize = 1024 * 1024);
+	// Stream the output to _callback.
+	JsonLinesWriter(const OutputCallback& _callback, uint _bufferSize = 1024 * 1024);
+	~JsonLinesWriter();
+
+	// Append _json as a single line. Return false if an error occurred, in which case nothing is appended (e.g. if _json contains
+	// NaN or infinity).
+	bool write(const Json& _json);
+
+	// Flush the output. Return false if an error occurred.
+	bool finish();
+	// As finish(), copy the buffered output to file_.
+	bool finish(File& file_);
+	// As finish(File&), write the output to _path.
+	bool finish(const char* _path, FileSystem::RootType _root = FileSystem::RootType_Default);
+
+	// Total bytes written.
+	uint64 getSize() const;
+	// Number of records written.
+	uint64 getRecordCount() const;
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+}; // class JsonLinesWriter
+
+} // namespace apt
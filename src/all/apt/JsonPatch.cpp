@@ -0,0 +1,635 @@
+#include <apt/Json.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/log.h>
+#include <apt/math.h>
+#include <apt/memory.h>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+
+#include <cmath>
+#include <cstring>
+
+using namespace apt;
+
+// Json::Diff()/ApplyPatch() (RFC 6902).
+
+void apt::CopyValue(rapidjson::Value& dst_, const rapidjson::Value& _src, rapidjson::Document::AllocatorType& _allocator_)
+{
+	switch (_src.GetType()) {
+		case rapidjson::kObjectType:
+			dst_.SetObject();
+			for (auto it = _src.MemberBegin(); it != _src.MemberEnd(); ++it) {
+				rapidjson::Value name;
+				if (IsBinaryName(it->name)) {
+					name.SetString(rapidjson::StringRef(kBinaryName));
+				} else {
+					name.SetString(it->name.GetString(), it->name.GetStringLength(), _allocator_);
+				}
+				rapidjson::Value value;
+				CopyValue(value, it->value, _allocator_);
+				dst_.AddMember(name, value, _allocator_);
+			}
+			break;
+		case rapidjson::kArrayType:
+			dst_.SetArray();
+			dst_.Reserve(_src.Size(), _allocator_);
+			for (auto it = _src.Begin(); it != _src.End(); ++it) {
+				rapidjson::Value value;
+				CopyValue(value, *it, _allocator_);
+				dst_.PushBack(value, _allocator_);
+			}
+			break;
+		case rapidjson::kStringType:
+			dst_.SetString(_src.GetString(), _src.GetStringLength(), _allocator_);
+			break;
+		default:
+			dst_.CopyFrom(_src, _allocator_);
+			break;
+	};
+}
+
+static inline bool NameMatches(const rapidjson::Value& _name, const char* _str, uint _length)
+{
+	return _name.GetStringLength() == _length && memcmp(_name.GetString(), _str, _length) == 0;
+}
+
+// Return the index of the member of _object named _name, or -1 if not found.
+static int FindMember(const rapidjson::Value& _object, const char* _name, uint _length)
+{
+	int i = 0;
+	for (auto it = _object.MemberBegin(); it != _object.MemberEnd(); ++it, ++i) {
+		if (NameMatches(it->name, _name, _length)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// 64 bit structural hash. Member order isn't significant and numbers hash by value (1, 1u and 1.0 are equal). Hashes of large
+// objects/arrays are cached by address, hence values must not be modified during the lifetime of the JsonHash.
+struct JsonHash
+{
+	static const uint kMinCachedSize = 8; // Smaller objects/arrays are cheaper to rehash than to cache.
+
+	eastl::hash_map<const rapidjson::Value*, uint64> m_cache;
+
+	static uint64 Mix(uint64 _x) // SplitMix64 finalizer
+	{
+		_x = (_x ^ (_x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		_x = (_x ^ (_x >> 27)) * 0x94d049bb133111ebull;
+		return _x ^ (_x >> 31);
+	}
+	static uint64 Combine(uint64 _tag, uint64 _payload)
+	{
+		return Mix(Mix(_tag) ^ _payload);
+	}
+
+	static uint64 GetNumber(const rapidjson::Value& _value)
+	{
+		if (_value.IsUint64()) {
+			return Combine(4, _value.GetUint64());
+		}
+		if (_value.IsInt64()) {
+			return Combine(5, (uint64)_value.GetInt64());
+		}
+	 // integral doubles hash as integers
+		const double d = _value.GetDouble();
+		if (d == std::floor(d)) {
+			if (d >= 0.0 && d < 18446744073709551616.0) {
+				return Combine(4, (uint64)d);
+			}
+			if (d < 0.0 && d >= -9223372036854775808.0) {
+				return Combine(5, (uint64)(sint64)d);
+			}
+		}
+		uint64 bits;
+		memcpy(&bits, &d, sizeof(bits));
+		return Combine(6, bits);
+	}
+
+	uint64 get(const rapidjson::Value& _value)
+	{
+		switch (_value.GetType()) {
+			case rapidjson::kNullType:   return Combine(1, 0);
+			case rapidjson::kFalseType:  return Combine(2, 0);
+			case rapidjson::kTrueType:   return Combine(3, 0);
+			case rapidjson::kNumberType: return GetNumber(_value);
+			case rapidjson::kStringType: return Combine(7, Hash<uint64>(_value.GetString(), _value.GetStringLength()));
+			default:                     break;
+		};
+		if (const rapidjson::Value* bin = GetBinary(_value)) {
+			return Combine(10, Hash<uint64>(bin->GetString(), bin->GetStringLength()));
+		}
+
+		const bool cache = (_value.IsArray() ? _value.Size() : _value.MemberCount()) >= kMinCachedSize;
+		if (cache) {
+			auto it = m_cache.find(&_value);
+			if (it != m_cache.end()) {
+				return it->second;
+			}
+		}
+		uint64 ret;
+		if (_value.IsArray()) {
+			ret = Combine(8, _value.Size());
+			for (auto elem = _value.Begin(); elem != _value.End(); ++elem) {
+				ret = Mix(ret ^ get(*elem));
+			}
+		} else {
+		 // commutative sum of the members
+			uint64 sum = 0;
+			for (auto member = _value.MemberBegin(); member != _value.MemberEnd(); ++member) {
+				sum += Mix(Hash<uint64>(member->name.GetString(), member->name.GetStringLength()) + Mix(get(member->value)));
+			}
+			ret = Combine(9, sum ^ _value.MemberCount());
+		}
+		if (cache) {
+			m_cache[&_value] = ret;
+		}
+		return ret;
+	}
+};
+
+// Parsed Json pointer (RFC 6901).
+struct JsonPointer
+{
+	eastl::vector<char> m_buffer; // Unescaped tokens, null-terminated.
+	eastl::vector<uint> m_tokens; // Offset of each token in m_buffer, plus the end of the buffer.
+
+	bool parse(const char* _str, uint _length)
+	{
+		m_buffer.clear();
+		m_tokens.clear();
+		if (_length == 0) {
+			return true; // whole document
+		}
+		if (_str[0] != '/') {
+			return false;
+		}
+		for (uint i = 0; i < _length; ++i) {
+			const char c = _str[i];
+			if (c == '/') {
+				if (!m_tokens.empty()) {
+					m_buffer.push_back('\0');
+				}
+				m_tokens.push_back((uint)m_buffer.size());
+			} else if (c == '~') {
+				if (++i == _length || (_str[i] != '0' && _str[i] != '1')) {
+					return false;
+				}
+				m_buffer.push_back(_str[i] == '0' ? '~' : '/');
+			} else {
+				m_buffer.push_back(c);
+			}
+		}
+		m_buffer.push_back('\0');
+		m_tokens.push_back((uint)m_buffer.size());
+		return true;
+	}
+
+	uint        getCount() const                 { return m_tokens.empty() ? 0 : (uint)m_tokens.size() - 1; }
+	const char* getToken(uint _i) const          { return m_buffer.data() + m_tokens[_i]; }
+	uint        getTokenLength(uint _i) const    { return m_tokens[_i + 1] - m_tokens[_i] - 1; }
+
+	// Return true if the first getCount() tokens of _pointer match.
+	bool isPrefixOf(const JsonPointer& _pointer) const
+	{
+		if (getCount() > _pointer.getCount()) {
+			return false;
+		}
+		for (uint i = 0; i < getCount(); ++i) {
+			if (getTokenLength(i) != _pointer.getTokenLength(i) || memcmp(getToken(i), _pointer.getToken(i), getTokenLength(i)) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Parse an array index token, "-" is the end of the array (_size). Return false if the token isn't a valid index.
+	static bool ParseIndex(const char* _token, uint _length, uint _size, uint& index_)
+	{
+		if (_length == 1 && _token[0] == '-') {
+			index_ = _size;
+			return true;
+		}
+		if (_length == 0 || _length > 9 || (_token[0] == '0' && _length > 1)) {
+			return false;
+		}
+		index_ = 0;
+		for (uint i = 0; i < _length; ++i) {
+			if (_token[i] < '0' || _token[i] > '9') {
+				return false;
+			}
+			index_ = index_ * 10 + (uint)(_token[i] - '0');
+		}
+		return true;
+	}
+
+	// Return the value referenced by the first _count tokens, or nullptr if not found.
+	rapidjson::Value* resolve(rapidjson::Value& _root, uint _count) const
+	{
+		rapidjson::Value* ret = &_root;
+		for (uint i = 0; i < _count; ++i) {
+			if (ret->IsObject()) {
+				int j = FindMember(*ret, getToken(i), getTokenLength(i));
+				if (j < 0) {
+					return nullptr;
+				}
+				ret = &(ret->MemberBegin() + j)->value;
+			} else if (ret->IsArray()) {
+				uint j;
+				if (!ParseIndex(getToken(i), getTokenLength(i), ret->Size(), j) || j >= ret->Size()) {
+					return nullptr;
+				}
+				ret = &(*ret)[j];
+			} else {
+				return nullptr;
+			}
+		}
+		return ret;
+	}
+};
+
+// Apply patch operations to a document.
+struct JsonPatcher
+{
+	rapidjson::Value&                   m_root;
+	rapidjson::Document::AllocatorType& m_allocator;
+	JsonPointer                         m_path;
+	JsonPointer                         m_from;
+	const char*                         m_error = nullptr;
+
+	JsonPatcher(rapidjson::Value& _root_, rapidjson::Document::AllocatorType& _allocator_)
+		: m_root(_root_)
+		, m_allocator(_allocator_)
+	{
+	}
+
+	bool error(const char* _msg)
+	{
+		m_error = _msg;
+		return false;
+	}
+
+	static const rapidjson::Value* FindString(const rapidjson::Value& _op, const char* _name)
+	{
+		auto it = _op.FindMember(_name);
+		return it != _op.MemberEnd() && it->value.IsString() ? &it->value : nullptr;
+	}
+
+	// Move _value_ to _path.
+	bool add(const JsonPointer& _path, rapidjson::Value& _value_)
+	{
+		const uint count = _path.getCount();
+		if (count == 0) {
+			m_root = _value_;
+			return true;
+		}
+		rapidjson::Value* parent = _path.resolve(m_root, count - 1);
+		if (!parent) {
+			return error("Path not found");
+		}
+		const char* token = _path.getToken(count - 1);
+		const uint length = _path.getTokenLength(count - 1);
+		if (parent->IsObject()) {
+			int i = FindMember(*parent, token, length);
+			if (i >= 0) {
+				(parent->MemberBegin() + i)->value = _value_;
+			} else {
+				rapidjson::Value name(token, length, m_allocator);
+				parent->AddMember(name, _value_, m_allocator);
+			}
+		} else if (parent->IsArray()) {
+			uint index;
+			if (!JsonPointer::ParseIndex(token, length, parent->Size(), index) || index > parent->Size()) {
+				return error("Invalid array index");
+			}
+		 // no insert, push back and swap into place
+			parent->PushBack(_value_, m_allocator);
+			for (uint i = parent->Size() - 1; i > index; --i) {
+				(*parent)[i].Swap((*parent)[i - 1]);
+			}
+		} else {
+			return error("Parent isn't an object or array");
+		}
+		return true;
+	}
+
+	// Remove the value at _path, optionally move it to removed_.
+	bool remove(const JsonPointer& _path, rapidjson::Value* removed_ = nullptr)
+	{
+		const uint count = _path.getCount();
+		if (count == 0) {
+			return error("Can't remove the root");
+		}
+		rapidjson::Value* parent = _path.resolve(m_root, count - 1);
+		if (!parent) {
+			return error("Path not found");
+		}
+		const char* token = _path.getToken(count - 1);
+		const uint length = _path.getTokenLength(count - 1);
+		if (parent->IsObject()) {
+			int i = FindMember(*parent, token, length);
+			if (i < 0) {
+				return error("Path not found");
+			}
+			if (removed_) {
+				removed_->Swap((parent->MemberBegin() + i)->value);
+			}
+			parent->EraseMember(parent->MemberBegin() + i); // preserves the member order
+		} else if (parent->IsArray()) {
+			uint index;
+			if (!JsonPointer::ParseIndex(token, length, parent->Size(), index) || index >= parent->Size()) {
+				return error("Invalid array index");
+			}
+			if (removed_) {
+				removed_->Swap((*parent)[index]);
+			}
+			parent->Erase(parent->Begin() + index);
+		} else {
+			return error("Parent isn't an object or array");
+		}
+		return true;
+	}
+
+	bool apply(const rapidjson::Value& _op)
+	{
+		if (!_op.IsObject()) {
+			return error("Operation isn't an object");
+		}
+		const rapidjson::Value* op = FindString(_op, "op");
+		const rapidjson::Value* path = FindString(_op, "path");
+		if (!op || !path) {
+			return error("Missing 'op' or 'path'");
+		}
+		if (!m_path.parse(path->GetString(), path->GetStringLength())) {
+			return error("Invalid path");
+		}
+
+		if (*op == "remove") {
+			return remove(m_path);
+		}
+
+		if (*op == "move" || *op == "copy") {
+			const rapidjson::Value* from = FindString(_op, "from");
+			if (!from || !m_from.parse(from->GetString(), from->GetStringLength())) {
+				return error("Missing or invalid 'from'");
+			}
+			rapidjson::Value value;
+			if (*op == "move") {
+				if (m_from.isPrefixOf(m_path)) {
+					if (m_from.getCount() == m_path.getCount()) {
+						return true; // move to self
+					}
+					return error("Can't move a value into one of its children");
+				}
+				if (!remove(m_from, &value)) {
+					return false;
+				}
+			} else {
+				const rapidjson::Value* src = m_from.resolve(m_root, m_from.getCount());
+				if (!src) {
+					return error("Path not found");
+				}
+				CopyValue(value, *src, m_allocator);
+			}
+			return add(m_path, value);
+		}
+
+		auto it = _op.FindMember("value");
+		if (it == _op.MemberEnd()) {
+			return error("Missing 'value'");
+		}
+		if (*op == "test") {
+			const rapidjson::Value* target = m_path.resolve(m_root, m_path.getCount());
+			if (!target) {
+				return error("Path not found");
+			}
+			return *target == it->value ? true : error("Test failed");
+		}
+		if (*op == "add" || *op == "replace") {
+			rapidjson::Value value;
+			CopyValue(value, it->value, m_allocator);
+			if (*op == "add") {
+				return add(m_path, value);
+			}
+			rapidjson::Value* target = m_path.resolve(m_root, m_path.getCount());
+			if (!target) {
+				return error("Path not found");
+			}
+			*target = value;
+			return true;
+		}
+		return error("Unknown operation");
+	}
+};
+
+// Generate patch operations which transform one document into another.
+struct JsonDiff
+{
+	static const uint kMinIndexedMembers = 32;
+
+	JsonHash                            m_hash;
+	rapidjson::Value&                   m_patch;
+	rapidjson::Document::AllocatorType& m_allocator;
+	eastl::vector<char>                 m_path; // Escaped Json pointer to the current value.
+
+	// Member lookup for objects, members are usually in the same order in both documents hence the member after the previous match
+	// is checked first. Large objects are indexed on the first miss.
+	struct MemberLookup
+	{
+		const rapidjson::Value&         m_object;
+		int                             m_next = 0;
+		eastl::hash_map<uint64, uint32> m_map;
+
+		MemberLookup(const rapidjson::Value& _object)
+			: m_object(_object)
+		{
+		}
+
+		int find(const char* _name, uint _length)
+		{
+			const int count = (int)m_object.MemberCount();
+			int ret = -1;
+			if (m_next < count && NameMatches((m_object.MemberBegin() + m_next)->name, _name, _length)) {
+				ret = m_next;
+			} else if (count >= (int)kMinIndexedMembers) {
+				if (m_map.empty()) {
+					uint32 i = 0;
+					for (auto it = m_object.MemberBegin(); it != m_object.MemberEnd(); ++it, ++i) {
+						m_map.insert(eastl::make_pair(Hash<uint64>(it->name.GetString(), it->name.GetStringLength()), i));
+					}
+				}
+				auto it = m_map.find(Hash<uint64>(_name, _length));
+				if (it != m_map.end()) {
+					ret = NameMatches((m_object.MemberBegin() + it->second)->name, _name, _length)
+						? (int)it->second
+						: FindMember(m_object, _name, _length) // hash collision
+						;
+				}
+			} else {
+				ret = FindMember(m_object, _name, _length);
+			}
+			if (ret >= 0) {
+				m_next = ret + 1;
+			}
+			return ret;
+		}
+	};
+
+	JsonDiff(rapidjson::Value& _patch_, rapidjson::Document::AllocatorType& _allocator_)
+		: m_patch(_patch_)
+		, m_allocator(_allocator_)
+	{
+	}
+
+	// Append a token to m_path, return the previous length.
+	uint pushToken(const char* _name, uint _length)
+	{
+		uint ret = (uint)m_path.size();
+		m_path.push_back('/');
+		for (uint i = 0; i < _length; ++i) {
+			if (_name[i] == '~') {
+				m_path.push_back('~');
+				m_path.push_back('0');
+			} else if (_name[i] == '/') {
+				m_path.push_back('~');
+				m_path.push_back('1');
+			} else {
+				m_path.push_back(_name[i]);
+			}
+		}
+		return ret;
+	}
+	uint pushIndex(uint _index)
+	{
+		char buf[24];
+		char* str = buf + sizeof(buf);
+		do {
+			*--str = (char)('0' + _index % 10);
+			_index /= 10;
+		} while (_index > 0);
+		return pushToken(str, (uint)(buf + sizeof(buf) - str));
+	}
+	void popToken(uint _length)
+	{
+		m_path.resize(_length);
+	}
+
+	void emit(const char* _op, const rapidjson::Value* _value)
+	{
+		rapidjson::Value op(rapidjson::kObjectType);
+		rapidjson::Value opName(rapidjson::StringRef(_op));
+		op.AddMember("op", opName, m_allocator);
+		rapidjson::Value path(m_path.empty() ? "" : m_path.data(), (rapidjson::SizeType)m_path.size(), m_allocator);
+		op.AddMember("path", path, m_allocator);
+		if (_value) {
+			rapidjson::Value value;
+			CopyValue(value, *_value, m_allocator);
+			op.AddMember("value", value, m_allocator);
+		}
+		m_patch.PushBack(op, m_allocator);
+	}
+
+	void diff(const rapidjson::Value& _from, const rapidjson::Value& _to)
+	{
+		if (m_hash.get(_from) == m_hash.get(_to)) {
+			return;
+		}
+	 // binary objects are leaves
+		if (_from.IsObject() && _to.IsObject() && !GetBinary(_from) && !GetBinary(_to)) {
+			diffObject(_from, _to);
+		} else if (_from.IsArray() && _to.IsArray()) {
+			diffArray(_from, _to);
+		} else {
+			emit("replace", &_to);
+		}
+	}
+
+	void diffObject(const rapidjson::Value& _from, const rapidjson::Value& _to)
+	{
+		MemberLookup fromLookup(_from);
+		MemberLookup toLookup(_to);
+		for (auto it = _from.MemberBegin(); it != _from.MemberEnd(); ++it) {
+			if (toLookup.find(it->name.GetString(), it->name.GetStringLength()) < 0) {
+				uint mark = pushToken(it->name.GetString(), it->name.GetStringLength());
+				emit("remove", nullptr);
+				popToken(mark);
+			}
+		}
+		for (auto it = _to.MemberBegin(); it != _to.MemberEnd(); ++it) {
+			int i = fromLookup.find(it->name.GetString(), it->name.GetStringLength());
+			uint mark = pushToken(it->name.GetString(), it->name.GetStringLength());
+			if (i < 0) {
+				emit("add", &it->value);
+			} else {
+				diff((_from.MemberBegin() + i)->value, it->value);
+			}
+			popToken(mark);
+		}
+	}
+
+	void diffArray(const rapidjson::Value& _from, const rapidjson::Value& _to)
+	{
+	 // skip the common prefix/suffix, diff the remaining elements pairwise then remove/add the difference
+		const uint fromSize = _from.Size();
+		const uint toSize = _to.Size();
+		uint prefix = 0;
+		while (prefix < fromSize && prefix < toSize && m_hash.get(_from[prefix]) == m_hash.get(_to[prefix])) {
+			++prefix;
+		}
+		uint suffix = 0;
+		while (prefix + suffix < fromSize && prefix + suffix < toSize && m_hash.get(_from[fromSize - suffix - 1]) == m_hash.get(_to[toSize - suffix - 1])) {
+			++suffix;
+		}
+		const uint fromCount = fromSize - prefix - suffix;
+		const uint toCount = toSize - prefix - suffix;
+		const uint common = APT_MIN(fromCount, toCount);
+		for (uint i = 0; i < common; ++i) {
+			uint mark = pushIndex(prefix + i);
+			diff(_from[prefix + i], _to[prefix + i]);
+			popToken(mark);
+		}
+		for (uint i = common; i < fromCount; ++i) {
+			uint mark = pushIndex(prefix + common); // subsequent elements shift down
+			emit("remove", nullptr);
+			popToken(mark);
+		}
+		for (uint i = common; i < toCount; ++i) {
+			uint mark = pushIndex(prefix + i);
+			emit("add", &_to[prefix + i]);
+			popToken(mark);
+		}
+	}
+};
+
+void Json::Diff(const Json& _from, const Json& _to, Json& patch_)
+{
+	APT_ASSERT(&patch_ != &_from && &patch_ != &_to);
+	patch_.clear();
+	rapidjson::Document& patch = patch_.m_impl->m_dom;
+	patch.SetArray();
+	JsonDiff diff(patch, patch.GetAllocator());
+	diff.diff(_from.m_impl->m_dom, _to.m_impl->m_dom);
+}
+
+bool Json::ApplyPatch(Json& json_, const Json& _patch)
+{
+	const rapidjson::Value& patch = _patch.m_impl->m_dom;
+	if (!patch.IsArray()) {
+		APT_LOG_ERR("Json::ApplyPatch: Patch isn't an array");
+		return false;
+	}
+	bool ret = true;
+	JsonPatcher patcher(json_.m_impl->m_dom, json_.m_impl->m_dom.GetAllocator());
+	for (uint i = 0; i < patch.Size(); ++i) {
+		if (!patcher.apply(patch[i])) {
+			APT_LOG_ERR("Json::ApplyPatch: Operation %u: %s", (uint32)i, patcher.m_error);
+			ret = false;
+			break;
+		}
+	}
+	json_.m_impl->resetStack();
+	return ret;
+}
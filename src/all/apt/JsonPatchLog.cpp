@@ -0,0 +1,187 @@
+#include <apt/JsonPatchLog.h>
+#include <apt/JsonImpl.h>
+#include <apt/JsonLinesReader.h>
+#include <apt/JsonLinesWriter.h>
+
+#include <apt/log.h>
+#include <apt/memory.h>
+#include <apt/String.h>
+#include <apt/Time.h>
+
+using namespace apt;
+
+struct JsonPatchLog::Impl
+{
+	Json                 m_saved;                // Last loaded/saved state.
+	bool                 m_isValid      = false; // m_saved, m_path and m_root match the file.
+	PathStr              m_path;
+	FileSystem::RootType m_root         = FileSystem::RootType_Default;
+	uint64               m_snapshotSize = 0;
+	uint64               m_patchSize    = 0;     // Total size of the patches following the snapshot.
+	uint                 m_patchCount   = 0;
+
+	void setSaved(const Json& _json)
+	{
+		m_saved.clear();
+		CopyValue(m_saved.m_impl->m_dom, _json.m_impl->m_dom, m_saved.m_impl->m_dom.GetAllocator());
+	}
+
+	// Write _file to a temporary file then rename it over _fullPath, such that an interrupted write leaves the previous file intact.
+	static bool Replace(const File& _file, const char* _fullPath)
+	{
+		PathStr tmpPath("%s.tmp", _fullPath);
+		if (!File::Write(_file, (const char*)tmpPath)) {
+			return false;
+		}
+		if (!FileSystem::Rename((const char*)tmpPath, _fullPath)) {
+			FileSystem::Delete((const char*)tmpPath);
+			return false;
+		}
+		return true;
+	}
+
+	bool writeSnapshot(const char* _path, FileSystem::RootType _root)
+	{
+		JsonLinesWriter writer;
+		writer.write(m_saved);
+		File f;
+		writer.finish(f);
+		m_isValid = Replace(f, (const char*)FileSystem::MakePath(_path, _root));
+		if (m_isValid) {
+			m_path.set(_path);
+			m_root         = _root;
+			m_snapshotSize = f.getDataSize();
+			m_patchSize    = 0;
+			m_patchCount   = 0;
+		}
+		return m_isValid;
+	}
+};
+
+// PUBLIC
+
+JsonPatchLog::JsonPatchLog()
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl);
+}
+
+JsonPatchLog::~JsonPatchLog()
+{
+	APT_DELETE(m_impl);
+}
+
+bool JsonPatchLog::load(Json& json_, const char* _path, FileSystem::RootType _rootHint)
+{
+	APT_AUTOTIMER("JsonPatchLog::load(%s)", _path);
+	m_impl->m_isValid = false;
+	File f;
+	if (!FileSystem::ReadIfExists(f, _path, _rootHint)) {
+		return false;
+	}
+
+ // ignore an incomplete last line
+	const char* data = f.getData();
+	uint64 dataSize = f.getDataSize();
+	while (dataSize > 0 && data[dataSize - 1] != '\n') {
+		--dataSize;
+	}
+
+	bool ret = true;
+	uint64 snapshotSize = dataSize;
+	uint patchCount = 0;
+	JsonLinesReader reader;
+	reader.begin(data, dataSize);
+	uint64 offset;
+	for (Json* record; ret && (record = reader.next(&offset)) != nullptr; ) {
+		if (reader.getRecordCount() == 1) {
+			json_.clear();
+			CopyValue(json_.m_impl->m_dom, record->m_impl->m_dom, json_.m_impl->m_dom.GetAllocator());
+		} else {
+			if (patchCount == 0) {
+				snapshotSize = offset;
+			}
+			ret = Json::ApplyPatch(json_, *record);
+			++patchCount;
+		}
+	}
+	if (ret && reader.getError()) {
+		ret = false;
+	}
+	if (ret && reader.getRecordCount() == 0) {
+		APT_LOG_ERR("JsonPatchLog: '%s' is empty", _path);
+		ret = false;
+	}
+	reader.end();
+	json_.m_impl->resetStack();
+	if (!ret) {
+		return false;
+	}
+
+	m_impl->setSaved(json_);
+	m_impl->m_isValid      = true;
+	m_impl->m_path.set(_path);
+	m_impl->m_root         = _rootHint;
+	m_impl->m_snapshotSize = snapshotSize;
+	m_impl->m_patchSize    = dataSize - snapshotSize;
+	m_impl->m_patchCount   = patchCount;
+
+ // truncate the incomplete line, else the next patch would be appended to it
+	if (dataSize != f.getDataSize()) {
+		APT_LOG("JsonPatchLog: '%s' truncated incomplete last line (%llu bytes)", _path, (unsigned long long)(f.getDataSize() - dataSize));
+		File truncated;
+		truncated.setData(data, dataSize);
+		if (!Impl::Replace(truncated, f.getPath())) {
+			m_impl->m_isValid = false; // the next save writes a snapshot
+		}
+	}
+	return true;
+}
+
+bool JsonPatchLog::save(const Json& _json, const char* _path, FileSystem::RootType _root)
+{
+	APT_AUTOTIMER("JsonPatchLog::save(%s)", _path);
+	if (!m_impl->m_isValid || !(m_impl->m_path == _path) || m_impl->m_root != _root) {
+		m_impl->setSaved(_json);
+		return m_impl->writeSnapshot(_path, _root);
+	}
+
+	Json patch;
+	Json::Diff(m_impl->m_saved, _json, patch);
+	if (patch.m_impl->m_dom.Empty()) {
+		return true;
+	}
+	JsonLinesWriter writer;
+	writer.write(patch);
+	File f;
+	writer.finish(f);
+
+ // rewrite the snapshot once the patches are larger
+	if (m_impl->m_patchSize + f.getDataSize() > m_impl->m_snapshotSize) {
+		m_impl->setSaved(_json);
+		return m_impl->writeSnapshot(_path, _root);
+	}
+
+	if (!FileSystem::Append(f, _path, _root)) {
+		m_impl->m_isValid = false; // file state unknown, the next save writes a snapshot
+		return false;
+	}
+	APT_VERIFY(Json::ApplyPatch(m_impl->m_saved, patch));
+	m_impl->m_patchSize += f.getDataSize();
+	++m_impl->m_patchCount;
+	return true;
+}
+
+bool JsonPatchLog::compact()
+{
+	if (!m_impl->m_isValid) {
+		return false;
+	}
+	PathStr path = m_impl->m_path;
+	return m_impl->writeSnapshot((const char*)path, m_impl->m_root);
+}
+
+uint JsonPatchLog::getPatchCount() const
+{
+	return m_impl->m_patchCount;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/FileSystem.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonPatchLog
+// Append-only save log. The file is newline-delimited Json (see
+// JsonLinesWriter), the first line is a snapshot of the document and each
+// subsequent line an RFC 6902 patch (see Json::Diff()). save() appends the
+// changes since the previous load()/save(), hence saving a small change to a
+// large document is a small write. load() replays the patches onto the
+// snapshot.
+// A new snapshot is written when the size of the patches exceeds the size of
+// the snapshot, or on the first save() to a path which wasn't loaded.
+// Snapshots are written to a temporary file which then replaces the log. An
+// incomplete last line (e.g. an interrupted save) is removed by load().
+////////////////////////////////////////////////////////////////////////////////
+class JsonPatchLog: private non_copyable<JsonPatchLog>
+{
+public:
+	JsonPatchLog();
+	~JsonPatchLog();
+
+	// Read the log at _path into json_. Return false if the file doesn't exist or an error occurred.
+	bool load(Json& json_, const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+	// Save _json to _path. Return false if an error occurred.
+	bool save(const Json& _json, const char* _path, FileSystem::RootType _root = FileSystem::RootType_Default);
+	// Rewrite the log as a snapshot of the last saved state.
+	bool compact();
+
+	// Number of patches following the snapshot.
+	uint getPatchCount() const;
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+}; // class JsonPatchLog
+
+} // namespace apt
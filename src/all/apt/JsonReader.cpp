@@ -0,0 +1,433 @@
+#include <apt/JsonReader.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/log.h>
+#include <apt/memory.h>
+#include <apt/String.h>
+
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+using namespace apt;
+
+struct JsonReader::Impl
+{
+	static const unsigned kParseFlags = rapidjson::kParseDefaultFlags | rapidjson::kParseStopWhenDoneFlag; // parse a single value
+
+	struct Level
+	{
+		const char* m_begin;   // Opening '{' or '['.
+		int         m_length;  // Array length, -1 if not yet counted.
+		bool        m_isArray;
+		bool        m_first;   // True if no elements have been read.
+	};
+
+	typedef rapidjson::BaseReaderHandler<rapidjson::UTF8<>, void> NullHandler;
+
+ // count the elements of an array
+	struct CountHandler: public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, CountHandler>
+	{
+		int m_depth = 0;
+		int m_count = 0;
+
+		bool Default()                         { m_count += m_depth == 1 ? 1 : 0; return true; }
+		bool StartObject()                     { Default(); ++m_depth; return true; }
+		bool EndObject(rapidjson::SizeType)    { --m_depth; return true; }
+		bool StartArray()                      { Default(); ++m_depth; return true; }
+		bool EndArray(rapidjson::SizeType)     { --m_depth; return true; }
+	};
+
+	rapidjson::Reader     m_reader;
+	const char*           m_begin   = nullptr;
+	const char*           m_end     = nullptr;
+	const char*           m_pos     = nullptr;
+	eastl::vector<Level>  m_stack;
+	String<64>            m_error;
+
+ // current value; objects/arrays are 'pending' until entered or skipped
+	Json::ValueType       m_type    = Json::ValueType_Count;
+	bool                  m_pending = false;
+	const char*           m_pendingBegin = nullptr;
+	rapidjson::Value      m_value;
+	eastl::vector<char>   m_string;
+	eastl::vector<char>   m_name;
+	rapidjson::Value      m_nameValue;
+
+	char peek() const
+	{
+		return m_pos < m_end ? *m_pos : '\0';
+	}
+
+	bool setError(uint _offset, const char* _msg)
+	{
+		if (m_error.isEmpty()) {
+			m_error.setf("offset %u: %s", (uint32)_offset, _msg);
+			APT_LOG_ERR("JsonReader error: %s", (const char*)m_error);
+		}
+		return false;
+	}
+
+	// Parse a single value at m_pos via _handler_, advance m_pos to the end of the value.
+	template <typename tHandler>
+	bool parse(tHandler& _handler_)
+	{
+		rapidjson::MemoryStream is(m_pos, (size_t)(m_end - m_pos));
+		rapidjson::ParseResult result = m_reader.Parse<kParseFlags>(is, _handler_);
+		if (result.IsError()) {
+			return setError((uint)(m_pos - m_begin + result.Offset()), rapidjson::GetParseError_En(result.Code()));
+		}
+		m_pos += is.Tell();
+		return true;
+	}
+
+	void skipWhitespace()
+	{
+		while (m_pos < m_end) {
+			char c = *m_pos;
+			if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+				++m_pos;
+			} else if (c == '/' && m_pos + 1 < m_end && m_pos[1] == '/') {
+				while (m_pos < m_end && *m_pos != '\n') {
+					++m_pos;
+				}
+			} else if (c == '/' && m_pos + 1 < m_end && m_pos[1] == '*') {
+				m_pos += 2;
+				while (m_pos + 1 < m_end && !(m_pos[0] == '*' && m_pos[1] == '/')) {
+					++m_pos;
+				}
+				if (m_pos + 1 >= m_end) {
+					m_pos = m_end;
+					setError((uint)(m_end - m_begin), "Unterminated comment.");
+					return;
+				}
+				m_pos += 2;
+			} else {
+				break;
+			}
+		}
+	}
+
+	// Move to the next element of the current object/array. If _skip is true the value isn't stored. If _name is specified the
+	// value is only stored if the member name matches. Return false at the end of the object/array or if an error occurred.
+	bool advance(bool _skip, const char* _name = nullptr)
+	{
+		m_type = Json::ValueType_Count;
+		if (!m_error.isEmpty()) {
+			return false;
+		}
+		if (m_pending) {
+		 // the previous value was an object/array which wasn't entered, skip it
+			m_pending = false;
+			m_pos = m_pendingBegin;
+			NullHandler nullHandler;
+			if (!parse(nullHandler)) {
+				return false;
+			}
+		}
+
+		Level& level = m_stack.back();
+		const char close = level.m_isArray ? ']' : '}';
+		skipWhitespace();
+		if (!level.m_first) {
+			if (peek() == close) {
+				return false;
+			}
+			if (peek() != ',') {
+				return setError((uint)(m_pos - m_begin), level.m_isArray ? "Missing a comma or ']' after an array element." : "Missing a comma or '}' after an object member.");
+			}
+			++m_pos;
+			skipWhitespace();
+		}
+		if (peek() == close) { // empty, or trailing comma
+			return false;
+		}
+		level.m_first = false;
+
+		if (!level.m_isArray) {
+			if (peek() != '"') {
+				return setError((uint)(m_pos - m_begin), "Missing a name for object member.");
+			}
+			if (_skip && !_name) {
+				NullHandler nullHandler;
+				if (!parse(nullHandler)) {
+					return false;
+				}
+			} else {
+				ValueHandler nameHandler(&m_nameValue, &m_name);
+				if (!parse(nameHandler)) {
+					return false;
+				}
+				_skip |= _name && strcmp(m_name.data(), _name) != 0;
+			}
+			skipWhitespace();
+			if (peek() != ':') {
+				return setError((uint)(m_pos - m_begin), "Missing a colon after a name of object member.");
+			}
+			++m_pos;
+			skipWhitespace();
+		}
+
+		const char c = peek();
+		if (c == '{' || c == '[') {
+			m_pending = true;
+			m_pendingBegin = m_pos;
+			if (!_skip) {
+				m_type = c == '{' ? Json::ValueType_Object : Json::ValueType_Array;
+			}
+			return true;
+		}
+		if (_skip) {
+			NullHandler nullHandler;
+			return parse(nullHandler);
+		}
+		ValueHandler valueHandler(&m_value, &m_string);
+		if (!parse(valueHandler)) {
+			return false;
+		}
+		m_type = GetValueType(m_value.GetType());
+		return true;
+	}
+
+	bool enter(Json::ValueType _type)
+	{
+		if (m_type != _type || !m_pending) {
+			return false;
+		}
+		Level level;
+		level.m_begin   = m_pendingBegin;
+		level.m_length  = -1;
+		level.m_isArray = _type == Json::ValueType_Array;
+		level.m_first   = true;
+		m_stack.push_back(level);
+		m_pos = m_pendingBegin + 1;
+		m_pending = false;
+		m_type = Json::ValueType_Count;
+		return true;
+	}
+
+	void leave(Json::ValueType _type)
+	{
+		APT_ASSERT(m_stack.size() > 1); // can't leave the root
+		APT_ASSERT(m_stack.back().m_isArray == (_type == Json::ValueType_Array));
+		while (advance(true)) {}
+		if (m_error.isEmpty()) {
+			APT_ASSERT(peek() == (_type == Json::ValueType_Array ? ']' : '}'));
+			++m_pos;
+		}
+		m_stack.pop_back();
+		m_type = Json::ValueType_Count;
+	}
+};
+
+// PUBLIC
+
+JsonReader::JsonReader()
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl);
+}
+
+JsonReader::~JsonReader()
+{
+	APT_DELETE(m_impl);
+}
+
+bool JsonReader::init(const char* _data, uint _dataSize)
+{
+	m_impl->m_begin   = _data;
+	m_impl->m_end     = _data + _dataSize;
+	m_impl->m_pos     = _data;
+	m_impl->m_type    = Json::ValueType_Count;
+	m_impl->m_pending = false;
+	m_impl->m_stack.clear();
+	m_impl->m_error.clear();
+
+	m_impl->skipWhitespace();
+	const char c = m_impl->peek();
+	if (c != '{' && c != '[') {
+		return m_impl->setError((uint)(m_impl->m_pos - m_impl->m_begin), "The document root must be an object or an array.");
+	}
+	Impl::Level level;
+	level.m_begin   = m_impl->m_pos;
+	level.m_length  = -1;
+	level.m_isArray = c == '[';
+	level.m_first   = true;
+	m_impl->m_stack.push_back(level);
+	++m_impl->m_pos;
+	return true;
+}
+
+const char* JsonReader::getError() const
+{
+	return m_impl->m_error.isEmpty() ? nullptr : (const char*)m_impl->m_error;
+}
+
+bool JsonReader::find(const char* _name)
+{
+	APT_ASSERT(!m_impl->m_stack.empty());
+	Impl::Level& level = m_impl->m_stack.back();
+	if (level.m_isArray) {
+		return false;
+	}
+
+ // search forward to the end of the object
+	const char* startPos     = m_impl->m_pos;
+	const char* startPending = m_impl->m_pending ? m_impl->m_pendingBegin : nullptr;
+	const bool  startFirst   = level.m_first;
+	while (m_impl->advance(false, _name)) {
+		if (m_impl->m_type != Json::ValueType_Count) {
+			return true;
+		}
+	}
+	if (!m_impl->m_error.isEmpty()) {
+		return false;
+	}
+
+ // wrap around to the start of the object
+	m_impl->m_pos = level.m_begin + 1;
+	m_impl->m_pending = false;
+	level.m_first = true;
+	while (m_impl->m_pos < startPos && m_impl->advance(false, _name)) {
+		if (m_impl->m_type != Json::ValueType_Count) {
+			return true;
+		}
+	}
+
+ // not found, restore the start position
+	m_impl->m_pos = startPos;
+	m_impl->m_pending = startPending != nullptr;
+	m_impl->m_pendingBegin = startPending;
+	m_impl->m_type = Json::ValueType_Count;
+	level.m_first = startFirst;
+	return false;
+}
+
+bool JsonReader::next()
+{
+	APT_ASSERT(!m_impl->m_stack.empty());
+	return m_impl->advance(false);
+}
+
+Json::ValueType JsonReader::getType() const
+{
+	return m_impl->m_type;
+}
+
+const char* JsonReader::getName() const
+{
+	if (m_impl->m_stack.empty() || m_impl->m_stack.back().m_isArray || m_impl->m_type == Json::ValueType_Count) {
+		return nullptr;
+	}
+	return m_impl->m_name.data();
+}
+
+template <> bool JsonReader::getValue<bool>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Bool, "JsonReader::getValue: not a bool");
+	return m_impl->m_value.GetBool();
+}
+template <> sint64 JsonReader::getValue<sint64>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonReader::getValue: not a number");
+	return m_impl->m_value.GetInt64();
+}
+template <> sint32 JsonReader::getValue<sint32>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonReader::getValue: not a number");
+	return m_impl->m_value.GetInt();
+}
+template <> sint16 JsonReader::getValue<sint16>() const
+{
+	return (sint16)getValue<sint32>();
+}
+template <> sint8 JsonReader::getValue<sint8>() const
+{
+	return (sint8)getValue<sint32>();
+}
+template <> uint64 JsonReader::getValue<uint64>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonReader::getValue: not a number");
+	return m_impl->m_value.GetUint64();
+}
+template <> uint32 JsonReader::getValue<uint32>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonReader::getValue: not a number");
+	return m_impl->m_value.GetUint();
+}
+template <> uint16 JsonReader::getValue<uint16>() const
+{
+	return (uint16)getValue<uint32>();
+}
+template <> uint8 JsonReader::getValue<uint8>() const
+{
+	return (uint8)getValue<uint32>();
+}
+template <> float32 JsonReader::getValue<float32>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonReader::getValue: not a number");
+	return m_impl->m_value.GetFloat();
+}
+template <> float64 JsonReader::getValue<float64>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_Number, "JsonReader::getValue: not a number");
+	return m_impl->m_value.GetDouble();
+}
+template <> const char* JsonReader::getValue<const char*>() const
+{
+	APT_ASSERT_MSG(m_impl->m_type == Json::ValueType_String, "JsonReader::getValue: not a string");
+	return m_impl->m_value.GetString();
+}
+
+bool JsonReader::enterObject()
+{
+	if (m_impl->enter(Json::ValueType_Object)) {
+		return true;
+	}
+	APT_ASSERT(false); // not an object
+	return false;
+}
+
+void JsonReader::leaveObject()
+{
+	m_impl->leave(Json::ValueType_Object);
+}
+
+bool JsonReader::enterArray()
+{
+	if (m_impl->enter(Json::ValueType_Array)) {
+		return true;
+	}
+	APT_ASSERT(false); // not an array
+	return false;
+}
+
+void JsonReader::leaveArray()
+{
+	m_impl->leave(Json::ValueType_Array);
+}
+
+bool JsonReader::isInArray() const
+{
+	APT_ASSERT(!m_impl->m_stack.empty());
+	return m_impl->m_stack.back().m_isArray;
+}
+
+int JsonReader::getArrayLength()
+{
+	APT_ASSERT(!m_impl->m_stack.empty());
+	Impl::Level& level = m_impl->m_stack.back();
+	if (!level.m_isArray) {
+		return -1;
+	}
+	if (level.m_length < 0) {
+		const char* pos = m_impl->m_pos;
+		m_impl->m_pos = level.m_begin;
+		Impl::CountHandler countHandler;
+		if (m_impl->parse(countHandler)) {
+			level.m_length = countHandler.m_count;
+		}
+		m_impl->m_pos = pos;
+	}
+	return level.m_length;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/Json.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonReader
+// Forward-only cursor over Json text. No DOM is built, memory use is
+// proportional to the nesting depth of the document rather than its size.
+// Traversal follows the same state machine as Json, with the following
+// differences:
+// - find() searches forward from the current position and wraps around to the
+//   start of the current object; it is cheapest when members are requested in
+//   document order. If find() returns false the current value is undefined.
+// - Array elements are accessed in order via next(). getArrayLength() counts
+//   the elements by scanning the array text (the result is cached).
+// - getValue() is only valid for the current value until the cursor moves,
+//   and only for bool/number/string values (use enterArray() for vec*/mat*).
+// - Objects/arrays which aren't entered, or aren't read to the end, are
+//   skipped without being parsed into values.
+// The text must remain valid for the lifetime of the reader.
+////////////////////////////////////////////////////////////////////////////////
+class JsonReader: private non_copyable<JsonReader>
+{
+public:
+	JsonReader();
+	~JsonReader();
+
+	// Begin reading _data (_dataSize bytes, need not be null-terminated). Return false if the root is not an object or an array.
+	bool init(const char* _data, uint _dataSize);
+	bool init(const File& _file)                       { return init(_file.getData(), (uint)_file.getDataSize()); }
+
+	// Return the first parse error encountered, or nullptr if no error occurred. Once an error occurs all traversal functions
+	// return false.
+	const char* getError() const;
+
+	// Find a named value in the current object. Return true if the value is found, in which case getValue() may be called.
+	bool find(const char* _name);
+
+	// Get the next value in the current object/array. Return true if not the end of the object/array, in which case getValue() may be called.
+	bool next();
+
+	// Get the type of the current value (ValueType_Count if there is no current value).
+	Json::ValueType getType() const;
+
+	// Get the name of the current value, or nullptr if in an array.
+	const char* getName() const;
+
+	// Get the current value. tType must match the type of the current value.
+	template <typename tType>
+	tType getValue() const;
+
+	// Enter the current object (call immediately after find() or next()). Return false if the current value is not an object.
+	bool enterObject();
+	// Skip any remaining members and leave the current object.
+	void leaveObject();
+
+	// Enter the current array (call immediately after find() or next()). Return false if the current value is not an array.
+	bool enterArray();
+	// Skip any remaining elements and leave the current array.
+	void leaveArray();
+
+	// Return the number of elements in the current array (or -1 if not in an array).
+	int getArrayLength();
+	// Return true if the current container is an array (cheaper than getArrayLength() >= 0).
+	bool isInArray() const;
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+}; // class JsonReader
+
+} // namespace apt
@@ -0,0 +1,95 @@
+#include <apt/JsonSchema.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/hash.h>
+#include <apt/log.h>
+#include <apt/memory.h>
+#include <apt/Time.h>
+
+#include <EASTL/hash_map.h>
+
+#include <mutex>
+
+using namespace apt;
+
+namespace {
+ // Schemas returned by JsonSchema::Find(), keyed by a hash of the path and root hint.
+	static eastl::hash_map<uint64, JsonSchema*> s_SchemaCache;
+	static std::mutex                           s_SchemaCacheMutex;
+	static thread_local int                     s_SchemaCompileDepth = 0; // Guards against cyclic remote references.
+	static const int                            kMaxSchemaCompileDepth = 16;
+
+	uint64 SchemaCacheKey(const char* _path, FileSystem::RootType _rootHint)
+	{
+		return HashString<uint64>(_path, Hash<uint64>(&_rootHint, sizeof(_rootHint)));
+	}
+}
+
+// PUBLIC
+
+const JsonSchema* JsonSchema::Find(const char* _path, FileSystem::RootType _rootHint)
+{
+	const uint64 key = SchemaCacheKey(_path, _rootHint);
+	{	std::lock_guard<std::mutex> lock(s_SchemaCacheMutex);
+		auto it = s_SchemaCache.find(key);
+		if (it != s_SchemaCache.end()) {
+			return it->second;
+		}
+	}
+
+ // compile without holding the lock, remote references call Find() recursively
+	if (s_SchemaCompileDepth >= kMaxSchemaCompileDepth) {
+		APT_LOG_ERR("JsonSchema error: %s\n\t'Too many nested remote references'", _path);
+		return nullptr;
+	}
+	++s_SchemaCompileDepth;
+	JsonSchema* schema = APT_NEW(JsonSchema);
+	bool ret = schema->init(_path, _rootHint);
+	--s_SchemaCompileDepth;
+	if (!ret) {
+		APT_DELETE(schema);
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(s_SchemaCacheMutex);
+	auto it = s_SchemaCache.insert(eastl::make_pair(key, schema));
+	if (!it.second) {
+		APT_DELETE(schema); // compiled concurrently by another thread
+	}
+	return it.first->second;
+}
+
+void JsonSchema::ClearCache()
+{
+	std::lock_guard<std::mutex> lock(s_SchemaCacheMutex);
+	for (auto& it : s_SchemaCache) {
+		APT_DELETE(it.second);
+	}
+	s_SchemaCache.clear();
+}
+
+JsonSchema::JsonSchema()
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl);
+}
+
+JsonSchema::~JsonSchema()
+{
+	APT_DELETE(m_impl);
+}
+
+bool JsonSchema::init(const File& _file)
+{
+	return m_impl->compile(_file, FileSystem::RootType_Default);
+}
+
+bool JsonSchema::init(const char* _path, FileSystem::RootType _rootHint)
+{
+	APT_AUTOTIMER("JsonSchema::init(%s)", _path);
+	File f;
+	if (!FileSystem::ReadIfExists(f, _path, _rootHint)) {
+		return false;
+	}
+	return m_impl->compile(f, _rootHint);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/FileSystem.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonSchema
+// Compiled Json schema (draft 4). Documents are validated during parsing by
+// passing a schema to Json::Read*(): parser events are filtered through the
+// validator before reaching the DOM, hence there's no second pass and an
+// invalid document is rejected as soon as the first error is found. Errors are
+// logged with Json pointers (RFC 6901) to the invalid value and to the schema.
+//
+// Find() compiles a schema once and caches it by path hash. Compiled schemas
+// are immutable and may be shared between threads. Remote references (e.g.
+// "$ref": "common.json#/definitions/vec3") are resolved via Find().
+////////////////////////////////////////////////////////////////////////////////
+class JsonSchema: private non_copyable<JsonSchema>
+{
+	friend class Json;
+public:
+	// Return the schema at _path, compiling it on the first call. Return nullptr if an error occurred (failures aren't cached).
+	static const JsonSchema* Find(const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+	// Destroy all schemas returned by Find(). Schemas which reference them remotely must be destroyed first.
+	static void ClearCache();
+
+	JsonSchema();
+	~JsonSchema();
+
+	// Compile the schema from _file or _path. Return false if an error occurred.
+	bool init(const File& _file);
+	bool init(const char* _path, FileSystem::RootType _rootHint = FileSystem::RootType_Default);
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+}; // class JsonSchema
+
+} // namespace apt
@@ -0,0 +1,244 @@
+#include <apt/JsonWriter.h>
+#include <apt/JsonImpl.h>
+
+#include <apt/log.h>
+#include <apt/memory.h>
+#include <apt/FileSystem.h>
+#include <apt/Time.h>
+
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+using namespace apt;
+
+struct JsonWriter::Impl
+{
+ // rapidjson output stream, writes into the current chunk
+	struct Stream
+	{
+		typedef char Ch;
+		Impl* m_impl;
+
+		void Put(char _c)
+		{
+			if (m_impl->m_chunkUsed == m_impl->m_chunkSize) {
+				m_impl->nextChunk();
+			}
+			m_impl->m_chunk[m_impl->m_chunkUsed++] = _c;
+		}
+		void Flush()
+		{
+		}
+	};
+
+	OutputCallback                  m_callback;
+	uint                            m_chunkSize;
+	eastl::vector<char*>            m_chunks;           // Buffered output (if no callback), all but the last chunk are full.
+	char*                           m_chunk     = nullptr;
+	uint                            m_chunkUsed = 0;
+	uint64                          m_size      = 0;    // Size of all chunks prior to m_chunk.
+	bool                            m_error     = false;
+	eastl::vector<bool>             m_stack;            // True if an array.
+	Stream                          m_stream;
+	bool                            m_pretty;
+	rapidjson::Writer<Stream>       m_writer;
+	rapidjson::PrettyWriter<Stream> m_prettyWriter;
+
+	Impl(const OutputCallback& _callback, bool _pretty, uint _chunkSize)
+		: m_callback(_callback)
+		, m_chunkSize(APT_MAX(_chunkSize, (uint)64))
+		, m_pretty(_pretty)
+		, m_writer(m_stream)
+		, m_prettyWriter(m_stream)
+	{
+		m_stream.m_impl = this;
+		m_prettyWriter.SetIndent('\t', 1);
+		m_prettyWriter.SetFormatOptions(rapidjson::kFormatSingleLineArray);
+		m_chunk = (char*)APT_MALLOC(m_chunkSize);
+		if (!m_callback) {
+			m_chunks.push_back(m_chunk);
+		}
+	}
+
+	~Impl()
+	{
+		if (m_callback) {
+			APT_FREE(m_chunk);
+		}
+		releaseChunks();
+	}
+
+	void releaseChunks()
+	{
+		for (char* chunk : m_chunks) {
+			APT_FREE(chunk);
+		}
+		m_chunks.clear();
+		m_chunk = nullptr;
+	}
+
+	void nextChunk()
+	{
+		m_size += m_chunkUsed;
+		if (m_callback) {
+		 // stream the chunk, then reuse it
+			if (!m_error) {
+				m_error = !m_callback(m_chunk, m_chunkUsed);
+			}
+		} else {
+			m_chunk = (char*)APT_MALLOC(m_chunkSize);
+			m_chunks.push_back(m_chunk);
+		}
+		m_chunkUsed = 0;
+	}
+
+	// Call _func with whichever writer is in use. If _func returns false (rapidjson rejects NaN/infinity) the error is recorded and
+	// finish() will return false.
+	template <typename tFunc>
+	void write(tFunc _func)
+	{
+		APT_ASSERT(m_chunk); // finish(File&) was called
+		bool ret = m_pretty ? _func(m_prettyWriter) : _func(m_writer);
+		if (!ret && !m_error) {
+			APT_LOG_ERR("Json error: JsonWriter\n\t'Invalid value (NaN or infinity)'");
+			m_error = true;
+		}
+	}
+};
+
+// PUBLIC
+
+JsonWriter::JsonWriter(bool _pretty, uint _chunkSize)
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl(OutputCallback(), _pretty, _chunkSize));
+	beginObject();
+}
+
+JsonWriter::JsonWriter(const OutputCallback& _callback, bool _pretty, uint _chunkSize)
+	: m_impl(nullptr)
+{
+	m_impl = APT_NEW(Impl(_callback, _pretty, _chunkSize));
+	beginObject();
+}
+
+JsonWriter::~JsonWriter()
+{
+	APT_DELETE(m_impl);
+}
+
+bool JsonWriter::finish()
+{
+	while (!m_impl->m_stack.empty()) {
+		if (m_impl->m_stack.back()) {
+			endArray();
+		} else {
+			endObject();
+		}
+	}
+	if (m_impl->m_callback && m_impl->m_chunkUsed > 0) {
+		m_impl->nextChunk();
+	}
+	return !m_impl->m_error;
+}
+
+bool JsonWriter::finish(File& file_)
+{
+	APT_ASSERT(!m_impl->m_callback); // output isn't buffered
+	if (!finish()) {
+		return false;
+	}
+	file_.setDataSize(getSize());
+	char* dst = file_.getData();
+	for (uint i = 0; i < m_impl->m_chunks.size(); ++i) {
+		uint size = i == m_impl->m_chunks.size() - 1 ? m_impl->m_chunkUsed : m_impl->m_chunkSize;
+		memcpy(dst, m_impl->m_chunks[i], size);
+		dst += size;
+	}
+	m_impl->releaseChunks();
+	return true;
+}
+
+bool JsonWriter::finish(const char* _path, FileSystem::RootType _root)
+{
+	APT_AUTOTIMER("JsonWriter::finish(%s)", _path);
+	File f;
+	if (finish(f)) {
+		return FileSystem::Write(f, _path, _root);
+	}
+	return false;
+}
+
+uint64 JsonWriter::getSize() const
+{
+	return m_impl->m_size + m_impl->m_chunkUsed;
+}
+
+void JsonWriter::beginObject(const char* _name)
+{
+	key(_name);
+	m_impl->write([](auto& _writer_) { return _writer_.StartObject(); });
+	m_impl->m_stack.push_back(false);
+}
+
+void JsonWriter::endObject()
+{
+	APT_ASSERT(!m_impl->m_stack.empty() && !m_impl->m_stack.back());
+	m_impl->m_stack.pop_back();
+	m_impl->write([](auto& _writer_) { return _writer_.EndObject(); });
+}
+
+void JsonWriter::beginArray(const char* _name)
+{
+	key(_name);
+	m_impl->write([](auto& _writer_) { return _writer_.StartArray(); });
+	m_impl->m_stack.push_back(true);
+}
+
+void JsonWriter::endArray()
+{
+	APT_ASSERT(!m_impl->m_stack.empty() && m_impl->m_stack.back());
+	m_impl->m_stack.pop_back();
+	m_impl->write([](auto& _writer_) { return _writer_.EndArray(); });
+}
+
+bool JsonWriter::isInArray() const
+{
+	return !m_impl->m_stack.empty() && m_impl->m_stack.back();
+}
+
+// PRIVATE
+
+void JsonWriter::key(const char* _name)
+{
+	if (m_impl->m_stack.empty() || isInArray()) {
+		return;
+	}
+	APT_ASSERT_MSG(_name, "JsonWriter: name must be specified if not in an array");
+	m_impl->write([_name](auto& _writer_) { return _writer_.Key(_name); });
+}
+
+void JsonWriter::write(bool _value)        { m_impl->write([_value](auto& _writer_) { return _writer_.Bool(_value);   }); }
+void JsonWriter::write(sint32 _value)      { m_impl->write([_value](auto& _writer_) { return _writer_.Int(_value);    }); }
+void JsonWriter::write(uint32 _value)      { m_impl->write([_value](auto& _writer_) { return _writer_.Uint(_value);   }); }
+void JsonWriter::write(sint64 _value)      { m_impl->write([_value](auto& _writer_) { return _writer_.Int64(_value);  }); }
+void JsonWriter::write(uint64 _value)      { m_impl->write([_value](auto& _writer_) { return _writer_.Uint64(_value); }); }
+void JsonWriter::write(float64 _value)     { m_impl->write([_value](auto& _writer_) { return _writer_.Double(_value); }); }
+void JsonWriter::write(const char* _value) { m_impl->write([_value](auto& _writer_) { return _writer_.String(_value); }); }
+
+template <typename tType, int kCount>
+static void WriteArray(JsonWriter& _writer_, const tType* _values)
+{
+	_writer_.beginArray();
+	for (int i = 0; i < kCount; ++i) {
+		_writer_.pushValue(_values[i]);
+	}
+	_writer_.endArray();
+}
+void JsonWriter::write(const vec2& _value) { WriteArray<float, 2>(*this, &_value.x); }
+void JsonWriter::write(const vec3& _value) { WriteArray<float, 3>(*this, &_value.x); }
+void JsonWriter::write(const vec4& _value) { WriteArray<float, 4>(*this, &_value.x); }
+void JsonWriter::write(const mat2& _value) { WriteArray<vec2, 2>(*this, &_value[0]); }
+void JsonWriter::write(const mat3& _value) { WriteArray<vec3, 3>(*this, &_value[0]); }
+void JsonWriter::write(const mat4& _value) { WriteArray<vec4, 4>(*this, &_value[0]); }
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/Json.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// JsonWriter
+// Emit Json text directly, no DOM is built. Output is either buffered in a
+// list of fixed-size chunks (retrieve via finish(File&)), or streamed to a
+// callback each time a chunk fills, in which case memory use is bounded by the
+// chunk size.
+// The root object is begun on construction and closed by finish(). Names are
+// ignored for values/objects/arrays written into an array. Unlike Json, 
+// setValue() doesn't replace an existing member of the same name.
+////////////////////////////////////////////////////////////////////////////////
+class JsonWriter: private non_copyable<JsonWriter>
+{
+public:
+	// Receive _size bytes of output. Return false to stop writing (finish() will return false).
+	typedef Json::OutputCallback OutputCallback;
+
+	// Buffer the output.
+	JsonWriter(bool _pretty = true, uint _chunkSize = 64 * 1024);
+	// Stream the output to _callback.
+	JsonWriter(const OutputCallback& _callback, bool _pretty = true, uint _chunkSize = 64 * 1024);
+	~JsonWriter();
+
+	// Close any open objects/arrays plus the root object and flush the output. Return false if an error occurred (a NaN or infinite value
+	// was written, or the callback returned false).
+	bool finish();
+	// As finish(), copy the buffered output to file_. The chunks are released.
+	bool finish(File& file_);
+	// As finish(File&), write the output to _path.
+	bool finish(const char* _path, FileSystem::RootType _root = FileSystem::RootType_Default);
+
+	// Total bytes written.
+	uint64 getSize() const;
+
+	// Begin an object/array. _name must be specified unless in an array.
+	void beginObject(const char* _name = nullptr);
+	void endObject();
+	void beginArray(const char* _name = nullptr);
+	void endArray();
+
+	bool isInArray() const;
+
+	// Write a named value into the current object, or into the current array (in which case _name is ignored).
+	template <typename tType>
+	void setValue(const char* _name, tType _value)     { key(_name); write(_value); }
+
+	// Push _value into the current array.
+	template <typename tType>
+	void pushValue(tType _value)                       { APT_ASSERT(isInArray()); write(_value); }
+
+private:
+	struct Impl;
+	Impl* m_impl;
+
+	void key(const char* _name);
+
+	void write(bool        _value);
+	void write(sint32      _value);
+	void write(uint32      _value);
+	void write(sint64      _value);
+	void write(uint64      _value);
+	void write(float64     _value);
+	void write(const char* _value);
+	void write(const vec2& _value);
+	void write(const vec3& _value);
+	void write(const vec4& _value);
+	void write(const mat2& _value);
+	void write(const mat3& _value);
+	void write(const mat4& _value);
+
+}; // class JsonWriter
+
+} // namespace apt
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/hash.h>
+#include <apt/log.h>
+#include <apt/Serializer.h>
+#include <apt/String.h>
+
+#include <EASTL/vector.h>
+
+#include <cstring>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////////
+// Reflect
+// Compile-time field lists for serialization. Declare the fields of a type
+// once (at global namespace scope, after the type definition):
+//
+//    struct Particle
+//    {
+//       vec3                 m_position;
+//       float32              m_mass;
+//       uint32               m_flags[4];
+//       eastl::vector<vec3>  m_path;
+//    };
+//
+//    APT_REFLECT_BEGIN(Particle)
+//       APT_REFLECT_FIELD_NAMED(m_position, "Position")
+//       APT_REFLECT_FIELD_NAMED(m_mass,     "Mass")
+//       APT_REFLECT_FIELD(m_flags)                     // name is "m_flags"
+//       APT_REFLECT_FIELD_NAMED(m_path,     "Path")
+//    APT_REFLECT_END()
+//
+// Serialize(_serializer_, particle, "Particle") then reads/writes the fields
+// as an object. Field names are hashed at compile time.
+//
+// Serialize() is resolved against the static type of the serializer, hence
+// passing a SerializerJson or SerializerBinary (both final) avoids virtual
+// dispatch per field. ReflectBackend may be specialized to provide a faster
+// path for a particular serializer (see SerializerJson).
+//
+// Fields may be scalars, strings, vec*/mat*, reflected types, any type with a
+// Serialize() overload, C arrays or eastl::vector of any of these. Arrays of
+// scalars are serialized in bulk (Serializer::value(tType*, uint)).
+////////////////////////////////////////////////////////////////////////////////
+#define APT_REFLECT_BEGIN(_type) \
+	namespace apt { \
+	template <> struct Reflect<_type> \
+	{ \
+		static const bool kIsReflected = true; \
+		template <typename tVisitor> \
+		static bool Visit(tVisitor& _visitor_, _type& _value_) \
+		{ \
+			bool ret = true;
+#define APT_REFLECT_FIELD_NAMED(_member, _name) \
+			ret &= _visitor_.field(_value_._member, apt::ReflectName { _name, (apt::uint)sizeof(_name) - 1, std::integral_constant<apt::uint64, apt::internal::HashStringConst64(_name)>::value });
+#define APT_REFLECT_FIELD(_member) \
+	APT_REFLECT_FIELD_NAMED(_member, #_member)
+#define APT_REFLECT_END() \
+			return ret; \
+		} \
+	}; \
+	}
+
+namespace apt {
+
+// Field name with a precomputed hash (m_hash == StringHash(m_str)).
+struct ReflectName
+{
+	const char* m_str;
+	uint        m_length;
+	uint64      m_hash;
+};
+
+// Specialized via APT_REFLECT_BEGIN/APT_REFLECT_END.
+template <typename tType>
+struct Reflect
+{
+	static const bool kIsReflected = false;
+};
+
+// Serializer operations used by reflected serialization. The default calls the serializer directly; _name is nullptr for array
+// elements.
+template <typename tSerializer>
+struct ReflectBackend
+{
+	static bool BeginObject(tSerializer& _serializer_, const ReflectName* _name)
+	{
+		return _serializer_.beginObject(_name ? _name->m_str : nullptr);
+	}
+	static void EndObject(tSerializer& _serializer_)
+	{
+		_serializer_.endObject();
+	}
+
+	static bool BeginArray(tSerializer& _serializer_, uint& _length_, const ReflectName* _name)
+	{
+		return _serializer_.beginArray(_length_, _name ? _name->m_str : nullptr);
+	}
+	static void EndArray(tSerializer& _serializer_)
+	{
+		_serializer_.endArray();
+	}
+
+	template <typename tType>
+	static bool Value(tSerializer& _serializer_, tType& _value_, const ReflectName* _name)
+	{
+		return _serializer_.value(_value_, _name ? _name->m_str : nullptr);
+	}
+
+	// Array of _count values (when reading, the array length must equal _count).
+	template <typename tType>
+	static bool Values(tSerializer& _serializer_, tType* _values_, uint _count, const ReflectName* _name)
+	{
+		return _serializer_.value(_values_, _count, _name ? _name->m_str : nullptr);
+	}
+
+	// _count elements of the current array.
+	template <typename tType>
+	static bool Elements(tSerializer& _serializer_, tType* _values_, uint _count)
+	{
+		bool ret = true;
+		for (uint i = 0; i < _count; ++i) {
+			ret &= _serializer_.value(_values_[i]);
+		}
+		return ret;
+	}
+};
+
+namespace internal {
+
+enum ReflectKind
+{
+	ReflectKind_Scalar,  // Serializer::value().
+	ReflectKind_String,  // Serializer::value(StringBase&).
+	ReflectKind_Object,  // Reflected type.
+	ReflectKind_Array,   // tType[kCount].
+	ReflectKind_Vector,  // eastl::vector<tType>.
+	ReflectKind_Value,   // Serializer::value() overload (vec*, mat*).
+	ReflectKind_Other    // Serialize() overload.
+};
+
+template <typename tType> struct ReflectIsScalar:          std::false_type {};
+template <>               struct ReflectIsScalar<bool>:    std::true_type  {};
+template <>               struct ReflectIsScalar<sint8>:   std::true_type  {};
+template <>               struct ReflectIsScalar<uint8>:   std::true_type  {};
+template <>               struct ReflectIsScalar<sint16>:  std::true_type  {};
+template <>               struct ReflectIsScalar<uint16>:  std::true_type  {};
+template <>               struct ReflectIsScalar<sint32>:  std::true_type  {};
+template <>               struct ReflectIsScalar<uint32>:  std::true_type  {};
+template <>               struct ReflectIsScalar<sint64>:  std::true_type  {};
+template <>               struct ReflectIsScalar<uint64>:  std::true_type  {};
+template <>               struct ReflectIsScalar<float32>: std::true_type  {};
+template <>               struct ReflectIsScalar<float64>: std::true_type  {};
+
+template <typename tType> struct ReflectHasValue:          std::false_type {};
+template <>               struct ReflectHasValue<vec2>:    std::true_type  {};
+template <>               struct ReflectHasValue<vec3>:    std::true_type  {};
+template <>               struct ReflectHasValue<vec4>:    std::true_type  {};
+template <>               struct ReflectHasValue<mat2>:    std::true_type  {};
+template <>               struct ReflectHasValue<mat3>:    std::true_type  {};
+template <>               struct ReflectHasValue<mat4>:    std::true_type  {};
+
+template <typename tType>
+struct ReflectKindOf: std::integral_constant<int,
+	ReflectIsScalar<tType>::value                ? ReflectKind_Scalar :
+	std::is_base_of<StringBase, tType>::value    ? ReflectKind_String :
+	Reflect<tType>::kIsReflected                 ? ReflectKind_Object :
+	ReflectHasValue<tType>::value                ? ReflectKind_Value  :
+	                                               ReflectKind_Other
+	> {};
+template <typename tType, uint kCount>
+struct ReflectKindOf<tType[kCount]>: std::integral_constant<int, ReflectKind_Array> {};
+template <typename tType, typename tAllocator>
+struct ReflectKindOf<eastl::vector<tType, tAllocator> >: std::integral_constant<int, ReflectKind_Vector> {};
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name);
+
+template <typename tSerializer>
+struct ReflectVisitor
+{
+	tSerializer& m_serializer;
+
+	template <typename tType>
+	bool field(tType& _value_, const ReflectName& _name)
+	{
+		return ReflectSerialize(m_serializer, _value_, &_name);
+	}
+};
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_Scalar>)
+{
+	return ReflectBackend<tSerializer>::Value(_serializer_, _value_, _name);
+}
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_String>)
+{
+	return ReflectBackend<tSerializer>::Value(_serializer_, (StringBase&)_value_, _name);
+}
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_Object>)
+{
+	if (!ReflectBackend<tSerializer>::BeginObject(_serializer_, _name)) {
+		return false;
+	}
+	ReflectVisitor<tSerializer> visitor = { _serializer_ };
+	bool ret = Reflect<tType>::Visit(visitor, _value_);
+	ReflectBackend<tSerializer>::EndObject(_serializer_);
+	return ret;
+}
+
+// Elements of the current array (non-scalar types are serialized individually).
+template <typename tSerializer, typename tType>
+bool ReflectElements(tSerializer& _serializer_, tType* _values_, uint _count, std::false_type)
+{
+	bool ret = true;
+	for (uint i = 0; i < _count; ++i) {
+		ret &= ReflectSerialize(_serializer_, _values_[i], nullptr);
+	}
+	return ret;
+}
+template <typename tSerializer, typename tType>
+bool ReflectElements(tSerializer& _serializer_, tType* _values_, uint _count, std::true_type)
+{
+	return ReflectBackend<tSerializer>::Elements(_serializer_, _values_, _count);
+}
+
+template <typename tSerializer, typename tType, uint kCount>
+bool ReflectSerializeArray(tSerializer& _serializer_, tType (&_value_)[kCount], const ReflectName* _name, std::true_type)
+{
+	return ReflectBackend<tSerializer>::Values(_serializer_, _value_, (uint)kCount, _name);
+}
+template <typename tSerializer, typename tType, uint kCount>
+bool ReflectSerializeArray(tSerializer& _serializer_, tType (&_value_)[kCount], const ReflectName* _name, std::false_type)
+{
+	uint length = (uint)kCount;
+	if (!ReflectBackend<tSerializer>::BeginArray(_serializer_, length, _name)) {
+		return false;
+	}
+	bool ret = true;
+	if (_serializer_.getMode() == Serializer::Mode_Read && length != (uint)kCount) {
+		_serializer_.setError("Error serializing array '%s': array length was %d, expected %d", _name ? _name->m_str : "", (int)length, (int)kCount);
+		ret = false;
+	} else {
+		ret = ReflectElements(_serializer_, _value_, (uint)kCount, std::false_type());
+	}
+	ReflectBackend<tSerializer>::EndArray(_serializer_);
+	return ret;
+}
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_Array>)
+{
+	return ReflectSerializeArray(_serializer_, _value_, _name, ReflectIsScalar<typename std::remove_extent<tType>::type>());
+}
+
+template <typename tSerializer, typename tType>
+bool ReflectSerializeVector(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::false_type)
+{
+	uint length = (uint)_value_.size();
+	if (!ReflectBackend<tSerializer>::BeginArray(_serializer_, length, _name)) {
+		return false;
+	}
+	if (_serializer_.getMode() == Serializer::Mode_Read) {
+		_value_.resize(length);
+	}
+	bool ret = ReflectElements(_serializer_, _value_.data(), length, ReflectIsScalar<typename tType::value_type>());
+	ReflectBackend<tSerializer>::EndArray(_serializer_);
+	return ret;
+}
+template <typename tSerializer, typename tType>
+bool ReflectSerializeVector(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::true_type)
+{
+	if (_serializer_.getMode() == Serializer::Mode_Write) {
+		return ReflectBackend<tSerializer>::Values(_serializer_, _value_.data(), (uint)_value_.size(), _name);
+	}
+	return ReflectSerializeVector(_serializer_, _value_, _name, std::false_type()); // length is unknown, read the elements
+}
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_Vector>)
+{
+	return ReflectSerializeVector(_serializer_, _value_, _name, ReflectIsScalar<typename tType::value_type>());
+}
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_Value>)
+{
+ // call value() directly, the Serialize() overloads log the error which the top level Serialize() then logs again
+	return ((Serializer&)_serializer_).value(_value_, _name ? _name->m_str : nullptr);
+}
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name, std::integral_constant<int, ReflectKind_Other>)
+{
+	return Serialize((Serializer&)_serializer_, _value_, _name ? _name->m_str : nullptr);
+}
+
+template <typename tSerializer, typename tType>
+bool ReflectSerialize(tSerializer& _serializer_, tType& _value_, const ReflectName* _name)
+{
+	return ReflectSerialize(_serializer_, _value_, _name, std::integral_constant<int, ReflectKindOf<tType>::value>());
+}
+
+// Runtime ReflectName for names passed to Serialize().
+inline ReflectName ReflectRuntimeName(const char* _name)
+{
+	ReflectName ret = { _name, _name ? (uint)strlen(_name) : 0u, _name ? HashString<uint64>(_name) : 0u };
+	return ret;
+}
+
+} // namespace internal
+
+// Serialize a reflected type as an object. tSerializer is the static type of the serializer, prefer passing the derived type.
+template <typename tSerializer, typename tType>
+typename std::enable_if<Reflect<tType>::kIsReflected && std::is_base_of<Serializer, tSerializer>::value, bool>::type
+	Serialize(tSerializer& _serializer_, tType& _value_, const char* _name = nullptr)
+{
+	ReflectName name = internal::ReflectRuntimeName(_name);
+	if (!internal::ReflectSerialize(_serializer_, _value_, _name ? &name : nullptr)) {
+		if (_serializer_.getError()) {
+			APT_LOG_ERR(_serializer_.getError());
+		}
+		return false;
+	}
+	return true;
+}
+
+// Serialize an array of reflected types.
+template <typename tSerializer, typename tType, typename tAllocator>
+typename std::enable_if<Reflect<tType>::kIsReflected && std::is_base_of<Serializer, tSerializer>::value, bool>::type
+	Serialize(tSerializer& _serializer_, eastl::vector<tType, tAllocator>& _value_, const char* _name = nullptr)
+{
+	ReflectName name = internal::ReflectRuntimeName(_name);
+	if (!internal::ReflectSerialize(_serializer_, _value_, _name ? &name : nullptr)) {
+		if (_serializer_.getError()) {
+			APT_LOG_ERR(_serializer_.getError());
+		}
+		return false;
+	}
+	return true;
+}
+
+} // namespace apt
@@ -47,6 +47,37 @@ bool Serializer::value(mat2& _value_, const char* _name) { return ValueVecMatImp
 bool Serializer::value(mat3& _value_, const char* _name) { return ValueVecMatImpl<mat3, 3*3>(*this, _value_, _name); }
 bool Serializer::value(mat4& _value_, const char* _name) { return ValueVecMatImpl<mat4, 4*4>(*this, _value_, _name); }
 
+template <typename tType>
+static bool ValueArrayImpl(Serializer& _serializer_, tType* _values_, uint _count, const char* _name)
+{
+	uint len = _count;
+	if (_serializer_.beginArray(len, _name)) {
+		bool ret = true;
+		if (len != _count) {
+			_serializer_.setError("Error serializing %s array '%s': array length was %d, expected %d", Serializer::ValueTypeToStr<tType>(), _name ? _name : "", (int)len, (int)_count);
+			ret = false;
+		} else {
+			for (uint i = 0; i < _count; ++i) {
+				ret &= _serializer_.value(_values_[i]);
+			}
+		}
+		_serializer_.endArray();
+		return ret;
+	}
+	return false;
+}
+bool Serializer::value(bool*    _values_, uint _count, const char* _name) { return ValueArrayImpl<bool>   (*this, _values_, _count, _name); }
+bool Serializer::value(sint8*   _values_, uint _count, const char* _name) { return ValueArrayImpl<sint8>  (*this, _values_, _count, _name); }
+bool Serializer::value(uint8*   _values_, uint _count, const char* _name) { return ValueArrayImpl<uint8>  (*this, _values_, _count, _name); }
+bool Serializer::value(sint16*  _values_, uint _count, const char* _name) { return ValueArrayImpl<sint16> (*this, _values_, _count, _name); }
+bool Serializer::value(uint16*  _values_, uint _count, const char* _name) { return ValueArrayImpl<uint16> (*this, _values_, _count, _name); }
+bool Serializer::value(sint32*  _values_, uint _count, const char* _name) { return ValueArrayImpl<sint32> (*this, _values_, _count, _name); }
+bool Serializer::value(uint32*  _values_, uint _count, const char* _name) { return ValueArrayImpl<uint32> (*this, _values_, _count, _name); }
+bool Serializer::value(sint64*  _values_, uint _count, const char* _name) { return ValueArrayImpl<sint64> (*this, _values_, _count, _name); }
+bool Serializer::value(uint64*  _values_, uint _count, const char* _name) { return ValueArrayImpl<uint64> (*this, _values_, _count, _name); }
+bool Serializer::value(float32* _values_, uint _count, const char* _name) { return ValueArrayImpl<float32>(*this, _values_, _count, _name); }
+bool Serializer::value(float64* _values_, uint _count, const char* _name) { return ValueArrayImpl<float64>(*this, _values_, _count, _name); }
+
 // PROTECTED
 
 template <typename tType>
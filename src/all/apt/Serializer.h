@@ -61,6 +61,20 @@ public:
 	bool         value(mat3& _value_, const char* _name = nullptr);
 	bool         value(mat4& _value_, const char* _name = nullptr);
 
+	// Arrays of _count values. When reading, the array length must equal _count. The default implementation serializes each
+	// element via value(), derived classes may override for efficiency.
+	virtual bool value(bool*       _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(sint8*      _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(uint8*      _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(sint16*     _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(uint16*     _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(sint32*     _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(uint32*     _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(sint64*     _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(uint64*     _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(float32*    _values_, uint _count, const char* _name = nullptr);
+	virtual bool value(float64*    _values_, uint _count, const char* _name = nullptr);
+
 	// Helper to avoid explicit cast to StringBase&.
 	template <uint kCapacity>
 	bool         value(String<kCapacity>& _value_, const char* _name = nullptr)
@@ -0,0 +1,602 @@
+#include <apt/SerializerBinary.h>
+
+#include <apt/hash.h>
+#include <apt/memory.h>
+#include <apt/File.h>
+
+#include <cstring>
+
+using namespace apt;
+
+// Values are written in native byte order, the supported architectures are all little endian (see config.h).
+static const char kMagic[4]   = { 'A', 'P', 'T', 'B' };
+static const uint kHeaderSize = 4 + 2 + 2 + 4; // magic, format version, flags, user version
+
+template <> uint32 SerializerBinary::TypeOf<bool>()    { return Type_Bool;    }
+template <> uint32 SerializerBinary::TypeOf<sint8>()   { return Type_Sint8;   }
+template <> uint32 SerializerBinary::TypeOf<uint8>()   { return Type_Uint8;   }
+template <> uint32 SerializerBinary::TypeOf<sint16>()  { return Type_Sint16;  }
+template <> uint32 SerializerBinary::TypeOf<uint16>()  { return Type_Uint16;  }
+template <> uint32 SerializerBinary::TypeOf<sint32>()  { return Type_Sint32;  }
+template <> uint32 SerializerBinary::TypeOf<uint32>()  { return Type_Uint32;  }
+template <> uint32 SerializerBinary::TypeOf<sint64>()  { return Type_Sint64;  }
+template <> uint32 SerializerBinary::TypeOf<uint64>()  { return Type_Uint64;  }
+template <> uint32 SerializerBinary::TypeOf<float32>() { return Type_Float32; }
+template <> uint32 SerializerBinary::TypeOf<float64>() { return Type_Float64; }
+
+// PUBLIC
+
+SerializerBinary::SerializerBinary(uint32 _version, uint32 _flags)
+	: Serializer(Mode_Write)
+	, m_data(nullptr)
+	, m_dataSize(0)
+	, m_version(_version)
+	, m_flags(_flags)
+{
+	writeBytes(kMagic, sizeof(kMagic));
+	writeRaw<uint16>((uint16)kFormatVersion);
+	writeRaw<uint16>((uint16)m_flags);
+	writeRaw<uint32>(m_version);
+
+	Level root = {};
+	root.m_type = Type_Object;
+	m_stack.push_back(root);
+}
+
+SerializerBinary::SerializerBinary(const void* _data, uint _sizeBytes)
+	: Serializer(Mode_Read)
+{
+	initRead(_data, _sizeBytes);
+}
+
+SerializerBinary::SerializerBinary(const File& _file)
+	: Serializer(Mode_Read)
+{
+	initRead(_file.getData(), (uint)_file.getDataSize());
+}
+
+SerializerBinary::~SerializerBinary()
+{
+}
+
+void SerializerBinary::write(File& file_) const
+{
+	APT_ASSERT(getMode() == Mode_Write);
+	APT_ASSERT(m_stack.size() == 1); // missing endObject()/endArray()
+	file_.setData(m_buffer.data(), m_buffer.size());
+}
+
+bool SerializerBinary::beginObject(const char* _name)
+{
+	if (getMode() == Mode_Write) {
+		if (!writeTag(Type_Object, _name, "object")) {
+			return false;
+		}
+		Level level = {};
+		level.m_type   = Type_Object;
+		level.m_offset = (uint)m_buffer.size();
+		alloc(sizeof(uint32));
+		m_stack.push_back(level);
+		return true;
+	}
+
+	uint32 type;
+	uint offset = seek(_name, type, "object");
+	if (!offset) {
+		return false;
+	}
+	if (type != Type_Object) {
+		setError("Error serializing object; '%s' not an object", _name ? _name : "");
+		return false;
+	}
+	const uint64 end = (uint64)offset + sizeof(uint32) + readRaw<uint32>(offset);
+	if (end > m_stack.back().m_end) {
+		setError("Error serializing object; '%s' invalid data", _name ? _name : "");
+		return false;
+	}
+	Level level = {};
+	level.m_type   = Type_Object;
+	level.m_offset = offset + sizeof(uint32);
+	level.m_end    = (uint)end;
+	level.m_pos    = level.m_offset;
+	m_stack.push_back(level);
+	return true;
+}
+
+void SerializerBinary::endObject()
+{
+	APT_ASSERT(m_stack.size() > 1 && m_stack.back().m_type == Type_Object);
+	if (getMode() == Mode_Write) {
+		const uint32 sizeBytes = (uint32)(m_buffer.size() - m_stack.back().m_offset - sizeof(uint32));
+		memcpy(m_buffer.data() + m_stack.back().m_offset, &sizeBytes, sizeof(uint32));
+	}
+	m_stack.pop_back();
+}
+
+bool SerializerBinary::beginArray(uint& _length_, const char* _name)
+{
+	if (getMode() == Mode_Write) {
+		if (!writeTag(Type_Array, _name, "array")) {
+			return false;
+		}
+		Level level = {};
+		level.m_type   = Type_Array;
+		level.m_offset = (uint)m_buffer.size();
+		alloc(sizeof(uint32) * 2);
+		m_stack.push_back(level);
+		return true;
+	}
+
+	uint32 type;
+	uint offset = seek(_name, type, "array");
+	if (!offset) {
+		return false;
+	}
+	Level level = {};
+	uint64 end;
+	if (type == Type_Array) {
+		level.m_type       = Type_Array;
+		level.m_count      = readRaw<uint32>(offset + sizeof(uint32));
+		level.m_offset     = offset + sizeof(uint32) * 2;
+		end                = (uint64)level.m_offset + readRaw<uint32>(offset);
+	} else if (type == Type_PackedArray) {
+		level.m_type       = Type_PackedArray;
+		level.m_packedType = (uint8)m_data[offset];
+		level.m_count      = readRaw<uint32>(offset + 1);
+		level.m_offset     = offset + 1 + sizeof(uint32);
+		end                = (uint64)level.m_offset + (uint64)level.m_count * TypeSizeBytes(level.m_packedType);
+	} else {
+		setError("Error serializing array; '%s' not an array", _name ? _name : "");
+		return false;
+	}
+	if (end > m_stack.back().m_end) {
+		setError("Error serializing array; '%s' invalid data", _name ? _name : "");
+		return false;
+	}
+	level.m_end = (uint)end;
+	level.m_pos = level.m_offset;
+	m_stack.push_back(level);
+	_length_ = level.m_count;
+	return true;
+}
+
+void SerializerBinary::endArray()
+{
+	APT_ASSERT(m_stack.size() > 1 && m_stack.back().m_type != Type_Object);
+	if (getMode() == Mode_Write) {
+		const Level& level = m_stack.back();
+		const uint32 header[2] = { (uint32)(m_buffer.size() - level.m_offset - sizeof(header)), level.m_count };
+		memcpy(m_buffer.data() + level.m_offset, header, sizeof(header));
+	}
+	m_stack.pop_back();
+}
+
+bool SerializerBinary::value(bool&    _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(sint8&   _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(uint8&   _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(sint16&  _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(uint16&  _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(sint32&  _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(uint32&  _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(sint64&  _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(uint64&  _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(float32& _value_, const char* _name) { return valueNumber(_value_, _name); }
+bool SerializerBinary::value(float64& _value_, const char* _name) { return valueNumber(_value_, _name); }
+
+bool SerializerBinary::value(StringBase& _value_, const char* _name)
+{
+	if (getMode() == Mode_Write) {
+		if (!writeTag(Type_String, _name, "StringBase")) {
+			return false;
+		}
+		const uint32 length = (uint32)_value_.getLength();
+		writeRaw<uint32>(length);
+		writeBytes((const char*)_value_, length);
+		return true;
+	}
+
+	uint32 type;
+	uint offset = seek(_name, type, "StringBase");
+	if (!offset) {
+		return false;
+	}
+	if (type != Type_String) {
+		setError("Error serializing StringBase; '%s' not a string", _name ? _name : "");
+		return false;
+	}
+	const uint32 length = readRaw<uint32>(offset);
+	if (length == 0) {
+		_value_.clear();
+	} else {
+		_value_.set(m_data + offset + sizeof(uint32), length);
+	}
+	return true;
+}
+
+bool SerializerBinary::value(bool*    _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(sint8*   _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(uint8*   _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(sint16*  _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(uint16*  _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(sint32*  _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(uint32*  _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(sint64*  _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(uint64*  _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(float32* _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+bool SerializerBinary::value(float64* _values_, uint _count, const char* _name) { return valueArray(_values_, _count, _name); }
+
+bool SerializerBinary::binary(void*& _data_, uint& _sizeBytes_, const char* _name, CompressionFlags _compressionFlags)
+{
+	if (getMode() == Mode_Write) {
+		APT_ASSERT(_data_ || _sizeBytes_ == 0);
+		if (!writeTag(Type_Binary, _name, "binary")) {
+			return false;
+		}
+		const char* data = (const char*)_data_;
+		uint sizeBytes = _sizeBytes_;
+		const bool compressed = _compressionFlags != CompressionFlags_None && _sizeBytes_ > 0;
+		if (compressed) {
+			void* compressedData = nullptr;
+			Compress(_data_, _sizeBytes_, compressedData, sizeBytes, _compressionFlags);
+			data = (const char*)compressedData;
+		}
+		*alloc(1) = compressed ? 1 : 0;
+		writeRaw<uint32>((uint32)sizeBytes);
+		alloc((uint)(BinaryDataOffset(m_buffer.size() - 1 - sizeof(uint32)) - m_buffer.size())); // padding
+		writeBytes(data, sizeBytes);
+		if (compressed) {
+			free((void*)data);
+		}
+		return true;
+	}
+
+	uint32 type;
+	uint offset = seek(_name, type, "binary");
+	if (!offset) {
+		return false;
+	}
+	if (type != Type_Binary) {
+		setError("Error serializing binary; '%s' not binary", _name ? _name : "");
+		return false;
+	}
+	const bool compressed = m_data[offset] != 0;
+	const uint sizeBytes = readRaw<uint32>(offset + 1);
+	const char* data = m_data + (uint)BinaryDataOffset(offset);
+	if (compressed) {
+		if (_data_) {
+			if (!DecompressToBuffer(data, sizeBytes, _data_, _sizeBytes_)) {
+				setError("Error serializing binary '%s'; decompressed size didn't match buffer size %llu", _name ? _name : "", (unsigned long long)_sizeBytes_);
+				return false;
+			}
+		} else {
+			Decompress(data, sizeBytes, _data_, _sizeBytes_);
+		}
+		return true;
+	}
+	if (_data_) {
+		if (sizeBytes != _sizeBytes_) {
+			setError("Error serializing binary '%s'; buffer size was %llu (expected %llu)", _name ? _name : "", (unsigned long long)_sizeBytes_, (unsigned long long)sizeBytes);
+			return false;
+		}
+	} else {
+		_data_ = APT_MALLOC(sizeBytes);
+		_sizeBytes_ = sizeBytes;
+	}
+	memcpy(_data_, data, sizeBytes);
+	return true;
+}
+
+bool SerializerBinary::binary(const void*& data_, uint& sizeBytes_, const char* _name)
+{
+	APT_ASSERT(getMode() == Mode_Read);
+	uint32 type;
+	uint offset = seek(_name, type, "binary");
+	if (!offset) {
+		return false;
+	}
+	if (type != Type_Binary) {
+		setError("Error serializing binary; '%s' not binary", _name ? _name : "");
+		return false;
+	}
+	if (m_data[offset] != 0) {
+		setError("Error serializing binary; '%s' is compressed, can't access in place", _name ? _name : "");
+		return false;
+	}
+	data_ = m_data + (uint)BinaryDataOffset(offset);
+	sizeBytes_ = readRaw<uint32>(offset + 1);
+	return true;
+}
+
+// PRIVATE
+
+uint SerializerBinary::TypeSizeBytes(uint32 _type)
+{
+	static const uint kSizes[] =
+	{
+		1, // Type_Bool
+		1, // Type_Sint8
+		1, // Type_Uint8
+		2, // Type_Sint16
+		2, // Type_Uint16
+		4, // Type_Sint32
+		4, // Type_Uint32
+		8, // Type_Sint64
+		8, // Type_Uint64
+		4, // Type_Float32
+		8, // Type_Float64
+	};
+	return _type < APT_ARRAY_COUNT(kSizes) ? kSizes[_type] : 0;
+}
+
+uint64 SerializerBinary::BinaryDataOffset(uint64 _offset)
+{
+	const uint64 ret = _offset + 1 + sizeof(uint32);
+	return (ret + kBinaryAlignment - 1) / kBinaryAlignment * kBinaryAlignment;
+}
+
+void SerializerBinary::initRead(const void* _data, uint _sizeBytes)
+{
+	m_data     = (const char*)_data;
+	m_dataSize = _sizeBytes;
+	m_version  = 0;
+	m_flags    = 0;
+	if (!m_data || m_dataSize < kHeaderSize || memcmp(m_data, kMagic, sizeof(kMagic)) != 0) {
+		setError("Error serializing binary data; invalid header");
+		return;
+	}
+	const uint16 formatVersion = readRaw<uint16>(4);
+	if (formatVersion != kFormatVersion) {
+		setError("Error serializing binary data; unsupported format version %u (expected %u)", (unsigned)formatVersion, (unsigned)kFormatVersion);
+		return;
+	}
+	m_flags   = readRaw<uint16>(6);
+	m_version = readRaw<uint32>(8);
+
+	Level root = {};
+	root.m_type   = Type_Object;
+	root.m_offset = kHeaderSize;
+	root.m_end    = m_dataSize;
+	root.m_pos    = kHeaderSize;
+	m_stack.push_back(root);
+}
+
+char* SerializerBinary::alloc(uint _sizeBytes)
+{
+	const uint offset = (uint)m_buffer.size();
+	m_buffer.resize(offset + _sizeBytes);
+	return m_buffer.data() + offset;
+}
+
+bool SerializerBinary::writeTag(uint32 _type, const char* _name, const char* _typeStr)
+{
+	Level& level = m_stack.back();
+	if (level.m_type == Type_Object) {
+		if (m_flags & Flags_NameHashes) {
+			if (!_name) {
+				setError("Error serializing %s; name must be specified if not in an array", _typeStr);
+				return false;
+			}
+			*alloc(1) = (char)_type;
+			writeRaw<uint32>(HashString<uint32>(_name));
+			return true;
+		}
+	} else {
+		++level.m_count;
+	}
+	*alloc(1) = (char)_type;
+	return true;
+}
+
+void SerializerBinary::writeBytes(const void* _data, uint _sizeBytes)
+{
+	m_buffer.insert(m_buffer.end(), (const char*)_data, (const char*)_data + _sizeBytes);
+}
+
+template <typename tType>
+void SerializerBinary::writeRaw(tType _value)
+{
+	writeBytes(&_value, sizeof(tType));
+}
+
+uint SerializerBinary::seek(const char* _name, uint32& type_, const char* _typeStr)
+{
+	if (m_stack.empty()) {
+		return 0; // invalid header
+	}
+	Level& level = m_stack.back();
+
+	if (level.m_type == Type_PackedArray) {
+		if (level.m_pos >= level.m_end) {
+			return 0;
+		}
+		type_ = level.m_packedType;
+		uint ret = level.m_pos;
+		level.m_pos += TypeSizeBytes(type_);
+		return ret;
+	}
+
+	const bool hasNames = level.m_type == Type_Object && (m_flags & Flags_NameHashes);
+	const uint tagSize = hasNames ? 1 + sizeof(uint32) : 1;
+	if (!hasNames) {
+	 // sequential access
+		if (level.m_pos >= level.m_end) {
+			if (level.m_type == Type_Object) {
+				setError("Error serializing %s; '%s' not found", _typeStr, _name ? _name : "");
+			}
+			return 0;
+		}
+		const uint offset = level.m_pos + tagSize;
+		const uint32 type = (uint8)m_data[level.m_pos];
+		const uint sizeBytes = offset <= level.m_end ? getValueSizeBytes(type, offset) : 0;
+		if (sizeBytes == 0 || offset + sizeBytes > level.m_end) {
+			setError("Error serializing %s; '%s' invalid data", _typeStr, _name ? _name : "");
+			return 0;
+		}
+		type_ = type;
+		level.m_pos = offset + sizeBytes;
+		return offset;
+	}
+
+	if (!_name) {
+		setError("Error serializing %s; name must be specified if not in an array", _typeStr);
+		return 0;
+	}
+
+ // search forward from the previous value, then from the start of the object
+	const uint32 nameHash = HashString<uint32>(_name);
+	uint pos = level.m_pos;
+	for (int pass = 0; pass < 2; ++pass) {
+		const uint end = pass == 0 ? level.m_end : level.m_pos;
+		if (pass == 1) {
+			pos = level.m_offset;
+		}
+		while (pos < end) {
+			const uint offset = pos + tagSize;
+			const uint32 type = (uint8)m_data[pos];
+			const uint sizeBytes = offset <= level.m_end ? getValueSizeBytes(type, offset) : 0;
+			if (sizeBytes == 0 || offset + sizeBytes > level.m_end) {
+				setError("Error serializing %s; '%s' invalid data", _typeStr, _name);
+				return 0;
+			}
+			if (readRaw<uint32>(pos + 1) == nameHash) {
+				type_ = type;
+				level.m_pos = offset + sizeBytes;
+				return offset;
+			}
+			pos = offset + sizeBytes;
+		}
+	}
+	setError("Error serializing %s; '%s' not found", _typeStr, _name);
+	return 0;
+}
+
+uint SerializerBinary::getValueSizeBytes(uint32 _type, uint _offset) const
+{
+	if (_offset > m_dataSize) {
+		return 0;
+	}
+	const uint64 available = m_dataSize - _offset;
+
+ // sizes are computed in 64 bits and checked against the available data before narrowing, a corrupt size prefix can't overflow
+	uint64 ret = TypeSizeBytes(_type);
+	if (ret == 0) {
+	 // check the size prefix is in range
+		uint prefixSize;
+		switch (_type) {
+			case Type_String:
+			case Type_Object:      prefixSize = sizeof(uint32);     break;
+			case Type_Array:       prefixSize = sizeof(uint32) * 2; break;
+			case Type_Binary:
+			case Type_PackedArray: prefixSize = 1 + sizeof(uint32); break;
+			default:               return 0;
+		}
+		if (prefixSize > available) {
+			return 0;
+		}
+		switch (_type) {
+			case Type_String:
+			case Type_Object:
+				ret = sizeof(uint32) + (uint64)readRaw<uint32>(_offset);
+				break;
+			case Type_Array:
+				ret = sizeof(uint32) * 2 + (uint64)readRaw<uint32>(_offset);
+				break;
+			case Type_Binary:
+				ret = BinaryDataOffset(_offset) - _offset + readRaw<uint32>(_offset + 1);
+				break;
+			case Type_PackedArray: {
+				const uint elementSize = TypeSizeBytes((uint8)m_data[_offset]);
+				if (elementSize == 0) {
+					return 0;
+				}
+				ret = prefixSize + (uint64)readRaw<uint32>(_offset + 1) * elementSize;
+				break;
+			}
+		}
+	}
+	return ret <= available ? (uint)ret : 0;
+}
+
+template <typename tType>
+tType SerializerBinary::readRaw(uint _offset) const
+{
+	tType ret;
+	memcpy(&ret, m_data + _offset, sizeof(tType));
+	return ret;
+}
+
+template <typename tType>
+bool SerializerBinary::readNumber(tType& _value_, const char* _name, const char* _typeStr)
+{
+	uint32 type;
+	uint offset = seek(_name, type, _typeStr);
+	if (!offset) {
+		return false;
+	}
+	switch (type) {
+		case Type_Bool:    _value_ = (tType)(m_data[offset] != 0);          break;
+		case Type_Sint8:   _value_ = (tType)readRaw<sint8>(offset);         break;
+		case Type_Uint8:   _value_ = (tType)readRaw<uint8>(offset);         break;
+		case Type_Sint16:  _value_ = (tType)readRaw<sint16>(offset);        break;
+		case Type_Uint16:  _value_ = (tType)readRaw<uint16>(offset);        break;
+		case Type_Sint32:  _value_ = (tType)readRaw<sint32>(offset);        break;
+		case Type_Uint32:  _value_ = (tType)readRaw<uint32>(offset);        break;
+		case Type_Sint64:  _value_ = (tType)readRaw<sint64>(offset);        break;
+		case Type_Uint64:  _value_ = (tType)readRaw<uint64>(offset);        break;
+		case Type_Float32: _value_ = (tType)readRaw<float32>(offset);       break;
+		case Type_Float64: _value_ = (tType)readRaw<float64>(offset);       break;
+		default:
+			setError("Error serializing %s; '%s' not a number", _typeStr, _name ? _name : "");
+			return false;
+	}
+	return true;
+}
+
+template <typename tType>
+bool SerializerBinary::valueNumber(tType& _value_, const char* _name)
+{
+	if (getMode() == Mode_Read) {
+		return readNumber(_value_, _name, ValueTypeToStr<tType>());
+	}
+	if (!writeTag(TypeOf<tType>(), _name, ValueTypeToStr<tType>())) {
+		return false;
+	}
+	writeRaw<tType>(_value_);
+	return true;
+}
+
+template <typename tType>
+bool SerializerBinary::valueArray(tType* _values_, uint _count, const char* _name)
+{
+	if (getMode() == Mode_Write) {
+		if (!writeTag(Type_PackedArray, _name, ValueTypeToStr<tType>())) {
+			return false;
+		}
+		*alloc(1) = (char)TypeOf<tType>();
+		writeRaw<uint32>((uint32)_count);
+		writeBytes(_values_, _count * sizeof(tType));
+		return true;
+	}
+
+	if (m_stack.empty()) {
+		return false;
+	}
+	const uint pos = m_stack.back().m_pos;
+	uint32 type;
+	uint offset = seek(_name, type, ValueTypeToStr<tType>());
+	if (!offset) {
+		return false;
+	}
+	if (type != Type_PackedArray || (uint8)m_data[offset] != TypeOf<tType>()) {
+	 // the array was written element-wise or with a different type, fall back to the element-wise conversion
+		m_stack.back().m_pos = pos;
+		return Serializer::value(_values_, _count, _name);
+	}
+	const uint length = readRaw<uint32>(offset + 1);
+	if (length != _count) {
+		setError("Error serializing %s array '%s': array length was %d, expected %d", ValueTypeToStr<tType>(), _name ? _name : "", (int)length, (int)_count);
+		return false;
+	}
+	memcpy(_values_, m_data + offset + 1 + sizeof(uint32), _count * sizeof(tType));
+	return true;
+}
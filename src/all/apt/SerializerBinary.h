@@ -0,0 +1,178 @@
+#pragma once
+
+#include <apt/apt.h>
+#include <apt/Serializer.h>
+
+#include <EASTL/vector.h>
+
+namespace apt {
+
+////////////////////////////////////////////////////////////////////////////////
+// SerializerBinary
+// Compact binary serializer, intended for runtime state which doesn't need to
+// be human readable (prefer SerializerJson for data which is edited by hand).
+//
+// The data begins with a header (magic, format version, flags and a user
+// version) followed by a sequence of values. Each value is a 1 byte type tag,
+// an optional 32 bit name hash and the value data in little endian byte order.
+// Strings, binary data, objects and arrays are prefixed by their size, hence
+// unknown values can be skipped in O(1).
+//
+// If Flags_NameHashes is set, values in objects are found by name (searching
+// forward from the previous value, hence reading in the same order as values
+// were written is most efficient) which permits values to be added or removed
+// between versions. Otherwise values are read in the order they were written
+// and names are ignored, which is more compact but brittle.
+//
+// Binary data is stored uncompressed (unless requested) and aligned to
+// kBinaryAlignment bytes relative to the start of the data, such that it can
+// be accessed in place (see binary(const void*&, ...)).
+////////////////////////////////////////////////////////////////////////////////
+class SerializerBinary final: public Serializer
+{
+public:
+	enum Flags
+	{
+		Flags_None       = 0,
+		Flags_NameHashes = 1 << 0,  // Store hashed names for values in objects.
+
+		Flags_Default    = Flags_NameHashes
+	};
+
+	static const uint32 kFormatVersion    = 1;
+	static const uint   kBinaryAlignment  = 16;
+
+	// Mode_Write, data is written to an internal buffer. _version is stored in the header (see getVersion()).
+	SerializerBinary(uint32 _version = 0, uint32 _flags = Flags_Default);
+	// Mode_Read, _data must remain valid for the lifetime of the serializer. If the header is invalid getError() returns non-null
+	// and all subsequent calls fail.
+	SerializerBinary(const void* _data, uint _sizeBytes);
+	SerializerBinary(const File& _file);
+	~SerializerBinary();
+
+	// User version (as passed to the constructor when the data was written).
+	uint32      getVersion() const   { return m_version; }
+	uint32      getFlags() const     { return m_flags; }
+
+	// Mode_Write only, access the data written so far. All objects/arrays must have been ended.
+	const char* getData() const      { return m_buffer.data(); }
+	uint        getDataSize() const  { return (uint)m_buffer.size(); }
+	// Mode_Write only, copy the data to file_.
+	void        write(File& file_) const;
+
+	bool beginObject(const char* _name = nullptr) override;
+	void endObject() override;
+
+	bool beginArray(uint& _length_, const char* _name = nullptr) override;
+	void endArray() override;
+	using Serializer::beginArray;
+
+	bool value(bool&       _value_, const char* _name = nullptr) override;
+	bool value(sint8&      _value_, const char* _name = nullptr) override;
+	bool value(uint8&      _value_, const char* _name = nullptr) override;
+	bool value(sint16&     _value_, const char* _name = nullptr) override;
+	bool value(uint16&     _value_, const char* _name = nullptr) override;
+	bool value(sint32&     _value_, const char* _name = nullptr) override;
+	bool value(uint32&     _value_, const char* _name = nullptr) override;
+	bool value(sint64&     _value_, const char* _name = nullptr) override;
+	bool value(uint64&     _value_, const char* _name = nullptr) override;
+	bool value(float32&    _value_, const char* _name = nullptr) override;
+	bool value(float64&    _value_, const char* _name = nullptr) override;
+	bool value(StringBase& _value_, const char* _name = nullptr) override;
+
+	// Arrays of values are stored packed (no per-element type tag) and copied directly.
+	bool value(bool*       _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint8*      _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint8*      _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint16*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint16*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint32*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint32*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(sint64*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(uint64*     _values_, uint _count, const char* _name = nullptr) override;
+	bool value(float32*    _values_, uint _count, const char* _name = nullptr) override;
+	bool value(float64*    _values_, uint _count, const char* _name = nullptr) override;
+
+	// vec*/mat* variants are implemented by the base class.
+	using Serializer::value;
+
+	bool binary(void*& _data_, uint& _sizeBytes_, const char* _name = nullptr, CompressionFlags _compressionFlags = CompressionFlags_None) override;
+
+	// Mode_Read only, access uncompressed binary data in place (no allocation or copy). data_ is valid for the lifetime of the
+	// data passed to the constructor.
+	bool binary(const void*& data_, uint& sizeBytes_, const char* _name = nullptr);
+
+private:
+	enum Type
+	{
+		Type_Bool,
+		Type_Sint8,
+		Type_Uint8,
+		Type_Sint16,
+		Type_Uint16,
+		Type_Sint32,
+		Type_Uint32,
+		Type_Sint64,
+		Type_Uint64,
+		Type_Float32,
+		Type_Float64,
+		Type_String,       // uint32 length, chars (no null terminator).
+		Type_Binary,       // uint8 compressed, uint32 size, padding to kBinaryAlignment, data.
+		Type_Object,       // uint32 size, values.
+		Type_Array,        // uint32 size, uint32 count, values (no name hashes).
+		Type_PackedArray,  // uint8 element type, uint32 count, elements (no type tags).
+
+		Type_Count
+	};
+
+	struct Level
+	{
+		uint32      m_type;        // Type_Object, Type_Array or Type_PackedArray.
+		uint32      m_count;       // Array element count.
+		uint        m_offset;      // Mode_Write: offset of the size field. Mode_Read: offset of the first value.
+		uint        m_end;         // Mode_Read: offset of the end of the object/array.
+		uint        m_pos;         // Mode_Read: offset of the next value.
+		uint32      m_packedType;  // Mode_Read: element type if m_type == Type_PackedArray.
+	};
+
+	eastl::vector<char>  m_buffer;    // Mode_Write.
+	const char*          m_data;      // Mode_Read.
+	uint                 m_dataSize;  // Mode_Read.
+	uint32               m_version;
+	uint32               m_flags;
+	eastl::vector<Level> m_stack;
+
+	// Size of a scalar type, 0 for other types.
+	static uint   TypeSizeBytes(uint32 _type);
+	template <typename tType>
+	static uint32 TypeOf();
+	// Offset of binary data, given the offset of the Type_Binary value data (64 bits, such that it can't overflow).
+	static uint64 BinaryDataOffset(uint64 _offset);
+
+	void         initRead(const void* _data, uint _sizeBytes);
+
+	// Mode_Write: append _sizeBytes to the buffer, return a ptr to the new data.
+	char*        alloc(uint _sizeBytes);
+	// Mode_Write: write the type tag and name hash, return false if _name is required but not specified.
+	bool         writeTag(uint32 _type, const char* _name, const char* _typeStr);
+	void         writeBytes(const void* _data, uint _sizeBytes);
+	template <typename tType>
+	void         writeRaw(tType _value);
+
+	// Mode_Read: move to the next array element or find _name in the current object. On success type_ is the value type and
+	// the return value is the offset of the value data, else return 0.
+	uint         seek(const char* _name, uint32& type_, const char* _typeStr);
+	// Mode_Read: return the size of the value data at _offset, or 0 if the data is invalid.
+	uint         getValueSizeBytes(uint32 _type, uint _offset) const;
+	template <typename tType>
+	tType        readRaw(uint _offset) const;
+	template <typename tType>
+	bool         readNumber(tType& _value_, const char* _name, const char* _typeStr);
+	template <typename tType>
+	bool         valueNumber(tType& _value_, const char* _name);
+	template <typename tType>
+	bool         valueArray(tType* _values_, uint _count, const char* _name);
+
+}; // class SerializerBinary
+
+} // namespace apt
@@ -45,23 +45,26 @@ uint StringBase::setf(const char* _fmt, ...)
 
 uint StringBase::setfv(const char* _fmt, va_list _args)
 {
+ // the first pass consumes a copy of _args, the second pass consumes _args
 	va_list args;
 	va_copy(args, _args);
 
 #ifdef APT_COMPILER_MSVC
  // vsnprintf returns -1 on overflow, requires 2 passes
 	int len = vsnprintf(0, 0, _fmt, args);
+	va_end(args);
 	APT_STRICT_ASSERT(len >= 0);
 	if (m_capacity < (uint)len + 1) {
 		alloc(len + 1);
 	}
-	APT_VERIFY(vsnprintf(m_buf, m_capacity, _fmt, args) >= 0);
+	APT_VERIFY(vsnprintf(m_buf, m_capacity, _fmt, _args) >= 0);
 #else
 	int len = vsnprintf(m_buf, m_capacity, _fmt, args);
+	va_end(args);
 	APT_STRICT_ASSERT(len >= 0);
 	if (m_capacity < len + 1) {
 		alloc(len + 1);
-		APT_VERIFY(vsnprintf(m_buf, m_capacity, _fmt, args) >= 0);
+		APT_VERIFY(vsnprintf(m_buf, m_capacity, _fmt, _args) >= 0);
 	}
 #endif
 	m_length = (uint)len;
@@ -99,16 +102,18 @@ uint StringBase::appendf(const char* _fmt, ...)
 
 uint StringBase::appendfv(const char* _fmt, va_list _args)
 {
+ // as setfv()
 	va_list args;
 	va_copy(args, _args);
 
 	uint len = getLength();
 	int srclen = vsnprintf(0, 0, _fmt, args);
+	va_end(args);
 	APT_ASSERT(srclen > 0);
 	if (m_capacity < len + srclen + 1) {
 		realloc(len + srclen + 1);
 	}
-	APT_VERIFY(vsnprintf(m_buf + len, m_capacity, _fmt, args) >= 0);
+	APT_VERIFY(vsnprintf(m_buf + len, m_capacity - len, _fmt, _args) >= 0);
 	m_length = (uint)srclen + len;
 	return m_length;
 }
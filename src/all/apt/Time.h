@@ -90,6 +90,9 @@ public:
 	sint32 getSecond() const;
 	sint32 getMillisecond() const;
 
+	// Return the interval between _since and this in seconds (negative if _since is later).
+	double getSecondsSince(DateTime _since) const;
+
 	// Return a formatted string. The default formatting is ISO 8601, however a format 
 	// string may be supplied using the following specifiers:
 	//   Specifier | Value
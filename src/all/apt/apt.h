@@ -109,18 +109,30 @@ namespace apt {
 
 // Forward declarations
 class ArgList;
+class DerivedDataCache;
 template <typename tType> class Factory;
 class File;
+class FileIndex;
 class FileSystem;
+class GlobSet;
 class Image;
 class Ini;
 class Json;
+class JsonArena;
+class JsonIndex;
+class JsonLinesReader;
+class JsonLinesWriter;
+class JsonPatchLog;
+class JsonSchema;
+class JsonReader;
+class JsonWriter;
 class MemoryPool;
 template <typename tType> class PersistentVector;
 template <typename tType> class Pool;
 template <typename PRNG>  class Rand;
 template <typename tType> class RingBuffer;
 class Serializer;
+	class SerializerBinary;
 	class SerializerJson;
 class StringBase;
 	template <uint kCapacity> class String;
@@ -0,0 +1,238 @@
+#include <apt/base64.h>
+
+#include <apt/math.h>
+
+#include <cstring>
+
+#include <tmmintrin.h> // SSSE3
+#if APT_COMPILER_MSVC
+	#include <intrin.h>
+	#define APT_TARGET_SSSE3
+#else
+	#include <cpuid.h>
+	#define APT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+using namespace apt;
+
+// The scalar implementation is adapted from https://github.com/adamvr/arduino-base64, the SSSE3 kernels from Wojciech Mula's base64simd (http://0x80.pl/articles/index.html#base64-algorithm-new).
+static const char kBase64Alphabet[] = 
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		"abcdefghijklmnopqrstuvwxyz"
+		"0123456789+/"
+		;
+static inline void Base64A3ToA4(const unsigned char* _a3, unsigned char* a4_) 
+{
+	a4_[0] = (_a3[0] & 0xfc) >> 2;
+	a4_[1] = ((_a3[0] & 0x03) << 4) + ((_a3[1] & 0xf0) >> 4);
+	a4_[2] = ((_a3[1] & 0x0f) << 2) + ((_a3[2] & 0xc0) >> 6);
+	a4_[3] = (_a3[2] & 0x3f);
+}
+static inline void Base64A4ToA3(const unsigned char* _a4, unsigned char* a3_) {
+	a3_[0] = (_a4[0] << 2) + ((_a4[1] & 0x30) >> 4);
+	a3_[1] = ((_a4[1] & 0xf) << 4) + ((_a4[2] & 0x3c) >> 2);
+	a3_[2] = ((_a4[2] & 0x3) << 6) + _a4[3];
+}
+static inline unsigned char Base64Index(char _c)
+{
+	if (_c >= 'A' && _c <= 'Z') return _c - 'A';
+	if (_c >= 'a' && _c <= 'z') return _c - 71;
+	if (_c >= '0' && _c <= '9') return _c + 4;
+	if (_c == '+') return 62;
+	if (_c == '/') return 63;
+	return 0xff;
+}
+
+static bool Base64HasSsse3()
+{
+	int info[4] = {};
+	#if APT_COMPILER_MSVC
+		__cpuid(info, 1);
+	#else
+		__cpuid(1, info[0], info[1], info[2], info[3]);
+	#endif
+	return (info[2] & (1 << 9)) != 0; // ECX bit 9
+}
+static const bool kBase64Ssse3 = Base64HasSsse3();
+
+// Encode 12 bytes per iteration while at least 16 bytes can be read from _in. Return the number of bytes consumed.
+APT_TARGET_SSSE3 static uint Base64EncodeSsse3(const char* _in, uint _inSizeBytes, char* out_)
+{
+	uint ret = 0;
+	while (_inSizeBytes - ret >= 16) {
+		__m128i in = _mm_loadu_si128((const __m128i*)(_in + ret));
+
+	 // split 3 bytes into 4 x 6 bit indices
+		in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+		const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+		const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+		const __m128i indices = _mm_or_si128(t0, t1);
+
+	 // map indices to ASCII: compute a range id per index, then add the offset for that range
+		__m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+		range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+		const __m128i offsets = _mm_setr_epi8(
+			'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+			'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A',      0,        0
+			);
+		_mm_storeu_si128((__m128i*)out_, _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range)));
+
+		ret += 12;
+		out_ += 16;
+	}
+	return ret;
+}
+
+// Decode 16 characters per iteration while at least 16 characters remain. Stop at the first block which contains a character
+// outside the alphabet (including padding), the remainder is handled by the scalar path. Return the number of characters consumed.
+APT_TARGET_SSSE3 static uint Base64DecodeSsse3(const char* _in, uint _inSizeBytes, char* out_)
+{
+	uint ret = 0;
+	while (_inSizeBytes - ret >= 16) {
+		const __m128i in = _mm_loadu_si128((const __m128i*)(_in + ret));
+
+	 // validate and map ASCII to 6 bit values via lookups on the high/low nibbles
+		const __m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+		const __m128i lo = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+		const __m128i validLo = _mm_shuffle_epi8(_mm_setr_epi8(
+			(char)0xa8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8, (char)0xf8,
+			(char)0xf8, (char)0xf8, (char)0xf0, (char)0x54, (char)0x50, (char)0x50, (char)0x50, (char)0x54
+			), lo);
+		const __m128i validHi = _mm_shuffle_epi8(_mm_setr_epi8(
+			0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+			), hi);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(validLo, validHi), _mm_setzero_si128())) != 0) {
+			break;
+		}
+		const __m128i isSlash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+		const __m128i offset = _mm_or_si128(
+			_mm_andnot_si128(isSlash, _mm_shuffle_epi8(_mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0), hi)),
+			_mm_and_si128(isSlash, _mm_set1_epi8(16))
+			);
+		const __m128i values = _mm_add_epi8(in, offset);
+
+	 // pack 4 x 6 bit values into 3 bytes
+		__m128i out = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+		out = _mm_madd_epi16(out, _mm_set1_epi32(0x00011000));
+		out = _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+		_mm_storel_epi64((__m128i*)out_, out);
+		const uint32 tail = (uint32)_mm_cvtsi128_si32(_mm_srli_si128(out, 8));
+		memcpy(out_ + 8, &tail, 4);
+
+		ret += 16;
+		out_ += 12;
+	}
+	return ret;
+}
+
+void apt::Base64Encode(const char* _in, uint _inSizeBytes, char* out_, uint outSizeBytes_)
+{
+	uint i = 0;
+	uint j = 0;
+	uint k = 0;
+	if (kBase64Ssse3) {
+		const uint n = Base64EncodeSsse3(_in, _inSizeBytes, out_);
+		_in += n;
+		_inSizeBytes -= n;
+		k = n / 3 * 4;
+	}
+	unsigned char a3[3];
+	unsigned char a4[4];
+	while (_inSizeBytes--) {
+		a3[i++] = *(_in++);
+		if (i == 3) {
+			Base64A3ToA4(a3, a4);
+			for (i = 0; i < 4; i++) {
+				out_[k++] = kBase64Alphabet[a4[i]];
+			}
+			i = 0;
+		}
+	}
+	if (i) {
+		for (j = i; j < 3; j++) {
+			a3[j] = '\0';
+		}
+		Base64A3ToA4(a3, a4);
+		for (j = 0; j < i + 1; j++) {
+			out_[k++] = kBase64Alphabet[a4[j]];
+		}
+		while ((i++ < 3)) {
+			out_[k++] = '=';
+		}
+	}
+	out_[k] = '\0';
+	APT_ASSERT(outSizeBytes_ == k + 1); // overflow
+}
+
+bool apt::Base64Decode(const char* _in, uint _inSizeBytes, char* out_, uint outSizeBytes_)
+{
+	uint i = 0;
+	uint j = 0;
+	uint k = 0;
+	if (kBase64Ssse3 && outSizeBytes_ >= 12) {
+		const uint n = Base64DecodeSsse3(_in, APT_MIN(_inSizeBytes, outSizeBytes_ / 3 * 4), out_); // clamp to avoid overrunning out_
+		_in += n;
+		_inSizeBytes -= n;
+		k = n / 4 * 3;
+	}
+	unsigned char a3[3];
+	unsigned char a4[4];
+	while (_inSizeBytes--) {
+		if (*_in == '=') {
+			break;
+		}
+		a4[i++] = *(_in++);
+		if (i == 4) {
+			for (i = 0; i < 4; i++) {
+				a4[i] = Base64Index(a4[i]);
+				if (a4[i] == 0xff) {
+					return false;
+				}
+			}
+			if (k + 3 > outSizeBytes_) {
+				return false;
+			}
+			Base64A4ToA3(a4, a3);
+			for (i = 0; i < 3; i++) {
+				out_[k++] = a3[i];
+			}
+			i = 0;
+		}
+	}
+
+	if (i) {
+		for (j = i; j < 4; j++) {
+			a4[j] = 'A';
+		}
+		for (j = 0; j < 4; j++) {
+			a4[j] = Base64Index(a4[j]);
+			if (a4[j] == 0xff) {
+				return false;
+			}
+		}
+		if (k + i - 1 > outSizeBytes_) {
+			return false;
+		}
+		Base64A4ToA3(a4, a3);
+		for (j = 0; j < i - 1; j++) {
+			out_[k++] = a3[j];
+		}
+	}
+	return outSizeBytes_ == k;
+}
+
+uint apt::Base64EncSizeBytes(uint _sizeBytes)
+{
+	uint n = _sizeBytes;
+	return (n + 2 - ((n + 2) % 3)) / 3 * 4;
+}
+
+uint apt::Base64DecSizeBytes(const char* _buf, uint _sizeBytes)
+{
+	uint padCount = 0;
+	for (uint i = _sizeBytes; i > 0 && _buf[i - 1] == '='; i--) {
+		padCount++;
+	}
+	return ((6 * _sizeBytes) / 8) - APT_MIN(padCount, (6 * _sizeBytes) / 8);
+}
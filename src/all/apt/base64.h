@@ -0,0 +1,20 @@
+#pragma once
+
+#include <apt/apt.h>
+
+namespace apt {
+
+// Return the size of the base64 encoding of _sizeBytes of binary data, excluding the null terminator.
+uint Base64EncSizeBytes(uint _sizeBytes);
+
+// Return the size of the binary data decoded from _sizeBytes of base64 in _buf (including padding).
+uint Base64DecSizeBytes(const char* _buf, uint _sizeBytes);
+
+// Encode _inSizeBytes from _in to out_, which must be exactly Base64EncSizeBytes(_inSizeBytes) + 1 (for the null terminator).
+void Base64Encode(const char* _in, uint _inSizeBytes, char* out_, uint outSizeBytes_);
+
+// Decode _inSizeBytes from _in to out_, which must be exactly Base64DecSizeBytes(). Return false if _in contains invalid characters
+// or the decoded size didn't match outSizeBytes_.
+bool Base64Decode(const char* _in, uint _inSizeBytes, char* out_, uint outSizeBytes_);
+
+} // namespace apt
@@ -30,3 +30,14 @@ void apt::Decompress(const void* _in, uint _inSizeBytes, void*& out_, uint& outS
 	out_ = tinfl_decompress_mem_to_heap(_in, _inSizeBytes, &outSizeBytes_, tinflFlags);
 	APT_ASSERT(out_);
 }
+
+bool apt::DecompressToBuffer(const void* _in, uint _inSizeBytes, void* out_, uint _outSizeBytes)
+{
+	APT_ASSERT(_in);
+	APT_ASSERT(_inSizeBytes);
+	APT_ASSERT(out_);
+
+	int tinflFlags = TINFL_FLAG_PARSE_ZLIB_HEADER;
+	size_t ret = tinfl_decompress_mem_to_mem(out_, _outSizeBytes, _in, _inSizeBytes, tinflFlags);
+	return ret != TINFL_DECOMPRESS_MEM_TO_MEM_FAILED && ret == _outSizeBytes;
+}
@@ -20,4 +20,8 @@ void Compress(const void* _in, uint _inSizeBytes, void*& out_, uint& outSizeByte
 // out_ should subsequently be release via free().
 void Decompress(const void* _in, uint _inSizeBytes, void*& out_, uint& outSizeBytes_);
 
+// Decompress _in to out_, which must be exactly the size of the decompressed data. Return false if the size didn't match or an error
+// occurred.
+bool DecompressToBuffer(const void* _in, uint _inSizeBytes, void* out_, uint _outSizeBytes);
+
 } // namespace apt
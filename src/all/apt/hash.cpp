@@ -4,9 +4,6 @@
 
 using namespace apt;
 
-constexpr uint32 kFnv1aPrime32 = 0x01000193u;
-constexpr uint64 kFnv1aPrime64 = 0x100000001B3ull;
-
 uint16 internal::Hash16(const uint8* _buf, uint _bufSize)
 {
 	APT_STRICT_ASSERT(_buf);
@@ -82,3 +79,14 @@ uint64 internal::HashString64(const char* _str, uint64 _base)
 	}
 	return ret;
 }
+
+uint64 apt::HashData(const void* _data, uint64 _sizeBytes)
+{
+	const uint64 kChunkSize = 1ull << 30;
+	uint64 ret = Hash<uint64>(&_sizeBytes, sizeof(_sizeBytes));
+	for (uint64 offset = 0; offset < _sizeBytes; offset += kChunkSize) {
+		const uint64 chunkSize = _sizeBytes - offset < kChunkSize ? _sizeBytes - offset : kChunkSize;
+		ret = Hash<uint64>((const char*)_data + offset, (uint)chunkSize, ret);
+	}
+	return ret;
+}
@@ -6,6 +6,8 @@ namespace apt { namespace internal {
 
 constexpr uint32 kFnv1aBase32 = 0x811C9DC5u;
 constexpr uint64 kFnv1aBase64 = 0xCBF29CE484222325ull;
+constexpr uint32 kFnv1aPrime32 = 0x01000193u;
+constexpr uint64 kFnv1aPrime64 = 0x100000001B3ull;
 
 uint16 Hash16(const uint8* _buf, uint _bufSize);
 uint16 Hash16(const uint8* _buf, uint _bufSize, uint16 _base);
@@ -17,6 +19,12 @@ uint16 HashString16(const char* _str, uint16 _base);
 uint32 HashString32(const char* _str, uint32 _base = kFnv1aBase32);
 uint64 HashString64(const char* _str, uint64 _base = kFnv1aBase64);
 
+// Compile-time equivalent of HashString64() (recursive for C++11 constexpr).
+constexpr uint64 HashStringConst64(const char* _str, uint64 _base = kFnv1aBase64)
+{
+	return *_str ? HashStringConst64(_str + 1, (_base ^ (uint64)*_str) * kFnv1aPrime64) : _base;
+}
+
 } } // namespace apt::internal
 
 
@@ -37,6 +45,10 @@ tType Hash(const void* _buf, uint _bufSize);
 	template <> inline uint32 Hash<uint32>(const void* _buf, uint _bufSize) { return internal::Hash32((const uint8*)_buf, _bufSize); }
 	template <> inline uint64 Hash<uint64>(const void* _buf, uint _bufSize) { return internal::Hash64((const uint8*)_buf, _bufSize); }
 
+// Hash _sizeBytes from _data, e.g. the contents of a file. The size is hashed first, the data is hashed in chunks such that sizes
+// beyond the range of uint are never truncated.
+uint64 HashData(const void* _data, uint64 _sizeBytes);
+
 // Hash a null-terminted string. _base is used to initialize the result.
 // tType = uint16, uint32, uint64
 template <typename tType>
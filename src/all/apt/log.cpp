@@ -18,6 +18,18 @@ static void DispatchLogCallback(const char* _fmt, va_list _args, LogType _type)
 	}
 }
 
+#if !(APT_LOG_CALLBACK_ONLY)
+static void PrintStd(FILE* _file, const char* _fmt, va_list _args)
+{
+ // _args is also passed to DispatchLogCallback(), a va_list can only be consumed once
+	va_list args;
+	va_copy(args, _args);
+	APT_VERIFY((vfprintf(_file, _fmt, args)) >= 0);
+	va_end(args);
+	APT_VERIFY((fprintf(_file, "\n")) > 0);
+}
+#endif
+
 void apt::SetLogCallback(LogCallback* _callback)
 {
 	g_logCallback= _callback;
@@ -33,8 +45,7 @@ void apt::internal::Log(const char* _fmt, ...)
 	va_list args;
 	va_start(args, _fmt);
 	#if !(APT_LOG_CALLBACK_ONLY)
-		APT_VERIFY((vfprintf(stdout, _fmt, args)) >= 0);
-		APT_VERIFY((fprintf(stdout, "\n")) >= 0);
+		PrintStd(stdout, _fmt, args);
 	#endif
 	DispatchLogCallback(_fmt, args, LogType_Log);
 	va_end(args);
@@ -45,8 +56,7 @@ void apt::internal::LogError(const char* _fmt, ...)
 	va_list args;
 	va_start(args, _fmt);
 	#if !(APT_LOG_CALLBACK_ONLY)
-		APT_VERIFY((vfprintf(stderr, _fmt, args)) > 0);
-		APT_VERIFY((fprintf(stderr, "\n")) > 0);
+		PrintStd(stderr, _fmt, args);
 	#endif
 	DispatchLogCallback(_fmt, args, LogType_Error);
 	va_end(args);
@@ -57,8 +67,7 @@ void apt::internal::LogDebug(const char* _fmt, ...)
 	va_list args;
 	va_start(args, _fmt);
 	#if !(APT_LOG_CALLBACK_ONLY)
-		APT_VERIFY((vfprintf(stdout, _fmt, args)) > 0);
-		APT_VERIFY((fprintf(stdout, "\n")) > 0);
+		PrintStd(stdout, _fmt, args);
 	#endif
 	DispatchLogCallback(_fmt, args, LogType_Debug);
 	va_end(args);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <apt/apt.h>
+
+#include <functional> // linalg specializes std::hash but doesn't include <functional>
 #include <linalg/linalg.h>
 
 namespace apt {
@@ -1,6 +1,8 @@
 #include <apt/memory.h>
 
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 #if 1
 	void* operator new(size_t _size)
@@ -41,7 +43,7 @@ void* apt::internal::malloc_aligned(size_t _size, size_t _align)
 #ifdef APT_COMPILER_MSVC
 	return _aligned_malloc(_size, _align);
 #else
-	aligned_alloc(_align, _size);
+	return aligned_alloc(_align, (_size + _align - 1) / _align * _align); // size must be a multiple of _align
 #endif
 }
 
@@ -50,11 +52,18 @@ void* apt::internal::realloc_aligned(void* _ptr, size_t _size, size_t _align)
 #ifdef APT_COMPILER_MSVC
 	return _aligned_realloc(_ptr, _size, _align);
 #else
-	if (_p) {
-		return realloc(_p, _size);
-	} else {
+	if (!_ptr) {
 		return malloc_aligned(_size, _align);
 	}
+	void* ret = ::realloc(_ptr, _size);
+	if (ret && ((uintptr_t)ret & (_align - 1)) != 0) {
+	 // realloc doesn't preserve the alignment, move to a new aligned block
+		void* aligned = malloc_aligned(_size, _align);
+		memcpy(aligned, ret, _size);
+		::free(ret);
+		ret = aligned;
+	}
+	return ret;
 #endif
 }
 
@@ -89,7 +98,8 @@ void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, cons
 #ifdef APT_COMPILER_MSVC
 	return _aligned_offset_malloc(size, alignment, alignmentOffset);
 #else
- // \todo no standard 'offset' version, implement via aligned_alloc
-	APT_ASSERT(false);
+ // \todo no standard 'offset' version, only offset 0 is supported
+	APT_ASSERT(alignmentOffset == 0);
+	return APT_MALLOC_ALIGNED(size, alignment);
 #endif
 }
\ No newline at end of file
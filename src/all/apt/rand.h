@@ -42,60 +42,65 @@ public:
 	uint32 raw()                            { return m_prng.raw(); }
 
 	template <typename tType>
-	tType get();
-		template <> bool get() 
-		{ 
-			return (raw() >> 31) != 0;
-		}
-		template <> float32 get()
-		{
-			internal::iee754_f32 x;
-			x.u = raw();
-			x.u &= 0x007fffffu;
-			x.u |= 0x3f800000u;
-			return x.f - 1.0f;
-		}
+	tType get()                                      { return get(Tag<tType>()); }
 
 	template <typename tType>
-	tType get(const tType& _min, const tType& _max);
-		template <> sint32 get(const sint32& _min, const sint32& _max)
-		{
-			uint64 i = (uint64)raw() * (_max - _min + 1);
-			uint32 j = (uint32)(i >> 32);
-			return (sint32)j + _min;
-		}
-		template <> float32 get(const float32& _min, const float32& _max)
-		{
-			float32 f = get<float32>();
-			return _min + f * (_max - _min);
-		}
+	tType get(const tType& _min, const tType& _max)  { return get(_min, _max, Tag<tType>()); }
 
-		template <> vec2 get(const vec2& _min, const vec2& _max)
-		{
-			return vec2(
-				get(_min.x, _max.x),
-				get(_min.y, _max.y)
-				);
-		}
-		template <> vec3 get(const vec3& _min, const vec3& _max)
-		{
-			return vec3(
-				get(_min.x, _max.x),
-				get(_min.y, _max.y),
-				get(_min.z, _max.z)
-				);
-		}
-		template <> vec4 get(const vec4& _min, const vec4& _max)
-		{
-			return vec4(
-				get(_min.x, _max.x),
-				get(_min.y, _max.y),
-				get(_min.z, _max.z),
-				get(_min.w, _max.w)
-				);
-		}
 private:
 	PRNG m_prng;
+
+ // get() overloads, selected via a tag (member templates can't be explicitly specialized at class scope)
+	template <typename tType> struct Tag {};
+
+	bool get(Tag<bool>)
+	{
+		return (raw() >> 31) != 0;
+	}
+	float32 get(Tag<float32>)
+	{
+		internal::iee754_f32 x;
+		x.u = raw();
+		x.u &= 0x007fffffu;
+		x.u |= 0x3f800000u;
+		return x.f - 1.0f;
+	}
+
+	sint32 get(const sint32& _min, const sint32& _max, Tag<sint32>)
+	{
+		uint64 i = (uint64)raw() * (_max - _min + 1);
+		uint32 j = (uint32)(i >> 32);
+		return (sint32)j + _min;
+	}
+	float32 get(const float32& _min, const float32& _max, Tag<float32>)
+	{
+		float32 f = get<float32>();
+		return _min + f * (_max - _min);
+	}
+	vec2 get(const vec2& _min, const vec2& _max, Tag<vec2>)
+	{
+		return vec2(
+			get(_min.x, _max.x),
+			get(_min.y, _max.y)
+			);
+	}
+	vec3 get(const vec3& _min, const vec3& _max, Tag<vec3>)
+	{
+		return vec3(
+			get(_min.x, _max.x),
+			get(_min.y, _max.y),
+			get(_min.z, _max.z)
+			);
+	}
+	vec4 get(const vec4& _min, const vec4& _max, Tag<vec4>)
+	{
+		return vec4(
+			get(_min.x, _max.x),
+			get(_min.y, _max.y),
+			get(_min.z, _max.z),
+			get(_min.w, _max.w)
+			);
+	}
 };
 
 } // namespace apt
@@ -63,6 +63,6 @@ private:
 	static Callback* s_onShutdown;
 };
 #define APT_DECLARE_STATIC_INIT(_type, _onInit, _onShutdown) static apt::static_initializer<_type> _type ## _static_initializer(_onInit, _onShutdown)
-#define APT_DEFINE_STATIC_INIT(_type)  int apt::static_initializer<_type>::s_initCounter; apt::static_initializer<_type>::Callback* apt::static_initializer<_type>::s_onShutdown
+#define APT_DEFINE_STATIC_INIT(_type)  template <> int apt::static_initializer<_type>::s_initCounter = 0; template <> apt::static_initializer<_type>::Callback* apt::static_initializer<_type>::s_onShutdown = nullptr
 
 } // namespace apt
@@ -0,0 +1,259 @@
+#include <apt/File.h>
+
+#include <apt/log.h>
+#include <apt/math.h>
+#include <apt/memory.h>
+#include <apt/platform.h>
+#include <apt/FileSystem.h>
+#include <apt/String.h>
+
+#include <cerrno>
+#include <cstdint> // SIZE_MAX
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace apt;
+
+namespace {
+	const uint64 kChunkSize = 64 * 1024 * 1024; // Max bytes per read()/write() call (which transfer at most 0x7ffff000 bytes).
+
+	// Read _size bytes from _fd into data_. Return 0 on success, else an error code.
+	int ReadChunked(int _fd, char* data_, uint64 _size)
+	{
+		while (_size > 0) {
+			ssize_t bytesRead = read(_fd, data_, (size_t)APT_MIN(_size, kChunkSize));
+			if (bytesRead < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return errno;
+			}
+			if (bytesRead == 0) {
+				return EIO; // file was truncated
+			}
+			data_ += bytesRead;
+			_size -= (uint64)bytesRead;
+		}
+		return 0;
+	}
+
+	int WriteChunked(int _fd, const char* _data, uint64 _size)
+	{
+		while (_size > 0) {
+			ssize_t bytesWritten = write(_fd, _data, (size_t)APT_MIN(_size, kChunkSize));
+			if (bytesWritten < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return errno;
+			}
+			_data += bytesWritten;
+			_size -= (uint64)bytesWritten;
+		}
+		return 0;
+	}
+
+	// O_DIRECT has the same alignment constraints as FILE_FLAG_NO_BUFFERING but isn't supported by all file systems (e.g. tmpfs), hence
+	// 'unbuffered' access is implemented by dropping the file's pages from the cache once the transfer is complete. Dirty pages can't be
+	// dropped, so a written file must be flushed first.
+	void DropCachedPages(int _fd, bool _flush)
+	{
+		if (_flush) {
+			APT_PLATFORM_VERIFY(fdatasync(_fd) == 0);
+		}
+		posix_fadvise(_fd, 0, 0, POSIX_FADV_DONTNEED); // advisory, ignore failure
+	}
+
+	void Close(int _fd)
+	{
+		APT_PLATFORM_VERIFY(close(_fd) == 0);
+	}
+}
+
+File::File()
+{
+	ctorCommon();
+	m_impl = nullptr; // unused, files are never kept open
+}
+
+File::~File()
+{
+	dtorCommon();
+}
+
+bool File::Exists(const char* _path)
+{
+	struct stat st;
+	return stat(_path, &st) == 0;
+}
+
+bool File::Read(File& file_, const char* _path)
+{
+	return ReadShared(file_, _path, 0);
+}
+
+bool File::ReadShared(File& file_, const char* _path, uint64 _maxSharedBytes)
+{
+	if (!_path) {
+		_path = file_.getPath();
+	}
+	APT_ASSERT(_path);
+
+	bool        ret        = false;
+	char*       data       = nullptr;
+	SharedData* shared     = nullptr;
+	int         err        = 0;
+	uint64      dataSize   = 0;
+	bool        unbuffered = false;
+	struct stat st;
+
+	int fd = open(_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		err = errno;
+		goto File_Read_end;
+	}
+	if (fstat(fd, &st) != 0) {
+		err = errno;
+		goto File_Read_end;
+	}
+	dataSize = (uint64)st.st_size;
+	unbuffered = GetUnbufferedThreshold() > 0 && dataSize > GetUnbufferedThreshold();
+	if (unbuffered) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	}
+
+	if (dataSize > (uint64)SIZE_MAX - 2) {
+		err = EFBIG;
+		goto File_Read_end;
+	}
+	if (_maxSharedBytes > 0 && dataSize <= _maxSharedBytes) {
+		shared = SharedData::Create(nullptr, dataSize);
+		data = shared->getData();
+	} else {
+		data = (char*)APT_MALLOC((size_t)dataSize + 2); // +2 for null terminator
+		APT_ASSERT(data);
+	}
+	err = ReadChunked(fd, data, dataSize);
+	if (err != 0) {
+		goto File_Read_end;
+	}
+	data[dataSize] = data[dataSize + 1] = 0;
+
+	ret = true;
+	
+  // free existing data
+	file_.releaseData();
+	
+	file_.m_data     = data;
+	file_.m_dataSize = dataSize;
+	file_.m_shared   = shared; // file_ takes the initial reference
+	file_.setPath(_path);
+
+File_Read_end:
+	if (!ret) {
+		if (shared) {
+			SharedData::Release(shared);
+		} else if (data) {
+			APT_FREE(data);
+		}
+		APT_LOG_ERR("Error reading '%s':\n\t%s", _path, GetPlatformErrorString((uint64)err));
+		APT_ASSERT(false);
+	}
+	if (fd >= 0) {
+		if (unbuffered) {
+			DropCachedPages(fd, false);
+		}
+		Close(fd);
+	}
+	return ret;
+}
+
+bool File::Write(const File& _file, const char* _path)
+{
+	if (!_path) {
+		_path = _file.getPath();
+	}
+	APT_ASSERT(_path);
+
+	bool ret        = false;
+	int  err        = 0;
+	bool unbuffered = GetUnbufferedThreshold() > 0 && _file.getDataSize() > GetUnbufferedThreshold();
+	
+	int fd = open(_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (fd < 0) {
+		err = errno;
+		if (err == ENOENT) {
+			if (FileSystem::CreateDir(_path)) {
+				return Write(_file, _path);
+			} else {
+				return false;
+			}
+		} else {
+			goto File_Write_end;
+		}
+	}
+
+	err = WriteChunked(fd, _file.getData(), _file.getDataSize());
+	if (err != 0) {
+		goto File_Write_end;
+	}
+
+	ret = true;
+
+File_Write_end:
+	if (!ret) {
+		APT_LOG_ERR("Error writing '%s':\n\t%s", _path, GetPlatformErrorString((uint64)err));
+		APT_ASSERT(false);
+	}
+	if (fd >= 0) {
+		if (unbuffered) {
+			DropCachedPages(fd, true);
+		}
+		Close(fd);
+	}
+	return ret;
+}
+
+bool File::Append(const File& _file, const char* _path)
+{
+	if (!_path) {
+		_path = _file.getPath();
+	}
+	APT_ASSERT(_path);
+
+	bool ret = false;
+	int  err = 0;
+	
+	int fd = open(_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+	if (fd < 0) {
+		err = errno;
+		if (err == ENOENT) {
+			if (FileSystem::CreateDir(_path)) {
+				return Append(_file, _path);
+			} else {
+				return false;
+			}
+		} else {
+			goto File_Append_end;
+		}
+	}
+
+	err = WriteChunked(fd, _file.getData(), _file.getDataSize());
+	if (err != 0) {
+		goto File_Append_end;
+	}
+
+	ret = true;
+
+File_Append_end:
+	if (!ret) {
+		APT_LOG_ERR("Error appending to '%s':\n\t%s", _path, GetPlatformErrorString((uint64)err));
+		APT_ASSERT(false);
+	}
+	if (fd >= 0) {
+		Close(fd);
+	}
+	return ret;
+}
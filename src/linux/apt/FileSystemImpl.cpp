@@ -0,0 +1,1039 @@
+#include <apt/FileSystem.h>
+
+#include <apt/FileActionCoalescer.h>
+#include <apt/hash.h>
+#include <apt/log.h>
+#include <apt/platform.h>
+#include <apt/Pool.h>
+#include <apt/String.h>
+#include <apt/StringHash.h>
+#include <apt/TextParser.h>
+#include <apt/Time.h>
+
+#include <cerrno>
+#include <climits> // PATH_MAX
+#include <condition_variable>
+#include <cstdio> // rename
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/vector.h>
+#include <EASTL/vector_map.h>
+
+using namespace apt;
+
+static DateTime TimespecToDateTime(const struct timespec& _time)
+{
+	return DateTime((sint64)_time.tv_sec * 10000000ll + (sint64)_time.tv_nsec / 100ll + 116444736000000000ll); // 100ns intervals since 1601, as TimeImpl.cpp
+}
+
+static DateTime StatxToDateTime(const struct statx_timestamp& _time)
+{
+	return DateTime((sint64)_time.tv_sec * 10000000ll + (sint64)_time.tv_nsec / 100ll + 116444736000000000ll);
+}
+
+static bool GetFileDateTime(const char* _fullPath, DateTime& created_, DateTime& modified_)
+{
+	struct statx stx;
+	if (statx(AT_FDCWD, _fullPath, 0, STATX_BTIME | STATX_MTIME, &stx) != 0) {
+		APT_LOG_ERR("GetFileDateTime: %s", GetPlatformErrorString(errno));
+		APT_ASSERT(false);
+		return false;
+	}
+	modified_ = StatxToDateTime(stx.stx_mtime);
+	created_ = (stx.stx_mask & STATX_BTIME) ? StatxToDateTime(stx.stx_btime) : modified_; // not all file systems record the creation time
+	return true;
+}
+
+static bool IsDotOrDotDot(const char* _name)
+{
+	return _name[0] == '.' && (_name[1] == '\0' || (_name[1] == '.' && _name[2] == '\0'));
+}
+
+// d_type is DT_UNKNOWN on some file systems, in which case stat the entry. Symbolic links to dirs are treated as dirs (as Windows).
+static bool IsDir(DIR* _dir, const struct dirent* _entry)
+{
+	if (_entry->d_type != DT_UNKNOWN && _entry->d_type != DT_LNK) {
+		return _entry->d_type == DT_DIR;
+	}
+	struct stat st;
+	return fstatat(dirfd(_dir), _entry->d_name, &st, 0) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Enumerate dir_, recursion appends to dir_ in place and restores it on return (no allocations unless dir_ outgrows its local buffer).
+static bool EnumerateImpl(PathStr& dir_, const FileSystem::EnumerateCallback& _callback, bool _recursive)
+{
+	const uint dirLength = dir_.getLength();
+	DIR* dir = opendir((const char*)dir_);
+	if (!dir) {
+		if (errno != ENOENT) {
+			APT_LOG_ERR("Enumerate (opendir): %s", GetPlatformErrorString(errno));
+		}
+		return true;
+	}
+
+	bool ret = true;
+	FileSystem::DirEntry entry;
+	for (;;) {
+		errno = 0;
+		struct dirent* ent = readdir(dir);
+		if (!ent) {
+			if (errno != 0) {
+				APT_LOG_ERR("Enumerate (readdir): %s", GetPlatformErrorString(errno));
+			}
+			break;
+		}
+		if (IsDotOrDotDot(ent->d_name)) {
+			continue;
+		}
+		struct stat st;
+		if (fstatat(dirfd(dir), ent->d_name, &st, 0) != 0 && fstatat(dirfd(dir), ent->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+			continue; // deleted since readdir()
+		}
+		entry.m_dir          = (const char*)dir_; // dir_ may be reallocated by the recursion, hence reset for each entry
+		entry.m_name         = ent->d_name;
+		entry.m_isDir        = S_ISDIR(st.st_mode);
+		entry.m_size         = entry.m_isDir ? 0ull : (uint64)st.st_size;
+		entry.m_timeModified = TimespecToDateTime(st.st_mtim);
+
+		FileSystem::EnumerateAction action = _callback(entry);
+		if (action == FileSystem::EnumerateAction_Stop) {
+			ret = false;
+			break;
+		}
+		if (entry.m_isDir && _recursive && action != FileSystem::EnumerateAction_SkipDir) {
+			dir_.appendf("/%s", ent->d_name);
+			ret = EnumerateImpl(dir_, _callback, _recursive);
+			dir_.setLength(dirLength);
+			dir_[dirLength] = '\0';
+			if (!ret) {
+				break;
+			}
+		}
+	}
+
+	closedir(dir);
+	return ret;
+}
+
+// As GetFullPathName(): make _path absolute (relative to the current directory) and remove '.', '..' and repeated separators. Unlike
+// realpath() the path needn't exist and symbolic links aren't resolved. Return false if the current directory couldn't be retrieved.
+static bool GetFullPath(PathStr& ret_, const char* _path)
+{
+	PathStr path;
+	if (*_path == '/' || *_path == '\\') {
+		path.set(_path);
+	} else {
+		char cwd[PATH_MAX];
+		if (!getcwd(cwd, sizeof(cwd))) {
+			return false;
+		}
+		path.setf("%s/%s", cwd, _path);
+	}
+	path.replace('\\', '/');
+
+	ret_.clear();
+	for (const char* beg = (const char*)path; *beg != '\0';) {
+		while (*beg == '/') {
+			++beg;
+		}
+		const char* end = beg;
+		while (*end != '/' && *end != '\0') {
+			++end;
+		}
+		const uint len = (uint)(end - beg);
+		const char* comp = beg;
+		beg = end;
+		if (len == 0 || (len == 1 && comp[0] == '.')) {
+			continue;
+		}
+		if (len == 2 && comp[0] == '.' && comp[1] == '.') {
+			const char* sep = strrchr((const char*)ret_, '/');
+			uint newLength = sep ? (uint)(sep - (const char*)ret_) : 0;
+			ret_.setLength(newLength);
+			ret_[newLength] = '\0';
+			continue;
+		}
+		ret_.append("/");
+		ret_.append(comp, len);
+	}
+	if (ret_.isEmpty()) {
+		ret_.set("/");
+	}
+	return true;
+}
+
+static void GetAppPath(PathStr& ret_, const char* _append = nullptr)
+{
+	char exe[PATH_MAX] = {};
+	APT_PLATFORM_VERIFY(readlink("/proc/self/exe", exe, sizeof(exe) - 1) > 0);
+	char* pathEnd = strrchr(exe, (int)'/');
+	if (pathEnd) {
+		*pathEnd = '\0';
+	}
+	if (_append && *_append != '\0') {
+		GetFullPath(ret_, (const char*)PathStr("%s/%s", exe, _append));
+	} else {
+		GetFullPath(ret_, exe);
+	}
+}
+
+// Full path of s_roots[_root], relative roots are relative to the application path (as the Windows implementation).
+static void GetRootPath(PathStr& ret_, const char* _root)
+{
+	if (FileSystem::IsAbsolute(_root)) {
+		GetFullPath(ret_, _root);
+	} else {
+		GetAppPath(ret_, _root);
+	}
+}
+
+// PUBLIC
+
+bool FileSystem::Delete(const char* _path)
+{
+	FlushPathCache();
+	InvalidateContentCache(_path);
+	if (unlink(_path) != 0) {
+		int err = errno;
+		if (err != ENOENT) {
+			APT_LOG_ERR("unlink(%s): %s", _path, GetPlatformErrorString(err));
+		}
+		return false;
+	}
+	return true;
+}
+
+bool FileSystem::DeleteDir(const char* _path)
+{
+ // Enumerate() visits dirs before their contents, hence dirs are removed in reverse order
+	eastl::vector<PathStr> files;
+	eastl::vector<PathStr> dirs;
+	dirs.push_back(PathStr());
+	dirs.back().set(_path);
+	Enumerate(_path, [&](const DirEntry& _entry)
+		{
+			(_entry.m_isDir ? dirs : files).push_back(_entry.getPath());
+			return EnumerateAction_Continue;
+		},
+		true);
+
+	bool ret = true;
+	for (auto& file : files) {
+		ret &= Delete((const char*)file);
+	}
+	for (auto it = dirs.rbegin(); it != dirs.rend(); ++it) {
+		if (rmdir((const char*)*it) != 0) {
+			int err = errno;
+			if (err != ENOENT) {
+				APT_LOG_ERR("rmdir(%s): %s", (const char*)*it, GetPlatformErrorString(err));
+			}
+			ret = false;
+		}
+	}
+	return ret;
+}
+
+bool FileSystem::Rename(const char* _path, const char* _newPath)
+{
+	FlushPathCache();
+	InvalidateContentCache(_path);
+	InvalidateContentCache(_newPath);
+	if (rename(_path, _newPath) != 0) {
+		APT_LOG_ERR("rename(%s, %s): %s", _path, _newPath, GetPlatformErrorString(errno));
+		return false;
+	}
+	return true;
+}
+
+DateTime FileSystem::GetTimeCreated(const char* _path, RootType _rootHint)
+{
+	PathStr fullPath;
+	if (!FindExisting(fullPath, _path, _rootHint)) {
+		return DateTime(); // \todo return invalid sentinel
+	}
+	DateTime created, modified;
+	GetFileDateTime((const char*)fullPath, created, modified);
+	return created;
+}
+
+DateTime FileSystem::GetTimeModified(const char* _path, RootType _rootHint)
+{
+	PathStr fullPath;
+	if (!FindExisting(fullPath, _path, _rootHint)) {
+		return DateTime(); // \todo return invalid sentinel
+	}
+	DateTime created, modified;
+	GetFileDateTime((const char*)fullPath, created, modified);
+	return modified;
+}
+
+bool FileSystem::CreateDir(const char* _path)
+{
+	TextParser tp(_path);
+	while (tp.advanceToNext("\\/") != 0) {
+		if (tp.getCharCount() > 0) { // skip the root of an absolute path
+			PathStr dir;
+			dir.set(_path, tp.getCharCount());
+			if (mkdir((const char*)dir, 0777) != 0) {
+				int err = errno;
+				if (err != EEXIST) {
+					APT_LOG_ERR("mkdir(%s): %s", _path, GetPlatformErrorString(err));
+					return false;
+				}
+			}
+		}
+		tp.advance(); // skip the delimiter
+	}
+	return true;
+}
+
+PathStr FileSystem::MakeRelative(const char* _path, RootType _root)
+{
+	PathStr root;
+	GetRootPath(root, (const char*)s_roots[_root]);
+
+ // construct the full path
+	PathStr path;
+	if (!GetFullPath(path, _path)) {
+		return _path;
+	}
+
+ // find the common prefix, whole path components only
+	uint common = 0;
+	for (uint i = 0;; ++i) {
+		const char r = root[i];
+		const char p = path[i];
+		if ((r == '/' || r == '\0') && (p == '/' || p == '\0')) {
+			common = i;
+			if (r == '\0' || p == '\0') {
+				break;
+			}
+		}
+		if (r != p) {
+			break;
+		}
+	}
+
+ // step up for each remaining component of root, then down to path
+	PathStr ret;
+	for (const char* r = (const char*)root + common; *r != '\0'; ++r) {
+		if (*r == '/' && r[1] != '\0') {
+			ret.append("../");
+		}
+	}
+	const char* tail = (const char*)path + common;
+	if (*tail == '/') {
+		++tail;
+	}
+	ret.append(tail);
+	if (ret.getLength() > 0 && ret[ret.getLength() - 1] == '/') {
+		ret.setLength(ret.getLength() - 1);
+		ret[ret.getLength()] = '\0';
+	}
+	return ret;
+}
+
+bool FileSystem::IsAbsolute(const char* _path)
+{
+	return *_path == '/';
+}
+
+PathStr FileSystem::StripRoot(const char* _path)
+{
+	PathStr path;
+	if (!GetFullPath(path, _path)) {
+		return _path;
+	}
+
+	for (int r = 0; r < RootType_Count; ++r) {
+		if (s_roots[r].isEmpty()) {
+			continue;
+		}
+		PathStr root;
+		GetRootPath(root, (const char*)s_roots[r]);
+		const uint rootLength = root.getLength();
+		if (strncmp((const char*)path, (const char*)root, rootLength) == 0 && path[rootLength] == '/') {
+			return PathStr((const char*)path + rootLength + 1);
+		}
+	}
+ // no root found, strip the whole path if not absolute
+	if (!IsAbsolute(_path)) {
+		return StripPath(_path);
+	}
+	return _path;
+}
+
+bool FileSystem::PlatformSelect(PathStr& ret_, std::initializer_list<const char*> _filterList)
+{
+	APT_LOG_ERR("FileSystem::PlatformSelect: not supported on Linux");
+	return false;
+}
+
+int FileSystem::PlatformSelectMulti(PathStr retList_[], int _maxResults, std::initializer_list<const char*> _filterList)
+{
+	APT_LOG_ERR("FileSystem::PlatformSelectMulti: not supported on Linux");
+	return 0;
+}
+
+int FileSystem::ListFiles(PathStr retList_[], int _maxResults, const char* _path, const GlobSet& _filter, bool _recursive)
+{
+	eastl::vector<PathStr> dirs;
+	dirs.push_back(_path);
+	int ret = 0;
+	while (!dirs.empty()) {
+		PathStr root = (PathStr&&)dirs.back();
+		dirs.pop_back();
+		root.replace('\\', '/');
+
+		DIR* dir = opendir((const char*)root);
+		if (!dir) {
+			int err = errno;
+			if (err != ENOENT) {
+				APT_LOG_ERR("ListFiles (opendir): %s", GetPlatformErrorString(err));
+			}
+			continue;
+		}
+
+		for (;;) {
+			errno = 0;
+			struct dirent* ent = readdir(dir);
+			if (!ent) {
+				if (errno != 0) {
+					APT_LOG_ERR("ListFiles (readdir): %s", GetPlatformErrorString(errno));
+				}
+				break;
+			}
+			if (IsDotOrDotDot(ent->d_name)) {
+				continue;
+			}
+			if (IsDir(dir, ent)) {
+				if (_recursive) {
+					dirs.push_back(root);
+					dirs.back().appendf("/%s", ent->d_name);
+				}
+			} else {
+				if (_filter.matches((const char*)ent->d_name)) {
+					if (ret < _maxResults) {
+						retList_[ret].setf("%s/%s", (const char*)root, ent->d_name);
+					}
+					++ret;
+				}
+			}
+		}
+
+		closedir(dir);
+	}
+
+	return ret;
+}
+
+int FileSystem::ListDirs(PathStr retList_[], int _maxResults, const char* _path, const GlobSet& _filter, bool _recursive)
+{
+	eastl::vector<PathStr> dirs;
+	dirs.push_back(_path);
+	int ret = 0;
+	// See the Windows implementation re. 'deferred' recursion.
+	while (!dirs.empty()) {
+		PathStr root = (PathStr&&)dirs.back();
+		dirs.pop_back();
+		root.replace('\\', '/');
+
+		DIR* dir = opendir((const char*)root);
+		if (!dir) {
+			int err = errno;
+			if (err != ENOENT) {
+				APT_LOG_ERR("ListDirs (opendir): %s", GetPlatformErrorString(err));
+			}
+			continue;
+		}
+
+		for (;;) {
+			errno = 0;
+			struct dirent* ent = readdir(dir);
+			if (!ent) {
+				if (errno != 0) {
+					APT_LOG_ERR("ListDirs (readdir): %s", GetPlatformErrorString(errno));
+				}
+				break;
+			}
+			if (IsDotOrDotDot(ent->d_name) || !IsDir(dir, ent)) {
+				continue;
+			}
+			if (_recursive) {
+				dirs.push_back(root);
+				dirs.back().appendf("/%s", ent->d_name);
+			}
+			if (_filter.matches((const char*)ent->d_name)) {
+				if (ret < _maxResults) {
+					retList_[ret].setf("%s/%s", (const char*)root, ent->d_name);
+				}
+				++ret;
+			}
+		}
+
+		closedir(dir);
+	}
+
+	return ret;
+}
+
+bool FileSystem::Enumerate(const char* _path, const EnumerateCallback& _callback, bool _recursive)
+{
+	PathStr dir;
+	dir.set(_path);
+	dir.replace('\\', '/'); // as ListFiles()
+	while (dir.getLength() > 1 && dir[dir.getLength() - 1] == '/') {
+		dir.setLength(dir.getLength() - 1);
+		dir[dir.getLength()] = '\0';
+	}
+	return EnumerateImpl(dir, _callback, _recursive);
+}
+
+PathStr FileSystem::DirEntry::getPath() const
+{
+	return PathStr("%s/%s", m_dir, m_name);
+}
+
+
+namespace {
+/* Notes:
+	- inotify isn't recursive, each dir in a watched subtree has its own watch descriptor (s_WatchDirs). Watches for new subdirs are added
+	  as the IN_CREATE/IN_MOVED_TO events arrive; the new subdir is scanned at that point and Created actions are pushed for its contents,
+	  since files may have been created before the watch was added.
+	- All watches share a single inotify instance, which is read by a single notification thread (epoll on the inotify fd + an eventfd
+	  used to wake the thread).
+	- If the inotify queue overflows (IN_Q_OVERFLOW) events are lost for all watches. Each watch keeps a snapshot of its subtree (path,
+	  size, modified time), on overflow the subtree is rescanned and diffed against the snapshot to synthesize the lost actions.
+*/
+	struct FileState
+	{
+		uint m_pathOffset;
+		uint m_pathLength;
+		uint64 m_size;
+		sint64 m_timeModified;
+		bool   m_isDir;
+	};
+
+	struct Snapshot
+	{
+		eastl::hash_map<uint64, FileState> m_states; // Keyed by path hash.
+		eastl::vector<char>                m_paths;  // Null-terminated paths, relative to the watched dir.
+
+		const char* getPath(const FileState& _state) const { return m_paths.data() + _state.m_pathOffset; }
+
+		void set(const char* _path, uint _pathLength, const struct stat& _stat)
+		{
+			const uint64 pathHash = Hash<uint64>(_path, _pathLength);
+			auto it = m_states.find(pathHash);
+			if (it == m_states.end()) {
+				FileState state;
+				state.m_pathOffset = (uint)m_paths.size();
+				state.m_pathLength = (uint)_pathLength;
+				m_paths.insert(m_paths.end(), _path, _path + _pathLength);
+				m_paths.push_back('\0');
+				it = m_states.insert(eastl::make_pair(pathHash, state)).first;
+			}
+			it->second.m_size         = S_ISDIR(_stat.st_mode) ? 0ull : (uint64)_stat.st_size;
+			it->second.m_timeModified = (sint64)_stat.st_mtim.tv_sec * 1000000000ll + (sint64)_stat.st_mtim.tv_nsec;
+			it->second.m_isDir        = S_ISDIR(_stat.st_mode);
+		}
+
+		// Erase _path, plus its subtree if _path is a dir.
+		void erase(const char* _path, uint _pathLength)
+		{
+			auto it = m_states.find(Hash<uint64>(_path, _pathLength));
+			if (it == m_states.end()) {
+				return;
+			}
+			const bool isDir = it->second.m_isDir;
+			m_states.erase(it);
+			if (isDir) {
+				for (it = m_states.begin(); it != m_states.end();) {
+					const char* path = getPath(it->second);
+					if (it->second.m_pathLength > _pathLength && strncmp(path, _path, _pathLength) == 0 && path[_pathLength] == '/') {
+						it = m_states.erase(it);
+					} else {
+						++it;
+					}
+				}
+			}
+		}
+
+		void swap(Snapshot& _other)
+		{
+			m_states.swap(_other.m_states);
+			m_paths.swap(_other.m_paths);
+		}
+	};
+
+	struct Watch
+	{
+		PathStr                              m_dir;
+		FileActionCoalescer                  m_coalescer;
+		FileSystem::FileActionCallback*      m_dispatchCallback = nullptr;
+		FileSystem::FileActionBatchCallback* m_batchCallback    = nullptr;
+		Snapshot                             m_snapshot;
+		bool*                                m_signal           = nullptr; // Set when the notification thread releases the watch, see EndNotifications().
+	};
+
+	struct WatchDir
+	{
+		Watch*  m_watch;
+		PathStr m_path;  // Relative to m_watch->m_dir, empty for the root.
+	};
+
+	const uint kInotifyMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+	static Pool<Watch>                           s_WatchPool(8);
+	static eastl::vector_map<StringHash, Watch*> s_WatchMap;
+	static eastl::hash_map<int, WatchDir>        s_WatchDirs;         // Keyed by inotify watch descriptor.
+	static std::mutex                            s_WatchMutex;        // Protects the above + the watch coalescers/snapshots.
+	static std::condition_variable               s_WatchSignal;
+	static eastl::vector<Watch*>                 s_ReleaseList;       // Watches to release on the notification thread.
+	static eastl::vector<Watch*>                 s_DispatchList;      // Used by DispatchNotifications().
+
+	static std::mutex                            s_NotifyThreadMutex; // Serializes Begin/EndNotifications() and hence s_NotifyThread start/stop, locked before s_WatchMutex.
+	static std::thread                           s_NotifyThread;
+	static bool                                  s_NotifyThreadExit  = false;
+	static int                                   s_InotifyFd         = -1;
+	static int                                   s_EpollFd           = -1;
+	static int                                   s_WakeFd            = -1;
+
+	PathStr MakeFullPath(const Watch& _watch, const char* _path)
+	{
+		if (*_path == '\0') {
+			return _watch.m_dir;
+		}
+		return PathStr("%s/%s", (const char*)_watch.m_dir, _path);
+	}
+
+	// Add inotify watches for _path (relative to the watched dir) and its subdirs, add all files/dirs to snapshot_. If _pushCreated is true,
+	// push a Created action for each file/dir found. s_WatchMutex must be locked.
+	void AddWatchRecursive(Watch& _watch, const PathStr& _path, Snapshot& snapshot_, bool _pushCreated, Timestamp _time)
+	{
+		PathStr fullPath = MakeFullPath(_watch, (const char*)_path);
+		int wd = inotify_add_watch(s_InotifyFd, (const char*)fullPath, kInotifyMask);
+		if (wd < 0) {
+			if (errno != ENOENT) { // dir was deleted before the watch could be added
+				APT_LOG_ERR("FileSystem notifications: inotify_add_watch '%s' failed (%s)", (const char*)fullPath, GetPlatformErrorString(errno));
+			}
+			return;
+		}
+		WatchDir& watchDir = s_WatchDirs[wd];
+		watchDir.m_watch = &_watch;
+		watchDir.m_path  = _path;
+
+		DIR* dir = opendir((const char*)fullPath);
+		if (!dir) {
+			return;
+		}
+		while (dirent* entry = readdir(dir)) {
+			if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0'))) {
+				continue;
+			}
+			struct stat st;
+			if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+				continue; // deleted since readdir()
+			}
+			PathStr path = _path.isEmpty() ? PathStr("%s", entry->d_name) : PathStr("%s/%s", (const char*)_path, entry->d_name);
+			snapshot_.set((const char*)path, path.getLength(), st);
+			if (_pushCreated) {
+				_watch.m_coalescer.push((const char*)path, path.getLength(), FileSystem::FileAction_Created, _time);
+			}
+			if (S_ISDIR(st.st_mode)) {
+				AddWatchRecursive(_watch, path, snapshot_, _pushCreated, _time);
+			}
+		}
+		closedir(dir);
+	}
+
+	// Remove inotify watches for _path (relative to the watched dir) and its subdirs, or all dirs if _path is nullptr. s_WatchMutex must be locked.
+	void RemoveWatches(const Watch& _watch, const char* _path)
+	{
+		const uint pathLength = _path ? (uint)strlen(_path) : 0;
+		for (auto it = s_WatchDirs.begin(); it != s_WatchDirs.end();) {
+			const WatchDir& watchDir = it->second;
+			if (watchDir.m_watch == &_watch) {
+				const char* path = (const char*)watchDir.m_path;
+				if (!_path || strcmp(path, _path) == 0 || (strncmp(path, _path, pathLength) == 0 && path[pathLength] == '/')) {
+					inotify_rm_watch(s_InotifyFd, it->first); // may fail if the dir was already deleted
+					it = s_WatchDirs.erase(it);
+					continue;
+				}
+			}
+			++it;
+		}
+	}
+
+	void UpdateSnapshot(Watch& _watch, const PathStr& _path)
+	{
+		struct stat st;
+		if (fstatat(AT_FDCWD, (const char*)MakeFullPath(_watch, (const char*)_path), &st, AT_SYMLINK_NOFOLLOW) == 0) {
+			_watch.m_snapshot.set((const char*)_path, _path.getLength(), st);
+		}
+	}
+
+	// Rescan _watch's subtree and diff against the snapshot, push actions for any differences. s_WatchMutex must be locked.
+	void RescanWatch(Watch& _watch, Timestamp _time)
+	{
+		APT_LOG_DBG("FileSystem notifications: rescanning '%s'", (const char*)_watch.m_dir);
+
+		RemoveWatches(_watch, nullptr); // drop watches for dirs which may have been deleted, AddWatchRecursive() re-adds the remainder
+		Snapshot current;
+		AddWatchRecursive(_watch, PathStr(), current, false, _time);
+
+		for (auto& it : current.m_states) {
+			const FileState& state = it.second;
+			const char* path = current.getPath(state);
+			auto prev = _watch.m_snapshot.m_states.find(it.first);
+			if (prev == _watch.m_snapshot.m_states.end()) {
+				_watch.m_coalescer.push(path, state.m_pathLength, FileSystem::FileAction_Created, _time);
+			} else if (prev->second.m_size != state.m_size || prev->second.m_timeModified != state.m_timeModified) {
+				_watch.m_coalescer.push(path, state.m_pathLength, FileSystem::FileAction_Modified, _time);
+			}
+		}
+		for (auto& it : _watch.m_snapshot.m_states) {
+			if (current.m_states.find(it.first) == current.m_states.end()) {
+				_watch.m_coalescer.push(_watch.m_snapshot.getPath(it.second), it.second.m_pathLength, FileSystem::FileAction_Deleted, _time);
+			}
+		}
+		_watch.m_snapshot.swap(current);
+	}
+
+	// s_WatchMutex must be locked.
+	void HandleEvent(const struct inotify_event* _event, Timestamp _time)
+	{
+		if (_event->mask & IN_Q_OVERFLOW) {
+			APT_LOG_ERR("FileSystem notifications: inotify queue overflow, rescanning watched dirs");
+			for (auto& it : s_WatchMap) {
+				RescanWatch(*it.second, _time);
+			}
+			return;
+		}
+
+		auto it = s_WatchDirs.find(_event->wd);
+		if (it == s_WatchDirs.end()) {
+			return; // watch was removed, remaining events are ignored
+		}
+		if (_event->mask & IN_IGNORED) {
+			s_WatchDirs.erase(it);
+			return;
+		}
+		if (_event->len == 0) {
+			return; // event for the watched dir itself, reported via its parent
+		}
+
+		Watch& watch = *it->second.m_watch;
+		const PathStr& dirPath = it->second.m_path;
+		PathStr path = dirPath.isEmpty() ? PathStr("%s", _event->name) : PathStr("%s/%s", (const char*)dirPath, _event->name);
+		const bool isDir = (_event->mask & IN_ISDIR) != 0;
+
+		if (_event->mask & (IN_CREATE | IN_MOVED_TO)) {
+			watch.m_coalescer.push((const char*)path, path.getLength(), FileSystem::FileAction_Created, _time);
+			UpdateSnapshot(watch, path);
+			if (isDir) {
+				AddWatchRecursive(watch, path, watch.m_snapshot, true, _time);
+			}
+
+		} else if (_event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+			watch.m_coalescer.push((const char*)path, path.getLength(), FileSystem::FileAction_Deleted, _time);
+			watch.m_snapshot.erase((const char*)path, path.getLength());
+			if (isDir && (_event->mask & IN_MOVED_FROM)) {
+				RemoveWatches(watch, (const char*)path); // the dir still exists elsewhere, stop watching it
+			}
+
+		} else if (_event->mask & (IN_MODIFY | IN_ATTRIB)) {
+			watch.m_coalescer.push((const char*)path, path.getLength(), FileSystem::FileAction_Modified, _time);
+			UpdateSnapshot(watch, path);
+		}
+	}
+
+	void ReadEvents()
+	{
+		alignas(struct inotify_event) char buf[64 * 1024];
+		for (;;) {
+			ssize_t len = read(s_InotifyFd, buf, sizeof(buf));
+			if (len <= 0) {
+				if (len < 0 && errno != EAGAIN && errno != EINTR) {
+					APT_LOG_ERR("FileSystem notifications: read failed (%s)", GetPlatformErrorString(errno));
+				}
+				break;
+			}
+			const Timestamp now = Time::GetTimestamp();
+			std::lock_guard<std::mutex> lock(s_WatchMutex);
+			for (const char* event = buf; event < buf + len;) {
+				const struct inotify_event* info = (const struct inotify_event*)event;
+				HandleEvent(info, now);
+				event += sizeof(struct inotify_event) + info->len;
+			}
+		}
+	}
+
+	void Wake()
+	{
+		uint64 one = 1;
+		APT_VERIFY(write(s_WakeFd, &one, sizeof(one)) == sizeof(one));
+	}
+
+	// Created/deleted files invalidate the FileSystem path cache, any action invalidates the file's content cache entry.
+	void FlushCachesIfRequired(const char* _dir, const FileSystem::FileActionEvent* _events, uint _eventCount)
+	{
+		const bool contentCache = FileSystem::GetContentCacheBudget() > 0;
+		bool flushPathCache = false;
+		for (uint i = 0; i < _eventCount; ++i) {
+			flushPathCache |= _events[i].m_action != FileSystem::FileAction_Modified;
+			if (contentCache) {
+				FileSystem::InvalidateContentCache((const char*)PathStr("%s/%s", _dir, _events[i].m_path));
+			}
+		}
+		if (flushPathCache) {
+			FileSystem::FlushPathCache();
+		}
+	}
+
+	void NotifyThreadProc()
+	{
+		eastl::vector<Watch*> readyList;
+		struct epoll_event events[2];
+		for (;;) {
+			int timeoutMs = -1;
+			{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+				if (!s_ReleaseList.empty()) {
+					for (Watch* watch : s_ReleaseList) {
+						*watch->m_signal = true;
+						s_WatchPool.free(watch);
+					}
+					s_ReleaseList.clear();
+					s_WatchSignal.notify_all();
+				}
+				if (s_NotifyThreadExit) {
+					break;
+				}
+
+				const Timestamp now = Time::GetTimestamp();
+				readyList.clear();
+				for (auto& it : s_WatchMap) {
+					Watch* watch = it.second;
+					if (!watch->m_batchCallback || watch->m_coalescer.isEmpty()) {
+						continue;
+					}
+					if (watch->m_coalescer.flush(now) > 0) {
+						readyList.push_back(watch);
+					}
+					if (!watch->m_coalescer.isEmpty()) {
+						int readyMs = (int)(watch->m_coalescer.getNextReadyTime() - now).asMilliseconds() + 1;
+						timeoutMs = (timeoutMs < 0 || readyMs < timeoutMs) ? readyMs : timeoutMs;
+					}
+				}
+			}
+
+		 // dispatch outside the lock; watches are only released at the top of this loop, batches are valid until the next flush (also on this thread)
+			for (Watch* watch : readyList) {
+				const FileSystem::FileActionEvent* batch = watch->m_coalescer.getBatch();
+				uint batchSize = watch->m_coalescer.getBatchSize();
+				FlushCachesIfRequired((const char*)watch->m_dir, batch, batchSize);
+				watch->m_batchCallback((const char*)watch->m_dir, batch, batchSize);
+			}
+
+			int count = epoll_wait(s_EpollFd, events, 2, timeoutMs);
+			if (count < 0 && errno != EINTR) {
+				APT_LOG_ERR("FileSystem notifications: epoll_wait failed (%s)", GetPlatformErrorString(errno));
+			}
+			for (int i = 0; i < count; ++i) {
+				if (events[i].data.fd == s_WakeFd) {
+					uint64 value;
+					APT_VERIFY(read(s_WakeFd, &value, sizeof(value)) == sizeof(value));
+				} else {
+					ReadEvents();
+				}
+			}
+		}
+	}
+
+	// s_NotifyThreadMutex must be locked.
+	void NotifyThreadStart()
+	{
+		if (s_NotifyThread.joinable()) {
+			return;
+		}
+		s_InotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		APT_PLATFORM_ASSERT(s_InotifyFd >= 0);
+		s_WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		APT_PLATFORM_ASSERT(s_WakeFd >= 0);
+		s_EpollFd = epoll_create1(EPOLL_CLOEXEC);
+		APT_PLATFORM_ASSERT(s_EpollFd >= 0);
+		struct epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = s_InotifyFd;
+		APT_PLATFORM_VERIFY(epoll_ctl(s_EpollFd, EPOLL_CTL_ADD, s_InotifyFd, &event) == 0);
+		event.data.fd = s_WakeFd;
+		APT_PLATFORM_VERIFY(epoll_ctl(s_EpollFd, EPOLL_CTL_ADD, s_WakeFd, &event) == 0);
+
+		s_NotifyThreadExit = false;
+		s_NotifyThread = std::thread(NotifyThreadProc);
+	}
+
+	// s_NotifyThreadMutex must be locked.
+	void NotifyThreadStop()
+	{
+		{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+			s_NotifyThreadExit = true;
+		}
+		Wake();
+		s_NotifyThread.join();
+		close(s_EpollFd);
+		close(s_WakeFd);
+		close(s_InotifyFd);
+		s_EpollFd = s_WakeFd = s_InotifyFd = -1;
+	}
+
+	void BeginWatch(const char* _dir, FileSystem::FileActionCallback* _callback, FileSystem::FileActionBatchCallback* _batchCallback, uint _coalesceMs)
+	{
+		std::lock_guard<std::mutex> threadLock(s_NotifyThreadMutex);
+		StringHash dirHash(_dir);
+		{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+			if (s_WatchMap.find(dirHash) != s_WatchMap.end()) {
+				APT_ASSERT(false);
+				return;
+			}
+		}
+
+		mkdir(_dir, 0777); // create if it doesn't already exist
+		NotifyThreadStart();
+
+		std::lock_guard<std::mutex> lock(s_WatchMutex);
+		Watch* watch = s_WatchPool.alloc();
+		watch->m_dir.set(_dir);
+		while (watch->m_dir.getLength() > 1 && watch->m_dir[watch->m_dir.getLength() - 1] == '/') {
+			watch->m_dir.setLength(watch->m_dir.getLength() - 1);
+			watch->m_dir[watch->m_dir.getLength()] = '\0';
+		}
+		watch->m_dispatchCallback = _callback;
+		watch->m_batchCallback = _batchCallback;
+		watch->m_coalescer.setWindow(_batchCallback ? _coalesceMs : 0);
+		AddWatchRecursive(*watch, PathStr(), watch->m_snapshot, false, Time::GetTimestamp());
+		s_WatchMap[dirHash] = watch;
+	}
+
+	// End any remaining watches (and hence stop the notification thread) during static deinitialization.
+	struct NotifyShutdown
+	{
+		~NotifyShutdown()
+		{
+			while (!s_WatchMap.empty()) {
+				FileSystem::EndNotifications((const char*)s_WatchMap.begin()->second->m_dir);
+			}
+		}
+	};
+	static NotifyShutdown s_NotifyShutdown;
+}
+
+void FileSystem::BeginNotifications(const char* _dir, FileActionCallback* _callback)
+{
+	BeginWatch(_dir, _callback, nullptr, 0);
+}
+
+void FileSystem::BeginNotifications(const char* _dir, FileActionBatchCallback* _callback, uint _coalesceMs)
+{
+	BeginWatch(_dir, nullptr, _callback, _coalesceMs);
+}
+
+void FileSystem::EndNotifications(const char* _dir)
+{
+ // s_NotifyThreadMutex is held until the thread is stopped, hence a concurrent BeginNotifications() can't add a watch after the map
+ // was found to be empty, or start the thread while it's being joined
+	std::lock_guard<std::mutex> threadLock(s_NotifyThreadMutex);
+	bool stopThread = false;
+	{	std::unique_lock<std::mutex> lock(s_WatchMutex);
+		auto it = s_WatchMap.find(StringHash(_dir));
+		if (it == s_WatchMap.end()) {
+			APT_ASSERT(false);
+			return;
+		}
+		Watch* watch = it->second;
+		s_WatchMap.erase(it);
+		RemoveWatches(*watch, nullptr);
+
+	 // the notification thread may be dispatching to the watch, hence it must release the watch
+		bool released = false;
+		watch->m_signal = &released;
+		s_ReleaseList.push_back(watch);
+		Wake();
+		s_WatchSignal.wait(lock, [&released] { return released; });
+		stopThread = s_WatchMap.empty();
+	}
+	if (stopThread) {
+		NotifyThreadStop();
+	}
+}
+
+void FileSystem::DispatchNotifications(const char* _dir)
+{
+	{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+		s_DispatchList.clear();
+		if (_dir) {
+			auto it = s_WatchMap.find(StringHash(_dir));
+			if (it == s_WatchMap.end()) {
+				APT_ASSERT(false);
+				return;
+			}
+			s_DispatchList.push_back(it->second);
+		} else {
+			for (auto& it : s_WatchMap) {
+				s_DispatchList.push_back(it.second);
+			}
+		}
+		for (Watch* watch : s_DispatchList) {
+			if (watch->m_dispatchCallback) {
+				watch->m_coalescer.flush(Timestamp(), true);
+			}
+		}
+	}
+
+ // dispatch outside the lock; watches with a FileActionCallback are only flushed here, hence the batches remain valid
+	for (Watch* watch : s_DispatchList) {
+		if (!watch->m_dispatchCallback) {
+			continue;
+		}
+		const FileActionEvent* events = watch->m_coalescer.getBatch();
+		uint eventCount = watch->m_coalescer.getBatchSize();
+		FlushCachesIfRequired((const char*)watch->m_dir, events, eventCount);
+		for (uint i = 0; i < eventCount; ++i) {
+			watch->m_dispatchCallback(events[i].m_path, events[i].m_action);
+		}
+	}
+}
+
+// PROTECTED
+
+bool FileSystem::GetTimeModifiedIfExists(const char* _path, DateTime& ret_)
+{
+	struct stat st;
+	if (stat(_path, &st) != 0) {
+		return false;
+	}
+	ret_ = TimespecToDateTime(st.st_mtim);
+	return true;
+}
+
+PathStr FileSystem::GetAbsolutePath(const char* _path)
+{
+	PathStr ret;
+	if (!GetFullPath(ret, _path)) {
+		ret.set(_path); // on failure fall back to _path as-is
+	}
+	return ret;
+}
+
+const char FileSystem::s_separator = '/';
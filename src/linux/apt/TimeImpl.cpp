@@ -0,0 +1,195 @@
+#include <apt/Time.h>
+
+#include <apt/memory.h>
+#include <apt/platform.h>
+#include <apt/String.h>
+
+#include <ctime>
+
+using namespace apt;
+
+// DateTime uses the same representation as the Windows FILETIME (100ns intervals since 1601-01-01 UTC) such that raw values are
+// portable between platforms.
+static const sint64 kUnixEpoch = 116444736000000000ll; // 1970-01-01 as a FILETIME
+
+static sint64 ToRaw(time_t _sec)
+{
+	return (sint64)_sec * 10000000ll + kUnixEpoch;
+}
+
+// Split _raw into seconds since the Unix epoch + the sub-second part in 100ns intervals (rounds toward -inf, _raw may precede 1970).
+static time_t ToTime(sint64 _raw, sint64* fraction_ = nullptr)
+{
+	sint64 sec = (_raw - kUnixEpoch) / 10000000ll;
+	sint64 rem = (_raw - kUnixEpoch) % 10000000ll;
+	if (rem < 0) {
+		sec -= 1;
+		rem += 10000000ll;
+	}
+	if (fraction_) {
+		*fraction_ = rem;
+	}
+	return (time_t)sec;
+}
+
+static struct tm ToTm(sint64 _raw)
+{
+	time_t t = ToTime(_raw);
+	struct tm ret;
+	gmtime_r(&t, &ret);
+	return ret;
+}
+
+static sint64 ToFraction(sint64 _raw)
+{
+	sint64 ret;
+	ToTime(_raw, &ret);
+	return ret;
+}
+
+/*******************************************************************************
+	
+                                 Time
+
+*******************************************************************************/
+
+APT_DEFINE_STATIC_INIT(Time);
+static storage<sint64, 1>    s_sysFreq;
+static storage<Timestamp, 1> s_appInit;
+
+Timestamp Time::GetTimestamp() 
+{
+	timespec t;
+	APT_PLATFORM_VERIFY(clock_gettime(CLOCK_MONOTONIC, &t) == 0);
+	return Timestamp((sint64)t.tv_sec * 1000000000ll + (sint64)t.tv_nsec);
+}
+
+sint64 Time::GetSystemFrequency() 
+{
+	return *s_sysFreq;
+}
+
+DateTime Time::GetDateTime() 
+{
+	timespec t;
+	APT_PLATFORM_VERIFY(clock_gettime(CLOCK_REALTIME, &t) == 0);
+	return DateTime(ToRaw(t.tv_sec) + (sint64)t.tv_nsec / 100ll);
+}
+
+DateTime Time::ToLocal(DateTime _utc)
+{
+	sint64 fraction;
+	time_t t = ToTime((sint64)_utc.getRaw(), &fraction);
+	struct tm local;
+	localtime_r(&t, &local);
+	return DateTime(ToRaw(timegm(&local)) + fraction); // timegm() treats the local broken-down time as UTC
+}
+
+DateTime Time::ToUTC(DateTime _local)
+{
+	sint64 fraction;
+	time_t t = ToTime((sint64)_local.getRaw(), &fraction);
+	struct tm local;
+	gmtime_r(&t, &local); // _local is stored as if it were UTC, see ToLocal()
+	local.tm_isdst = -1; // let mktime() determine whether DST applies
+	return DateTime(ToRaw(mktime(&local)) + fraction);
+}
+
+Timestamp Time::GetApplicationElapsed()
+{
+	return GetTimestamp() - *s_appInit;
+}
+
+void Time::Sleep(sint64 _ms)
+{
+	timespec t;
+	t.tv_sec  = (time_t)(_ms / 1000);
+	t.tv_nsec = (long)(_ms % 1000) * 1000000l;
+	while (nanosleep(&t, &t) != 0 && errno == EINTR) {
+		// interrupted by a signal, t is the remaining time
+	}
+}
+
+void Time::Init()
+{
+	*s_sysFreq = 1000000000ll; // timestamps are in ns, see GetTimestamp()
+	*s_appInit = GetTimestamp();
+}
+
+void Time::Shutdown()
+{
+}
+
+/*******************************************************************************
+	
+                                 Timestamp
+
+*******************************************************************************/
+
+double Timestamp::asSeconds() const
+{
+	return asMicroseconds() / 1000000.0;
+}
+
+double Timestamp::asMilliseconds() const
+{
+	return asMicroseconds() / 1000.0;
+}
+
+double Timestamp::asMicroseconds() const
+{
+	return (double)((m_raw * 1000000ll) / Time::GetSystemFrequency());
+}
+
+/*******************************************************************************
+	
+                                   DateTime
+
+*******************************************************************************/
+
+sint32 DateTime::getYear() const         { return (sint32)ToTm(m_raw).tm_year + 1900; }
+sint32 DateTime::getMonth() const        { return (sint32)ToTm(m_raw).tm_mon + 1; }
+sint32 DateTime::getDay() const          { return (sint32)ToTm(m_raw).tm_mday; }
+sint32 DateTime::getHour() const         { return (sint32)ToTm(m_raw).tm_hour; }
+sint32 DateTime::getMinute() const       { return (sint32)ToTm(m_raw).tm_min; }
+sint32 DateTime::getSecond() const       { return (sint32)ToTm(m_raw).tm_sec; }
+sint32 DateTime::getMillisecond() const  { return (sint32)(ToFraction(m_raw) / 10000ll); }
+
+double DateTime::getSecondsSince(DateTime _since) const
+{
+	return (double)((sint64)m_raw - (sint64)_since.m_raw) / 10000000.0; // 100ns intervals, as FILETIME
+}
+
+const char* apt::DateTime::asString(const char* _format) const
+{
+	static String<128> s_buf;
+	struct tm st    = ToTm(m_raw);
+	const int year  = st.tm_year + 1900;
+	const int month = st.tm_mon + 1;
+	const int ms    = (int)(ToFraction(m_raw) / 10000ll);
+	if (!_format) { // default ISO 8601 format
+		s_buf.setf("%.4d-%.2d-%.2dT%.2d:%.2d:%.2dZ", year, month, st.tm_mday, st.tm_hour, st.tm_min, st.tm_sec);
+	} else {
+		s_buf.clear();
+		for (int i = 0; _format[i] != 0; ++i) {
+			if (_format[i] == '%') {
+				switch (_format[++i]) {
+					case 'Y': s_buf.appendf("%.4d", year);       break;
+					case 'm': s_buf.appendf("%.2d", month);      break;
+					case 'd': s_buf.appendf("%.2d", st.tm_mday); break;
+					case 'H': s_buf.appendf("%.2d", st.tm_hour); break;
+					case 'M': s_buf.appendf("%.2d", st.tm_min);  break;
+					case 'S': s_buf.appendf("%.2d", st.tm_sec);  break;
+					case 's': s_buf.appendf("%.2d", ms);         break;
+					default:
+						if (_format[i] != 0) {
+							s_buf.append(&_format[i], 1);
+						}
+				};
+			} else {
+				s_buf.append(&_format[i], 1);
+			}
+		}
+	}
+	return (const char*)s_buf;
+}
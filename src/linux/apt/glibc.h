@@ -0,0 +1,8 @@
+#pragma once
+
+// glibc declares ::uint in <sys/types.h>, which is ambiguous with apt::uint wherever 'using namespace apt' is used at global scope.
+// This header is force-included on Linux (see ApplicationTools_premake.lua) so that the glibc declaration is renamed before any
+// other header can include it.
+#define uint glibc_uint
+#include <sys/types.h>
+#undef uint
@@ -0,0 +1,57 @@
+#include <apt/platform.h>
+
+#include <apt/String.h>
+
+#include <cpuid.h> // __get_cpuid
+#include <cstring>
+#include <sys/sysinfo.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+const char* apt::GetPlatformErrorString(uint64 _err)
+{
+	static thread_local String<1024> ret;
+	char buf[256];
+	ret.setf("(%llu) %s", _err, strerror_r((int)_err, buf, sizeof(buf))); // GNU strerror_r, may return a static string instead of buf
+	return (const char*)ret;
+}
+
+const char* apt::GetPlatformInfoString()
+{
+	static thread_local String<1024> ret;
+	ret.clear();
+
+ // OS version
+	ret.appendf("\tOS:     ");
+	struct utsname osinf;
+	if (uname(&osinf) != 0) {
+		ret.append((const char*)GetPlatformErrorString(errno));
+	} else {
+		ret.appendf("%s %s", osinf.sysname, osinf.release);
+	}
+
+ // cpu vendor/brand
+	unsigned int cpuinf[4] = {};
+	char cpustr[64] = {};
+	__get_cpuid(0x80000002, &cpuinf[0], &cpuinf[1], &cpuinf[2], &cpuinf[3]);
+	memcpy(cpustr + 0,  cpuinf, sizeof(cpuinf));
+	__get_cpuid(0x80000003, &cpuinf[0], &cpuinf[1], &cpuinf[2], &cpuinf[3]);
+	memcpy(cpustr + 16, cpuinf, sizeof(cpuinf));
+	__get_cpuid(0x80000004, &cpuinf[0], &cpuinf[1], &cpuinf[2], &cpuinf[3]);
+	memcpy(cpustr + 32, cpuinf, sizeof(cpuinf));
+	ret.appendf("\n\tCPU:    %s", cpustr);
+
+ // proccessor count
+	ret.appendf(" (%ld cores)", sysconf(_SC_NPROCESSORS_ONLN));
+
+ // global memory status
+	struct sysinfo meminf;
+	ret.append("\n\tMemory: ");
+	if (sysinfo(&meminf) != 0) {
+		ret.append((const char*)GetPlatformErrorString(errno));
+	} else {
+		ret.appendf("%lluMb", (unsigned long long)meminf.totalram * meminf.mem_unit / 1024 / 1024);
+	}
+
+	return (const char*)ret;
+}
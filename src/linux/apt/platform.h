@@ -0,0 +1,23 @@
+#pragma once
+
+#include <apt/apt.h>
+
+#if !(APT_PLATFORM_LINUX)
+	#error apt: APT_PLATFORM_LINUX was not defined, probably the build system was configured incorrectly
+#endif
+
+#include <cerrno>
+
+// ASSERT/VERIFY with platform-specific error string (use to wrap OS calls).
+#define APT_PLATFORM_ASSERT(_err) APT_ASSERT_MSG(_err, apt::GetPlatformErrorString((uint64)errno))
+#define APT_PLATFORM_VERIFY(_err) APT_VERIFY_MSG(_err, apt::GetPlatformErrorString((uint64)errno))
+
+namespace apt {
+
+// Format a system error code (errno) as a string.
+const char* GetPlatformErrorString(uint64 _err);
+
+// Return a string containing OS, CPU and system memory info.
+const char* GetPlatformInfoString(); 
+
+} // namespace apt
@@ -1,6 +1,7 @@
 #include <apt/File.h>
 
 #include <apt/log.h>
+#include <apt/math.h>
 #include <apt/memory.h>
 #include <apt/platform.h>
 #include <apt/win.h>
@@ -8,10 +9,142 @@
 #include <apt/String.h>
 #include <apt/TextParser.h>
 
+#include <cstring> // memcpy, memset
 #include <utility> // swap
 
 using namespace apt;
 
+namespace {
+	const DWORD kChunkSize           = 64 * 1024 * 1024; // Max bytes per ReadFile()/WriteFile() call (which are limited to DWORD bytes), a multiple of kUnbufferedAlignment.
+	const DWORD kUnbufferedAlignment = 4096;             // FILE_FLAG_NO_BUFFERING requires sector-aligned buffers/sizes, 4096 covers 512 byte and 4k sector drives.
+	const DWORD kUnbufferedChunkSize = 8 * 1024 * 1024;  // Size of the aligned staging buffer for unbuffered access.
+
+	// Read _size bytes from _h into data_. Return 0 on success, else an error code.
+	DWORD ReadChunked(HANDLE _h, char* data_, uint64 _size)
+	{
+		while (_size > 0) {
+			DWORD bytesRead = 0;
+			if (!ReadFile(_h, data_, (DWORD)APT_MIN(_size, (uint64)kChunkSize), &bytesRead, NULL)) {
+				return GetLastError();
+			}
+			if (bytesRead == 0) {
+				return ERROR_HANDLE_EOF; // file was truncated
+			}
+			data_  += bytesRead;
+			_size  -= bytesRead;
+		}
+		return 0;
+	}
+
+	bool IsSectorAligned(const void* _ptr)
+	{
+		return ((uintptr_t)_ptr & (kUnbufferedAlignment - 1)) == 0;
+	}
+
+	// Size of the staging buffer required to transfer _size bytes unbuffered.
+	DWORD GetStagingSize(uint64 _size)
+	{
+		return (DWORD)APT_MIN((_size + kUnbufferedAlignment - 1) / kUnbufferedAlignment * kUnbufferedAlignment, (uint64)kUnbufferedChunkSize);
+	}
+
+	// As ReadChunked() for a handle opened with FILE_FLAG_NO_BUFFERING. If data_ is sector-aligned whole sectors are read directly into
+	// data_ and only the tail is read via an aligned staging buffer, else all the data is staged.
+	DWORD ReadUnbuffered(HANDLE _h, char* data_, uint64 _size)
+	{
+		DWORD err = 0;
+		if (IsSectorAligned(data_)) {
+			uint64 directSize = _size / kUnbufferedAlignment * kUnbufferedAlignment;
+			err = ReadChunked(_h, data_, directSize);
+			if (err != 0) {
+				return err;
+			}
+			data_ += directSize;
+			_size -= directSize;
+		}
+		if (_size == 0) {
+			return 0;
+		}
+
+		const DWORD bufSize = GetStagingSize(_size);
+		char* buf = (char*)APT_MALLOC_ALIGNED(bufSize, kUnbufferedAlignment);
+		while (_size > 0) {
+			DWORD bytesRead = 0;
+			if (!ReadFile(_h, buf, bufSize, &bytesRead, NULL)) {
+				err = GetLastError();
+				break;
+			}
+			if (bytesRead == 0) {
+				err = ERROR_HANDLE_EOF;
+				break;
+			}
+			DWORD n = (DWORD)APT_MIN(_size, (uint64)bytesRead);
+			memcpy(data_, buf, n);
+			data_ += n;
+			_size -= n;
+		}
+		APT_FREE_ALIGNED(buf);
+		return err;
+	}
+
+	DWORD WriteChunked(HANDLE _h, const char* _data, uint64 _size)
+	{
+		while (_size > 0) {
+			DWORD bytesWritten = 0;
+			if (!WriteFile(_h, _data, (DWORD)APT_MIN(_size, (uint64)kChunkSize), &bytesWritten, NULL)) {
+				return GetLastError();
+			}
+			_data += bytesWritten;
+			_size -= bytesWritten;
+		}
+		return 0;
+	}
+
+	// As WriteChunked() for a handle opened with FILE_FLAG_NO_BUFFERING. If _data is sector-aligned whole sectors are written directly
+	// from _data, else via an aligned staging buffer. The tail is staged and padded to the sector size, the file is then truncated to _size.
+	DWORD WriteUnbuffered(HANDLE _h, const char* _data, uint64 _size)
+	{
+		DWORD err = 0;
+		uint64 remaining = _size;
+		if (IsSectorAligned(_data)) {
+			uint64 directSize = remaining / kUnbufferedAlignment * kUnbufferedAlignment;
+			err = WriteChunked(_h, _data, directSize);
+			if (err != 0) {
+				return err;
+			}
+			_data     += directSize;
+			remaining -= directSize;
+		}
+
+		if (remaining > 0) {
+			const DWORD bufSize = GetStagingSize(remaining);
+			char* buf = (char*)APT_MALLOC_ALIGNED(bufSize, kUnbufferedAlignment);
+			while (remaining > 0) {
+				DWORD n = (DWORD)APT_MIN(remaining, (uint64)bufSize);
+				DWORD bytesToWrite = (n + kUnbufferedAlignment - 1) / kUnbufferedAlignment * kUnbufferedAlignment;
+				memcpy(buf, _data, n);
+				memset(buf + n, 0, bytesToWrite - n);
+				DWORD bytesWritten = 0;
+				if (!WriteFile(_h, buf, bytesToWrite, &bytesWritten, NULL)) {
+					err = GetLastError();
+					break;
+				}
+				APT_ASSERT(bytesWritten == bytesToWrite);
+				_data     += n;
+				remaining -= n;
+			}
+			APT_FREE_ALIGNED(buf);
+		}
+		if (err == 0 && _size % kUnbufferedAlignment != 0) {
+			FILE_END_OF_FILE_INFO eof;
+			eof.EndOfFile.QuadPart = (LONGLONG)_size;
+			if (!SetFileInformationByHandle(_h, FileEndOfFileInfo, &eof, sizeof(eof))) {
+				err = GetLastError();
+			}
+		}
+		return err;
+	}
+}
+
 File::File()
 {
 	ctorCommon();
@@ -32,16 +165,25 @@ bool File::Exists(const char* _path)
 }
 
 bool File::Read(File& file_, const char* _path)
+{
+	return ReadShared(file_, _path, 0);
+}
+
+bool File::ReadShared(File& file_, const char* _path, uint64 _maxSharedBytes)
 {
 	if (!_path) {
 		_path = file_.getPath();
 	}
 	APT_ASSERT(_path);
 
-	bool  ret      = false;
-	char* data     = nullptr;
-	DWORD err      = 0;
-	int   tryCount = 3; // avoid sharing violations, especially when loading a file after a file change notification
+	bool        ret        = false;
+	char*       data       = nullptr;
+	SharedData* shared     = nullptr;
+	DWORD       err        = 0;
+	int         tryCount   = 3; // avoid sharing violations, especially when loading a file after a file change notification
+	uint64      dataSize   = 0;
+	bool        unbuffered = false;
+	LARGE_INTEGER li;
 
  	HANDLE h = INVALID_HANDLE_VALUE;
 	do {
@@ -51,7 +193,7 @@ bool File::Read(File& file_, const char* _path)
 			FILE_SHARE_READ,
 			NULL,
 			OPEN_EXISTING,
-			FILE_ATTRIBUTE_NORMAL,
+			unbuffered ? (FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN) : FILE_ATTRIBUTE_NORMAL,
 			NULL
 			);
 		if (h == INVALID_HANDLE_VALUE) {
@@ -60,24 +202,40 @@ bool File::Read(File& file_, const char* _path)
 				APT_LOG_DBG("Sharing violation reading '%s', retrying...", _path);
 				Sleep(1);
 				--tryCount;
+				continue;
 			} else {
 				goto File_Read_end;
 			}
 		}
+
+		if (!unbuffered) {
+			if (!GetFileSizeEx(h, &li)) {
+				err = GetLastError();
+				goto File_Read_end;
+			}
+			dataSize = (uint64)li.QuadPart;
+			if (GetUnbufferedThreshold() > 0 && dataSize > GetUnbufferedThreshold()) {
+			 // reopen unbuffered
+				APT_PLATFORM_VERIFY(CloseHandle(h));
+				h = INVALID_HANDLE_VALUE;
+				unbuffered = true;
+			}
+		}
 	} while (h == INVALID_HANDLE_VALUE);
-	
-	LARGE_INTEGER li;
-	if (!GetFileSizeEx(h, &li)) {
-		err = GetLastError();
+
+	if (dataSize > (uint64)SIZE_MAX - 2) {
+		err = ERROR_FILE_TOO_LARGE;
 		goto File_Read_end;
 	}
-	DWORD dataSize = (DWORD)li.QuadPart; // ReadFile can only read DWORD bytes
-
-	data = (char*)APT_MALLOC(dataSize + 2); // +2 for null terminator
-	APT_ASSERT(data);
-	DWORD bytesRead;
-	if (!ReadFile(h, data, dataSize, &bytesRead, 0)) {
-		err = GetLastError();
+	if (_maxSharedBytes > 0 && dataSize <= _maxSharedBytes) {
+		shared = SharedData::Create(nullptr, dataSize);
+		data = shared->getData();
+	} else {
+		data = (char*)APT_MALLOC((size_t)dataSize + 2); // +2 for null terminator
+		APT_ASSERT(data);
+	}
+	err = unbuffered ? ReadUnbuffered(h, data, dataSize) : ReadChunked(h, data, dataSize);
+	if (err != 0) {
 		goto File_Read_end;
 	}
 	data[dataSize] = data[dataSize + 1] = 0;
@@ -88,17 +246,18 @@ bool File::Read(File& file_, const char* _path)
 	if ((HANDLE)file_.m_impl != INVALID_HANDLE_VALUE) {
 		APT_PLATFORM_VERIFY(CloseHandle((HANDLE)file_.m_impl));
 	}
-	if (file_.m_data) {
-		APT_FREE(file_.m_data);
-	}
+	file_.releaseData();
 	
 	file_.m_data     = data;
 	file_.m_dataSize = dataSize;
+	file_.m_shared   = shared; // file_ takes the initial reference
 	file_.setPath(_path);
 
 File_Read_end:
 	if (!ret) {
-		if (data) {
+		if (shared) {
+			SharedData::Release(shared);
+		} else if (data) {
 			APT_FREE(data);
 		}
 		APT_LOG_ERR("Error reading '%s':\n\t%s", _path, GetPlatformErrorString((uint64)err));
@@ -117,9 +276,9 @@ bool File::Write(const File& _file, const char* _path)
 	}
 	APT_ASSERT(_path);
 
-	bool  ret  = false;
-	char* data = nullptr;
-	DWORD err  = 0;
+	bool  ret        = false;
+	DWORD err        = 0;
+	bool  unbuffered = GetUnbufferedThreshold() > 0 && _file.getDataSize() > GetUnbufferedThreshold();
 	
  	HANDLE h = CreateFile(
 		_path,
@@ -127,7 +286,7 @@ bool File::Write(const File& _file, const char* _path)
 		FILE_SHARE_READ,
 		NULL,
 		CREATE_ALWAYS,
-		FILE_ATTRIBUTE_NORMAL,
+		unbuffered ? FILE_FLAG_NO_BUFFERING : FILE_ATTRIBUTE_NORMAL,
 		NULL
 		);
 	if (h == INVALID_HANDLE_VALUE) {
@@ -143,11 +302,10 @@ bool File::Write(const File& _file, const char* _path)
 		}
 	}
 
-	DWORD bytesWritten;
-	if (!WriteFile(h, _file.getData(), (DWORD)_file.getDataSize(), &bytesWritten, NULL)) {
+	err = unbuffered ? WriteUnbuffered(h, _file.getData(), _file.getDataSize()) : WriteChunked(h, _file.getData(), _file.getDataSize());
+	if (err != 0) {
 		goto File_Write_end;
 	}
-	APT_ASSERT(bytesWritten == _file.getDataSize());
 
 	ret = true;
 
@@ -160,4 +318,54 @@ File_Write_end:
 		APT_PLATFORM_VERIFY(CloseHandle(h));
 	}
 	return ret;
-}
\ No newline at end of file
+}
+
+bool File::Append(const File& _file, const char* _path)
+{
+	if (!_path) {
+		_path = _file.getPath();
+	}
+	APT_ASSERT(_path);
+
+	bool  ret = false;
+	DWORD err = 0;
+	
+ 	HANDLE h = CreateFile(
+		_path,
+		FILE_APPEND_DATA,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL
+		);
+	if (h == INVALID_HANDLE_VALUE) {
+		err = GetLastError();
+		if (err == ERROR_PATH_NOT_FOUND) {
+			if (FileSystem::CreateDir(_path)) {
+				return Append(_file, _path);
+			} else {
+				return false;
+			}
+		} else {
+			goto File_Append_end;
+		}
+	}
+
+	err = WriteChunked(h, _file.getData(), _file.getDataSize());
+	if (err != 0) {
+		goto File_Append_end;
+	}
+
+	ret = true;
+
+File_Append_end:
+	if (!ret) {
+		APT_LOG_ERR("Error appending to '%s':\n\t%s", _path, GetPlatformErrorString((uint64)err));
+		APT_ASSERT(false);
+	}
+	if (h != INVALID_HANDLE_VALUE) {
+		APT_PLATFORM_VERIFY(CloseHandle(h));
+	}
+	return ret;
+}
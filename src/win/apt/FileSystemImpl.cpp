@@ -1,5 +1,6 @@
 #include <apt/FileSystem.h>
 
+#include <apt/FileActionCoalescer.h>
 #include <apt/log.h>
 #include <apt/memory.h>
 #include <apt/platform.h>
@@ -8,10 +9,14 @@
 #include <apt/String.h>
 #include <apt/StringHash.h>
 #include <apt/TextParser.h>
+#include <apt/Time.h>
 
 #include <Shlwapi.h>
 #include <commdlg.h>
+#include <condition_variable>
 #include <cstring>
+#include <mutex>
+#include <thread>
 
 #include <EASTL/vector.h>
 #include <EASTL/vector_map.h>
@@ -87,6 +92,66 @@ GetFileDateTime_End:
 #endif
 }
 
+static bool IsDotOrDotDot(const char* _name)
+{
+	return _name[0] == '.' && (_name[1] == '\0' || (_name[1] == '.' && _name[2] == '\0'));
+}
+
+// Enumerate dir_, recursion appends to dir_ in place and restores it on return (no allocations unless dir_ outgrows its local buffer).
+static bool EnumerateImpl(PathStr& dir_, const FileSystem::EnumerateCallback& _callback, bool _recursive)
+{
+	const uint dirLength = dir_.getLength();
+	dir_.append("\\*");
+	WIN32_FIND_DATA ffd;
+	HANDLE h = FindFirstFileEx((const char*)dir_, FindExInfoBasic, &ffd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	dir_.setLength(dirLength);
+	dir_[dirLength] = '\0';
+	if (h == INVALID_HANDLE_VALUE) {
+		DWORD err = GetLastError();
+		if (err != ERROR_FILE_NOT_FOUND) {
+			APT_LOG_ERR("Enumerate (FindFirstFileEx): %s", GetPlatformErrorString(err));
+		}
+		return true;
+	}
+
+	bool ret = true;
+	FileSystem::DirEntry entry;
+	do {
+		if (IsDotOrDotDot(ffd.cFileName)) {
+			continue;
+		}
+		entry.m_dir          = (const char*)dir_; // dir_ may be reallocated by the recursion, hence reset for each entry
+		entry.m_name         = ffd.cFileName;
+		entry.m_isDir        = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		entry.m_size         = entry.m_isDir ? 0ull : (((uint64)ffd.nFileSizeHigh << 32) | (uint64)ffd.nFileSizeLow);
+		entry.m_timeModified = FileTimeToDateTime(ffd.ftLastWriteTime);
+
+		FileSystem::EnumerateAction action = _callback(entry);
+		if (action == FileSystem::EnumerateAction_Stop) {
+			ret = false;
+			break;
+		}
+		if (entry.m_isDir && _recursive && action != FileSystem::EnumerateAction_SkipDir) {
+			dir_.appendf("\\%s", ffd.cFileName);
+			ret = EnumerateImpl(dir_, _callback, _recursive);
+			dir_.setLength(dirLength);
+			dir_[dirLength] = '\0';
+			if (!ret) {
+				break;
+			}
+		}
+	} while (FindNextFile(h, &ffd) != 0);
+
+	if (ret) {
+		DWORD err = GetLastError();
+		if (err != ERROR_NO_MORE_FILES) {
+			APT_LOG_ERR("Enumerate (FindNextFile): %s", GetPlatformErrorString(err));
+		}
+	}
+	FindClose(h);
+	return ret;
+}
+
 static void GetAppPath(TCHAR ret_[MAX_PATH], const char* _append = nullptr)
 {
 	TCHAR tmp[MAX_PATH];
@@ -110,6 +175,8 @@ static void GetAppPath(TCHAR ret_[MAX_PATH], const char* _append = nullptr)
 
 bool FileSystem::Delete(const char* _path)
 {
+	FlushPathCache();
+	InvalidateContentCache(_path);
 	if (DeleteFile(_path) == 0) {
 		DWORD err = GetLastError();
 		if (err != ERROR_FILE_NOT_FOUND) {
@@ -120,6 +187,48 @@ bool FileSystem::Delete(const char* _path)
 	return true;
 }
 
+bool FileSystem::DeleteDir(const char* _path)
+{
+ // Enumerate() visits dirs before their contents, hence dirs are removed in reverse order
+	eastl::vector<PathStr> files;
+	eastl::vector<PathStr> dirs;
+	dirs.push_back(PathStr());
+	dirs.back().set(_path);
+	Enumerate(_path, [&](const DirEntry& _entry)
+		{
+			(_entry.m_isDir ? dirs : files).push_back(_entry.getPath());
+			return EnumerateAction_Continue;
+		},
+		true);
+
+	bool ret = true;
+	for (auto& file : files) {
+		ret &= Delete((const char*)file);
+	}
+	for (auto it = dirs.rbegin(); it != dirs.rend(); ++it) {
+		if (RemoveDirectory((const char*)*it) == 0) {
+			DWORD err = GetLastError();
+			if (err != ERROR_FILE_NOT_FOUND && err != ERROR_PATH_NOT_FOUND) {
+				APT_LOG_ERR("RemoveDirectory(%s): %s", (const char*)*it, GetPlatformErrorString(err));
+			}
+			ret = false;
+		}
+	}
+	return ret;
+}
+
+bool FileSystem::Rename(const char* _path, const char* _newPath)
+{
+	FlushPathCache();
+	InvalidateContentCache(_path);
+	InvalidateContentCache(_newPath);
+	if (MoveFileEx(_path, _newPath, MOVEFILE_REPLACE_EXISTING) == 0) {
+		APT_LOG_ERR("MoveFileEx(%s, %s): %s", _path, _newPath, GetPlatformErrorString(GetLastError()));
+		return false;
+	}
+	return true;
+}
+
 DateTime FileSystem::GetTimeCreated(const char* _path, RootType _rootHint)
 {
 	PathStr fullPath;
@@ -299,7 +408,7 @@ int FileSystem::PlatformSelectMulti(PathStr retList_[], int _maxResults, std::in
 	return 0;
 }
 
-int FileSystem::ListFiles(PathStr retList_[], int _maxResults, const char* _path, std::initializer_list<const char*> _filterList, bool _recursive)
+int FileSystem::ListFiles(PathStr retList_[], int _maxResults, const char* _path, const GlobSet& _filter, bool _recursive)
 {
 	eastl::vector<PathStr> dirs;
 	dirs.push_back(_path);
@@ -329,7 +438,7 @@ int FileSystem::ListFiles(PathStr retList_[], int _maxResults, const char* _path
 						dirs.back().appendf("\\%s", ffd.cFileName);
 					}
 				} else {
-					if (MatchesMulti(_filterList, (const char*)ffd.cFileName)) {
+					if (_filter.matches((const char*)ffd.cFileName)) {
 						if (ret < _maxResults) {
 							retList_[ret].setf("%s\\%s", (const char*)root, ffd.cFileName);
 						}
@@ -351,7 +460,7 @@ int FileSystem::ListFiles(PathStr retList_[], int _maxResults, const char* _path
 	return ret;
 }
 
-int FileSystem::ListDirs(PathStr retList_[], int _maxResults, const char* _path, std::initializer_list<const char*> _filterList, bool _recursive)
+int FileSystem::ListDirs(PathStr retList_[], int _maxResults, const char* _path, const GlobSet& _filter, bool _recursive)
 {
 	eastl::vector<PathStr> dirs;
 	dirs.push_back(_path);
@@ -383,7 +492,7 @@ int FileSystem::ListDirs(PathStr retList_[], int _maxResults, const char* _path,
 						dirs.push_back(root);
 						dirs.back().appendf("\\%s", ffd.cFileName);
 					}
-					if (MatchesMulti(_filterList, (const char*)ffd.cFileName)) {
+					if (_filter.matches((const char*)ffd.cFileName)) {
 						if (ret < _maxResults) {
 							retList_[ret].setf("%s\\%s", (const char*)root, ffd.cFileName);
 						}
@@ -404,13 +513,31 @@ int FileSystem::ListDirs(PathStr retList_[], int _maxResults, const char* _path,
 	return ret;
 }
 
+bool FileSystem::Enumerate(const char* _path, const EnumerateCallback& _callback, bool _recursive)
+{
+	PathStr dir;
+	dir.set(_path);
+	dir.replace('/', '\\'); // as ListFiles()
+	while (dir.getLength() > 1 && dir[dir.getLength() - 1] == '\\') {
+		dir.setLength(dir.getLength() - 1);
+		dir[dir.getLength()] = '\0';
+	}
+	return EnumerateImpl(dir, _callback, _recursive);
+}
+
+PathStr FileSystem::DirEntry::getPath() const
+{
+	return PathStr("%s\\%s", m_dir, m_name);
+}
+
 
 namespace {
 /* Notes:
 	- Changes within symbolic link subdirs don't generate events.
 	- Deleting a subdir doesn't generate events for its subtree.
-	- Duplicate 'modified' actions are received consecutively but may be split over 2 calls to DispatchNotifications(),
-	  hence store the last received action inside the watch struct (the queue gets cleared, so can't use queue.back()).
+	- Completion routines for ReadDirectoryChangesW only run on the thread which issued the request, during an alertable wait. All watches
+	  are therefore serviced by a single notification thread; Begin/EndNotifications() queue APCs to that thread and wait for them to run.
+	- Duplicate 'modified' actions are received consecutively and may be split over several completions, the coalescer merges them.
 */
 	struct Watch
 	{
@@ -419,76 +546,84 @@ namespace {
 		DWORD      m_filter     = 0;
 		UINT       m_bufSize    = 1024 * 32; // 32kb
 		BYTE*      m_buf        = NULL;
+		bool       m_pendingIo  = false;     // ReadDirectoryChangesW was issued and hasn't completed.
+		bool*      m_signal     = nullptr;   // Set by WatchBegin/WatchEnd, see Begin/EndNotifications().
 
-		eastl::pair<PathStr, FileSystem::FileAction> m_prevAction;
-		FileSystem::FileActionCallback* m_dispatchCallback;
-		eastl::vector<eastl::pair<PathStr, FileSystem::FileAction> > m_dispatchQueue;
+		PathStr                              m_dir;
+		FileActionCoalescer                  m_coalescer;
+		FileSystem::FileActionCallback*      m_dispatchCallback = nullptr;
+		FileSystem::FileActionBatchCallback* m_batchCallback    = nullptr;
 	};
-	static Pool<Watch> s_WatchPool(8);
+	static Pool<Watch>                           s_WatchPool(8);
 	static eastl::vector_map<StringHash, Watch*> s_WatchMap;
+	static std::mutex                            s_WatchMutex;        // Protects the above + the watch coalescers.
+	static std::condition_variable               s_WatchSignal;
+	static eastl::vector<Watch*>                 s_DispatchList;      // Used by DispatchNotifications().
+
+	static std::mutex                            s_NotifyThreadMutex; // Serializes Begin/EndNotifications() and hence s_NotifyThread start/stop, locked before s_WatchMutex.
+	static std::thread                           s_NotifyThread;
+	static bool                                  s_NotifyThreadExit  = false;
+	static int                                   s_ClosingWatchCount = 0; // Watches waiting for an aborted completion (the thread must not exit).
 
 	void CALLBACK WatchCompletion(DWORD _err, DWORD _bytes, LPOVERLAPPED _overlapped);
 	void          WatchUpdate(Watch* _watch);
+	void          WatchRelease(Watch* _watch);
 
 
 	void CALLBACK WatchCompletion(DWORD _err, DWORD _bytes, LPOVERLAPPED _overlapped)
 	{
-		if (_err == ERROR_OPERATION_ABORTED) { // CancellIo was called
+		Watch* watch = (Watch*)_overlapped; // m_overlapped is the first member, so this works
+		watch->m_pendingIo = false;
+
+		if (_err == ERROR_OPERATION_ABORTED) { // CancelIo was called by WatchEnd
+			std::lock_guard<std::mutex> lock(s_WatchMutex);
+			WatchRelease(watch);
+			--s_ClosingWatchCount;
 			return;
 		}
 		APT_ASSERT(_err == ERROR_SUCCESS);
-		APT_ASSERT(_bytes != 0); // overflow? notifications lost in this case?
-
-		Watch* watch = (Watch*)_overlapped; // m_overlapped is the first member, so this works
-
-		TCHAR fileName[MAX_PATH];
-		for (DWORD off = 0;;) {
-			PFILE_NOTIFY_INFORMATION info = (PFILE_NOTIFY_INFORMATION)(watch->m_buf + off);		
-			off += info->NextEntryOffset;
 
-		 // unicode -> utf8
-			int count = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof(WCHAR), fileName, MAX_PATH - 1, NULL, NULL);
-			fileName[count] = '\0';
+		if (_bytes == 0) {
+			APT_LOG_ERR("FileSystem notifications: buffer overflow, changes to '%s' were lost", (const char*)watch->m_dir);
 
-			FileSystem::FileAction action = FileSystem::FileAction_Count;
-			switch (info->Action) {
-				case FILE_ACTION_ADDED: 
-				case FILE_ACTION_RENAMED_NEW_NAME:
-					action = FileSystem::FileAction_Created; 
-					break;
-				case FILE_ACTION_REMOVED:
-				case FILE_ACTION_RENAMED_OLD_NAME:
-					action = FileSystem::FileAction_Deleted; 
-					break;
-				case FILE_ACTION_MODIFIED:
-				default:
-					action = FileSystem::FileAction_Modified;
+		} else {
+			const Timestamp now = Time::GetTimestamp();
+			std::lock_guard<std::mutex> lock(s_WatchMutex);
+			TCHAR fileName[MAX_PATH];
+			for (DWORD off = 0;;) {
+				PFILE_NOTIFY_INFORMATION info = (PFILE_NOTIFY_INFORMATION)(watch->m_buf + off);		
+				off += info->NextEntryOffset;
+
+			 // unicode -> utf8
+				int count = WideCharToMultiByte(CP_UTF8, 0, info->FileName, info->FileNameLength / sizeof(WCHAR), fileName, MAX_PATH - 1, NULL, NULL);
+				fileName[count] = '\0';
+				std::replace(fileName, fileName + count, '\\', '/');
+
+				FileSystem::FileAction action = FileSystem::FileAction_Count;
+				switch (info->Action) {
+					case FILE_ACTION_ADDED: 
+					case FILE_ACTION_RENAMED_NEW_NAME:
+						action = FileSystem::FileAction_Created; 
+						break;
+					case FILE_ACTION_REMOVED:
+					case FILE_ACTION_RENAMED_OLD_NAME:
+						action = FileSystem::FileAction_Deleted; 
+						break;
+					case FILE_ACTION_MODIFIED:
+					default:
+						action = FileSystem::FileAction_Modified;
+						break;
+				};
+				watch->m_coalescer.push(fileName, (uint)count, action, now);
+			
+				if (info->NextEntryOffset == 0) {
 					break;
-			};
-
-		 // check to see if the action was duplicated - this happens often for FILE_ACTION_MODIFIED
-			bool duplicate = false;
-			std::replace(fileName, fileName + count, '\\', '/');
-			auto& prev = watch->m_prevAction;
-			if (prev.second == action) { // action matches
-				if (prev.first.getLength() == count) { // path length matches
-					if (memcmp(prev.first.c_str(), fileName, count) == 0) { // compare the strings
-						duplicate = true;
-					}
 				}
 			}
-			if (!duplicate) {
-				watch->m_prevAction = eastl::make_pair(PathStr(fileName), action);
-				watch->m_dispatchQueue.push_back(watch->m_prevAction);
-			}
-			
-			if (info->NextEntryOffset == 0) {
-				break;
-			}
 		}
 
 	 // reissue ReadDirectoryChangesW; it seems that we don't actually miss any notifications which happen between the start of the completion routine
-	 // and the reissue, so it's safe to wait until the dispatch is done
+	 // and the reissue
 		WatchUpdate(watch);
 	}
 
@@ -504,101 +639,271 @@ namespace {
  			&_watch->m_overlapped, 
 			WatchCompletion
 			));
+		_watch->m_pendingIo = true;
 	}
-}
 
-void FileSystem::BeginNotifications(const char* _dir, FileActionCallback* _callback)
-{
-	StringHash dirHash(_dir);
-	if (s_WatchMap.find(dirHash) != s_WatchMap.end()) {
-		APT_ASSERT(false);
-		return;
+	// Close the dir handle and free the watch, s_WatchMutex must be locked.
+	void WatchRelease(Watch* _watch)
+	{
+		APT_PLATFORM_VERIFY(CloseHandle(_watch->m_hDir));
+		APT_FREE_ALIGNED(_watch->m_buf);
+		s_WatchPool.free(_watch);
 	}
 
-	CreateDirectoryA(_dir, NULL); // create if it doesn't already exist
+	// APCs, run on the notification thread.
+	void CALLBACK WatchBegin(ULONG_PTR _watch)
+	{
+		Watch* watch = (Watch*)_watch;
+		WatchUpdate(watch);
+		std::lock_guard<std::mutex> lock(s_WatchMutex);
+		*watch->m_signal = true;
+		watch->m_signal = nullptr;
+		s_WatchSignal.notify_all();
+	}
+	void CALLBACK WatchEnd(ULONG_PTR _watch)
+	{
+		Watch* watch = (Watch*)_watch;
+		std::lock_guard<std::mutex> lock(s_WatchMutex);
+		*watch->m_signal = true;
+		watch->m_signal = nullptr;
+		if (watch->m_pendingIo) {
+			APT_PLATFORM_VERIFY(CancelIo(watch->m_hDir)); // the completion routine releases the watch
+			++s_ClosingWatchCount;
+		} else {
+			WatchRelease(watch);
+		}
+		s_WatchSignal.notify_all();
+	}
+	void CALLBACK NotifyThreadWake(ULONG_PTR)
+	{
+	}
 
-	Watch* watch = s_WatchPool.alloc();
-	watch->m_hDir = CreateFileA(
-		_dir,                                                    // path
-		FILE_LIST_DIRECTORY,                                     // desired access
-		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,  // share mode
-		NULL,                                                    // security attribs
-		OPEN_EXISTING,                                           // create mode
-		FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,       // file attribs
-		NULL                                                     // template handle
-		);
-	APT_PLATFORM_ASSERT(watch->m_hDir != INVALID_HANDLE_VALUE);
-
-	s_WatchMap[dirHash] = watch;
-	watch->m_buf = (BYTE*)APT_MALLOC_ALIGNED(watch->m_bufSize, sizeof(DWORD));
-	watch->m_filter = 0
-			| FILE_NOTIFY_CHANGE_CREATION
-			| FILE_NOTIFY_CHANGE_SIZE
-			| FILE_NOTIFY_CHANGE_ATTRIBUTES 
-			| FILE_NOTIFY_CHANGE_FILE_NAME 
-			| FILE_NOTIFY_CHANGE_DIR_NAME 
-			;
-	watch->m_dispatchCallback = _callback;
-	WatchUpdate(watch);
+	// Created/deleted files invalidate the FileSystem path cache, any action invalidates the file's content cache entry.
+	void FlushCachesIfRequired(const char* _dir, const FileSystem::FileActionEvent* _events, uint _eventCount)
+	{
+		const bool contentCache = FileSystem::GetContentCacheBudget() > 0;
+		bool flushPathCache = false;
+		for (uint i = 0; i < _eventCount; ++i) {
+			flushPathCache |= _events[i].m_action != FileSystem::FileAction_Modified;
+			if (contentCache) {
+				FileSystem::InvalidateContentCache((const char*)PathStr("%s/%s", _dir, _events[i].m_path));
+			}
+		}
+		if (flushPathCache) {
+			FileSystem::FlushPathCache();
+		}
+	}
+
+	void NotifyThreadProc()
+	{
+		eastl::vector<Watch*> readyList;
+		for (;;) {
+			DWORD waitMs = INFINITE;
+			{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+				if (s_NotifyThreadExit && s_ClosingWatchCount == 0) {
+					break;
+				}
+				const Timestamp now = Time::GetTimestamp();
+				readyList.clear();
+				for (auto& it : s_WatchMap) {
+					Watch* watch = it.second;
+					if (!watch->m_batchCallback || watch->m_coalescer.isEmpty()) {
+						continue;
+					}
+					if (watch->m_coalescer.flush(now) > 0) {
+						readyList.push_back(watch);
+					}
+					if (!watch->m_coalescer.isEmpty()) {
+						DWORD readyMs = (DWORD)(watch->m_coalescer.getNextReadyTime() - now).asMilliseconds() + 1;
+						waitMs = readyMs < waitMs ? readyMs : waitMs;
+					}
+				}
+			}
+
+		 // dispatch outside the lock; watches can only be released by an APC on this thread, batches are valid until the next flush (also on this thread)
+			for (Watch* watch : readyList) {
+				const FileSystem::FileActionEvent* events = watch->m_coalescer.getBatch();
+				uint eventCount = watch->m_coalescer.getBatchSize();
+				FlushCachesIfRequired((const char*)watch->m_dir, events, eventCount);
+				watch->m_batchCallback((const char*)watch->m_dir, events, eventCount);
+			}
+
+			SleepEx(waitMs, TRUE);
+		}
+	}
+
+	// s_NotifyThreadMutex must be locked.
+	void NotifyThreadStart()
+	{
+		if (!s_NotifyThread.joinable()) {
+			s_NotifyThreadExit = false;
+			s_NotifyThread = std::thread(NotifyThreadProc);
+		}
+	}
+
+	// s_NotifyThreadMutex must be locked.
+	void NotifyThreadStop()
+	{
+		{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+			s_NotifyThreadExit = true;
+		}
+		APT_PLATFORM_VERIFY(QueueUserAPC(NotifyThreadWake, s_NotifyThread.native_handle(), 0));
+		s_NotifyThread.join();
+	}
+
+	void BeginWatch(const char* _dir, FileSystem::FileActionCallback* _callback, FileSystem::FileActionBatchCallback* _batchCallback, uint _coalesceMs)
+	{
+		std::lock_guard<std::mutex> threadLock(s_NotifyThreadMutex);
+		StringHash dirHash(_dir);
+		{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+			if (s_WatchMap.find(dirHash) != s_WatchMap.end()) {
+				APT_ASSERT(false);
+				return;
+			}
+		}
+
+		CreateDirectoryA(_dir, NULL); // create if it doesn't already exist
+		HANDLE hDir = CreateFileA(
+			_dir,                                                    // path
+			FILE_LIST_DIRECTORY,                                     // desired access
+			FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,  // share mode
+			NULL,                                                    // security attribs
+			OPEN_EXISTING,                                           // create mode
+			FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,       // file attribs
+			NULL                                                     // template handle
+			);
+		APT_PLATFORM_ASSERT(hDir != INVALID_HANDLE_VALUE);
+
+		NotifyThreadStart();
+
+		std::unique_lock<std::mutex> lock(s_WatchMutex);
+		Watch* watch = s_WatchPool.alloc();
+		watch->m_hDir = hDir;
+		watch->m_dir.set(_dir);
+		watch->m_buf = (BYTE*)APT_MALLOC_ALIGNED(watch->m_bufSize, sizeof(DWORD));
+		watch->m_filter = 0
+				| FILE_NOTIFY_CHANGE_CREATION
+				| FILE_NOTIFY_CHANGE_SIZE
+				| FILE_NOTIFY_CHANGE_ATTRIBUTES 
+				| FILE_NOTIFY_CHANGE_FILE_NAME 
+				| FILE_NOTIFY_CHANGE_DIR_NAME 
+				;
+		watch->m_dispatchCallback = _callback;
+		watch->m_batchCallback = _batchCallback;
+		watch->m_coalescer.setWindow(_batchCallback ? _coalesceMs : 0);
+		s_WatchMap[dirHash] = watch;
+
+		bool started = false;
+		watch->m_signal = &started;
+		APT_PLATFORM_VERIFY(QueueUserAPC(WatchBegin, s_NotifyThread.native_handle(), (ULONG_PTR)watch));
+		s_WatchSignal.wait(lock, [&started] { return started; });
+	}
+
+	// End any remaining watches (and hence stop the notification thread) during static deinitialization.
+	struct NotifyShutdown
+	{
+		~NotifyShutdown()
+		{
+			while (!s_WatchMap.empty()) {
+				FileSystem::EndNotifications((const char*)s_WatchMap.begin()->second->m_dir);
+			}
+		}
+	};
+	static NotifyShutdown s_NotifyShutdown;
 }
 
-void FileSystem::EndNotifications(const char* _dir)
+void FileSystem::BeginNotifications(const char* _dir, FileActionCallback* _callback)
 {
-	StringHash dirHash(_dir);
-	auto it = s_WatchMap.find(dirHash);
-	if (it == s_WatchMap.end()) {
-		APT_ASSERT(false);
-		return;
-	}
-	auto watch = it->second;
-	APT_PLATFORM_VERIFY(CancelIo(watch->m_hDir));
-	SleepEx(0, TRUE); // flush any pending calls to the completion routine
-	APT_PLATFORM_VERIFY(CloseHandle(watch->m_hDir));
-	APT_FREE_ALIGNED(watch->m_buf);
-	s_WatchPool.free(watch);
-	s_WatchMap.erase(it);
+	BeginWatch(_dir, _callback, nullptr, 0);
 }
 
-void FileSystem::DispatchNotifications(const char* _dir)
+void FileSystem::BeginNotifications(const char* _dir, FileActionBatchCallback* _callback, uint _coalesceMs)
 {
- // clear 'prevAction' - identical consecutive actions *between* calls to DispatchNotifications are allowed
-	if (_dir) {
+	BeginWatch(_dir, nullptr, _callback, _coalesceMs);
+}
+
+void FileSystem::EndNotifications(const char* _dir)
+{
+ // s_NotifyThreadMutex is held until the thread is stopped, hence a concurrent BeginNotifications() can't add a watch after the map
+ // was found to be empty, or start the thread while it's being joined
+	std::lock_guard<std::mutex> threadLock(s_NotifyThreadMutex);
+	bool stopThread = false;
+	{	std::unique_lock<std::mutex> lock(s_WatchMutex);
 		auto it = s_WatchMap.find(StringHash(_dir));
 		if (it == s_WatchMap.end()) {
 			APT_ASSERT(false);
 			return;
 		}
-		it->second->m_prevAction.second = FileAction_Count;
+		Watch* watch = it->second;
+		s_WatchMap.erase(it);
+
+		bool ended = false;
+		watch->m_signal = &ended;
+		APT_PLATFORM_VERIFY(QueueUserAPC(WatchEnd, s_NotifyThread.native_handle(), (ULONG_PTR)watch));
+		s_WatchSignal.wait(lock, [&ended] { return ended; });
+		stopThread = s_WatchMap.empty();
+	}
+	if (stopThread) {
+		NotifyThreadStop();
+	}
+}
 
-	} else {
-		for (auto& it : s_WatchMap) {
-			it.second->m_prevAction.second = FileAction_Count;
+void FileSystem::DispatchNotifications(const char* _dir)
+{
+	{	std::lock_guard<std::mutex> lock(s_WatchMutex);
+		s_DispatchList.clear();
+		if (_dir) {
+			auto it = s_WatchMap.find(StringHash(_dir));
+			if (it == s_WatchMap.end()) {
+				APT_ASSERT(false);
+				return;
+			}
+			s_DispatchList.push_back(it->second);
+		} else {
+			for (auto& it : s_WatchMap) {
+				s_DispatchList.push_back(it.second);
+			}
+		}
+		for (Watch* watch : s_DispatchList) {
+			if (watch->m_dispatchCallback) {
+				watch->m_coalescer.flush(Timestamp(), true);
+			}
 		}
 	}
 
- // let the kernel call the completion routine and fill the dispatch queues
-	SleepEx(0, TRUE);
-
- // dispatch
-	if (_dir) {
-		auto it = s_WatchMap.find(StringHash(_dir));
-		Watch& watch = *it->second;
-		for (auto& file : watch.m_dispatchQueue) {
-			watch.m_dispatchCallback(file.first.c_str(), file.second);
+ // dispatch outside the lock; watches with a FileActionCallback are only flushed here, hence the batches remain valid
+	for (Watch* watch : s_DispatchList) {
+		if (!watch->m_dispatchCallback) {
+			continue;
 		}
-		watch.m_dispatchQueue.clear();
-
-	} else {
-		for (auto& it : s_WatchMap) {
-			Watch& watch = *it.second;
-			for (auto& file : watch.m_dispatchQueue) {
-				watch.m_dispatchCallback(file.first.c_str(), file.second);
-			}
-			watch.m_dispatchQueue.clear();
+		const FileActionEvent* events = watch->m_coalescer.getBatch();
+		uint eventCount = watch->m_coalescer.getBatchSize();
+		FlushCachesIfRequired((const char*)watch->m_dir, events, eventCount);
+		for (uint i = 0; i < eventCount; ++i) {
+			watch->m_dispatchCallback(events[i].m_path, events[i].m_action);
 		}
 	}
 }
 
 // PROTECTED
 
+bool FileSystem::GetTimeModifiedIfExists(const char* _path, DateTime& ret_)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attr;
+	if (GetFileAttributesEx(_path, GetFileExInfoStandard, &attr) == 0) {
+		return false;
+	}
+	ret_ = FileTimeToDateTime(attr.ftLastWriteTime);
+	return true;
+}
+
+PathStr FileSystem::GetAbsolutePath(const char* _path)
+{
+	PathStr ret;
+	TCHAR path[MAX_PATH] = {};
+	DWORD len = GetFullPathName(_path, MAX_PATH, path, NULL);
+	ret.set((len == 0 || len >= MAX_PATH) ? _path : path); // on failure fall back to _path as-is
+	return ret;
+}
+
 const char FileSystem::s_separator = '/';
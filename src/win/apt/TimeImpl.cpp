@@ -135,6 +135,11 @@ sint32 DateTime::getMinute() const       { return (sint32)ToSystemTime(m_raw).wM
 sint32 DateTime::getSecond() const       { return (sint32)ToSystemTime(m_raw).wSecond; }
 sint32 DateTime::getMillisecond() const  { return (sint32)ToSystemTime(m_raw).wMilliseconds; }
 
+double DateTime::getSecondsSince(DateTime _since) const
+{
+	return (double)((sint64)m_raw - (sint64)_since.m_raw) / 10000000.0; // FILETIME is in 100ns intervals
+}
+
 const char* apt::DateTime::asString(const char* _format) const
 {
 	static String<128> s_buf;
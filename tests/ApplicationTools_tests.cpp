@@ -6,6 +6,12 @@
 #include <apt/platform.h>
 #include <apt/Time.h>
 
+#ifdef APT_PLATFORM_LINUX
+	#include <climits> // PATH_MAX
+	#include <cstring>
+	#include <unistd.h>
+#endif
+
 using namespace apt;
 
 TEST_CASE("adhoc")
@@ -19,5 +25,13 @@ TEST_CASE("adhoc")
 		*(++pathend) = '\0';
 		APT_PLATFORM_VERIFY(SetCurrentDirectory(buf));
 		APT_LOG("Set current directory: '%s'", buf);
+	#elif defined(APT_PLATFORM_LINUX)
+	 // as above
+		char buf[PATH_MAX] = {};
+		APT_PLATFORM_VERIFY(readlink("/proc/self/exe", buf, PATH_MAX - 1) > 0);
+		char* pathend = strrchr(buf, (int)'/');
+		*(++pathend) = '\0';
+		APT_PLATFORM_VERIFY(chdir(buf) == 0);
+		APT_LOG("Set current directory: '%s'", buf);
 	#endif
 }
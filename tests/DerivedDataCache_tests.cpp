@@ -0,0 +1,118 @@
+#include <catch.hpp>
+
+#include <apt/DerivedDataCache.h>
+#include <apt/FileSystem.h>
+#include <apt/Image.h>
+
+#include <cstring>
+
+using namespace apt;
+
+static DerivedDataCache::Key PutTestOutput(DerivedDataCache& _cache, const char* _input, const char* _output)
+{
+	DerivedDataCache::Key key = DerivedDataCache::MakeKey(_input, strlen(_input), "Test", 1);
+	File f;
+	f.setData(_output, strlen(_output));
+	REQUIRE(_cache.put(key, f));
+	return key;
+}
+
+TEST_CASE("DerivedDataCache", "[DerivedDataCache]")
+{
+	FileSystem::DeleteDir("DerivedDataCacheTest");
+	DerivedDataCache cache;
+	REQUIRE(cache.init("DerivedDataCacheTest", 64));
+	DerivedDataCache::Key a = PutTestOutput(cache, "a", "0123456789abcdef");
+	DerivedDataCache::Key b = PutTestOutput(cache, "b", "0123456789abcdef");
+
+	File f;
+	REQUIRE(cache.get(a, f));
+	REQUIRE(memcmp(f.getData(), "0123456789abcdef", 16) == 0);
+
+ // different converter version is a different key
+	DerivedDataCache::Key a2 = DerivedDataCache::MakeKey("a", 1, "Test", 2);
+	REQUIRE(!cache.exists(a2));
+
+ // entries are found by a new instance
+	DerivedDataCache::Key e;
+	{	DerivedDataCache cache2;
+		REQUIRE(cache2.init("DerivedDataCacheTest", 64));
+		REQUIRE(cache2.getEntryCount() >= 2);
+		REQUIRE(cache2.exists(b));
+		e = PutTestOutput(cache2, "e", "0123");
+	}
+
+ // outputs written by another instance exist but aren't indexed until read
+	const uint entryCount = cache.getEntryCount();
+	REQUIRE(cache.exists(e));
+	REQUIRE(cache.getEntryCount() == entryCount);
+	REQUIRE(cache.remove(e));
+
+ // least recently used entries are evicted
+	REQUIRE(cache.get(a, f));
+	PutTestOutput(cache, "c", "0123456789abcdef");
+	PutTestOutput(cache, "d", "0123456789abcdef01234567");
+	REQUIRE(cache.getSize() <= 64);
+	REQUIRE(!cache.exists(b));
+	REQUIRE(cache.exists(a));
+
+	REQUIRE(cache.remove(a));
+	REQUIRE(!cache.exists(a));
+	cache.setMaxSize(0);
+	REQUIRE(cache.getEntryCount() == 0);
+	FileSystem::DeleteDir("DerivedDataCacheTest");
+}
+
+TEST_CASE("DerivedDataCache convertImage", "[DerivedDataCache]")
+{
+	const char* kSrcPath = "DerivedDataCacheImageTest/src.png";
+	FileSystem::DeleteDir("DerivedDataCacheImageTest");
+
+	Image* src = Image::Create2d(4, 4, Image::Layout_RGBA, DataType_Uint8N);
+	char* srcData = src->getRawImage();
+	for (uint i = 0; i < src->getRawImageSize(); ++i) {
+		srcData[i] = (char)i;
+	}
+	REQUIRE(Image::Write(*src, kSrcPath));
+	Image::Destroy(src);
+
+	int convertCount = 0;
+	auto converter = [&convertCount](const Image& _src, Image& ret_)
+		{
+			++convertCount;
+			File tmp;
+			return Image::Write(_src, tmp, Image::FileFormat_Dds) && Image::Read(ret_, tmp, Image::FileFormat_Dds);
+		};
+
+	DerivedDataCache cache;
+	REQUIRE(cache.init("DerivedDataCacheImageTest/cache", 1024 * 1024));
+
+ // first call converts, subsequent calls read the output from the cache
+	Image a, b;
+	REQUIRE(cache.convertImage(a, kSrcPath, "Test", 1, converter));
+	REQUIRE(convertCount == 1);
+	REQUIRE(cache.getEntryCount() == 1);
+	REQUIRE(cache.convertImage(b, kSrcPath, "Test", 1, converter));
+	REQUIRE(convertCount == 1);
+	REQUIRE(b.getWidth() == 4);
+	REQUIRE(b.getHeight() == 4);
+	REQUIRE(b.getRawImageSize() == a.getRawImageSize());
+	REQUIRE(memcmp(b.getRawImage(), a.getRawImage(), a.getRawImageSize()) == 0);
+
+ // a new converter version reconverts
+	REQUIRE(cache.convertImage(b, kSrcPath, "Test", 2, converter));
+	REQUIRE(convertCount == 2);
+
+ // an invalid output is discarded and reconverted
+	char invalidData[256] = {}; // larger than the DDS header, no DDS magic
+	File invalid;
+	invalid.setData(invalidData, sizeof(invalidData));
+	File srcFile;
+	REQUIRE(FileSystem::Read(srcFile, kSrcPath));
+	REQUIRE(cache.put(DerivedDataCache::MakeKey(srcFile, "Test", 1), invalid));
+	REQUIRE(cache.convertImage(b, kSrcPath, "Test", 1, converter));
+	REQUIRE(convertCount == 3);
+
+	cache.setMaxSize(0);
+	FileSystem::DeleteDir("DerivedDataCacheImageTest");
+}
@@ -0,0 +1,74 @@
+#include <catch.hpp>
+
+#include <apt/FileIndex.h>
+#include <apt/FileSystem.h>
+
+#include <cstring>
+
+using namespace apt;
+
+static void WriteTestFile(const char* _path, const char* _data)
+{
+	File f;
+	f.setData(_data, strlen(_data));
+	REQUIRE(FileSystem::Write(f, _path));
+}
+
+TEST_CASE("FileIndex", "[FileIndex]")
+{
+	FileSystem::DeleteDir("FileIndexTest");
+	WriteTestFile("FileIndexTest/a.txt", "a");
+	WriteTestFile("FileIndexTest/sub/b.txt", "bb");
+	WriteTestFile("FileIndexTest/sub/deep/c.txt", "ccc");
+
+	FileIndex index;
+	REQUIRE(index.build("FileIndexTest", true));
+	REQUIRE(index.getEntryCount() == 3);
+	REQUIRE(index.exists("a.txt"));
+	REQUIRE(index.exists("sub\\deep\\c.txt"));
+	REQUIRE(!index.exists("missing.txt"));
+	REQUIRE(index.find("sub/b.txt")->m_size == 2);
+	REQUIRE(index.refresh() == 0);
+
+ // save/load
+	REQUIRE(index.save("FileIndexTest.idx"));
+	FileIndex loaded;
+	REQUIRE(loaded.load("FileIndexTest.idx"));
+	REQUIRE(loaded.getEntryCount() == 3);
+	REQUIRE(loaded.hasContentHash());
+	REQUIRE(loaded.find("a.txt")->m_contentHash == index.find("a.txt")->m_contentHash);
+
+ // corrupt tables are rejected; move a byte from the string table to the root path (header offsets 20/24) such that the file size
+ // remains valid but the last dir path is out of range
+	{	File f;
+		REQUIRE(FileSystem::Read(f, "FileIndexTest.idx"));
+		--*(uint32*)(f.getData() + 20);
+		++*(uint32*)(f.getData() + 24);
+		REQUIRE(FileSystem::Write(f, "FileIndexTest.idx"));
+		FileIndex corrupt;
+		REQUIRE(!corrupt.load("FileIndexTest.idx"));
+		REQUIRE(corrupt.getEntryCount() == 0);
+	}
+
+ // created/deleted files are found via the dir modified time
+	WriteTestFile("FileIndexTest/sub/new/d.txt", "d");
+	REQUIRE(FileSystem::Delete("FileIndexTest/a.txt"));
+	REQUIRE(loaded.refresh() == 2);
+	REQUIRE(loaded.exists("sub/new/d.txt"));
+	REQUIRE(!loaded.exists("a.txt"));
+
+ // modified files require notify() or a full rescan
+	WriteTestFile("FileIndexTest/sub/b.txt", "bbbb");
+	loaded.notify("sub/b.txt", FileSystem::FileAction_Modified);
+	REQUIRE(loaded.refresh() == 1);
+	REQUIRE(loaded.find("sub/b.txt")->m_size == 4);
+	REQUIRE(loaded.refresh(true) == 0);
+
+ // deleted subtrees are removed
+	REQUIRE(FileSystem::DeleteDir("FileIndexTest/sub"));
+	REQUIRE(loaded.refresh() == 3);
+	REQUIRE(loaded.getEntryCount() == 0);
+
+	REQUIRE(FileSystem::DeleteDir("FileIndexTest"));
+	REQUIRE(FileSystem::Delete("FileIndexTest.idx"));
+}
@@ -1,6 +1,18 @@
 #include <catch.hpp>
 
-#include <apt/Filesystem.h>
+#include <apt/File.h>
+#include <apt/FileSystem.h>
+#include <apt/FileActionCoalescer.h>
+#include <apt/Time.h>
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+#include <EASTL/vector.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
 
 using namespace apt;
 
@@ -29,3 +41,349 @@ TEST_CASE("Matches", "[FileSystem]")
 	REQUIRE(FileSystem::Matches("*Law*",   "La")       == false);
 	REQUIRE(FileSystem::Matches("*Law*",   "aw")       == false);
 }
+
+TEST_CASE("PathCache", "[FileSystem]")
+{
+	const char* kPath = "PathCacheTest.txt";
+	FileSystem::Delete(kPath);
+	File f;
+	f.setData("PathCacheTest", strlen("PathCacheTest"));
+
+ // 'not found' results aren't cached by default, a file created outside FileSystem is found
+	FileSystem::SetPathCacheEnabled(true);
+	REQUIRE(FileSystem::Exists(kPath) == false);
+	REQUIRE(File::Write(f, kPath));
+	REQUIRE(FileSystem::Exists(kPath) == true);
+	REQUIRE(FileSystem::Delete(kPath));
+
+ // 'not found' result is cached, Write() must invalidate it
+	FileSystem::SetPathCacheEnabled(true, true);
+	REQUIRE(FileSystem::Exists(kPath) == false);
+	REQUIRE(FileSystem::Write(f, kPath));
+	REQUIRE(FileSystem::Exists(kPath) == true);
+
+ // Delete() must invalidate the cached path
+	REQUIRE(FileSystem::Delete(kPath));
+	REQUIRE(FileSystem::Exists(kPath) == false);
+
+	FileSystem::SetPathCacheEnabled(false);
+}
+
+TEST_CASE("ContentCache", "[FileSystem]")
+{
+	const char* kPath = "ContentCacheTest.txt";
+	File f;
+	f.setData("ContentCacheTest", strlen("ContentCacheTest"));
+	REQUIRE(FileSystem::Write(f, kPath));
+
+	FileSystem::SetContentCache(1024);
+	File a, b;
+	REQUIRE(FileSystem::Read(a, kPath));
+	REQUIRE(FileSystem::Read(b, kPath));
+	REQUIRE(FileSystem::GetContentCacheSize() == strlen("ContentCacheTest"));
+
+ // cached data is shared until modified
+	const File& ca = a;
+	const File& cb = b;
+	REQUIRE(ca.getData() == cb.getData());
+	REQUIRE(strcmp(ca.getData(), "ContentCacheTest") == 0);
+	a.getData()[0] = 'X';
+	REQUIRE(!a.isShared());
+	REQUIRE(strcmp(cb.getData(), "ContentCacheTest") == 0);
+
+ // Write() invalidates the entry, shared data remains valid
+	f.setData("Modified", strlen("Modified"));
+	REQUIRE(FileSystem::Write(f, kPath));
+	REQUIRE(FileSystem::GetContentCacheSize() == 0);
+	REQUIRE(strcmp(cb.getData(), "ContentCacheTest") == 0);
+	REQUIRE(FileSystem::Read(a, kPath));
+	REQUIRE(strcmp(ca.getData(), "Modified") == 0);
+
+ // files which exceed the budget aren't cached
+	FileSystem::SetContentCache(4);
+	REQUIRE(FileSystem::GetContentCacheSize() == 0);
+	REQUIRE(FileSystem::Read(a, kPath));
+	REQUIRE(!a.isShared());
+
+	FileSystem::SetContentCache(0);
+	REQUIRE(FileSystem::Delete(kPath));
+
+ // Delete() via a different (but equivalent) path invalidates an entry read via a root
+	FileSystem::SetContentCache(1024);
+	PathStr appRoot = FileSystem::GetRoot(FileSystem::RootType_Application);
+	FileSystem::SetRoot(FileSystem::RootType_Application, "ContentCacheRoot");
+	f.setData("ContentCacheTest", strlen("ContentCacheTest"));
+	REQUIRE(FileSystem::Write(f, kPath));
+	REQUIRE(FileSystem::Read(a, kPath));
+	REQUIRE(FileSystem::GetContentCacheSize() == strlen("ContentCacheTest"));
+	REQUIRE(FileSystem::Delete("ContentCacheRoot/../ContentCacheRoot/ContentCacheTest.txt"));
+	REQUIRE(FileSystem::GetContentCacheSize() == 0);
+	FileSystem::SetRoot(FileSystem::RootType_Application, (const char*)appRoot);
+	FileSystem::SetContentCache(0);
+	FileSystem::DeleteDir("ContentCacheRoot");
+}
+
+TEST_CASE("Enumerate", "[FileSystem]")
+{
+	const char* kData = "Enumerate";
+	File f;
+	f.setData(kData, strlen(kData));
+	FileSystem::DeleteDir("EnumerateTest");
+	REQUIRE(FileSystem::Write(f, "EnumerateTest/a.txt"));
+	REQUIRE(FileSystem::Write(f, "EnumerateTest/b.png"));
+	REQUIRE(FileSystem::Write(f, "EnumerateTest/sub/c.txt"));
+
+	int fileCount = 0;
+	int dirCount  = 0;
+	FileSystem::Enumerate("EnumerateTest", [&](const FileSystem::DirEntry& _entry)
+		{
+			if (_entry.m_isDir) {
+				++dirCount;
+			} else {
+				++fileCount;
+				REQUIRE(_entry.m_size == strlen(kData));
+			}
+			return FileSystem::EnumerateAction_Continue;
+		},
+		true);
+	REQUIRE(fileCount == 3);
+	REQUIRE(dirCount  == 1);
+
+ // prune subtrees
+	fileCount = 0;
+	FileSystem::Enumerate("EnumerateTest", [&](const FileSystem::DirEntry& _entry)
+		{
+			if (_entry.m_isDir) {
+				return FileSystem::EnumerateAction_SkipDir;
+			}
+			++fileCount;
+			return FileSystem::EnumerateAction_Continue;
+		},
+		true);
+	REQUIRE(fileCount == 2);
+
+ // early out
+	fileCount = 0;
+	bool complete = FileSystem::Enumerate("EnumerateTest", [&](const FileSystem::DirEntry& _entry)
+		{
+			++fileCount;
+			return FileSystem::EnumerateAction_Stop;
+		},
+		true);
+	REQUIRE(complete == false);
+	REQUIRE(fileCount == 1);
+
+ // paths match ListFiles()
+	PathStr files[3];
+	REQUIRE(FileSystem::ListFiles(files, 3, "EnumerateTest", { "*" }, true) == 3);
+	FileSystem::Enumerate("EnumerateTest", [&](const FileSystem::DirEntry& _entry)
+		{
+			if (!_entry.m_isDir) {
+				REQUIRE(eastl::find(files, files + 3, _entry.getPath()) != files + 3);
+			}
+			return FileSystem::EnumerateAction_Continue;
+		},
+		true);
+
+	REQUIRE(FileSystem::DeleteDir("EnumerateTest"));
+	REQUIRE(!FileSystem::Exists("EnumerateTest/a.txt"));
+}
+
+TEST_CASE("ListFilesParallel", "[FileSystem]")
+{
+	const char* kData = "ListFilesParallel";
+	File f;
+	f.setData(kData, strlen(kData));
+	FileSystem::DeleteDir("ListFilesParallelTest");
+	for (int i = 0; i < 4; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			REQUIRE(FileSystem::Write(f, PathStr("ListFilesParallelTest/dir%d/sub%d/%d.txt", i, j, j).c_str()));
+			REQUIRE(FileSystem::Write(f, PathStr("ListFilesParallelTest/dir%d/sub%d/%d.png", i, j, j).c_str()));
+		}
+	}
+
+	eastl::vector<PathStr> files;
+	int n = FileSystem::ListFilesParallel(files, "ListFilesParallelTest", { "*.txt" }, 4, true);
+	REQUIRE(n == 16);
+	REQUIRE((int)files.size() == n);
+	for (int i = 1; i < n; ++i) {
+		REQUIRE(files[i - 1] < files[i]);
+	}
+
+ // same paths as ListFiles()
+	PathStr expected[16];
+	REQUIRE(n == FileSystem::ListFiles(expected, 16, "ListFilesParallelTest", { "*.txt" }, true));
+	eastl::sort(expected, expected + 16);
+	for (int i = 0; i < n; ++i) {
+		REQUIRE(files[i] == expected[i]);
+	}
+
+	REQUIRE(FileSystem::DeleteDir("ListFilesParallelTest"));
+}
+
+TEST_CASE("GlobSet", "[FileSystem]")
+{
+	const char* patterns[] = { "*.txt", "abc", "Law*", "*Law*", "?at", "a*b*c", "*.tar.gz", "x?y*", "*z" };
+	const char* strs[] = { "", "abc", "abcd", "file.txt", "file.txt2", ".txt", "Law", "Lawyer", "GrokLaw", "cat", "at", "aXbYc", "ac", "a.tar.gz", "xAy", "xy", "buzz" };
+	GlobSet globs;
+	for (auto& pattern : patterns) {
+		globs.add(pattern);
+	}
+	for (auto& str : strs) {
+		bool expected = false;
+		for (auto& pattern : patterns) {
+			expected |= FileSystem::Matches(pattern, str);
+		}
+		REQUIRE(globs.matches(str) == expected);
+	}
+
+	REQUIRE(GlobSet({ "*" }).matches("anything"));
+	REQUIRE(!GlobSet().matches("anything"));
+}
+
+TEST_CASE("FileActionCoalescer", "[FileSystem]")
+{
+	FileActionCoalescer coalescer;
+	coalescer.push("a.txt", 5, FileSystem::FileAction_Created,  Timestamp(1));
+	coalescer.push("a.txt", 5, FileSystem::FileAction_Modified, Timestamp(2));
+	coalescer.push("b.txt", 5, FileSystem::FileAction_Created,  Timestamp(3));
+	coalescer.push("b.txt", 5, FileSystem::FileAction_Deleted,  Timestamp(4));
+	coalescer.push("c.txt", 5, FileSystem::FileAction_Deleted,  Timestamp(5));
+	coalescer.push("c.txt", 5, FileSystem::FileAction_Created,  Timestamp(6));
+	REQUIRE(coalescer.flush(Timestamp(), true) == 2);
+	const FileSystem::FileActionEvent* events = coalescer.getBatch();
+	REQUIRE(strcmp(events[0].m_path, "a.txt") == 0);
+	REQUIRE(events[0].m_action == FileSystem::FileAction_Created);
+	REQUIRE(strcmp(events[1].m_path, "c.txt") == 0);
+	REQUIRE(events[1].m_action == FileSystem::FileAction_Modified);
+	REQUIRE(coalescer.isEmpty());
+
+ // paths are ready once the window has elapsed since their last action
+	coalescer.setWindow(1000);
+	Timestamp second(Time::GetSystemFrequency());
+	coalescer.push("x", 1, FileSystem::FileAction_Modified, Timestamp(0));
+	coalescer.push("y", 1, FileSystem::FileAction_Modified, second);
+	REQUIRE(coalescer.flush(second) == 1);
+	REQUIRE(strcmp(coalescer.getBatch()[0].m_path, "x") == 0);
+	REQUIRE(coalescer.getNextReadyTime().getRaw() == (second + second).getRaw());
+	REQUIRE(coalescer.flush(second + second) == 1);
+	REQUIRE(strcmp(coalescer.getBatch()[0].m_path, "y") == 0);
+}
+
+static eastl::vector<eastl::pair<PathStr, FileSystem::FileAction> > s_fileActions;
+static void OnFileAction(const char* _path, FileSystem::FileAction _action)
+{
+	s_fileActions.push_back(eastl::make_pair(PathStr(_path), _action));
+}
+
+// Dispatch notifications for _dir until _action is received for _path, or timeout.
+static bool WaitForFileAction(const char* _dir, const char* _path, FileSystem::FileAction _action)
+{
+	for (int i = 0; i < 500; ++i) {
+		FileSystem::DispatchNotifications(_dir);
+		for (auto& it : s_fileActions) {
+			if (it.first == _path && it.second == _action) {
+				return true;
+			}
+		}
+		Time::Sleep(10);
+	}
+	return false;
+}
+
+TEST_CASE("Notifications", "[FileSystem]")
+{
+	const char* kDir = "NotificationsTest";
+	File f;
+	f.setData("Notifications", strlen("Notifications"));
+	FileSystem::DeleteDir(kDir);
+	REQUIRE(FileSystem::CreateDir("NotificationsTest/"));
+	FileSystem::BeginNotifications(kDir, OnFileAction);
+
+	s_fileActions.clear();
+	REQUIRE(FileSystem::Write(f, "NotificationsTest/a.txt"));
+	REQUIRE(WaitForFileAction(kDir, "a.txt", FileSystem::FileAction_Created));
+
+	s_fileActions.clear();
+	REQUIRE(FileSystem::Append(f, "NotificationsTest/a.txt"));
+	REQUIRE(WaitForFileAction(kDir, "a.txt", FileSystem::FileAction_Modified));
+
+ // files in new subdirs are reported
+	s_fileActions.clear();
+	REQUIRE(FileSystem::Write(f, "NotificationsTest/sub/b.txt"));
+	REQUIRE(WaitForFileAction(kDir, "sub/b.txt", FileSystem::FileAction_Created));
+
+	s_fileActions.clear();
+	REQUIRE(FileSystem::Delete("NotificationsTest/a.txt"));
+	REQUIRE(WaitForFileAction(kDir, "a.txt", FileSystem::FileAction_Deleted));
+
+	FileSystem::EndNotifications(kDir);
+	FileSystem::DeleteDir(kDir);
+}
+
+#if APT_PLATFORM_LINUX
+static std::mutex              s_overflowMutex;
+static std::condition_variable s_overflowSignal;
+static bool                    s_overflowBlocked = false;
+static bool                    s_overflowRelease = false;
+static bool                    s_overflowLostCreated = false;
+// Block the notification thread on the first call, such that the inotify queue overflows.
+static void OnFileActionBatchBlocking(const char* _dir, const FileSystem::FileActionEvent* _events, uint _eventCount)
+{
+	std::unique_lock<std::mutex> lock(s_overflowMutex);
+	for (uint i = 0; i < _eventCount; ++i) {
+		if (strcmp(_events[i].m_path, "lost.txt") == 0 && _events[i].m_action == FileSystem::FileAction_Created) {
+			s_overflowLostCreated = true;
+		}
+	}
+	s_overflowBlocked = true;
+	s_overflowSignal.notify_all();
+	s_overflowSignal.wait(lock, [] { return s_overflowRelease; });
+}
+
+TEST_CASE("NotificationsOverflow", "[FileSystem]")
+{
+	int maxQueuedEvents = 16384;
+	if (FILE* proc = fopen("/proc/sys/fs/inotify/max_queued_events", "r")) {
+		REQUIRE(fscanf(proc, "%d", &maxQueuedEvents) == 1);
+		fclose(proc);
+	}
+	if (maxQueuedEvents > 1024 * 1024) {
+		WARN("max_queued_events is " << maxQueuedEvents << ", skipping");
+		return;
+	}
+
+	const char* kDir = "NotificationsOverflowTest";
+	File f;
+	f.setData("Overflow", strlen("Overflow"));
+	FileSystem::DeleteDir(kDir);
+	REQUIRE(FileSystem::CreateDir("NotificationsOverflowTest/"));
+	FileSystem::BeginNotifications(kDir, OnFileActionBatchBlocking, 0);
+
+	REQUIRE(File::Write(f, "NotificationsOverflowTest/block.txt"));
+	{	std::unique_lock<std::mutex> lock(s_overflowMutex);
+		REQUIRE(s_overflowSignal.wait_for(lock, std::chrono::seconds(5), [] { return s_overflowBlocked; }));
+	}
+
+ // alternate between 2 files, consecutive identical events are merged by the kernel
+	for (int i = 0; i < maxQueuedEvents + 1024; ++i) {
+		REQUIRE(File::Write(f, (i & 1) ? "NotificationsOverflowTest/a.txt" : "NotificationsOverflowTest/b.txt"));
+	}
+	REQUIRE(File::Write(f, "NotificationsOverflowTest/lost.txt")); // IN_CREATE is dropped, the rescan must recover it
+
+	{	std::unique_lock<std::mutex> lock(s_overflowMutex);
+		s_overflowRelease = true;
+		s_overflowSignal.notify_all();
+	}
+	bool lostCreated = false;
+	for (int i = 0; i < 500 && !lostCreated; ++i) {
+		Time::Sleep(10);
+		std::lock_guard<std::mutex> lock(s_overflowMutex);
+		lostCreated = s_overflowLostCreated;
+	}
+	REQUIRE(lostCreated);
+
+	FileSystem::EndNotifications(kDir);
+	FileSystem::DeleteDir(kDir);
+}
+#endif
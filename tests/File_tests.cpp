@@ -0,0 +1,72 @@
+#include <catch.hpp>
+
+#include <apt/File.h>
+#include <apt/FileSystem.h>
+#include <apt/log.h>
+#include <apt/Time.h>
+
+#include <cstring>
+
+using namespace apt;
+
+static void FillTestData(File& file_, uint64 _size)
+{
+	file_.setDataSize(_size);
+	char* data = file_.getData();
+	for (uint64 i = 0; i < _size; ++i) {
+		data[i] = (char)(i * 7 + (i >> 12));
+	}
+}
+
+TEST_CASE("Unbuffered", "[File]")
+{
+	const char* kPath = "FileUnbufferedTest.bin";
+	const uint64 kSize = 3 * 4096 + 123; // not a multiple of the sector size
+
+	File f;
+	FillTestData(f, kSize);
+	File::SetUnbufferedThreshold(1);
+	REQUIRE(File::Write(f, kPath));
+	File r;
+	REQUIRE(File::Read(r, kPath));
+	File::SetUnbufferedThreshold(0);
+
+	REQUIRE(r.getDataSize() == kSize);
+	REQUIRE(memcmp(r.getData(), f.getData(), kSize) == 0);
+	REQUIRE(r.getData()[kSize] == '\0');
+	REQUIRE(FileSystem::Delete(kPath));
+}
+
+// Write/read a file larger than 4GB, report the throughput for buffered and unbuffered access. The file is read twice, the second read
+// may be served by the system file cache in the buffered case.
+TEST_CASE("Large file throughput", "[.][File][benchmark]")
+{
+	const char* kPath = "FileLargeTest.bin";
+	const uint64 kSize = 5ull * 1024 * 1024 * 1024 + 123;
+
+	File f;
+	FillTestData(f, kSize);
+	for (int unbuffered = 0; unbuffered < 2; ++unbuffered) {
+		File::SetUnbufferedThreshold(unbuffered ? 1 : 0);
+
+		Timestamp t = Time::GetTimestamp();
+		REQUIRE(File::Write(f, kPath));
+		double writeSeconds = (Time::GetTimestamp() - t).asSeconds();
+
+		double readSeconds[2];
+		for (int i = 0; i < 2; ++i) {
+			t = Time::GetTimestamp();
+			File r;
+			REQUIRE(File::Read(r, kPath));
+			readSeconds[i] = (Time::GetTimestamp() - t).asSeconds();
+
+			REQUIRE(r.getDataSize() == kSize);
+			REQUIRE(memcmp(r.getData(), f.getData(), kSize) == 0);
+		}
+
+		const double mb = (double)kSize / (1024.0 * 1024.0);
+		APT_LOG("File (%s): write %.0f MB/s, read %.0f MB/s, re-read %.0f MB/s", unbuffered ? "unbuffered" : "buffered", mb / writeSeconds, mb / readSeconds[0], mb / readSeconds[1]);
+	}
+	File::SetUnbufferedThreshold(0);
+	REQUIRE(FileSystem::Delete(kPath));
+}
@@ -1,7 +1,20 @@
 #include <catch.hpp>
 
 #include <apt/memory.h>
+#include <apt/FileSystem.h>
 #include <apt/Json.h>
+#include <apt/JsonArena.h>
+#include <apt/JsonIndex.h>
+#include <apt/JsonLinesReader.h>
+#include <apt/JsonLinesWriter.h>
+#include <apt/JsonPatchLog.h>
+#include <apt/JsonReader.h>
+#include <apt/JsonSchema.h>
+#include <apt/JsonWriter.h>
+#include <apt/log.h>
+#include <apt/Time.h>
+
+#include <limits>
 
 using namespace apt;
 
@@ -55,6 +68,19 @@ static void _ArrayAccessTest(const char* _name, Json& _json_)
 	_macro(mat3);    \
 	_macro(mat4)
 
+static bool ReadString(Json& json_, const char* _str)
+{
+	File f;
+	f.setData(_str, strlen(_str) + 1); // include the null terminator
+	return Json::Read(json_, f);
+}
+
+static void ToString(const File& _file, eastl::vector<char>& string_)
+{
+	string_.assign(_file.getData(), _file.getData() + _file.getDataSize());
+	string_.push_back('\0');
+}
+
 TEST_CASE("ValueAccess", "[Json]")
 {
 	Json json;
@@ -67,6 +93,322 @@ TEST_CASE("ArrayAccess", "[Json]")
 	TestTypes(ArrayAccessTest);
 }
 
+TEST_CASE("ReadInsitu", "[Json]")
+{
+	const char* kSrc = "{ \"String\": \"abc\\tdef\", \"Number\": 3 }";
+	File f;
+	f.setData(kSrc, strlen(kSrc) + 1); // include the null terminator
+
+	Json json;
+	REQUIRE(Json::ReadInsitu(json, f));
+	REQUIRE(f.getData() == nullptr);
+	REQUIRE(strcmp(json.getValue<const char*>("String"), "abc\tdef") == 0);
+	REQUIRE(json.getValue<int>("Number") == 3);
+
+	f.setData("{ \"Number\": ", strlen("{ \"Number\": ") + 1);
+	REQUIRE_FALSE(Json::ReadInsitu(json, f));
+	REQUIRE(strcmp(json.getValue<const char*>("String"), "abc\tdef") == 0); // previous document is unchanged
+}
+
+TEST_CASE("Arena", "[Json]")
+{
+	JsonArena arena(0, 1024);
+	Json json(arena);
+	File f;
+	for (int i = 0; i < 3; ++i) {
+		json.clear();
+		f.setData(0, 0);
+		f.appendData("{ \"Array\": [", strlen("{ \"Array\": ["));
+		for (int j = 0; j < 100; ++j) {
+			String<64> item("%s{ \"Name\": \"item%d\", \"Value\": %d }", j ? "," : "", j, j);
+			f.appendData((const char*)item, item.getLength());
+		}
+		f.appendData("] }", strlen("] }") + 1);
+		REQUIRE(Json::Read(json, f));
+		REQUIRE(json.find("Array"));
+		REQUIRE(json.enterArray());
+		REQUIRE(json.getArrayLength() == 100);
+		json.leaveArray();
+	}
+	uint capacity = arena.getCapacity();
+	json.clear();
+	REQUIRE(arena.getSize() == 0);
+	REQUIRE(arena.getCapacity() >= capacity); // reset() grows the buffer to fit the previous document
+
+	Json json2(arena);
+	json2.setValue("Value", 1);
+	json.clear(); // arena is shared, json2 remains valid
+	REQUIRE(json2.getValue<int>("Value") == 1);
+}
+
+TEST_CASE("JsonReader", "[Json]")
+{
+	const char* kSrc =
+		"{\n"
+		"	\"Number\": 1, // comment\n"
+		"	\"Skip\": { \"Array\": [1, 2, { \"String\": \"}\" }] },\n"
+		"	\"String\": \"abc\\tdef\",\n"
+		"	\"Array\": [ 1.5, [1, 2], { \"Bool\": true }, \"str\", ],\n"
+		"}";
+	JsonReader reader;
+	REQUIRE(reader.init(kSrc, strlen(kSrc)));
+	REQUIRE(reader.find("String"));
+	REQUIRE(strcmp(reader.getValue<const char*>(), "abc\tdef") == 0);
+	REQUIRE(reader.find("Number")); // wraps around
+	REQUIRE(reader.getValue<int>() == 1);
+	REQUIRE_FALSE(reader.find("Missing"));
+
+	REQUIRE(reader.find("Array"));
+	REQUIRE(reader.enterArray());
+		REQUIRE(reader.getArrayLength() == 4);
+		REQUIRE(reader.next());
+		REQUIRE(reader.getValue<float>() == 1.5f);
+		REQUIRE(reader.next());
+		REQUIRE(reader.getType() == Json::ValueType_Array); // not entered, skipped by the next call to next()
+		REQUIRE(reader.next());
+		REQUIRE(reader.enterObject());
+			REQUIRE(reader.find("Bool"));
+			REQUIRE(reader.getValue<bool>());
+		reader.leaveObject();
+		REQUIRE(reader.next());
+		REQUIRE(strcmp(reader.getValue<const char*>(), "str") == 0);
+		REQUIRE_FALSE(reader.next());
+	reader.leaveArray();
+	REQUIRE(reader.getError() == nullptr);
+}
+
+TEST_CASE("JsonIndex", "[Json]")
+{
+	const char* kSrc =
+		"{\n"
+		"	\"Skip\": { \"Array\": [1, 2, { \"String\": \"}\\\"\" }] },\n"
+		"	\"String\": \"abc\\tdef\",\n"
+		"	\"Esc\\u0061ped\": 2,\n"
+		"	\"Array\": [ 1.5, [1, 2], { \"Bool\": true }, \"str\", ],\n"
+		"	\"Number\": 1\n"
+		"}";
+	JsonIndex index;
+	REQUIRE(index.init(kSrc, strlen(kSrc)));
+	REQUIRE(index.find("Number"));
+	REQUIRE(index.getValue<int>() == 1);
+	REQUIRE(index.find("String")); // wraps around
+	REQUIRE(strcmp(index.getValue<const char*>(), "abc\tdef") == 0);
+	REQUIRE(index.find("Escaped"));
+	REQUIRE(index.getValue<int>() == 2);
+	REQUIRE_FALSE(index.find("Missing"));
+
+	REQUIRE(index.find("Array"));
+	REQUIRE(index.enterArray());
+		REQUIRE(index.getArrayLength() == 4);
+		REQUIRE(index.next());
+		REQUIRE(index.getValue<float>() == 1.5f);
+		REQUIRE(index.next());
+		REQUIRE(index.getType() == Json::ValueType_Array);
+		REQUIRE(index.next());
+		REQUIRE(index.enterObject());
+			REQUIRE(index.find("Bool"));
+			REQUIRE(index.getValue<bool>());
+		index.leaveObject();
+	index.leaveArray(); // remaining elements aren't parsed
+
+	REQUIRE(index.find("Skip"));
+	REQUIRE(index.enterObject());
+		REQUIRE(index.find("Array"));
+		REQUIRE(index.enterArray());
+			REQUIRE(index.getArrayLength() == 3);
+		index.leaveArray();
+	index.leaveObject();
+	REQUIRE(index.getError() == nullptr);
+
+ // comments (scalar path)
+	const char* kSrcComment = "{ /* \"comment\" */ \"Number\": 1 // comment\n }";
+	REQUIRE(index.init(kSrcComment, strlen(kSrcComment)));
+	REQUIRE(index.find("Number"));
+	REQUIRE(index.getValue<int>() == 1);
+
+ // invalid structure
+	const char* kSrcInvalid = "{ \"Array\": [1, 2 }";
+	REQUIRE_FALSE(index.init(kSrcInvalid, strlen(kSrcInvalid)));
+	REQUIRE(index.getError() != nullptr);
+
+ // too large (the size is checked before the data is read)
+	REQUIRE_FALSE(index.init(kSrc, (uint64)UINT32_MAX + 1));
+	REQUIRE(index.getError() != nullptr);
+}
+
+TEST_CASE("JsonLines", "[Json]")
+{
+	const int kRecordCount = 1000;
+	JsonLinesWriter writer;
+	for (int i = 0; i < kRecordCount; ++i) {
+		Json json;
+		json.setValue("Index", i);
+		json.setValue("String", "str");
+		REQUIRE(writer.write(json));
+	}
+	Json nan;
+	nan.setValue("NaN", std::numeric_limits<double>::quiet_NaN());
+	REQUIRE_FALSE(writer.write(nan)); // not appended
+	File file;
+	REQUIRE(writer.finish(file));
+	REQUIRE(writer.getRecordCount() == kRecordCount);
+
+	JsonLinesReader reader(4, 256); // small chunks
+	for (bool ordered : { true, false }) {
+		int count = 0;
+		bool inOrder = true;
+		REQUIRE(reader.read(file, [&](Json& _json_, uint64 _offset) {
+				inOrder &= _json_.getValue<int>("Index") == count;
+				++count;
+				return file.getData()[_offset] == '{';
+			}, ordered));
+		REQUIRE(count == kRecordCount);
+		REQUIRE((inOrder || !ordered));
+	}
+
+	const char* kSrc = "{ \"Index\": 0 }\r\n\n{ \"Index\": 1 }\n{ \"Index\": }\n{ \"Index\": 3 }";
+	reader.begin(kSrc, strlen(kSrc));
+	REQUIRE(reader.next()->getValue<int>("Index") == 0);
+	REQUIRE(reader.next()->getValue<int>("Index") == 1);
+	REQUIRE(reader.next() == nullptr);
+	REQUIRE(reader.getError() != nullptr); // line 4
+	reader.end();
+}
+
+TEST_CASE("SerializeJsonReader", "[SerializerJson]")
+{
+	Json json;
+	SerializerJson jsWrite(json, SerializerJson::Mode_Write);
+	vec3 v(1.0f, 2.0f, 3.0f);
+	String<32> str("String");
+	sint32 n = -7;
+	Serialize(jsWrite, v, "Vec");
+	Serialize(jsWrite, str, "String");
+	Serialize(jsWrite, n, "Number");
+	File f;
+	REQUIRE(Json::Write(json, f));
+
+	JsonReader reader;
+	REQUIRE(reader.init(f));
+	SerializerJson jsRead(reader);
+	vec3 v2;
+	String<32> str2;
+	sint32 n2;
+	REQUIRE(Serialize(jsRead, v2, "Vec"));
+	REQUIRE(Serialize(jsRead, n2, "Number")); // out of order
+	REQUIRE(Serialize(jsRead, str2, "String"));
+	REQUIRE(v2 == v);
+	REQUIRE(str2 == str);
+	REQUIRE(n2 == n);
+}
+
+static void SerializeWriterTest(Serializer& _serializer_)
+{
+	vec3 v(1.0f, 2.0f, 3.0f);
+	String<32> str("String");
+	sint32 n = -7;
+	Serialize(_serializer_, v, "Vec");
+	Serialize(_serializer_, str, "String");
+	_serializer_.beginArray("Array");
+		for (int i = 0; i < 100; ++i) {
+			_serializer_.beginObject();
+				Serialize(_serializer_, n, "Number");
+			_serializer_.endObject();
+		}
+	_serializer_.endArray();
+}
+
+TEST_CASE("SerializeJsonWriter", "[SerializerJson]")
+{
+	Json json;
+	SerializerJson jsDom(json, SerializerJson::Mode_Write);
+	SerializeWriterTest(jsDom);
+	File domFile;
+	REQUIRE(Json::Write(json, domFile));
+
+	JsonWriter writer(true, 128); // small chunks to test chunk boundaries
+	SerializerJson jsWriter(writer);
+	SerializeWriterTest(jsWriter);
+	File writerFile;
+	REQUIRE(writer.finish(writerFile));
+
+	REQUIRE(writerFile.getDataSize() == domFile.getDataSize());
+	REQUIRE(memcmp(writerFile.getData(), domFile.getData(), domFile.getDataSize()) == 0);
+
+ // NaN/infinity can't be represented, finish() fails
+	JsonWriter nanWriter;
+	nanWriter.setValue("NaN", std::numeric_limits<float64>::quiet_NaN());
+	File nanFile;
+	REQUIRE_FALSE(nanWriter.finish(nanFile));
+}
+
+TEST_CASE("MemberIndex", "[Json]")
+{
+	static const int kCount = 1000;
+	static String<16> s_names[kCount]; // names passed to setValue() must outlive the Json
+	Json json;
+	json.setMemberIndexThreshold(16);
+	for (int i = 0; i < kCount; ++i) {
+		s_names[i].setf("Member%d", i);
+		json.setValue((const char*)s_names[i], i);
+	}
+	for (int i = kCount - 1; i >= 0; --i) { // reverse order, uses the index
+		REQUIRE(json.find((const char*)s_names[i]));
+		REQUIRE(json.getValue<int>() == i);
+	}
+	for (int i = 0; i < kCount; ++i) { // in order
+		REQUIRE(json.find(StringHash((const char*)s_names[i])));
+		REQUIRE(json.getValue<int>() == i);
+	}
+	REQUIRE_FALSE(json.find("Missing"));
+	REQUIRE_FALSE(json.find(StringHash("Missing")));
+
+ // removing and adding members (same member count) invalidates the index
+	Json patch;
+	REQUIRE(ReadString(patch, "[ { \"op\": \"remove\", \"path\": \"/Member500\" }, { \"op\": \"add\", \"path\": \"/Added\", \"value\": -1 } ]"));
+	REQUIRE(Json::ApplyPatch(json, patch));
+	REQUIRE_FALSE(json.find("Member500"));
+	REQUIRE(json.find("Added"));
+	REQUIRE(json.getValue<int>() == -1);
+	REQUIRE(json.find("Member999"));
+	REQUIRE(json.getValue<int>() == 999);
+}
+
+TEST_CASE("BulkArrayAccess", "[Json]")
+{
+	const float kValues[5] = { 1.5f, 2.5f, -3.0f, 4.25f, 5.0f };
+	Json json;
+	json.beginArray("Values");
+		json.pushValues(kValues, 5);
+		json.pushValue(6.0f);
+	json.endArray();
+
+	float values[8] = {};
+	REQUIRE(json.find("Values"));
+	REQUIRE(json.getValues(values, 8) == 6);
+	REQUIRE(memcmp(values, kValues, sizeof(kValues)) == 0);
+	REQUIRE(values[5] == 6.0f);
+	REQUIRE(json.getValues(values, 8, 4) == 2);
+	REQUIRE(values[0] == 5.0f);
+	REQUIRE(json.getValues(values, 8, 6) == 0);
+	sint32 ints[8] = {};
+	REQUIRE(json.getValues(ints, 8) == 0); // not integers
+
+	{	SerializerJson js(json, SerializerJson::Mode_Write);
+		sint32 in[4] = { -1, 2, -3, 4 };
+		REQUIRE(js.value(in, 4, "Ints"));
+	}
+	{	SerializerJson js(json, SerializerJson::Mode_Read);
+		sint32 out[4] = {};
+		REQUIRE(js.value(out, 4, "Ints"));
+		REQUIRE((out[0] == -1 && out[1] == 2 && out[2] == -3 && out[3] == 4));
+		REQUIRE_FALSE(js.value(out, 3, "Ints")); // length mismatch
+		uint32 outu[4] = {};
+		REQUIRE_FALSE(js.value(outu, 4, "Ints")); // element 0 is negative
+		REQUIRE(strstr(js.getError(), "element 0") != nullptr);
+	}
+}
+
 TEST_CASE("ArrayOfArray", "[SerializerJson]")
 {
 	Json json;
@@ -128,6 +470,417 @@ TEST_CASE("Binary", "[SerializerJson]")
 	
 	REQUIRE(dataSize == kSrcDataSize);
 	REQUIRE(memcmp(data, kSrcData, dataSize) == 0);
+	APT_FREE(data);
+
+ // compressed, decode into an existing buffer
+	js.setMode(SerializerJson::Mode_Write);
+	data = (void*)kSrcData;
+	js.binary(data, dataSize, "BinaryTestCompressed", CompressionFlags_Speed);
+	js.setMode(SerializerJson::Mode_Read);
+	char buf[512] = {};
+	data = buf;
+	REQUIRE(js.binary(data, dataSize, "BinaryTestCompressed"));
+	REQUIRE(memcmp(buf, kSrcData, dataSize) == 0);
+	dataSize = kSrcDataSize - 1;
+	REQUIRE_FALSE(js.binary(data, dataSize, "BinaryTestCompressed")); // size mismatch
+
+ // invalid data
+	json.setValue("BinaryTestInvalid", "0TWFu!ZGlz");
+	data = nullptr;
+	REQUIRE_FALSE(js.binary(data, dataSize, "BinaryTestInvalid"));
+
+ // text can't produce raw binary data
+	Json text;
+	REQUIRE(ReadString(text, "{ \"Null\": \"\\u00000TWFu\", \"Object\": { \"binary\": \"0TWFu\" } }"));
+	SerializerJson jsText(text, SerializerJson::Mode_Read);
+	data = nullptr;
+	REQUIRE_FALSE(jsText.binary(data, dataSize, "Null"));
+	REQUIRE_FALSE(jsText.binary(data, dataSize, "Object"));
+	File textOut;
+	REQUIRE(Json::Write(text, textOut, Json::WriteFlags_None));
+	eastl::vector<char> str;
+	ToString(textOut, str);
+	REQUIRE(strstr(str.data(), "\"Object\":{\"binary\":\"0TWFu\"}") != nullptr);
+
+ // binary values are diffed as a whole
+	Json json2;
+	SerializerJson js2(json2, SerializerJson::Mode_Write);
+	data = (void*)kSrcData;
+	dataSize = kSrcDataSize - 1;
+	js2.binary(data, dataSize, "BinaryTest");
+	Json patch;
+	Json::Diff(json, json2, patch);
+	REQUIRE(patch.getArrayLength() == 3); // 2 removed, 1 replaced
+	REQUIRE(Json::ApplyPatch(json, patch));
+	js.setMode(SerializerJson::Mode_Read);
+	data = nullptr;
+	REQUIRE(js.binary(data, dataSize, "BinaryTest"));
+	REQUIRE(dataSize == kSrcDataSize - 1);
+	APT_FREE(data);
+}
+
+TEST_CASE("CborRoundTrip", "[Json]")
+{
+	const char* kSrc = "{ \"Int\": -2, \"Float\": 0.1, \"String\": \"str\", \"Bool\": true, \"Null\": null, \"Uint8s\": [1, 2, 3, 255], \"Sint32s\": [-1, 2, -3, 70000], \"Floats\": [0.5, 1.5, 2.5, 3.5], \"Mixed\": [1, \"x\", 2, 3], \"Object\": { \"Array\": [ [1], [] ] } }";
+	Json json;
+	File f;
+	f.setData(kSrc, strlen(kSrc) + 1);
+	REQUIRE(Json::Read(json, f));
+
+	uint8 blob[256];
+	for (int i = 0; i < 256; ++i) {
+		blob[i] = (uint8)i;
+	}
+	SerializerJson js(json, SerializerJson::Mode_Write);
+	void* data = blob;
+	uint dataSize = sizeof(blob);
+	REQUIRE(js.binary(data, dataSize, "Binary"));
+
+	File text0, text1, cbor;
+	REQUIRE(Json::Write(json, text0));
+	REQUIRE(Json::WriteBinary(json, cbor));
+	REQUIRE(cbor.getDataSize() < text0.getDataSize());
+
+	Json json2;
+	REQUIRE(Json::ReadBinary(json2, cbor));
+	REQUIRE(Json::Write(json2, text1));
+	REQUIRE(text0.getDataSize() == text1.getDataSize());
+	REQUIRE(memcmp(text0.getData(), text1.getData(), text0.getDataSize()) == 0);
+	REQUIRE(json2.getValue<float64>("Float") == 0.1);
+
+ // doubles outside the float32 range
+	json.setValue("Large", 1e300);
+	Json json3;
+	REQUIRE(Json::WriteBinary(json, cbor));
+	REQUIRE(Json::ReadBinary(json3, cbor));
+	REQUIRE(json3.getValue<float64>("Large") == 1e300);
+
+	SerializerJson js2(json2, SerializerJson::Mode_Read);
+	uint8 out[256] = {};
+	data = out;
+	REQUIRE(js2.binary(data, dataSize, "Binary"));
+	REQUIRE(memcmp(out, blob, sizeof(blob)) == 0);
+
+ // truncated data
+	File truncated;
+	truncated.setData(cbor.getData(), cbor.getDataSize() / 2);
+	REQUIRE_FALSE(Json::ReadBinary(json2, truncated));
+}
+
+static bool Equals(const Json& _a, const Json& _b)
+{
+	Json patch;
+	Json::Diff(_a, _b, patch);
+	return patch.getArrayLength() == 0;
+}
+
+TEST_CASE("JsonPatch", "[Json]")
+{
+	const char* kFrom = "{ \"Name\": \"a\", \"Removed\": 1, \"Array\": [1, 2, 3, 4, 5], \"Object\": { \"x\": 1, \"y/z\": [true], \"a~b\": null }, \"Same\": { \"Deep\": [ { \"k\": 1 } ] } }";
+	const char* kTo   = "{ \"Same\": { \"Deep\": [ { \"k\": 1 } ] }, \"Name\": \"b\", \"Array\": [1, 9, 3, 5, 6, 7], \"Object\": { \"x\": 1.0, \"y/z\": [false], \"a~b\": null, \"New\": { \"n\": [] } }, \"Added\": \"str\" }";
+	Json from, to;
+	REQUIRE(ReadString(from, kFrom));
+	REQUIRE(ReadString(to, kTo));
+	REQUIRE_FALSE(Equals(from, to));
+
+	SECTION("Diff")
+	{
+		Json patch;
+		Json::Diff(from, to, patch);
+		bool escaped = false;
+		while (patch.next()) {
+			patch.enterObject();
+			const char* path = patch.getValue<const char*>("path");
+			REQUIRE(strncmp(path, "/Same", 5) != 0);     // identical subtree
+			REQUIRE(strcmp(path, "/Object/x") != 0);     // 1 == 1.0
+			escaped |= strcmp(path, "/Object/y~1z/0") == 0;
+			patch.leaveObject();
+		}
+		REQUIRE(escaped);
+
+		REQUIRE(Json::ApplyPatch(from, patch));
+		REQUIRE(Equals(from, to));
+		REQUIRE(from.getValue<int>("Array", 5) == 7);
+	}
+
+	SECTION("ApplyPatch")
+	{
+		Json patch;
+		REQUIRE(ReadString(patch, "["
+			"{ \"op\": \"test\",    \"path\": \"/Name\", \"value\": \"a\" },"
+			"{ \"op\": \"copy\",    \"from\": \"/Object/x\", \"path\": \"/Copied\" },"
+			"{ \"op\": \"move\",    \"from\": \"/Array/0\", \"path\": \"/Array/-\" },"
+			"{ \"op\": \"add\",     \"path\": \"/Array/0\", \"value\": 0 },"
+			"{ \"op\": \"remove\",  \"path\": \"/Object/a~0b\" },"
+			"{ \"op\": \"replace\", \"path\": \"/Name\", \"value\": \"c\" }"
+			"]"));
+		REQUIRE(Json::ApplyPatch(from, patch));
+		REQUIRE(from.getValue<int>("Copied") == 1);
+		const int kArray[] = { 0, 2, 3, 4, 5, 1 };
+		for (int i = 0; i < 6; ++i) {
+			REQUIRE(from.getValue<int>("Array", i) == kArray[i]);
+		}
+		REQUIRE(strcmp(from.getValue<const char*>("Name"), "c") == 0);
+		from.find("Object");
+		from.enterObject();
+		REQUIRE_FALSE(from.find("a~b"));
+		from.leaveObject();
+
+		const char* kInvalid[] = {
+			"[{ \"op\": \"test\",   \"path\": \"/Name\", \"value\": \"a\" }]",
+			"[{ \"op\": \"move\",   \"from\": \"/Object\", \"path\": \"/Object/x\" }]",
+			"[{ \"op\": \"remove\", \"path\": \"/Missing\" }]",
+			"[{ \"op\": \"add\",    \"path\": \"/Array/7\", \"value\": 0 }]",
+			"[{ \"op\": \"add\",    \"path\": \"Name\", \"value\": 0 }]",
+		};
+		for (const char* src : kInvalid) {
+			REQUIRE(ReadString(patch, src));
+			REQUIRE_FALSE(Json::ApplyPatch(from, patch));
+		}
+	}
+}
+
+TEST_CASE("JsonPatchLog", "[Json]")
+{
+	const char* kPath = "JsonPatchLogTest.json";
+	FileSystem::Delete(kPath);
+
+	String<32> names[100]; // member names aren't copied
+	Json json;
+	for (int i = 0; i < 100; ++i) {
+		names[i].setf("Value%d", i);
+		json.setValue((const char*)names[i], i);
+	}
+	JsonPatchLog log;
+	REQUIRE(log.save(json, kPath)); // snapshot
+	json.setValue("Value7", -7);
+	REQUIRE(log.save(json, kPath));
+	json.setValue("Added", "str");
+	REQUIRE(log.save(json, kPath));
+	REQUIRE(log.save(json, kPath)); // no changes, nothing written
+	REQUIRE(log.getPatchCount() == 2);
+
+	Json loaded;
+	JsonPatchLog log2;
+	REQUIRE(log2.load(loaded, kPath));
+	REQUIRE(log2.getPatchCount() == 2);
+	REQUIRE(Equals(loaded, json));
+
+ // incomplete last line is removed, subsequent patches are appended after the last complete line
+	File f;
+	f.setData("[{\"op\":", strlen("[{\"op\":"));
+	REQUIRE(FileSystem::Append(f, kPath));
+	REQUIRE(log2.load(loaded, kPath));
+	REQUIRE(Equals(loaded, json));
+	json.setValue("Value8", -8);
+	REQUIRE(log2.save(json, kPath));
+	REQUIRE(log.load(loaded, kPath));
+	REQUIRE(log.getPatchCount() == 3);
+	REQUIRE(Equals(loaded, json));
+	REQUIRE_FALSE(FileSystem::Exists("JsonPatchLogTest.json.tmp"));
+
+ // a snapshot is written once the patches exceed the snapshot size
+	for (int i = 0; i < 100; ++i) {
+		json.setValue("Value0", i * 1000);
+		REQUIRE(log2.save(json, kPath));
+	}
+	REQUIRE(log2.getPatchCount() < 100);
+	REQUIRE(log.load(loaded, kPath));
+	REQUIRE(Equals(loaded, json));
+
+	REQUIRE(log.compact());
+	REQUIRE(log.getPatchCount() == 0);
+	REQUIRE(log2.load(loaded, kPath));
+	REQUIRE(log2.getPatchCount() == 0);
+	REQUIRE(Equals(loaded, json));
+
+	FileSystem::Delete(kPath);
+}
+
+static String<256> s_lastError;
+static void CaptureLogError(const char* _msg, LogType _type)
+{
+	if (_type == LogType_Error) {
+		s_lastError.set(_msg);
+	}
+}
+
+TEST_CASE("JsonSchema", "[Json]")
+{
+	const char* kSchema  = "{ \"type\": \"object\", \"required\": [\"Items\"], \"properties\": { \"Items\": { \"type\": \"array\", \"items\": { \"type\": \"object\", \"required\": [\"Name\"], \"properties\": { \"Name\": { \"type\": \"string\" }, \"Value\": { \"type\": \"number\", \"minimum\": 0 } } } } } }";
+	const char* kValid   = "{ \"Items\": [ { \"Name\": \"a\", \"Value\": 1 }, { \"Name\": \"b\" } ] }";
+	const char* kInvalid = "{ \"Items\": [ { \"Name\": \"a\", \"Value\": 1 }, { \"Name\": \"c\", \"Value\": -1 } ] }";
+
+	LogCallback* logCallback = GetLogCallback();
+	SetLogCallback(CaptureLogError);
+
+	SECTION("Read")
+	{
+		JsonSchema schema;
+		File f;
+		f.setData(kSchema, strlen(kSchema) + 1);
+		REQUIRE(schema.init(f));
+
+		Json json;
+		f.setData(kValid, strlen(kValid) + 1);
+		REQUIRE(Json::Read(json, f, &schema));
+		REQUIRE(Json::Validate(json, schema));
+
+	 // errors report the Json pointer to the invalid value, the previous document is unchanged
+		f.setData(kInvalid, strlen(kInvalid) + 1);
+		REQUIRE_FALSE(Json::Read(json, f, &schema));
+		REQUIRE(strstr((const char*)s_lastError, "'minimum' failed at '/Items/1/Value'") != nullptr);
+		json.find("Items");
+		json.enterArray();
+		json.next();
+		json.next();
+		json.enterObject();
+		REQUIRE(strcmp(json.getValue<const char*>("Name"), "b") == 0);
+		json.leaveObject();
+		json.leaveArray();
+
+		s_lastError.clear();
+		REQUIRE_FALSE(Json::ReadInsitu(json, f, &schema));
+		REQUIRE(f.getData() != nullptr); // ownership isn't taken on failure
+		REQUIRE(!s_lastError.isEmpty());
+
+		f.setData(kInvalid, strlen(kInvalid) + 1); // the data was modified by ReadInsitu()
+		REQUIRE(Json::Read(json, f)); // no schema
+		REQUIRE_FALSE(Json::Validate(json, schema));
+		REQUIRE(strstr((const char*)s_lastError, "/Items/1/Value") != nullptr);
+
+		f.setData(kValid, strlen(kValid) + 1);
+		REQUIRE(Json::ReadInsitu(json, f, &schema));
+		REQUIRE(f.getData() == nullptr);
+	}
+
+	SECTION("Find")
+	{
+		const char* kPath       = "JsonSchemaTest.json";
+		const char* kRemotePath = "JsonSchemaRemoteTest.json";
+		const char* kRemote     = "{ \"type\": \"object\", \"properties\": { \"List\": { \"$ref\": \"JsonSchemaTest.json#/properties/Items\" } } }";
+		File f;
+		f.setData(kSchema, strlen(kSchema));
+		REQUIRE(FileSystem::Write(f, kPath));
+		f.setData(kRemote, strlen(kRemote));
+		REQUIRE(FileSystem::Write(f, kRemotePath));
+
+		const JsonSchema* schema = JsonSchema::Find(kPath);
+		REQUIRE(schema != nullptr);
+		REQUIRE(JsonSchema::Find(kPath) == schema); // cached
+		REQUIRE(JsonSchema::Find("JsonSchemaMissing.json") == nullptr);
+
+		const JsonSchema* remote = JsonSchema::Find(kRemotePath);
+		REQUIRE(remote != nullptr);
+		Json json;
+		const char* kRemoteValid   = "{ \"List\": [ { \"Name\": \"a\" } ] }";
+		const char* kRemoteInvalid = "{ \"List\": [ { \"Value\": 1 } ] }";
+		f.setData(kRemoteValid, strlen(kRemoteValid) + 1);
+		REQUIRE(Json::Read(json, f, remote));
+		f.setData(kRemoteInvalid, strlen(kRemoteInvalid) + 1);
+		REQUIRE_FALSE(Json::Read(json, f, remote));
+		REQUIRE(strstr((const char*)s_lastError, "'required' failed at '/List/0'") != nullptr);
+
+		JsonSchema::ClearCache();
+		FileSystem::Delete(kPath);
+		FileSystem::Delete(kRemotePath);
+	}
+
+	SetLogCallback(logCallback);
+}
+
+TEST_CASE("WriteFlags", "[Json]")
+{
+	const char* kSrc = "{ \"Int\": -2, \"Double\": 0.1, \"Large\": 1e300, \"String\": \"a b\", \"Array\": [1, 2.5, [true, null]], \"Object\": { \"x\": 1 } }";
+	Json json;
+	REQUIRE(ReadString(json, kSrc));
+	json.setValue("Float", 0.1f);
+
+	File pretty, compact, compactFloat32;
+	eastl::vector<char> str;
+	REQUIRE(Json::Write(json, pretty));
+	REQUIRE(Json::Write(json, compact, Json::WriteFlags_None));
+	REQUIRE(Json::Write(json, compactFloat32, Json::WriteFlags_Float32));
+	REQUIRE(compact.getDataSize() < pretty.getDataSize());
+	ToString(compact, str);
+	REQUIRE(strpbrk(str.data(), " \t\n") == strstr(str.data(), "a b") + 1); // the only whitespace is inside the string value
+	REQUIRE(strstr(str.data(), "\"Float\":0.10000000149011612") != nullptr);
+	ToString(compactFloat32, str);
+	REQUIRE(strstr(str.data(), "\"Float\":0.1}") != nullptr);
+	REQUIRE(strstr(str.data(), "\"Large\":1e300") != nullptr); // outside float32 range
+
+	Json json2;
+	REQUIRE(ReadString(json2, str.data()));
+	REQUIRE(json2.getValue<float32>("Float") == 0.1f);
+	REQUIRE(json2.getValue<float64>("Double") == 0.1);
+	ToString(compact, str);
+	REQUIRE(ReadString(json2, str.data()));
+	REQUIRE(Equals(json, json2));
+	REQUIRE(json2.getValue<int>("Int") == -2);
+
+ // streamed output matches the File output regardless of the chunk size
+	for (uint32 flags : { (uint32)Json::WriteFlags_Default, (uint32)Json::WriteFlags_None }) {
+		File expected;
+		REQUIRE(Json::Write(json, expected, flags));
+		str.clear();
+		uint maxChunk = 0;
+		REQUIRE(Json::Write(json, [&](const char* _data, uint _size) {
+				str.insert(str.end(), _data, _data + _size);
+				maxChunk = APT_MAX(maxChunk, _size);
+				return true;
+			}, flags, 64));
+		REQUIRE(maxChunk == 64);
+		REQUIRE(str.size() == expected.getDataSize());
+		REQUIRE(memcmp(str.data(), expected.getData(), str.size()) == 0);
+	}
+	REQUIRE_FALSE(Json::Write(json, [](const char*, uint) { return false; }));
+
+ // NaN/infinity can't be written
+	json.setValue("NaN", std::numeric_limits<float64>::quiet_NaN());
+	REQUIRE_FALSE(Json::Write(json, compact, Json::WriteFlags_None));
+	REQUIRE_FALSE(Json::Write(json, compact, Json::WriteFlags_Float32));
+}
+
+TEST_CASE("Json write throughput", "[.][Json][benchmark]")
+{
+	const int kItemCount = 200000;
+	Json json;
+	json.beginArray("Items");
+	for (int i = 0; i < kItemCount; ++i) {
+		const float32 position[] = { i * 0.1f, i * -0.37f, 1.0f / (i + 1) };
+		json.beginObject();
+			json.setValue("Name", "item");
+			json.setValue("Index", i);
+			json.setValue("Weight", i * 0.01);
+			json.beginArray("Position");
+				json.pushValues(position, 3);
+			json.endArray();
+		json.endObject();
+	}
+	json.endArray();
+
+	const struct { uint32 flags; const char* name; } kModes[] =
+	{
+		{ Json::WriteFlags_Pretty,                           "pretty"           },
+		{ Json::WriteFlags_None,                             "compact"          },
+		{ Json::WriteFlags_Pretty | Json::WriteFlags_Float32, "pretty, float32"  },
+		{ Json::WriteFlags_Float32,                          "compact, float32" },
+	};
+	for (auto& mode : kModes) {
+		Timestamp t = Time::GetTimestamp();
+		File f;
+		REQUIRE(Json::Write(json, f, mode.flags));
+		double writeSeconds = (Time::GetTimestamp() - t).asSeconds();
+
+		uint64 streamedSize = 0;
+		t = Time::GetTimestamp();
+		REQUIRE(Json::Write(json, [&](const char* _data, uint _size) { streamedSize += _size; return true; }, mode.flags));
+		double streamSeconds = (Time::GetTimestamp() - t).asSeconds();
+		REQUIRE(streamedSize == f.getDataSize());
+
+		const double mb = (double)f.getDataSize() / (1024.0 * 1024.0);
+		APT_LOG("Json::Write (%s): %.1f MB, write %.0f ms (%.0f MB/s), stream %.0f ms (%.0f MB/s)", mode.name, mb, writeSeconds * 1000.0, mb / writeSeconds, streamSeconds * 1000.0, mb / streamSeconds);
+	}
 }
 
 TEST_CASE("Enum", "[SerializerJson]")
@@ -0,0 +1,220 @@
+#include <catch.hpp>
+
+#include <apt/memory.h>
+#include <apt/File.h>
+#include <apt/Json.h>
+#include <apt/JsonReader.h>
+#include <apt/JsonWriter.h>
+#include <apt/Reflect.h>
+#include <apt/SerializerBinary.h>
+#include <apt/StringHash.h>
+
+#include <cstring>
+
+using namespace apt;
+
+struct ReflectChild
+{
+	sint32     m_id;
+	String<16> m_tag;
+};
+
+struct ReflectParent
+{
+	vec3                         m_position;
+	float32                      m_mass;
+	uint32                       m_flags[4];
+	ReflectChild                 m_pair[2];
+	eastl::vector<float32>       m_weights;
+	eastl::vector<ReflectChild>  m_children;
+};
+
+APT_REFLECT_BEGIN(ReflectChild)
+	APT_REFLECT_FIELD_NAMED(m_id,  "Id")
+	APT_REFLECT_FIELD_NAMED(m_tag, "Tag")
+APT_REFLECT_END()
+
+APT_REFLECT_BEGIN(ReflectParent)
+	APT_REFLECT_FIELD_NAMED(m_position, "Position")
+	APT_REFLECT_FIELD_NAMED(m_mass,     "Mass")
+	APT_REFLECT_FIELD(m_flags)
+	APT_REFLECT_FIELD_NAMED(m_pair,     "Pair")
+	APT_REFLECT_FIELD_NAMED(m_weights,  "Weights")
+	APT_REFLECT_FIELD_NAMED(m_children, "Children")
+APT_REFLECT_END()
+
+static ReflectParent MakeReflectParent(int _i)
+{
+	ReflectParent ret;
+	ret.m_position = vec3((float32)_i, 2.0f, 3.0f);
+	ret.m_mass = (float32)_i * 0.5f;
+	for (int i = 0; i < 4; ++i) {
+		ret.m_flags[i] = (uint32)(_i + i);
+	}
+	for (int i = 0; i < 2; ++i) {
+		ret.m_pair[i].m_id = i;
+		ret.m_pair[i].m_tag.setf("pair%d", i);
+	}
+	for (int i = 0; i < _i % 5; ++i) {
+		ret.m_weights.push_back((float32)i * 0.25f);
+	}
+	for (int i = 0; i < _i % 3; ++i) {
+		ReflectChild child;
+		child.m_id = _i * 10 + i;
+		child.m_tag.setf("child%d", i);
+		ret.m_children.push_back(child);
+	}
+	return ret;
+}
+
+static bool operator==(const ReflectChild& _a, const ReflectChild& _b)
+{
+	return _a.m_id == _b.m_id && _a.m_tag == _b.m_tag;
+}
+
+static bool operator==(const ReflectParent& _a, const ReflectParent& _b)
+{
+	return _a.m_position == _b.m_position
+		&& _a.m_mass == _b.m_mass
+		&& memcmp(_a.m_flags, _b.m_flags, sizeof(_a.m_flags)) == 0
+		&& _a.m_pair[0] == _b.m_pair[0]
+		&& _a.m_pair[1] == _b.m_pair[1]
+		&& _a.m_weights == _b.m_weights
+		&& _a.m_children == _b.m_children
+		;
+}
+
+static bool ReadJsonString(Json& json_, const char* _str)
+{
+	File f;
+	f.setData(_str, strlen(_str) + 1); // include the null terminator
+	return Json::Read(json_, f);
+}
+
+TEST_CASE("ReflectNameHash", "[Reflect]")
+{
+	REQUIRE(internal::HashStringConst64("Position") == StringHash("Position").getHash());
+	REQUIRE(internal::HashStringConst64("") == HashString<uint64>(""));
+	REQUIRE(internal::HashStringConst64("\xe9t\xe9") == HashString<uint64>("\xe9t\xe9"));
+}
+
+TEST_CASE("ReflectRoundTrip", "[Reflect]")
+{
+	eastl::vector<ReflectParent> in;
+	for (int i = 0; i < 20; ++i) {
+		in.push_back(MakeReflectParent(i));
+	}
+
+	SECTION("SerializerJson")
+	{
+		Json json;
+		SerializerJson writer(json, SerializerJson::Mode_Write);
+		REQUIRE(Serialize(writer, in, "Parents"));
+
+	 // reflected fields are regular members
+		REQUIRE(json.find("Parents"));
+		json.enterArray();
+		REQUIRE(json.next());
+		json.enterObject();
+		REQUIRE(json.find("m_flags"));
+		REQUIRE(json.getType() == Json::ValueType_Array);
+		REQUIRE(json.find("Mass"));
+		REQUIRE(json.getValue<float32>() == in[0].m_mass);
+		json.leaveObject();
+		json.leaveArray();
+
+		SerializerJson reader(json, SerializerJson::Mode_Read);
+		eastl::vector<ReflectParent> out;
+		REQUIRE(Serialize(reader, out, "Parents"));
+		REQUIRE(out == in);
+
+	 // via the base class
+		SerializerJson baseReader(json, SerializerJson::Mode_Read);
+		out.clear();
+		REQUIRE(Serialize((Serializer&)baseReader, out, "Parents"));
+		REQUIRE(out == in);
+	}
+
+	SECTION("JsonWriter")
+	{
+		JsonWriter jsonWriter;
+		SerializerJson writer(jsonWriter);
+		REQUIRE(Serialize(writer, in, "Parents"));
+		File file;
+		REQUIRE(jsonWriter.finish(file));
+
+		JsonReader jsonReader;
+		REQUIRE(jsonReader.init(file));
+		SerializerJson reader(jsonReader);
+		eastl::vector<ReflectParent> out;
+		REQUIRE(Serialize(reader, out, "Parents"));
+		REQUIRE(out == in);
+	}
+
+	SECTION("SerializerBinary")
+	{
+		SerializerBinary writer;
+		REQUIRE(Serialize(writer, in, "Parents"));
+
+		SerializerBinary reader(writer.getData(), writer.getDataSize());
+		eastl::vector<ReflectParent> out;
+		REQUIRE(Serialize(reader, out, "Parents"));
+		REQUIRE(out == in);
+	}
+}
+
+TEST_CASE("ReflectExistingJson", "[Reflect]")
+{
+	Json json;
+	REQUIRE(ReadJsonString(json, "{ \"Child\": { \"Tag\": \"old\", \"Id\": 1 } }"));
+
+ // writing to an existing object modifies the members
+	ReflectChild child;
+	child.m_id = 5;
+	child.m_tag.set("new");
+	SerializerJson writer(json, SerializerJson::Mode_Write);
+	REQUIRE(Serialize(writer, child, "Child"));
+	REQUIRE(json.find("Child"));
+	json.enterObject();
+	int memberCount = 0;
+	while (json.next()) {
+		++memberCount;
+	}
+	REQUIRE(memberCount == 2);
+	json.leaveObject();
+
+	SerializerJson reader(json, SerializerJson::Mode_Read);
+	ReflectChild out;
+	REQUIRE(Serialize(reader, out, "Child"));
+	REQUIRE(out == child);
+
+	Json missing;
+	REQUIRE(ReadJsonString(missing, "{ \"Child\": { \"Id\": 7 } }"));
+	SerializerJson missingReader(missing, SerializerJson::Mode_Read);
+	REQUIRE_FALSE(Serialize(missingReader, out, "Child"));
+	REQUIRE(missingReader.getError() != nullptr);
+	REQUIRE(out.m_id == 7);
+}
+
+static int s_errorCount;
+static void CountLogErrors(const char* _msg, LogType _type)
+{
+	if (_type == LogType_Error) {
+		++s_errorCount;
+	}
+}
+
+TEST_CASE("ReflectErrorLoggedOnce", "[Reflect]")
+{
+	Json json;
+	REQUIRE(ReadJsonString(json, "{ \"Parent\": { \"Position\": \"not an array\" } }"));
+
+	LogCallback* logCallback = GetLogCallback();
+	SetLogCallback(CountLogErrors);
+	s_errorCount = 0;
+	SerializerJson reader(json, SerializerJson::Mode_Read);
+	ReflectParent out;
+	REQUIRE_FALSE(Serialize(reader, out, "Parent"));
+	REQUIRE(s_errorCount == 1);
+	SetLogCallback(logCallback);
+}
@@ -0,0 +1,177 @@
+#include <catch.hpp>
+
+#include <apt/memory.h>
+#include <apt/File.h>
+#include <apt/SerializerBinary.h>
+
+#include <cstring>
+
+using namespace apt;
+
+struct TestState
+{
+	sint32     m_int;
+	float32    m_float;
+	bool       m_bool;
+	String<32> m_str;
+	vec3       m_vec;
+	mat4       m_mat;
+	float32    m_array[5];
+	uint8      m_blob[37];
+};
+
+static bool SerializeTestState(Serializer& _serializer_, TestState& _state_, bool _extra)
+{
+	bool ret = _serializer_.beginObject("State");
+	if (_extra) {
+		sint32 extra = 99;
+		ret &= _serializer_.value(extra, "Extra");
+		ret &= _serializer_.beginObject("ExtraObject");
+			ret &= _serializer_.value(extra, "Extra");
+		_serializer_.endObject();
+	}
+	ret &= _serializer_.value(_state_.m_int,   "Int");
+	ret &= _serializer_.value(_state_.m_float, "Float");
+	ret &= _serializer_.value(_state_.m_bool,  "Bool");
+	ret &= _serializer_.value(_state_.m_str,   "Str");
+	ret &= _serializer_.value(_state_.m_vec,   "Vec");
+	ret &= _serializer_.value(_state_.m_mat,   "Mat");
+	ret &= _serializer_.value(_state_.m_array, 5, "Array");
+	void* blob = _state_.m_blob;
+	uint blobSize = sizeof(_state_.m_blob);
+	ret &= _serializer_.binary(blob, blobSize, "Blob");
+	_serializer_.endObject();
+	return ret;
+}
+
+TEST_CASE("RoundTrip", "[SerializerBinary]")
+{
+	TestState in = {};
+	in.m_int   = -5;
+	in.m_float = 2.5f;
+	in.m_bool  = true;
+	in.m_str.set("hello");
+	in.m_vec   = vec3(1.0f, 2.0f, 3.0f);
+	in.m_mat   = mat4(2.0f);
+	for (int i = 0; i < 5; ++i) {
+		in.m_array[i] = (float32)i * 0.5f;
+	}
+	for (int i = 0; i < 37; ++i) {
+		in.m_blob[i] = (uint8)(i * 7);
+	}
+
+	for (uint32 flags : { (uint32)SerializerBinary::Flags_None, (uint32)SerializerBinary::Flags_NameHashes }) {
+		SerializerBinary writer(7, flags);
+		REQUIRE(SerializeTestState(writer, in, true));
+		File file;
+		writer.write(file);
+
+		SerializerBinary reader(file);
+		REQUIRE(reader.getError() == nullptr);
+		REQUIRE(reader.getVersion() == 7);
+		TestState out = {};
+		REQUIRE(SerializeTestState(reader, out, flags == SerializerBinary::Flags_None)); // with name hashes the extra values are skipped
+		REQUIRE(out.m_int == in.m_int);
+		REQUIRE(out.m_float == in.m_float);
+		REQUIRE(out.m_bool == in.m_bool);
+		REQUIRE(out.m_str == in.m_str);
+		REQUIRE(out.m_vec == in.m_vec);
+		REQUIRE(out.m_mat == in.m_mat);
+		REQUIRE(memcmp(out.m_array, in.m_array, sizeof(in.m_array)) == 0);
+		REQUIRE(memcmp(out.m_blob, in.m_blob, sizeof(in.m_blob)) == 0);
+	}
+}
+
+TEST_CASE("NameLookup", "[SerializerBinary]")
+{
+	SerializerBinary writer;
+	sint32 i = 3;
+	float32 f = 1.5f;
+	writer.value(i, "Int");
+	writer.value(f, "Float");
+	uint8 data[100];
+	for (int k = 0; k < 100; ++k) {
+		data[k] = (uint8)k;
+	}
+	void* dataPtr = data;
+	uint dataSize = sizeof(data);
+	writer.binary(dataPtr, dataSize, "Data");
+
+	SerializerBinary reader(writer.getData(), writer.getDataSize());
+	float64 d;
+	REQUIRE(reader.value(d, "Float")); // out of order, converted
+	REQUIRE(d == 1.5);
+	REQUIRE(reader.value(d, "Int"));
+	REQUIRE(d == 3.0);
+	REQUIRE_FALSE(reader.value(i, "Missing"));
+
+	const void* inPlace = nullptr;
+	uint inPlaceSize = 0;
+	REQUIRE(reader.binary(inPlace, inPlaceSize, "Data"));
+	REQUIRE(inPlaceSize == sizeof(data));
+	REQUIRE(((const char*)inPlace - writer.getData()) % SerializerBinary::kBinaryAlignment == 0);
+	REQUIRE(memcmp(inPlace, data, sizeof(data)) == 0);
+
+	char invalid[16] = {};
+	SerializerBinary invalidReader(invalid, sizeof(invalid));
+	REQUIRE(invalidReader.getError() != nullptr);
+	REQUIRE_FALSE(invalidReader.value(i, "Int"));
+}
+
+// Size prefixes which exceed the data (or overflow 32 bit arithmetic) are rejected.
+TEST_CASE("CorruptSize", "[SerializerBinary]")
+{
+	const uint kHeaderSize = 12;
+	const uint kSizeOffset = kHeaderSize + 1; // after the type tag
+
+	SECTION("Object")
+	{
+		SerializerBinary writer;
+		sint32 i = 1;
+		writer.beginObject("Object");
+			writer.value(i, "Int");
+		writer.endObject();
+		File file;
+		writer.write(file);
+		const uint32 size = 0xffffffff;
+		memcpy(file.getData() + kSizeOffset, &size, sizeof(size));
+
+		SerializerBinary reader(file);
+		REQUIRE_FALSE(reader.beginObject("Object"));
+		REQUIRE(reader.getError() != nullptr);
+	}
+
+	SECTION("PackedArray")
+	{
+		SerializerBinary writer;
+		uint64 values[1] = { 1 };
+		writer.value(values, 1, "Values");
+		File file;
+		writer.write(file);
+		const uint32 count = 0x20000001; // count * sizeof(uint64) wraps to 8 in 32 bits
+		memcpy(file.getData() + kSizeOffset + 1, &count, sizeof(count));
+
+		SerializerBinary reader(file);
+		REQUIRE_FALSE(reader.value(values, 1, "Values"));
+		REQUIRE(reader.getError() != nullptr);
+	}
+
+	SECTION("Binary")
+	{
+		SerializerBinary writer;
+		uint8 data[16] = {};
+		void* dataPtr = data;
+		uint dataSize = sizeof(data);
+		writer.binary(dataPtr, dataSize, "Data");
+		File file;
+		writer.write(file);
+		const uint32 size = 0xfffffff0;
+		memcpy(file.getData() + kSizeOffset + 1, &size, sizeof(size));
+
+		SerializerBinary reader(file);
+		const void* inPlace = nullptr;
+		uint inPlaceSize = 0;
+		REQUIRE_FALSE(reader.binary(inPlace, inPlaceSize, "Data"));
+		REQUIRE(reader.getError() != nullptr);
+	}
+}
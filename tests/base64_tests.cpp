@@ -0,0 +1,64 @@
+#include <catch.hpp>
+
+#include <apt/base64.h>
+
+#include <EASTL/vector.h>
+
+#include <cstring>
+
+using namespace apt;
+
+TEST_CASE("known values", "[base64]")
+{
+	const char* kVectors[][2] = {
+		{ "",       ""         },
+		{ "f",      "Zg=="     },
+		{ "fo",     "Zm8="     },
+		{ "foo",    "Zm9v"     },
+		{ "foob",   "Zm9vYg==" },
+		{ "fooba",  "Zm9vYmE=" },
+		{ "foobar", "Zm9vYmFy" },
+	};
+	for (auto& v : kVectors) {
+		const uint binSizeBytes = (uint)strlen(v[0]);
+		const uint strSizeBytes = Base64EncSizeBytes(binSizeBytes);
+		REQUIRE(strSizeBytes == strlen(v[1]));
+		char enc[16];
+		Base64Encode(v[0], binSizeBytes, enc, strSizeBytes + 1);
+		REQUIRE(strcmp(enc, v[1]) == 0);
+
+		REQUIRE(Base64DecSizeBytes(enc, strSizeBytes) == binSizeBytes);
+		char dec[16];
+		REQUIRE(Base64Decode(enc, strSizeBytes, dec, binSizeBytes));
+		REQUIRE(memcmp(dec, v[0], binSizeBytes) == 0);
+	}
+}
+
+TEST_CASE("round trip", "[base64]")
+{
+ // cover the vectorized paths plus each tail length
+	for (uint binSizeBytes = 1; binSizeBytes < 100; ++binSizeBytes) {
+		eastl::vector<char> bin(binSizeBytes);
+		for (uint i = 0; i < binSizeBytes; ++i) {
+			bin[i] = (char)(i * 97 + binSizeBytes);
+		}
+		const uint strSizeBytes = Base64EncSizeBytes(binSizeBytes);
+		eastl::vector<char> str(strSizeBytes + 1);
+		Base64Encode(bin.data(), binSizeBytes, str.data(), strSizeBytes + 1);
+		REQUIRE(strlen(str.data()) == strSizeBytes);
+
+		REQUIRE(Base64DecSizeBytes(str.data(), strSizeBytes) == binSizeBytes);
+		eastl::vector<char> dec(binSizeBytes);
+		REQUIRE(Base64Decode(str.data(), strSizeBytes, dec.data(), binSizeBytes));
+		REQUIRE(memcmp(dec.data(), bin.data(), binSizeBytes) == 0);
+	}
+}
+
+TEST_CASE("invalid", "[base64]")
+{
+	char dec[32];
+	const char* kStr = "QUJDREVGR0hJSktMTU5PUFFSU1RV*1hZ";
+	const uint strSizeBytes = (uint)strlen(kStr);
+	REQUIRE_FALSE(Base64Decode(kStr, strSizeBytes, dec, Base64DecSizeBytes(kStr, strSizeBytes)));
+	REQUIRE_FALSE(Base64Decode("Zm9v", 4, dec, 2)); // size mismatch
+}